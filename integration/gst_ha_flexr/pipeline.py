@@ -163,9 +163,11 @@ class GstHAFlexrPipeline:
             self.dec1.connect("pad-added", self._on_pad_added)
             # Audio convert
             self.dec2 = Gst.ElementFactory.make("audioconvert", "convert")
-            # Resampler
-            self.resampler = Gst.ElementFactory.make("audioresample")
-            self.pipeline.add(self.resampler)
+            # Fallback for rates dlbresample does not take, passthrough
+            # for 32, 44.1 and 48 kHz
+            self.fallback_resampler = Gst.ElementFactory.make(
+                "audioresample", "fallback-resample")
+            self.pipeline.add(self.fallback_resampler)
 
         elif self.input_type in DD_TYPES:
             # AC3 parser
@@ -178,6 +180,10 @@ class GstHAFlexrPipeline:
             self.error_kill()
             return
 
+        # Resampler, decoders may output 32 or 44.1 kHz
+        self.resampler = Gst.ElementFactory.make("dlbresample", "resample")
+        self.pipeline.add(self.resampler)
+
         self.pipeline.add(self.dec1)
         self.pipeline.add(self.dec2)
 
@@ -185,27 +191,30 @@ class GstHAFlexrPipeline:
         if "video/quicktime" in self.input_type:
             self.typefind.link(self.demux)
             self.dec1.link(self.dec2)
-            self.dec2.link(self.flexr)
+            self.dec2.link(self.resampler)
 
         elif "audio/x-wav" in self.input_type:
             self.typefind.link(self.dec1)
-            self.dec2.link(self.resampler)
-            self.resampler.link(self.flexr)
+            self.dec2.link(self.fallback_resampler)
+            self.fallback_resampler.link(self.resampler)
 
         elif self.input_type in DD_TYPES:
             # If bitstream is decoded, we can connect right away.
             # Otherwise, we have to wait for a pad.
             self.typefind.link(self.dec1)
             self.dec1.link(self.dec2)
-            self.dec2.link(self.flexr)
+            self.dec2.link(self.resampler)
+
+        self.resampler.link(self.flexr)
 
         # Sync with pipeline state starting with downstream elements
+        self.resampler.sync_state_with_parent()
+        if "audio/x-wav" in self.input_type:
+            self.fallback_resampler.sync_state_with_parent()
         self.dec2.sync_state_with_parent()
         self.dec1.sync_state_with_parent()
         if "video/quicktime" in self.input_type:
             self.demux.sync_state_with_parent()
-        if "audio/x-wav" in self.input_type:
-            self.resampler.sync_state_with_parent()
 
     def _windows_audiosink(self, device):
         """Returns audio sink specific for Windows"""
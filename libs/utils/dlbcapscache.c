@@ -0,0 +1,163 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "dlbcapscache.h"
+
+typedef struct
+{
+  GstPadDirection direction;
+  GstCaps *caps;
+  GstCaps *filter;
+  GstCaps *result;
+} DlbCapsCacheEntry;
+
+struct _DlbCapsCache
+{
+  GMutex lock;
+  guint size;
+
+  /* bumped by each invalidation */
+  guint generation;
+
+  /* most recently inserted first */
+  GQueue entries;
+};
+
+static gboolean
+caps_equal (GstCaps * a, GstCaps * b)
+{
+  if (a == b)
+    return TRUE;
+
+  return a && b && gst_caps_is_strictly_equal (a, b);
+}
+
+static void
+entry_free (DlbCapsCacheEntry * entry)
+{
+  gst_caps_replace (&entry->caps, NULL);
+  gst_caps_replace (&entry->filter, NULL);
+  gst_caps_unref (entry->result);
+  g_slice_free (DlbCapsCacheEntry, entry);
+}
+
+DlbCapsCache *
+dlb_caps_cache_new (guint size)
+{
+  DlbCapsCache *cache;
+
+  g_return_val_if_fail (size > 0, NULL);
+
+  cache = g_new0 (DlbCapsCache, 1);
+  g_mutex_init (&cache->lock);
+  g_queue_init (&cache->entries);
+  cache->size = size;
+
+  return cache;
+}
+
+void
+dlb_caps_cache_free (DlbCapsCache * cache)
+{
+  if (!cache)
+    return;
+
+  g_list_free_full (cache->entries.head, (GDestroyNotify) entry_free);
+  g_mutex_clear (&cache->lock);
+  g_free (cache);
+}
+
+GstCaps *
+dlb_caps_cache_lookup (DlbCapsCache * cache, GstPadDirection direction,
+    GstCaps * caps, GstCaps * filter, guint * cookie)
+{
+  GstCaps *result = NULL;
+  GList *l;
+
+  g_mutex_lock (&cache->lock);
+
+  if (cookie)
+    *cookie = cache->generation;
+
+  for (l = cache->entries.head; l; l = l->next) {
+    DlbCapsCacheEntry *entry = l->data;
+
+    if (entry->direction == direction && caps_equal (entry->caps, caps)
+        && caps_equal (entry->filter, filter)) {
+      result = gst_caps_ref (entry->result);
+      break;
+    }
+  }
+
+  g_mutex_unlock (&cache->lock);
+
+  return result;
+}
+
+void
+dlb_caps_cache_insert (DlbCapsCache * cache, GstPadDirection direction,
+    GstCaps * caps, GstCaps * filter, GstCaps * result, guint cookie)
+{
+  DlbCapsCacheEntry *entry, *evicted = NULL;
+
+  g_return_if_fail (GST_IS_CAPS (result));
+
+  entry = g_slice_new0 (DlbCapsCacheEntry);
+  entry->direction = direction;
+  entry->caps = caps ? gst_caps_ref (caps) : NULL;
+  entry->filter = filter ? gst_caps_ref (filter) : NULL;
+  entry->result = gst_caps_ref (result);
+
+  g_mutex_lock (&cache->lock);
+
+  /* result was computed from settings that have changed since */
+  if (cookie != cache->generation) {
+    evicted = entry;
+  } else {
+    g_queue_push_head (&cache->entries, entry);
+    if (g_queue_get_length (&cache->entries) > cache->size)
+      evicted = g_queue_pop_tail (&cache->entries);
+  }
+
+  g_mutex_unlock (&cache->lock);
+
+  if (evicted)
+    entry_free (evicted);
+}
+
+void
+dlb_caps_cache_invalidate (DlbCapsCache * cache)
+{
+  GList *entries;
+
+  /* results are released outside of the lock */
+  g_mutex_lock (&cache->lock);
+  entries = cache->entries.head;
+  g_queue_init (&cache->entries);
+  cache->generation++;
+  g_mutex_unlock (&cache->lock);
+
+  g_list_free_full (entries, (GDestroyNotify) entry_free);
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _GST_DLB_CAPS_CACHE_H_
+#define _GST_DLB_CAPS_CACHE_H_
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DlbCapsCache DlbCapsCache;
+
+/**
+ * dlb_caps_cache_new:
+ * @size: maximum number of results kept, oldest are evicted first
+ *
+ * Creates cache of caps negotiation results. Results are keyed by pad
+ * direction, input caps and filter caps. Anything else a result depends on
+ * has to be handled by invalidating the cache when it changes.
+ *
+ * returns: (transfer full): the #DlbCapsCache that needs to be released
+ *              using #dlb_caps_cache_free function
+ */
+DlbCapsCache *
+dlb_caps_cache_new (guint size);
+
+/**
+ * dlb_caps_cache_free:
+ * @cache: the #DlbCapsCache pointer
+ *
+ * Releases the cache and all results it holds.
+ */
+void
+dlb_caps_cache_free (DlbCapsCache * cache);
+
+/**
+ * dlb_caps_cache_lookup:
+ * @cache: the #DlbCapsCache pointer
+ * @direction: direction of @caps
+ * @caps: (nullable): input caps
+ * @filter: (nullable): filter caps
+ * @cookie: (out) (optional): state of the cache, to be passed to
+ *          #dlb_caps_cache_insert when the result is not cached
+ *
+ * Looks up result stored for given key. Caps are compared with
+ * gst_caps_is_strictly_equal().
+ *
+ * returns: (transfer full) (nullable): the result or %NULL if not cached
+ */
+GstCaps *
+dlb_caps_cache_lookup (DlbCapsCache * cache, GstPadDirection direction,
+    GstCaps * caps, GstCaps * filter, guint * cookie);
+
+/**
+ * dlb_caps_cache_insert:
+ * @cache: the #DlbCapsCache pointer
+ * @direction: direction of @caps
+ * @caps: (nullable): input caps
+ * @filter: (nullable): filter caps
+ * @result: result to store
+ * @cookie: value returned by #dlb_caps_cache_lookup before @result was
+ *          computed
+ *
+ * Stores @result for given key, unless the cache was invalidated since
+ * @cookie was taken. Key and result are referenced, not copied, the caps
+ * must not be modified afterwards.
+ */
+void
+dlb_caps_cache_insert (DlbCapsCache * cache, GstPadDirection direction,
+    GstCaps * caps, GstCaps * filter, GstCaps * result, guint cookie);
+
+/**
+ * dlb_caps_cache_invalidate:
+ * @cache: the #DlbCapsCache pointer
+ *
+ * Drops all stored results. Can be called from any thread.
+ */
+void
+dlb_caps_cache_invalidate (DlbCapsCache * cache);
+
+G_END_DECLS
+
+#endif /* _GST_DLB_CAPS_CACHE_H_ */
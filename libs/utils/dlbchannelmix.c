@@ -0,0 +1,280 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "dlbchannelmix.h"
+
+#define MAX_CHANNELS 64
+
+struct _DlbChannelMix
+{
+  gint in_channels;
+  gint out_channels;
+  DlbChannelMixKind kind;
+
+  /* source of each output, silent outputs read the zero slot past the
+   * last input channel */
+  gint map[MAX_CHANNELS];
+  gboolean has_silence;
+
+  /* sparse matrices, taps of output c are tap_start[c]..tap_start[c+1] */
+  gboolean single_tap;
+  gint tap_start[MAX_CHANNELS + 1];
+  gint *tap_in;
+  gfloat *tap_gain;
+};
+
+DlbChannelMix *
+dlb_channel_mix_new (const gfloat * matrix, gint in_channels,
+    gint out_channels)
+{
+  DlbChannelMix *mix;
+  gboolean unit = TRUE, single = TRUE, identity, bijective;
+  guint64 used = 0;
+  gint i, j, taps = 0;
+
+  g_return_val_if_fail (matrix, NULL);
+  g_return_val_if_fail (in_channels > 0 && in_channels <= MAX_CHANNELS, NULL);
+  g_return_val_if_fail (out_channels > 0 && out_channels <= MAX_CHANNELS,
+      NULL);
+
+  mix = g_new0 (DlbChannelMix, 1);
+  mix->in_channels = in_channels;
+  mix->out_channels = out_channels;
+
+  for (i = 0; i < out_channels * in_channels; ++i)
+    taps += matrix[i] != 0.0f;
+
+  mix->tap_in = g_new (gint, MAX (taps, 1));
+  mix->tap_gain = g_new (gfloat, MAX (taps, 1));
+
+  for (i = 0, taps = 0; i < out_channels; ++i) {
+    const gfloat *row = matrix + i * in_channels;
+
+    mix->tap_start[i] = taps;
+    mix->map[i] = in_channels;
+
+    for (j = 0; j < in_channels; ++j) {
+      if (row[j] == 0.0f)
+        continue;
+
+      mix->map[i] = j;
+      mix->tap_in[taps] = j;
+      mix->tap_gain[taps++] = row[j];
+      unit &= row[j] == 1.0f;
+    }
+
+    if (taps - mix->tap_start[i] > 1)
+      single = unit = FALSE;
+    else if (taps == mix->tap_start[i])
+      mix->has_silence = TRUE;
+  }
+
+  mix->tap_start[out_channels] = taps;
+  mix->single_tap = single;
+
+  identity = in_channels == out_channels && !mix->has_silence;
+  bijective = identity;
+
+  for (i = 0; i < out_channels && bijective; ++i) {
+    identity &= mix->map[i] == i;
+    bijective &= !(used & (G_GUINT64_CONSTANT (1) << mix->map[i]));
+    used |= G_GUINT64_CONSTANT (1) << mix->map[i];
+  }
+
+  if (!unit)
+    mix->kind = DLB_CHANNEL_MIX_SPARSE;
+  else if (identity)
+    mix->kind = DLB_CHANNEL_MIX_IDENTITY;
+  else if (bijective)
+    mix->kind = DLB_CHANNEL_MIX_PERMUTATION;
+  else
+    mix->kind = DLB_CHANNEL_MIX_DUPLICATION;
+
+  return mix;
+}
+
+void
+dlb_channel_mix_free (DlbChannelMix * mix)
+{
+  if (!mix)
+    return;
+
+  g_free (mix->tap_in);
+  g_free (mix->tap_gain);
+  g_free (mix);
+}
+
+DlbChannelMixKind
+dlb_channel_mix_get_kind (const DlbChannelMix * mix)
+{
+  return mix->kind;
+}
+
+/* frames are staged when the output overwrites them or a silent output
+ * needs the zero slot, the copy stays in L1 */
+#define STAGE(type)                                                            \
+  (staged ? (memcpy (frame, in, inch * sizeof (type)), (const type *) frame)  \
+      : in)
+
+/* constant channel counts let the compiler unroll the common layouts, the
+ * map is only known at runtime so every output sample stays a scalar
+ * gather */
+#define MAP_LOOP(type, N)                                                      \
+  for (i = 0; i < samples; ++i, in += inch, out += (N)) {                      \
+    const type *s = STAGE (type);                                              \
+                                                                               \
+    for (c = 0; c < (N); ++c)                                                  \
+      out[c] = s[map[c]];                                                      \
+  }
+
+#define DEFINE_MAP_KERNEL(type)                                                \
+static void                                                                    \
+map_##type (const DlbChannelMix * mix, const type * in, type * out,           \
+    gsize samples)                                                             \
+{                                                                              \
+  const gint *map = mix->map;                                                  \
+  gint inch = mix->in_channels;                                                \
+  gboolean staged = mix->has_silence || (gconstpointer) in == out;             \
+  type frame[MAX_CHANNELS + 1];                                                \
+  gsize i;                                                                     \
+  gint c;                                                                      \
+                                                                               \
+  frame[inch] = 0;                                                             \
+                                                                               \
+  switch (mix->out_channels) {                                                 \
+    case 2:                                                                    \
+      MAP_LOOP (type, 2);                                                      \
+      break;                                                                   \
+    case 6:                                                                    \
+      MAP_LOOP (type, 6);                                                      \
+      break;                                                                   \
+    case 8:                                                                    \
+      MAP_LOOP (type, 8);                                                      \
+      break;                                                                   \
+    default:                                                                   \
+      MAP_LOOP (type, mix->out_channels);                                      \
+      break;                                                                   \
+  }                                                                            \
+}
+
+DEFINE_MAP_KERNEL (guint16)
+DEFINE_MAP_KERNEL (guint32)
+DEFINE_MAP_KERNEL (guint64)
+
+#define STORE_F32(x) (x)
+#define STORE_F64(x) (x)
+#define STORE_S16(x) ((gint16) CLAMP (lrintf (x), G_MININT16, G_MAXINT16))
+#define STORE_S32(x) ((gint32) CLAMP (llrint (x), G_MININT32, G_MAXINT32))
+
+/* weighted sums, rows with a single tap are scaled copies */
+#define DEFINE_SPARSE_KERNEL(fmt, type, acctype)                               \
+static void                                                                    \
+sparse_##fmt (const DlbChannelMix * mix, const type * in, type * out,         \
+    gsize samples)                                                             \
+{                                                                              \
+  const gint *map = mix->map;                                                  \
+  const gint *start = mix->tap_start;                                          \
+  const gint *tap_in = mix->tap_in;                                            \
+  const gfloat *tap_gain = mix->tap_gain;                                      \
+  gint inch = mix->in_channels;                                                \
+  gint outch = mix->out_channels;                                              \
+  gboolean staged = mix->has_silence || (gconstpointer) in == out;             \
+  type frame[MAX_CHANNELS + 1];                                                \
+  acctype gain[MAX_CHANNELS];                                                  \
+  gsize i;                                                                     \
+  gint c, t;                                                                   \
+                                                                               \
+  frame[inch] = 0;                                                             \
+                                                                               \
+  if (mix->single_tap) {                                                       \
+    for (c = 0; c < outch; ++c)                                                \
+      gain[c] = start[c] < start[c + 1] ? tap_gain[start[c]] : 0;              \
+                                                                               \
+    for (i = 0; i < samples; ++i, in += inch, out += outch) {                  \
+      const type *s = STAGE (type);                                            \
+                                                                               \
+      for (c = 0; c < outch; ++c)                                              \
+        out[c] = STORE_##fmt ((acctype) s[map[c]] * gain[c]);                  \
+    }                                                                          \
+    return;                                                                    \
+  }                                                                            \
+                                                                               \
+  for (i = 0; i < samples; ++i, in += inch, out += outch) {                    \
+    const type *s = STAGE (type);                                              \
+                                                                               \
+    for (c = 0; c < outch; ++c) {                                              \
+      acctype acc = 0;                                                         \
+                                                                               \
+      for (t = start[c]; t < start[c + 1]; ++t)                                \
+        acc += (acctype) s[tap_in[t]] * tap_gain[t];                           \
+      out[c] = STORE_##fmt (acc);                                              \
+    }                                                                          \
+  }                                                                            \
+}
+
+DEFINE_SPARSE_KERNEL (F32, gfloat, gfloat)
+DEFINE_SPARSE_KERNEL (F64, gdouble, gdouble)
+DEFINE_SPARSE_KERNEL (S16, gint16, gfloat)
+DEFINE_SPARSE_KERNEL (S32, gint32, gdouble)
+
+void
+dlb_channel_mix_process (const DlbChannelMix * mix, const guint8 * in,
+    guint8 * out, gsize samples, GstAudioFormat format)
+{
+  const GstAudioFormatInfo *finfo = gst_audio_format_get_info (format);
+  gint width = GST_AUDIO_FORMAT_INFO_WIDTH (finfo);
+
+  g_return_if_fail (in != out || mix->in_channels == mix->out_channels);
+
+  switch (mix->kind) {
+    case DLB_CHANNEL_MIX_IDENTITY:
+      if (in != out)
+        memcpy (out, in, samples * mix->in_channels * width / 8);
+      break;
+    case DLB_CHANNEL_MIX_PERMUTATION:
+    case DLB_CHANNEL_MIX_DUPLICATION:
+      if (width == 16)
+        map_guint16 (mix, (const guint16 *) in, (guint16 *) out, samples);
+      else if (width == 32)
+        map_guint32 (mix, (const guint32 *) in, (guint32 *) out, samples);
+      else
+        map_guint64 (mix, (const guint64 *) in, (guint64 *) out, samples);
+      break;
+    case DLB_CHANNEL_MIX_SPARSE:
+      if (format == GST_AUDIO_FORMAT_F32)
+        sparse_F32 (mix, (const gfloat *) in, (gfloat *) out, samples);
+      else if (format == GST_AUDIO_FORMAT_F64)
+        sparse_F64 (mix, (const gdouble *) in, (gdouble *) out, samples);
+      else if (format == GST_AUDIO_FORMAT_S16)
+        sparse_S16 (mix, (const gint16 *) in, (gint16 *) out, samples);
+      else if (format == GST_AUDIO_FORMAT_S32)
+        sparse_S32 (mix, (const gint32 *) in, (gint32 *) out, samples);
+      else
+        g_return_if_reached ();
+      break;
+  }
+}
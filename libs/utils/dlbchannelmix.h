@@ -0,0 +1,102 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _GST_DLB_CHANNEL_MIX_H_
+#define _GST_DLB_CHANNEL_MIX_H_
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DlbChannelMix DlbChannelMix;
+
+/**
+ * DlbChannelMixKind:
+ * @DLB_CHANNEL_MIX_IDENTITY: output equals input
+ * @DLB_CHANNEL_MIX_PERMUTATION: every input channel is moved to exactly one
+ *          output channel
+ * @DLB_CHANNEL_MIX_DUPLICATION: every output channel is a copy of one input
+ *          channel or silent
+ * @DLB_CHANNEL_MIX_SPARSE: output channels are weighted sums of few input
+ *          channels
+ *
+ * Cheapest processing the mix matrix reduces to.
+ */
+typedef enum
+{
+  DLB_CHANNEL_MIX_IDENTITY,
+  DLB_CHANNEL_MIX_PERMUTATION,
+  DLB_CHANNEL_MIX_DUPLICATION,
+  DLB_CHANNEL_MIX_SPARSE,
+} DlbChannelMixKind;
+
+/**
+ * dlb_channel_mix_new:
+ * @matrix: @out_channels rows of @in_channels gains
+ * @in_channels: number of input channels, up to 64
+ * @out_channels: number of output channels, up to 64
+ *
+ * Analyses the mix matrix once and selects the processing kernel, so
+ * channel permutations and copies never go through multiplications.
+ *
+ * returns: (transfer full): the #DlbChannelMix that needs to be released
+ *              using #dlb_channel_mix_free function
+ */
+DlbChannelMix *
+dlb_channel_mix_new (const gfloat * matrix, gint in_channels,
+    gint out_channels);
+
+/**
+ * dlb_channel_mix_free:
+ * @mix: the #DlbChannelMix pointer
+ *
+ * Releases the mixer.
+ */
+void
+dlb_channel_mix_free (DlbChannelMix * mix);
+
+/**
+ * dlb_channel_mix_get_kind:
+ * @mix: the #DlbChannelMix pointer
+ *
+ * returns: the #DlbChannelMixKind the matrix was classified as
+ */
+DlbChannelMixKind
+dlb_channel_mix_get_kind (const DlbChannelMix * mix);
+
+/**
+ * dlb_channel_mix_process:
+ * @mix: the #DlbChannelMix pointer
+ * @in: interleaved input samples
+ * @out: interleaved output samples, may be @in when channel counts match
+ * @samples: number of samples per channel
+ * @format: one of F32, F64, S16 or S32 in native endianness
+ *
+ * Mixes @samples frames. Integer formats are rounded and clipped when the
+ * matrix is sparse.
+ */
+void
+dlb_channel_mix_process (const DlbChannelMix * mix, const guint8 * in,
+    guint8 * out, gsize samples, GstAudioFormat format);
+
+G_END_DECLS
+
+#endif /* _GST_DLB_CHANNEL_MIX_H_ */
@@ -0,0 +1,401 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2020-2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <gio/gio.h>
+
+#include "dlbconfigloader.h"
+
+/* coalesces bursts of change notifications generated by a single save */
+#define RELOAD_DELAY_MS 50
+
+struct _DlbConfigLoader
+{
+  gint ref_count;
+
+  GMutex lock;
+  GCond cond;
+
+  /* protected by lock */
+  gchar *filename;
+  guint scheduled;
+  guint completed;
+  gboolean disposed;
+  gboolean shutdown;
+
+  /* accessed from the loader thread only */
+  GFileMonitor *monitor;
+  gchar *monitored;
+  GSource *reload_source;
+
+  DlbConfigLoaderParseFunc parse_func;
+  GDestroyNotify free_func;
+  DlbConfigLoaderNotifyFunc notify_func;
+  gpointer user_data;
+
+  /* latest parsed configuration, exchanged atomically */
+  gpointer published;
+};
+
+/* single thread shared by all loaders in the process */
+static GMutex worker_lock;
+static guint worker_users;
+static GThread *worker_thread;
+static GMainContext *worker_context;
+static GMainLoop *worker_loop;
+
+static gpointer
+worker_thread_func (gpointer data)
+{
+  GMainLoop *loop = data;
+  GMainContext *context = g_main_loop_get_context (loop);
+
+  g_main_context_push_thread_default (context);
+  g_main_loop_run (loop);
+  g_main_context_pop_thread_default (context);
+
+  return NULL;
+}
+
+static gboolean
+worker_quit (gpointer data)
+{
+  g_main_loop_quit ((GMainLoop *) data);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+worker_invoke (GSourceFunc func, gpointer data, GDestroyNotify notify)
+{
+  GSource *source = g_idle_source_new ();
+
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, func, data, notify);
+  g_source_attach (source, worker_context);
+  g_source_unref (source);
+}
+
+static void
+worker_acquire (void)
+{
+  g_mutex_lock (&worker_lock);
+
+  if (worker_users++ == 0) {
+    worker_context = g_main_context_new ();
+    worker_loop = g_main_loop_new (worker_context, FALSE);
+    worker_thread =
+        g_thread_new ("dlbconfigloader", worker_thread_func, worker_loop);
+  }
+
+  g_mutex_unlock (&worker_lock);
+}
+
+static void
+worker_release (void)
+{
+  g_mutex_lock (&worker_lock);
+
+  if (--worker_users == 0) {
+    worker_invoke (worker_quit, worker_loop, NULL);
+    g_thread_join (worker_thread);
+
+    g_main_loop_unref (worker_loop);
+    g_main_context_unref (worker_context);
+
+    worker_thread = NULL;
+    worker_loop = NULL;
+    worker_context = NULL;
+  }
+
+  g_mutex_unlock (&worker_lock);
+}
+
+static DlbConfigLoader *
+dlb_config_loader_ref (DlbConfigLoader * loader)
+{
+  g_atomic_int_inc (&loader->ref_count);
+  return loader;
+}
+
+static void
+dlb_config_loader_unref (gpointer data)
+{
+  DlbConfigLoader *loader = data;
+  gpointer config;
+
+  if (!g_atomic_int_dec_and_test (&loader->ref_count))
+    return;
+
+  if ((config = dlb_config_loader_take (loader)))
+    loader->free_func (config);
+
+  g_free (loader->filename);
+  g_mutex_clear (&loader->lock);
+  g_cond_clear (&loader->cond);
+  g_free (loader);
+}
+
+static void
+dlb_config_loader_publish (DlbConfigLoader * loader, gpointer config)
+{
+  gpointer old;
+
+  do {
+    old = g_atomic_pointer_get (&loader->published);
+  } while (!g_atomic_pointer_compare_and_exchange (&loader->published, old,
+          config));
+
+  /* previous one was never picked up by the consumer */
+  if (old)
+    loader->free_func (old);
+}
+
+static void
+dlb_config_loader_load (DlbConfigLoader * loader, const gchar * filename)
+{
+  GError *error = NULL;
+  gpointer config;
+
+  config = loader->parse_func (filename, loader->user_data, &error);
+
+  if (loader->notify_func)
+    loader->notify_func (filename, config, error, loader->user_data);
+
+  if (config)
+    dlb_config_loader_publish (loader, config);
+
+  g_clear_error (&error);
+}
+
+static gboolean
+dlb_config_loader_reload_timeout (gpointer data)
+{
+  DlbConfigLoader *loader = data;
+
+  g_source_unref (loader->reload_source);
+  loader->reload_source = NULL;
+
+  if (loader->monitored)
+    dlb_config_loader_load (loader, loader->monitored);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+dlb_config_loader_file_changed (GFileMonitor * monitor, GFile * file,
+    GFile * other, GFileMonitorEvent event, gpointer data)
+{
+  DlbConfigLoader *loader = data;
+
+  if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT &&
+      event != G_FILE_MONITOR_EVENT_CREATED)
+    return;
+
+  if (loader->reload_source)
+    return;
+
+  loader->reload_source = g_timeout_source_new (RELOAD_DELAY_MS);
+  g_source_set_callback (loader->reload_source,
+      dlb_config_loader_reload_timeout, loader, NULL);
+  g_source_attach (loader->reload_source, worker_context);
+}
+
+static void
+dlb_config_loader_watch (DlbConfigLoader * loader, const gchar * filename)
+{
+  GError *error = NULL;
+  GFile *file = g_file_new_for_path (filename);
+
+  loader->monitor =
+      g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, &error);
+
+  if (loader->monitor) {
+    g_signal_connect (loader->monitor, "changed",
+        G_CALLBACK (dlb_config_loader_file_changed), loader);
+  } else {
+    /* hot reload is not available, initial load still takes place */
+    g_debug ("Cannot watch %s: %s", filename, error->message);
+    g_clear_error (&error);
+  }
+
+  loader->monitored = g_strdup (filename);
+  g_object_unref (file);
+}
+
+static void
+dlb_config_loader_unwatch (DlbConfigLoader * loader)
+{
+  if (loader->monitor) {
+    g_signal_handlers_disconnect_by_data (loader->monitor, loader);
+    g_file_monitor_cancel (loader->monitor);
+    g_object_unref (loader->monitor);
+    loader->monitor = NULL;
+  }
+
+  if (loader->reload_source) {
+    g_source_destroy (loader->reload_source);
+    g_source_unref (loader->reload_source);
+    loader->reload_source = NULL;
+  }
+
+  g_free (loader->monitored);
+  loader->monitored = NULL;
+}
+
+static gboolean
+dlb_config_loader_update (gpointer data)
+{
+  DlbConfigLoader *loader = data;
+  gchar *filename;
+  guint serial;
+
+  g_mutex_lock (&loader->lock);
+  if (loader->disposed || loader->completed == loader->scheduled) {
+    g_mutex_unlock (&loader->lock);
+    return G_SOURCE_REMOVE;
+  }
+
+  filename = g_strdup (loader->filename);
+  serial = loader->scheduled;
+  g_mutex_unlock (&loader->lock);
+
+  if (g_strcmp0 (filename, loader->monitored)) {
+    dlb_config_loader_unwatch (loader);
+
+    if (filename)
+      dlb_config_loader_watch (loader, filename);
+  }
+
+  if (filename)
+    dlb_config_loader_load (loader, filename);
+
+  g_mutex_lock (&loader->lock);
+  loader->completed = serial;
+  g_cond_broadcast (&loader->cond);
+  g_mutex_unlock (&loader->lock);
+
+  g_free (filename);
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+dlb_config_loader_shutdown (gpointer data)
+{
+  DlbConfigLoader *loader = data;
+
+  dlb_config_loader_unwatch (loader);
+
+  g_mutex_lock (&loader->lock);
+  loader->shutdown = TRUE;
+  loader->completed = loader->scheduled;
+  g_cond_broadcast (&loader->cond);
+  g_mutex_unlock (&loader->lock);
+
+  return G_SOURCE_REMOVE;
+}
+
+DlbConfigLoader *
+dlb_config_loader_new (DlbConfigLoaderParseFunc parse_func,
+    GDestroyNotify free_func, DlbConfigLoaderNotifyFunc notify_func,
+    gpointer user_data)
+{
+  DlbConfigLoader *loader;
+
+  g_return_val_if_fail (parse_func != NULL, NULL);
+  g_return_val_if_fail (free_func != NULL, NULL);
+
+  loader = g_new0 (DlbConfigLoader, 1);
+  loader->ref_count = 1;
+  loader->parse_func = parse_func;
+  loader->free_func = free_func;
+  loader->notify_func = notify_func;
+  loader->user_data = user_data;
+
+  g_mutex_init (&loader->lock);
+  g_cond_init (&loader->cond);
+
+  worker_acquire ();
+
+  return loader;
+}
+
+void
+dlb_config_loader_free (DlbConfigLoader * loader)
+{
+  g_return_if_fail (loader != NULL);
+
+  g_mutex_lock (&loader->lock);
+  loader->disposed = TRUE;
+  g_mutex_unlock (&loader->lock);
+
+  worker_invoke (dlb_config_loader_shutdown, dlb_config_loader_ref (loader),
+      dlb_config_loader_unref);
+
+  g_mutex_lock (&loader->lock);
+  while (!loader->shutdown)
+    g_cond_wait (&loader->cond, &loader->lock);
+  g_mutex_unlock (&loader->lock);
+
+  dlb_config_loader_unref (loader);
+  worker_release ();
+}
+
+void
+dlb_config_loader_set_filename (DlbConfigLoader * loader,
+    const gchar * filename)
+{
+  g_return_if_fail (loader != NULL);
+
+  g_mutex_lock (&loader->lock);
+  g_free (loader->filename);
+  loader->filename = g_strdup (filename);
+  loader->scheduled++;
+  g_mutex_unlock (&loader->lock);
+
+  worker_invoke (dlb_config_loader_update, dlb_config_loader_ref (loader),
+      dlb_config_loader_unref);
+}
+
+void
+dlb_config_loader_wait (DlbConfigLoader * loader)
+{
+  g_return_if_fail (loader != NULL);
+
+  g_mutex_lock (&loader->lock);
+  while (loader->completed != loader->scheduled)
+    g_cond_wait (&loader->cond, &loader->lock);
+  g_mutex_unlock (&loader->lock);
+}
+
+gpointer
+dlb_config_loader_take (DlbConfigLoader * loader)
+{
+  gpointer config;
+
+  do {
+    config = g_atomic_pointer_get (&loader->published);
+  } while (config && !g_atomic_pointer_compare_and_exchange
+      (&loader->published, config, NULL));
+
+  return config;
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2020-2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _GST_DLB_CONFIG_LOADER_H_
+#define _GST_DLB_CONFIG_LOADER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DlbConfigLoader DlbConfigLoader;
+
+/**
+ * DlbConfigLoaderParseFunc:
+ * @filename: path of the configuration file
+ * @user_data: user data passed to #dlb_config_loader_new
+ * @error: return location for a #GError
+ *
+ * Reads and parses configuration file. Called from the loader thread.
+ *
+ * returns: (transfer full): parsed configuration or %NULL on error
+ */
+typedef gpointer (*DlbConfigLoaderParseFunc) (const gchar * filename,
+    gpointer user_data, GError ** error);
+
+/**
+ * DlbConfigLoaderNotifyFunc:
+ * @filename: path of the configuration file
+ * @config: (transfer none): parsed configuration or %NULL on error
+ * @error: error reported by the parse function or %NULL on success
+ * @user_data: user data passed to #dlb_config_loader_new
+ *
+ * Called from the loader thread after each load attempt, right before the
+ * result is published.
+ */
+typedef void (*DlbConfigLoaderNotifyFunc) (const gchar * filename,
+    gconstpointer config, const GError * error, gpointer user_data);
+
+/**
+ * dlb_config_loader_new:
+ * @parse_func: function used to read and parse the file
+ * @free_func: function used to release parsed configuration
+ * @notify_func: (nullable): function called after each load attempt
+ * @user_data: user data passed to @parse_func and @notify_func
+ *
+ * Creates configuration loader. File I/O and parsing is done on a shared
+ * background thread. Watched file is reloaded whenever it changes on disk.
+ *
+ * returns: (transfer full): the #DlbConfigLoader that needs to be released
+ *              using #dlb_config_loader_free function
+ */
+DlbConfigLoader *
+dlb_config_loader_new (DlbConfigLoaderParseFunc parse_func,
+    GDestroyNotify free_func, DlbConfigLoaderNotifyFunc notify_func,
+    gpointer user_data);
+
+/**
+ * dlb_config_loader_free:
+ * @loader: the #DlbConfigLoader pointer
+ *
+ * Stops watching the file and releases the loader together with any
+ * configuration that has not been taken yet.
+ */
+void
+dlb_config_loader_free (DlbConfigLoader * loader);
+
+/**
+ * dlb_config_loader_set_filename:
+ * @loader: the #DlbConfigLoader pointer
+ * @filename: (nullable): path of the configuration file
+ *
+ * Schedules loading of @filename and starts watching it for changes.
+ * Returns immediately. Passing %NULL stops watching previous file.
+ */
+void
+dlb_config_loader_set_filename (DlbConfigLoader * loader,
+    const gchar * filename);
+
+/**
+ * dlb_config_loader_wait:
+ * @loader: the #DlbConfigLoader pointer
+ *
+ * Blocks until all scheduled loads are completed. Must not be called from
+ * the audio processing thread.
+ */
+void
+dlb_config_loader_wait (DlbConfigLoader * loader);
+
+/**
+ * dlb_config_loader_take:
+ * @loader: the #DlbConfigLoader pointer
+ *
+ * Atomically takes most recently published configuration. Never blocks, so
+ * it is safe to call at each processing block boundary.
+ *
+ * returns: (transfer full) (nullable): new configuration or %NULL if
+ *              nothing has been published since last call
+ */
+gpointer
+dlb_config_loader_take (DlbConfigLoader * loader);
+
+G_END_DECLS
+
+#endif /* _GST_DLB_CONFIG_LOADER_H_ */
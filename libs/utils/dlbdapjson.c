@@ -20,6 +20,8 @@
 
 #include "dlbdapjson.h"
 
+#include <stdio.h>
+
 #include <glib/gi18n.h>
 #include <json-glib/json-glib.h>
 
@@ -473,24 +475,13 @@ dlb_dap_profile_settings_get_type (void)
   return b_type;
 }
 
-gboolean
-dlb_dap_json_parse_config (const gchar * filename,
+static DlbDapJsonSections
+dlb_dap_json_parse_object (JsonObject * jsonobj,
     dlb_dap_global_settings * global, dlb_dap_virtualizer_settings * virt,
-    dlb_dap_gain_settings *gains, dlb_dap_profile_settings * profile,
-    GError ** error)
+    dlb_dap_gain_settings * gains, dlb_dap_profile_settings * profile)
 {
-  JsonParser *parser;
+  DlbDapJsonSections sections = 0;
   JsonNode *root;
-  JsonObject *jsonobj;
-
-  parser = json_parser_new ();
-  if (!json_parser_load_from_file (parser, filename, error)) {
-    g_object_unref (parser);
-    return FALSE;
-  }
-
-  root = json_parser_get_root (parser);
-  jsonobj = json_node_get_object (root);
 
   if (global && json_object_has_member (jsonobj, "global")) {
     dlb_dap_global_settings *g;
@@ -503,6 +494,7 @@ dlb_dap_json_parse_config (const gchar * filename,
     global->virtualizer_enable = g->virtualizer_enable;
     global->profile = g_strdup (g->profile);
     g_boxed_free (DLB_DAP_GLOBAL_SETTINGS_TYPE_BOXED, g);
+    sections |= DLB_DAP_JSON_SECTION_GLOBAL;
   }
 
   if (virt && json_object_has_member (jsonobj, "virtualizer-settings")) {
@@ -513,6 +505,7 @@ dlb_dap_json_parse_config (const gchar * filename,
 
     *virt = *v;
     g_boxed_free (DLB_DAP_VIRTUALIZER_SETTINGS_TYPE_BOXED, v);
+    sections |= DLB_DAP_JSON_SECTION_VIRTUALIZER;
   }
 
   if (gains && json_object_has_member (jsonobj, "gain-settings")) {
@@ -523,9 +516,11 @@ dlb_dap_json_parse_config (const gchar * filename,
 
     *gains = *g;
     g_boxed_free (DLB_DAP_GAIN_SETTINGS_TYPE_BOXED, g);
+    sections |= DLB_DAP_JSON_SECTION_GAINS;
   }
 
-  if (profile && json_object_has_member (jsonobj, "profiles")) {
+  if (profile && global && global->profile
+      && json_object_has_member (jsonobj, "profiles")) {
     root = json_object_get_member (jsonobj, "profiles");
     jsonobj = json_node_get_object (root);
     if (json_object_has_member (jsonobj, global->profile)) {
@@ -536,9 +531,32 @@ dlb_dap_json_parse_config (const gchar * filename,
 
       *profile = *p;
       g_boxed_free (DLB_DAP_PROFILE_SETTINGS_TYPE_BOXED, p);
+      sections |= DLB_DAP_JSON_SECTION_PROFILE;
     }
   }
 
+  return sections;
+}
+
+gboolean
+dlb_dap_json_parse_config (const gchar * filename,
+    dlb_dap_global_settings * global, dlb_dap_virtualizer_settings * virt,
+    dlb_dap_gain_settings *gains, dlb_dap_profile_settings * profile,
+    GError ** error)
+{
+  JsonParser *parser;
+  JsonNode *root;
+
+  parser = json_parser_new ();
+  if (!json_parser_load_from_file (parser, filename, error)) {
+    g_object_unref (parser);
+    return FALSE;
+  }
+
+  root = json_parser_get_root (parser);
+  dlb_dap_json_parse_object (json_node_get_object (root), global, virt, gains,
+      profile);
+
   g_object_unref (parser);
   return TRUE;
 }
@@ -586,3 +604,94 @@ dlb_dap_json_parse_serialized_config (const gchar * filename,
   g_object_unref (parser);
   return data;
 }
+
+#define SERIALIZED_KEY(rate, virt) GUINT_TO_POINTER (((rate) << 1) | !!(virt))
+
+dlb_dap_json_config *
+dlb_dap_json_config_load (const gchar * filename, GError ** error)
+{
+  dlb_dap_json_config *config;
+  JsonParser *parser;
+  JsonNode *root;
+  JsonObject *jsonobj;
+
+  parser = json_parser_new ();
+  if (!json_parser_load_from_file (parser, filename, error)) {
+    g_object_unref (parser);
+    return NULL;
+  }
+
+  config = g_slice_new0 (dlb_dap_json_config);
+  config->serialized =
+      g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+      (GDestroyNotify) g_bytes_unref);
+
+  dlb_dap_virtualizer_settings_init (&config->virt);
+  dlb_dap_profile_settings_init (&config->profile);
+
+  root = json_parser_get_root (parser);
+  jsonobj = json_node_get_object (root);
+
+  config->sections = dlb_dap_json_parse_object (jsonobj, &config->global,
+      &config->virt, &config->gains, &config->profile);
+
+  /* decode serialized configs for all sample rates up front, so that caps
+   * negotiation never has to touch the file */
+  if (json_object_has_member (jsonobj, "serialized-settings")) {
+    GList *rates, *l;
+
+    root = json_object_get_member (jsonobj, "serialized-settings");
+    jsonobj = json_node_get_object (root);
+    rates = json_object_get_members (jsonobj);
+
+    for (l = rates; l; l = l->next) {
+      const gchar *sr = l->data;
+      JsonObject *virtobj;
+      guint rate;
+
+      if (sscanf (sr, "sr-%u", &rate) != 1)
+        continue;
+
+      root = json_object_get_member (jsonobj, sr);
+      virtobj = json_node_get_object (root);
+
+      for (gint virt = 0; virt < 2; ++virt) {
+        const gchar *member = virt ? "virt-enable" : "virt-disable";
+        const gchar *base64;
+        guchar *data;
+        gsize data_size;
+
+        if (!json_object_has_member (virtobj, member))
+          continue;
+
+        base64 = json_object_get_string_member (virtobj, member);
+        data = g_base64_decode (base64, &data_size);
+        g_hash_table_insert (config->serialized, SERIALIZED_KEY (rate, virt),
+            g_bytes_new_take (data, data_size));
+      }
+    }
+
+    g_list_free (rates);
+  }
+
+  g_object_unref (parser);
+  return config;
+}
+
+void
+dlb_dap_json_config_free (dlb_dap_json_config * config)
+{
+  if (G_LIKELY (config != NULL)) {
+    g_free (config->global.profile);
+    g_hash_table_unref (config->serialized);
+    g_slice_free (dlb_dap_json_config, config);
+  }
+}
+
+GBytes *
+dlb_dap_json_config_get_serialized (const dlb_dap_json_config * config,
+    gint sample_rate, gboolean virtualizer_enable)
+{
+  return g_hash_table_lookup (config->serialized,
+      SERIALIZED_KEY (sample_rate, virtualizer_enable));
+}
@@ -42,6 +42,29 @@ typedef struct dlb_dap_global_settings_s
   gchar  *profile;
 } dlb_dap_global_settings;
 
+typedef enum
+{
+  DLB_DAP_JSON_SECTION_GLOBAL      = (1 << 0),
+  DLB_DAP_JSON_SECTION_VIRTUALIZER = (1 << 1),
+  DLB_DAP_JSON_SECTION_GAINS       = (1 << 2),
+  DLB_DAP_JSON_SECTION_PROFILE     = (1 << 3),
+} DlbDapJsonSections;
+
+/* Complete content of json config file, including decoded serialized
+ * configs for every sample rate. Sections missing in the file are marked in
+ * sections field and keep library defaults. */
+typedef struct dlb_dap_json_config_s
+{
+  DlbDapJsonSections sections;
+
+  dlb_dap_global_settings global;
+  dlb_dap_virtualizer_settings virt;
+  dlb_dap_gain_settings gains;
+  dlb_dap_profile_settings profile;
+
+  GHashTable *serialized;
+} dlb_dap_json_config;
+
 GType    dlb_dap_global_settings_get_type      (void);
 
 GType    dlb_dap_virtualizer_settings_get_type (void);
@@ -62,4 +85,14 @@ guchar * dlb_dap_json_parse_serialized_config  (const gchar * filename,
                                                 gboolean virtualizer_enable,
                                                 GError **error);
 
+dlb_dap_json_config *
+         dlb_dap_json_config_load              (const gchar * filename,
+                                                GError **error);
+
+void     dlb_dap_json_config_free              (dlb_dap_json_config *config);
+
+GBytes * dlb_dap_json_config_get_serialized    (const dlb_dap_json_config *config,
+                                                gint sample_rate,
+                                                gboolean virtualizer_enable);
+
 #endif /* _DAP_DLBDAPJSON_H_ */
@@ -0,0 +1,146 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2020-2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "dlbparammailbox.h"
+
+/* state word: index of the middle buffer, fresh flag, pending groups */
+#define STATE_INDEX_MASK  0x3
+#define STATE_FRESH       0x4
+#define STATE_GROUPS_SHIFT 3
+
+struct _DlbParamMailbox
+{
+  gsize size;
+
+  /* serializes writers, never taken by the reader */
+  GMutex lock;
+  gpointer shadow;
+
+  /* owned by writer (back) and reader (front), exchanged through state */
+  gint back;
+  gint front;
+  gint state;
+
+  gpointer buffers[3];
+};
+
+DlbParamMailbox *
+dlb_param_mailbox_new (gsize size, gconstpointer initial)
+{
+  DlbParamMailbox *mailbox;
+
+  g_return_val_if_fail (size > 0, NULL);
+
+  mailbox = g_new0 (DlbParamMailbox, 1);
+  mailbox->size = size;
+  mailbox->shadow = g_malloc0 (size);
+  if (initial)
+    memcpy (mailbox->shadow, initial, size);
+
+  for (gint i = 0; i < 3; ++i) {
+    mailbox->buffers[i] = g_malloc (size);
+    memcpy (mailbox->buffers[i], mailbox->shadow, size);
+  }
+
+  mailbox->front = 0;
+  mailbox->state = 1;
+  mailbox->back = 2;
+
+  g_mutex_init (&mailbox->lock);
+
+  return mailbox;
+}
+
+void
+dlb_param_mailbox_free (DlbParamMailbox * mailbox)
+{
+  g_return_if_fail (mailbox != NULL);
+
+  for (gint i = 0; i < 3; ++i)
+    g_free (mailbox->buffers[i]);
+
+  g_free (mailbox->shadow);
+  g_mutex_clear (&mailbox->lock);
+  g_free (mailbox);
+}
+
+gpointer
+dlb_param_mailbox_lock (DlbParamMailbox * mailbox)
+{
+  g_return_val_if_fail (mailbox != NULL, NULL);
+
+  g_mutex_lock (&mailbox->lock);
+  return mailbox->shadow;
+}
+
+void
+dlb_param_mailbox_unlock (DlbParamMailbox * mailbox, guint groups)
+{
+  gint old, new;
+
+  g_return_if_fail (mailbox != NULL);
+
+  if (groups) {
+    memcpy (mailbox->buffers[mailbox->back], mailbox->shadow, mailbox->size);
+
+    do {
+      old = g_atomic_int_get (&mailbox->state);
+      new = mailbox->back | STATE_FRESH
+          | ((((guint) old >> STATE_GROUPS_SHIFT) | groups)
+          << STATE_GROUPS_SHIFT);
+    } while (!g_atomic_int_compare_and_exchange (&mailbox->state, old, new));
+
+    mailbox->back = old & STATE_INDEX_MASK;
+  }
+
+  g_mutex_unlock (&mailbox->lock);
+}
+
+gconstpointer
+dlb_param_mailbox_read (DlbParamMailbox * mailbox, guint * groups)
+{
+  gint old;
+
+  g_return_val_if_fail (mailbox != NULL, NULL);
+
+  do {
+    old = g_atomic_int_get (&mailbox->state);
+    if (!(old & STATE_FRESH)) {
+      if (groups)
+        *groups = 0;
+
+      return mailbox->buffers[mailbox->front];
+    }
+  } while (!g_atomic_int_compare_and_exchange (&mailbox->state, old,
+          mailbox->front));
+
+  mailbox->front = old & STATE_INDEX_MASK;
+
+  if (groups)
+    *groups = (guint) old >> STATE_GROUPS_SHIFT;
+
+  return mailbox->buffers[mailbox->front];
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2020-2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _GST_DLB_PARAM_MAILBOX_H_
+#define _GST_DLB_PARAM_MAILBOX_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _DlbParamMailbox DlbParamMailbox;
+
+/**
+ * dlb_param_mailbox_new:
+ * @size: size of the parameter structure in bytes
+ * @initial: (nullable): initial parameter values, zeroed if %NULL
+ *
+ * Creates triple buffered mailbox used to hand over parameter snapshots
+ * from application threads to a single streaming thread. Publishing never
+ * waits for the reader and reading never waits at all.
+ *
+ * returns: (transfer full): the #DlbParamMailbox that needs to be released
+ *              using #dlb_param_mailbox_free function
+ */
+DlbParamMailbox *
+dlb_param_mailbox_new (gsize size, gconstpointer initial);
+
+/**
+ * dlb_param_mailbox_free:
+ * @mailbox: the #DlbParamMailbox pointer
+ *
+ * Releases the mailbox.
+ */
+void
+dlb_param_mailbox_free (DlbParamMailbox * mailbox);
+
+/**
+ * dlb_param_mailbox_lock:
+ * @mailbox: the #DlbParamMailbox pointer
+ *
+ * Starts writer transaction. Writers are serialized against each other
+ * only, streaming thread is never blocked by them.
+ *
+ * returns: (transfer none): writer copy holding most recent values, valid
+ *              until #dlb_param_mailbox_unlock
+ */
+gpointer
+dlb_param_mailbox_lock (DlbParamMailbox * mailbox);
+
+/**
+ * dlb_param_mailbox_unlock:
+ * @mailbox: the #DlbParamMailbox pointer
+ * @groups: bit mask of parameter groups modified in the transaction
+ *
+ * Ends writer transaction. Snapshot of the writer copy is published when
+ * @groups is non-zero. Groups of snapshots not yet read are accumulated.
+ */
+void
+dlb_param_mailbox_unlock (DlbParamMailbox * mailbox, guint groups);
+
+/**
+ * dlb_param_mailbox_read:
+ * @mailbox: the #DlbParamMailbox pointer
+ * @groups: (out) (optional): groups changed since previous read
+ *
+ * Picks up most recently published snapshot, if any. Never blocks, so it is
+ * safe to call at each processing block boundary. Must be called from one
+ * thread at a time.
+ *
+ * returns: (transfer none): current snapshot, valid until next read
+ */
+gconstpointer
+dlb_param_mailbox_read (DlbParamMailbox * mailbox, guint * groups);
+
+G_END_DECLS
+
+#endif /* _GST_DLB_PARAM_MAILBOX_H_ */
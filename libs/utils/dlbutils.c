@@ -22,6 +22,9 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+#include <string.h>
+
 #include "dlbutils.h"
 
 /**
@@ -102,6 +105,11 @@ dlb_buffer_data_size (int data_type)
       return sizeof (float);
     case DLB_BUFFER_DOUBLE:
       return sizeof (double);
+    case DLB_BUFFER_LFRACT:
+      if (dlb_audio_lfract_container () == GST_AUDIO_FORMAT_UNKNOWN)
+        return 0;
+      return GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info
+          (dlb_audio_lfract_container ())) / 8;
     default:
       return 0;
   }
@@ -254,3 +262,251 @@ dlb_get_reorder_map (const GstAudioChannelPosition * orig,
     }
   }
 }
+
+gboolean
+dlb_audio_channel_positions_to_dlb_order (const GstAudioChannelPosition *
+    positions, gint channels, GstAudioChannelPosition * dlb_positions)
+{
+  guint64 chmask = 0;
+
+  gst_audio_channel_positions_to_mask (positions, channels, TRUE, &chmask);
+
+  if (!chmask) {
+    memcpy (dlb_positions, positions, channels * sizeof (*positions));
+    return TRUE;
+  }
+
+  return dlb_channel_positions_from_channel_mask (channels, chmask,
+      dlb_positions);
+}
+
+/* NaN is never considered silent */
+#define DLB_SILENT_LOOP(type, limit)                                          \
+  G_STMT_START {                                                              \
+    const type *p = (const type *) data;                                      \
+    for (i = 0; i < n; ++i) {                                                 \
+      if (!(ABS (p[i]) <= (limit)))                                           \
+        return FALSE;                                                         \
+    }                                                                         \
+  } G_STMT_END
+
+gboolean
+dlb_audio_is_silent (const guint8 * data, gsize samples,
+    const GstAudioInfo * info, gdouble threshold)
+{
+  gsize i, n = samples * GST_AUDIO_INFO_CHANNELS (info);
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_F32:
+      DLB_SILENT_LOOP (gfloat, (gfloat) threshold);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      DLB_SILENT_LOOP (gdouble, threshold);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      DLB_SILENT_LOOP (gint32, (gint64) (threshold * G_MAXINT32));
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      DLB_SILENT_LOOP (gint16, (gint32) (threshold * G_MAXINT16));
+      break;
+    default:
+      n = samples * GST_AUDIO_INFO_BPF (info);
+      for (i = 0; i < n; ++i) {
+        if (data[i])
+          return FALSE;
+      }
+      break;
+  }
+
+  return TRUE;
+}
+
+gfloat *
+dlb_audio_crossfade_ramp_new (gsize len)
+{
+  gfloat *ramp = g_new (gfloat, len + 1);
+  gsize i;
+
+  for (i = 0; i < len; ++i)
+    ramp[i] = cos ((gdouble) i / len * G_PI_2);
+
+  ramp[len] = 0.0f;
+  return ramp;
+}
+
+/* gain fading in at position i is the one fading out at len - i */
+#define DLB_CROSSFADE_LOOP(type, lo, hi)                                      \
+  G_STMT_START {                                                              \
+    type *d = (type *) dst;                                                   \
+    const type *s = (const type *) src;                                       \
+    for (i = 0; i < samples; ++i) {                                           \
+      gsize k = MIN (pos + i, len);                                           \
+      gfloat gout = ramp[k];                                                  \
+      gfloat gin = ramp[len - k];                                             \
+      for (c = 0; c < channels; ++c, ++d, ++s) {                              \
+        gdouble v = gout * *d + gin * *s;                                     \
+        *d = (type) CLAMP (v, lo, hi);                                        \
+      }                                                                       \
+    }                                                                         \
+  } G_STMT_END
+
+void
+dlb_audio_crossfade (guint8 * dst, const guint8 * src, gsize samples,
+    const GstAudioInfo * info, const gfloat * ramp, gsize pos, gsize len)
+{
+  gint c, channels = GST_AUDIO_INFO_CHANNELS (info);
+  gsize i;
+
+  if (pos >= len) {
+    memcpy (dst, src, samples * GST_AUDIO_INFO_BPF (info));
+    return;
+  }
+
+  switch (GST_AUDIO_INFO_FORMAT (info)) {
+    case GST_AUDIO_FORMAT_F32:
+      DLB_CROSSFADE_LOOP (gfloat, -G_MAXFLOAT, G_MAXFLOAT);
+      break;
+    case GST_AUDIO_FORMAT_F64:
+      DLB_CROSSFADE_LOOP (gdouble, -G_MAXDOUBLE, G_MAXDOUBLE);
+      break;
+    case GST_AUDIO_FORMAT_S32:
+      DLB_CROSSFADE_LOOP (gint32, G_MININT32, G_MAXINT32);
+      break;
+    case GST_AUDIO_FORMAT_S16:
+      DLB_CROSSFADE_LOOP (gint16, G_MININT16, G_MAXINT16);
+      break;
+    default:
+      g_return_if_reached ();
+  }
+}
+
+GstAudioFormat
+dlb_audio_lfract_container (void)
+{
+#if DLB_LFRACT_SIZE == 2
+  return GST_AUDIO_FORMAT_S16;
+#elif DLB_LFRACT_SIZE == 4
+  return GST_AUDIO_FORMAT_F32;
+#elif DLB_LFRACT_SIZE == 8
+  return GST_AUDIO_FORMAT_F64;
+#else
+  return GST_AUDIO_FORMAT_UNKNOWN;
+#endif
+}
+
+GstCaps *
+dlb_audio_caps_to_lfract (const GstCaps * caps)
+{
+  GstCaps *res = gst_caps_new_empty ();
+  GstCapsFeatures *features;
+  GstStructure *s;
+  guint i;
+
+  if (dlb_audio_lfract_container () == GST_AUDIO_FORMAT_UNKNOWN)
+    return res;
+
+  for (i = 0; i < gst_caps_get_size (caps); ++i) {
+    s = gst_caps_get_structure (caps, i);
+    features = gst_caps_get_features (caps, i);
+
+    if (!gst_structure_has_name (s, "audio/x-raw"))
+      continue;
+
+    s = gst_structure_copy (s);
+    gst_structure_set_name (s, DLB_AUDIO_LFRACT_CAPS_NAME);
+    gst_structure_remove_field (s, "format");
+
+    gst_caps_append_structure_full (res, s,
+        features ? gst_caps_features_copy (features) : NULL);
+  }
+
+  return res;
+}
+
+GstCaps *
+dlb_audio_caps_from_lfract (const GstCaps * caps)
+{
+  GstCaps *res = gst_caps_new_empty ();
+  GstCapsFeatures *features;
+  GstStructure *s;
+  guint i;
+
+  for (i = 0; i < gst_caps_get_size (caps); ++i) {
+    s = gst_structure_copy (gst_caps_get_structure (caps, i));
+    features = gst_caps_get_features (caps, i);
+
+    if (gst_structure_has_name (s, DLB_AUDIO_LFRACT_CAPS_NAME)) {
+      gst_structure_set_name (s, "audio/x-raw");
+      gst_structure_set (s, "format", G_TYPE_STRING,
+          gst_audio_format_to_string (dlb_audio_lfract_container ()), NULL);
+    }
+
+    gst_caps_append_structure_full (res, s,
+        features ? gst_caps_features_copy (features) : NULL);
+  }
+
+  return res;
+}
+
+gboolean
+dlb_audio_info_from_caps (GstAudioInfo * info, const GstCaps * caps,
+    gboolean * lfract)
+{
+  GstStructure *s;
+  GstCaps *raw;
+  gboolean ret;
+
+  if (!(s = gst_caps_get_structure (caps, 0)))
+    return FALSE;
+
+  *lfract = gst_structure_has_name (s, DLB_AUDIO_LFRACT_CAPS_NAME);
+  if (!*lfract)
+    return gst_audio_info_from_caps (info, caps);
+
+  if (dlb_audio_lfract_container () == GST_AUDIO_FORMAT_UNKNOWN)
+    return FALSE;
+
+  raw = dlb_audio_caps_from_lfract (caps);
+  ret = gst_audio_info_from_caps (info, raw);
+  gst_caps_unref (raw);
+
+  return ret;
+}
+
+void
+dlb_shim_stats_append (GstStructure * stats, DlbShimStatsQuery query)
+{
+  unsigned long long calls, total_ns, buckets[DLB_SHIM_STATS_BUCKETS];
+  const gchar *name;
+  gint index, used, i;
+
+  for (index = 0; !query (index, &name, &calls, &total_ns, buckets,
+          DLB_SHIM_STATS_BUCKETS); ++index) {
+    GValue histogram = G_VALUE_INIT;
+    GstStructure *call;
+
+    if (!calls)
+      continue;
+
+    used = DLB_SHIM_STATS_BUCKETS;
+    while (used > 0 && !buckets[used - 1])
+      --used;
+
+    g_value_init (&histogram, GST_TYPE_ARRAY);
+    for (i = 0; i < used; ++i) {
+      GValue bucket = G_VALUE_INIT;
+
+      g_value_init (&bucket, G_TYPE_UINT64);
+      g_value_set_uint64 (&bucket, buckets[i]);
+      gst_value_array_append_and_take_value (&histogram, &bucket);
+    }
+
+    call = gst_structure_new ("dlb-shim-call",
+        "calls", G_TYPE_UINT64, (guint64) calls,
+        "total-ns", G_TYPE_UINT64, (guint64) total_ns, NULL);
+    gst_structure_take_value (call, "histogram", &histogram);
+
+    gst_structure_set (stats, name, GST_TYPE_STRUCTURE, call, NULL);
+    gst_structure_free (call);
+  }
+}
@@ -57,6 +57,11 @@ G_BEGIN_DECLS
    GST_AUDIO_CHANNEL_POSITION_MASK(TOP_REAR_LEFT) |                            \
    GST_AUDIO_CHANNEL_POSITION_MASK(TOP_REAR_RIGHT))
 
+/* samples in the library native fractional format, only exchanged between
+ * Dolby elements. Structures carry the audio/x-raw fields except format,
+ * samples are stored in containers of dlb_audio_lfract_container() size */
+#define DLB_AUDIO_LFRACT_CAPS_NAME "audio/x-dlb-lfract"
+
 /**
  * dlb_buffer_new:
  * @info: the #GstAudioInfo structure describing how the #dlb_buffer
@@ -140,6 +145,158 @@ void
 dlb_get_reorder_map (const GstAudioChannelPosition * orig,
     const GstAudioChannelPosition * reordered, guint channels, guint * map);
 
+/**
+ * dlb_audio_channel_positions_to_dlb_order:
+ * @positions: channel positions of the stream
+ * @channels: number of channels
+ * @dlb_positions: (out caller-allocates) (array fixed-size=64): the same
+ *          channels in Dolby order
+ *
+ * Gives the channel layout #dlb_buffer_new_wrapped maps a stream to when
+ * it forces Dolby order. Unpositioned channels are left untouched.
+ *
+ * returns: %FALSE if @positions contain channels not supported by Dolby
+ */
+gboolean
+dlb_audio_channel_positions_to_dlb_order (const GstAudioChannelPosition *
+    positions, gint channels, GstAudioChannelPosition * dlb_positions);
+
+/**
+ * dlb_audio_is_silent:
+ * @data: interleaved samples
+ * @samples: number of samples per channel
+ * @info: the #GstAudioInfo describing @data
+ * @threshold: peak amplitude, relative to full scale, at or below which
+ *          samples are considered silent. 0 accepts digital silence only
+ *
+ * Checks whether all samples of all channels stay within @threshold.
+ *
+ * returns: %TRUE if @data is silent
+ */
+gboolean
+dlb_audio_is_silent (const guint8 * data, gsize samples,
+    const GstAudioInfo * info, gdouble threshold);
+
+/**
+ * dlb_audio_crossfade_ramp_new:
+ * @len: crossfade length in samples
+ *
+ * Computes the equal-power fade out gains of a crossfade, @len + 1 entries
+ * going from 1 to 0.
+ *
+ * returns: (transfer full): the gain table, free with g_free()
+ */
+gfloat *
+dlb_audio_crossfade_ramp_new (gsize len);
+
+/**
+ * dlb_audio_crossfade:
+ * @dst: interleaved samples fading out, replaced by the mix
+ * @src: interleaved samples fading in
+ * @samples: number of samples per channel
+ * @info: the #GstAudioInfo describing @dst and @src
+ * @ramp: gain table from dlb_audio_crossfade_ramp_new() for @len
+ * @pos: position of the first sample within the crossfade
+ * @len: crossfade length in samples
+ *
+ * Mixes @src into @dst with equal-power gains. Samples at or past @len
+ * are taken from @src only.
+ */
+void
+dlb_audio_crossfade (guint8 * dst, const guint8 * src, gsize samples,
+    const GstAudioInfo * info, const gfloat * ramp, gsize pos, gsize len);
+
+/**
+ * dlb_audio_lfract_container:
+ *
+ * The library does not tell the size of its native samples, it is given at
+ * build time by the lfract_size option.
+ *
+ * returns: the PCM format of that size holding native samples, or
+ *     %GST_AUDIO_FORMAT_UNKNOWN if the size is not known and the native
+ *     format must not be negotiated
+ */
+GstAudioFormat
+dlb_audio_lfract_container (void);
+
+/**
+ * dlb_audio_caps_to_lfract:
+ * @caps: audio/x-raw caps
+ *
+ * Gives the native format variant of each audio/x-raw structure in @caps,
+ * features are kept. Other structures are dropped. Caps are empty if
+ * the native sample size is not known.
+ *
+ * returns: (transfer full): the new #GstCaps
+ */
+GstCaps *
+dlb_audio_caps_to_lfract (const GstCaps * caps);
+
+/**
+ * dlb_audio_caps_from_lfract:
+ * @caps: caps that may contain native format structures
+ *
+ * Replaces native format structures in @caps with audio/x-raw structures of
+ * the container format, so they can be parsed as #GstAudioInfo. Other
+ * structures are copied unchanged.
+ *
+ * returns: (transfer full): the new #GstCaps
+ */
+GstCaps *
+dlb_audio_caps_from_lfract (const GstCaps * caps);
+
+/**
+ * dlb_audio_info_from_caps:
+ * @info: (out caller-allocates): the #GstAudioInfo to fill
+ * @caps: fixed audio/x-raw or native format caps
+ * @lfract: (out): whether @caps describe the native format
+ *
+ * Parses @caps like gst_audio_info_from_caps(). Native format is described
+ * by its container format and refused if that is not known.
+ *
+ * returns: %TRUE if @caps could be parsed
+ */
+gboolean
+dlb_audio_info_from_caps (GstAudioInfo * info, const GstCaps * caps,
+    gboolean * lfract);
+
+/* latency buckets of the shim layer call statistics */
+#define DLB_SHIM_STATS_BUCKETS 32
+
+/**
+ * DlbShimStatsQuery:
+ * @index: function index, starting at 0
+ * @name: (out): function name
+ * @calls: (out): number of calls
+ * @total_ns: (out): time spent in the calls
+ * @buckets: (out caller-allocates): latency histogram, bucket i counts calls
+ *          of [2^i, 2^(i+1)) ns
+ * @nbuckets: size of @buckets
+ *
+ * Call statistics of a library bound by the shim layer, such as
+ * dlb_dap_query_stats().
+ *
+ * returns: 0 on success, non-zero past the last function or while the
+ *          statistics are disabled
+ */
+typedef gint (*DlbShimStatsQuery) (gint index, const gchar ** name,
+    unsigned long long *calls, unsigned long long *total_ns,
+    unsigned long long *buckets, gint nbuckets);
+
+/**
+ * dlb_shim_stats_append:
+ * @stats: the #GstStructure to add the statistics to
+ * @query: statistics query of a library
+ *
+ * Adds a "dlb-shim-call" structure field, named after the function, for each
+ * library function called at least once. It holds the "calls" and
+ * "total-ns" counters as well as the "histogram" array, up to the last
+ * non-empty bucket. Statistics are collected while the DLB_SHIM_STATS
+ * environment variable is set.
+ */
+void
+dlb_shim_stats_append (GstStructure * stats, DlbShimStatsQuery query);
+
 G_END_DECLS
 
 #endif /* _GST_DLB_UTILS_H_ */
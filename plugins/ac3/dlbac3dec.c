@@ -33,6 +33,13 @@ GST_DEBUG_CATEGORY_STATIC (dlb_ac3dec_debug_category);
 
 #define CHMASK(mask) (DLB_UDC_CHANNEL_MASK (mask))
 
+/* groups of settings published to the streaming thread */
+enum
+{
+  DLB_AC3DEC_PARAMS_STATIC = 1 << 0,
+  DLB_AC3DEC_PARAMS_DYNAMIC = 1 << 1,
+};
+
 /* public prototypes */
 static void dlb_ac3dec_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
@@ -40,6 +47,8 @@ static void dlb_ac3dec_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
 static void dlb_ac3dec_dispose (GObject * object);
 static void dlb_ac3dec_finalize (GObject * object);
+static GstStateChangeReturn dlb_ac3dec_change_state (GstElement * element,
+    GstStateChange transition);
 static gboolean dlb_ac3dec_start (GstAudioDecoder * decoder);
 static gboolean dlb_ac3dec_stop (GstAudioDecoder * decoder);
 static gboolean dlb_ac3dec_set_format (GstAudioDecoder * decoder,
@@ -54,6 +63,7 @@ static gboolean renegotiate (DlbAc3Dec * decoder,
     const dlb_udc_audio_info * info);
 static gboolean update_static_params (DlbAc3Dec * decoder);
 static gboolean update_dynamic_params (DlbAc3Dec * decoder);
+static gboolean update_params (DlbAc3Dec * decoder);
 static void evaluate_output_sample_format (DlbAc3Dec * decoder);
 static void convert_dlb_udc_channel_mask_to_gst_pos (gint channel_mask,
     gint channels, GstAudioChannelPosition * pos, gboolean force_order);
@@ -67,6 +77,7 @@ enum
   PROP_DRC_CUT,
   PROP_DRC_BOOST,
   PROP_DMX_ENABLE,
+  PROP_STATS,
 };
 
 #define DLB_AC3DEC_SRC_CAPS                                             \
@@ -82,6 +93,15 @@ enum
     "channels = (int) [ 1, 16 ], "                                      \
     "rate = (int) { 32000, 44100, 48000 }, "                            \
     "layout = (string) { interleaved}; "                                \
+  DLB_AUDIO_LFRACT_CAPS_NAME ", "                                       \
+    "channels = (int) [ 1, 16 ], "                                      \
+    "rate = (int) { 32000, 44100, 48000 }, "                            \
+    "layout = (string) { interleaved}; "                                \
+  DLB_AUDIO_LFRACT_CAPS_NAME                                            \
+    "(" DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META "),  "                  \
+    "channels = (int) [ 1, 16 ], "                                      \
+    "rate = (int) { 32000, 44100, 48000 }, "                            \
+    "layout = (string) { interleaved}; "                                \
 
 #define DLB_AC3DEC_SINK_CAPS                                            \
   "audio/x-ac3, "                                                       \
@@ -120,6 +140,8 @@ dlb_ac3dec_class_init (DlbAc3DecClass * klass)
   gobject_class->get_property = dlb_ac3dec_get_property;
   gobject_class->dispose = dlb_ac3dec_dispose;
   gobject_class->finalize = dlb_ac3dec_finalize;
+  GST_ELEMENT_CLASS (klass)->change_state =
+      GST_DEBUG_FUNCPTR (dlb_ac3dec_change_state);
   audio_decoder_class->start = GST_DEBUG_FUNCPTR (dlb_ac3dec_start);
   audio_decoder_class->stop = GST_DEBUG_FUNCPTR (dlb_ac3dec_stop);
   audio_decoder_class->set_format = GST_DEBUG_FUNCPTR (dlb_ac3dec_set_format);
@@ -146,6 +168,11 @@ dlb_ac3dec_class_init (DlbAc3DecClass * klass)
   g_object_class_override_property (gobject_class, PROP_DRC_BOOST, "drc-boost");
   g_object_class_override_property (gobject_class, PROP_DMX_ENABLE, "dmx-enable");
 
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Library call statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gst_tag_register ("object-audio", GST_TAG_FLAG_META,
       G_TYPE_BOOLEAN, "object-audio tag",
       "a tag that indicates if object audio is present", NULL);
@@ -154,15 +181,20 @@ dlb_ac3dec_class_init (DlbAc3DecClass * klass)
 static void
 dlb_ac3dec_init (DlbAc3Dec * ac3dec)
 {
-  ac3dec->outmode = DLB_AUDIO_DECODER_OUT_MODE_RAW;
+  DlbAc3DecParams params;
+
+  params.outmode = DLB_AUDIO_DECODER_OUT_MODE_RAW;
+  params.drc_mode = DLB_AUDIO_DECODER_DRC_MODE_DEFAULT;
+  params.dmx_enable = TRUE;
+  dlb_udc_drc_settings_init (&params.drc);
+
+  ac3dec->params = dlb_param_mailbox_new (sizeof (params), &params);
+  ac3dec->applied = dlb_param_mailbox_read (ac3dec->params, NULL);
+
   ac3dec->output_format = GST_AUDIO_FORMAT_F32LE;
-  ac3dec->drc_mode = DLB_AUDIO_DECODER_DRC_MODE_DEFAULT;
   ac3dec->bps = 4;
   ac3dec->metadata_buffer = g_malloc (DLB_UDC_MAX_MD_SIZE);
   ac3dec->tags = gst_tag_list_new_empty ();
-  ac3dec->dmx_enable = TRUE;
-
-  dlb_udc_drc_settings_init (&ac3dec->drc);
 
   gst_audio_decoder_set_needs_format (GST_AUDIO_DECODER (ac3dec), TRUE);
   gst_audio_decoder_set_estimate_rate (GST_AUDIO_DECODER (ac3dec), TRUE);
@@ -177,43 +209,39 @@ dlb_ac3dec_set_property (GObject * object, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
   DlbAc3Dec *ac3dec = DLB_AC3DEC (object);
-  gboolean update_static = FALSE, update_dynamic = FALSE;
+  DlbAc3DecParams *params;
+  guint groups = 0;
 
-  GST_OBJECT_LOCK (ac3dec);
+  /* decoder is reconfigured by the streaming thread at frame boundary */
+  params = dlb_param_mailbox_lock (ac3dec->params);
 
   switch (property_id) {
     case PROP_OUT_MODE:
-      ac3dec->outmode = g_value_get_enum (value);
-      update_static = TRUE;
+      params->outmode = g_value_get_enum (value);
+      groups = DLB_AC3DEC_PARAMS_STATIC;
       break;
     case PROP_DRC_MODE:
-      ac3dec->drc_mode = g_value_get_enum (value);
-      update_dynamic = TRUE;
+      params->drc_mode = g_value_get_enum (value);
+      groups = DLB_AC3DEC_PARAMS_DYNAMIC;
       break;
     case PROP_DRC_CUT:
-      ac3dec->drc.cut = g_value_get_double (value);
-      update_dynamic = TRUE;
+      params->drc.cut = g_value_get_double (value);
+      groups = DLB_AC3DEC_PARAMS_DYNAMIC;
       break;
     case PROP_DRC_BOOST:
-      ac3dec->drc.boost = g_value_get_double (value);
-      update_dynamic = TRUE;
+      params->drc.boost = g_value_get_double (value);
+      groups = DLB_AC3DEC_PARAMS_DYNAMIC;
       break;
     case PROP_DMX_ENABLE:
-      ac3dec->dmx_enable = g_value_get_boolean (value);
-      update_static = TRUE;
+      params->dmx_enable = g_value_get_boolean (value);
+      groups = DLB_AC3DEC_PARAMS_STATIC;
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
   }
 
-  if (update_static && ac3dec->udc)
-    update_static_params (ac3dec);
-
-  if (update_dynamic && ac3dec->udc)
-    update_dynamic_params (ac3dec);
-
-  GST_OBJECT_UNLOCK (ac3dec);
+  dlb_param_mailbox_unlock (ac3dec->params, groups);
 }
 
 static void
@@ -221,33 +249,42 @@ dlb_ac3dec_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec)
 {
   DlbAc3Dec *ac3dec = DLB_AC3DEC (object);
+  DlbAc3DecParams *params;
+  GstStructure *stats;
 
   GST_DEBUG_OBJECT (ac3dec, "get_property");
 
-  GST_OBJECT_LOCK (ac3dec);
+  params = dlb_param_mailbox_lock (ac3dec->params);
 
   switch (property_id) {
     case PROP_OUT_MODE:
-      g_value_set_enum (value, ac3dec->outmode);
+      g_value_set_enum (value, params->outmode);
       break;
     case PROP_DRC_MODE:
-      g_value_set_enum (value, ac3dec->drc_mode);
+      g_value_set_enum (value, params->drc_mode);
       break;
     case PROP_DRC_CUT:
-      g_value_set_double (value, ac3dec->drc.cut);
+      g_value_set_double (value, params->drc.cut);
       break;
     case PROP_DRC_BOOST:
-      g_value_set_double (value, ac3dec->drc.boost);
+      g_value_set_double (value, params->drc.boost);
       break;
     case PROP_DMX_ENABLE:
-      g_value_set_boolean (value, ac3dec->dmx_enable);
+      g_value_set_boolean (value, params->dmx_enable);
+      break;
+    case PROP_STATS:
+      stats = gst_structure_new_empty ("dlbac3dec-stats");
+#ifdef DLB_UDC_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_udc_query_stats);
+#endif
+      g_value_take_boxed (value, stats);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
   }
 
-  GST_OBJECT_UNLOCK (ac3dec);
+  dlb_param_mailbox_unlock (ac3dec->params, 0);
 }
 
 static void
@@ -267,6 +304,7 @@ dlb_ac3dec_finalize (GObject * object)
   ac3dec->metadata_buffer = NULL;
 
   gst_tag_list_unref (ac3dec->tags);
+  dlb_param_mailbox_free (ac3dec->params);
 
   G_OBJECT_CLASS (dlb_ac3dec_parent_class)->finalize (object);
 }
@@ -403,6 +441,9 @@ dlb_ac3dec_start (GstAudioDecoder * decoder)
       g_assert_not_reached ();
   }
 
+  if (ac3dec->lfract)
+    data_type = DLB_BUFFER_LFRACT;
+
   memset (&ac3dec->info, 0, sizeof (ac3dec->info));
   memset (&ac3dec->gstpos, 0, sizeof (ac3dec->gstpos));
   memset (&ac3dec->dlbpos, 0, sizeof (ac3dec->dlbpos));
@@ -413,8 +454,11 @@ dlb_ac3dec_start (GstAudioDecoder * decoder)
   ac3dec->alloc_params = gst_allocation_params_copy (&alloc_params);
   ac3dec->alloc_params->align = DLB_UDC_OUTBUF_MEMORY_ALIGNMENT - 1;
 
-  init_info.outmode = get_udc_output_mode (ac3dec->outmode);
-  init_info.dmx_enable = ac3dec->dmx_enable;
+  /* new instance is configured with all the latest settings */
+  ac3dec->applied = dlb_param_mailbox_read (ac3dec->params, NULL);
+
+  init_info.outmode = get_udc_output_mode (ac3dec->applied->outmode);
+  init_info.dmx_enable = ac3dec->applied->dmx_enable;
 
   ac3dec->udc = dlb_udc_new (&init_info);
   if (!ac3dec->udc)
@@ -432,6 +476,8 @@ dlb_ac3dec_start (GstAudioDecoder * decoder)
   if (!ac3dec->outbuf)
     goto buf_error;
 
+  ac3dec->outbuf->data_type = data_type;
+
   update_dynamic_params (ac3dec);
   return TRUE;
 
@@ -506,6 +552,9 @@ dlb_ac3dec_handle_frame (GstAudioDecoder * decoder, GstBuffer * inbuf)
     return GST_FLOW_OK;
   }
 
+  if (G_UNLIKELY (!update_params (ac3dec)))
+    return GST_FLOW_ERROR;
+
   /* calculate available input data size */
   GST_LOG_OBJECT (decoder, "handling input buffer %" GST_PTR_FORMAT, inbuf);
   gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
@@ -683,6 +732,13 @@ renegotiate (DlbAc3Dec * ac3dec, const dlb_udc_audio_info * info)
 
   caps = gst_audio_info_to_caps (&audio_info);
 
+  if (ac3dec->lfract) {
+    GstCaps *lfract = dlb_audio_caps_to_lfract (caps);
+
+    gst_caps_unref (caps);
+    caps = lfract;
+  }
+
   if (info->object_audio) {
     features =
         gst_caps_features_from_string (DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META);
@@ -727,6 +783,7 @@ update_static_params (DlbAc3Dec * ac3dec)
 static gboolean
 update_dynamic_params (DlbAc3Dec * ac3dec)
 {
+  const DlbAc3DecParams *params = ac3dec->applied;
   dlb_udc_drc_settings drc;
 
   if (!ac3dec->udc) {
@@ -734,12 +791,12 @@ update_dynamic_params (DlbAc3Dec * ac3dec)
     return FALSE;
   }
 
-  if (DLB_AUDIO_DECODER_DRC_MODE_DISABLE == ac3dec->drc_mode) {
+  if (DLB_AUDIO_DECODER_DRC_MODE_DISABLE == params->drc_mode) {
     drc.cut = 0;
     drc.boost = 0;
   } else {
-    drc.cut = ac3dec->drc.cut;
-    drc.boost = ac3dec->drc.boost;
+    drc.cut = params->drc.cut;
+    drc.boost = params->drc.boost;
   }
 
   GST_DEBUG_OBJECT (ac3dec, "Dynamic settings: drc_boost %.2f, drc_cut %.2f",
@@ -753,11 +810,30 @@ update_dynamic_params (DlbAc3Dec * ac3dec)
   return TRUE;
 }
 
+/* picks up settings published since last frame, never blocks */
+static gboolean
+update_params (DlbAc3Dec * ac3dec)
+{
+  guint groups;
+
+  ac3dec->applied = dlb_param_mailbox_read (ac3dec->params, &groups);
+
+  if (G_LIKELY (!groups))
+    return TRUE;
+
+  /* restart applies dynamic settings as well */
+  if (groups & DLB_AC3DEC_PARAMS_STATIC)
+    return update_static_params (ac3dec);
+
+  update_dynamic_params (ac3dec);
+  return TRUE;
+}
+
 void
 evaluate_output_sample_format (DlbAc3Dec * ac3dec)
 {
   GstCaps *filter_all, *filter_f32, *filter_f64, *filter_s32, *filter_s16;
-  GstCaps *down_caps;
+  GstCaps *filter_lfract, *down_caps;
 
   filter_all =
       gst_caps_from_string ("audio/x-raw,format = (string) {" GST_AUDIO_NE (F32)
@@ -777,6 +853,18 @@ evaluate_output_sample_format (DlbAc3Dec * ac3dec)
       gst_caps_from_string ("audio/x-raw,format=(string) " GST_AUDIO_NE (S16)
       "");
 
+  filter_lfract = gst_caps_new_empty_simple (DLB_AUDIO_LFRACT_CAPS_NAME);
+
+  /* Dolby elements downstream take the native format directly. It is only
+   * picked when they list it and its sample size is known, including for
+   * channel based output, anything accepting ANY caps gets PCM */
+  down_caps = gst_pad_peer_query_caps (GST_AUDIO_DECODER_SRC_PAD (ac3dec),
+      NULL);
+  ac3dec->lfract = down_caps && !gst_caps_is_any (down_caps)
+      && gst_caps_can_intersect (down_caps, filter_lfract)
+      && dlb_audio_lfract_container () != GST_AUDIO_FORMAT_UNKNOWN;
+  gst_caps_replace (&down_caps, NULL);
+
   down_caps =
       gst_pad_peer_query_caps (GST_AUDIO_DECODER_SRC_PAD (ac3dec), filter_all);
 
@@ -784,7 +872,11 @@ evaluate_output_sample_format (DlbAc3Dec * ac3dec)
   ac3dec->output_format = GST_AUDIO_FORMAT_F32;
   ac3dec->bps = 4;
 
-  if (down_caps) {
+  if (ac3dec->lfract) {
+    ac3dec->output_format = dlb_audio_lfract_container ();
+    ac3dec->bps = GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info
+        (ac3dec->output_format)) / 8;
+  } else if (down_caps) {
     if (gst_caps_is_subset (down_caps, filter_f32)) {
       ac3dec->output_format = GST_AUDIO_FORMAT_F32;
       ac3dec->bps = 4;
@@ -798,24 +890,38 @@ evaluate_output_sample_format (DlbAc3Dec * ac3dec)
       ac3dec->output_format = GST_AUDIO_FORMAT_S16;
       ac3dec->bps = 2;
     }
-    gst_caps_unref (down_caps);
   }
 
+  gst_caps_replace (&down_caps, NULL);
+
   gst_caps_unref (filter_all);
   gst_caps_unref (filter_f32);
   gst_caps_unref (filter_f64);
   gst_caps_unref (filter_s32);
   gst_caps_unref (filter_s16);
+  gst_caps_unref (filter_lfract);
 }
 
-static gboolean
-plugin_init (GstPlugin * plugin)
+static GstStateChangeReturn
+dlb_ac3dec_change_state (GstElement * element, GstStateChange transition)
 {
 #ifdef DLB_UDC_OPEN_DYNLIB
-  if (dlb_udc_try_open_dynlib ())
-    return FALSE;
+  /* vendor library is bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY
+      && dlb_udc_try_open_dynlib ()) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load UDC library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
 #endif
 
+  return GST_ELEMENT_CLASS (dlb_ac3dec_parent_class)->change_state (element,
+      transition);
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
   GST_DEBUG_CATEGORY_INIT (dlb_ac3dec_debug_category, "dlbac3dec", 0,
       "debug category for AC3 decoder element");
 
@@ -23,6 +23,7 @@
 
 #include "dlbutils.h"
 #include "dlbaudiodecoder.h"
+#include "dlbparammailbox.h"
 
 #include "dlb_udc.h"
 
@@ -34,6 +35,19 @@ G_BEGIN_DECLS
 #define DLB_IS_AC3DEC_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),DLB_TYPE_AC3DEC))
 typedef struct _DlbAc3Dec DlbAc3Dec;
 typedef struct _DlbAc3DecClass DlbAc3DecClass;
+typedef struct _DlbAc3DecParams DlbAc3DecParams;
+
+/* settings exchanged through the parameter mailbox */
+struct _DlbAc3DecParams
+{
+  /* static params */
+  DlbAudioDecoderOutMode outmode;
+  gboolean dmx_enable;
+
+  /* dynamic params */
+  gint drc_mode;
+  dlb_udc_drc_settings drc;
+};
 
 struct _DlbAc3Dec
 {
@@ -65,15 +79,13 @@ struct _DlbAc3Dec
 
   /* target layout (depends on downstream source pad peer Caps) */
   GstAudioFormat output_format;
+  /* samples are handed over in the library native format */
+  gboolean lfract;
 
-  /* static params */
-  DlbAudioDecoderOutMode outmode;
-
-  /* dynamic params */
-  gint drc_mode;
-  dlb_udc_drc_settings drc;
-
-  gboolean dmx_enable;
+  /* published by property setters, picked up at frame boundary */
+  DlbParamMailbox *params;
+  /* snapshot the decoder is configured with */
+  const DlbAc3DecParams *applied;
 };
 
 struct _DlbAc3DecClass
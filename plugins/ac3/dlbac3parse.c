@@ -34,6 +34,8 @@ GST_DEBUG_CATEGORY_STATIC (dlb_ac3_parse_debug_category);
 
 
 /* prototypes */
+static GstStateChangeReturn dlb_ac3_parse_change_state (GstElement * element,
+    GstStateChange transition);
 static gboolean dlb_ac3_parse_start (GstBaseParse * parse);
 static gboolean dlb_ac3_parse_stop (GstBaseParse * parse);
 static GstFlowReturn dlb_ac3_parse_handle_frame (GstBaseParse * parse,
@@ -88,6 +90,8 @@ dlb_ac3_parse_class_init (DlbAc3ParseClass * klass)
       "Parse AC-3 and E-AC-3 audio stream",
       "Dolby Support <support@dolby.com>");
 
+  GST_ELEMENT_CLASS (klass)->change_state =
+      GST_DEBUG_FUNCPTR (dlb_ac3_parse_change_state);
   base_parse_class->start = GST_DEBUG_FUNCPTR (dlb_ac3_parse_start);
   base_parse_class->stop = GST_DEBUG_FUNCPTR (dlb_ac3_parse_stop);
   base_parse_class->handle_frame =
@@ -257,14 +261,26 @@ dlb_ac3_parse_pre_push_frame (GstBaseParse * parse, GstBaseParseFrame * frame)
   return GST_FLOW_OK;
 }
 
+static GstStateChangeReturn
+dlb_ac3_parse_change_state (GstElement * element, GstStateChange transition)
+{
+#ifdef DLB_AUDIO_PARSER_OPEN_DYNLIB
+  /* vendor library is bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY
+      && dlb_audio_parser_try_open_dynlib ()) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load audio parser library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+#endif
+
+  return GST_ELEMENT_CLASS (dlb_ac3_parse_parent_class)->change_state (element,
+      transition);
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  #ifdef DLB_AUDIO_PARSER_OPEN_DYNLIB
-  if (dlb_audio_parser_try_open_dynlib())
-    return FALSE;
-  #endif
-
   return gst_element_register (plugin, "dlbac3parse", GST_RANK_PRIMARY + 2,
       DLB_TYPE_AC3_PARSE);
 }
@@ -18,15 +18,26 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  ******************************************************************************/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
+#ifdef __linux__
+#include <errno.h>
+#include <sched.h>
+#include <string.h>
+#endif
+
 #include <gst/gstchildproxy.h>
 #include <gst/gstvalue.h>
 #include <gst/pbutils/pbutils.h>
 
 #include "dlbaudiodecbin.h"
+#include "dlbchmix.h"
 #include "dlbaudiodecoder.h"
 #include "dlbaudiometa.h"
 #include "dlbutils.h"
@@ -75,8 +86,38 @@ enum
   PROP_DRC_CUT,
   PROP_DRC_BOOST,
   PROP_DMX_ENABLE,
+  PROP_INPUT_CAPS,
+  PROP_THREADING,
+  PROP_DECODER_AFFINITY,
+  PROP_RENDER_AFFINITY,
+  PROP_THREAD_PRIORITY,
 };
 
+#define DEFAULT_THREADING DLB_AUDIO_DEC_BIN_THREADING_SINGLE
+#define DEFAULT_THREAD_PRIORITY 0
+
+/* stage queues only absorb scheduling jitter, a few buffers are enough */
+#define STAGE_QUEUE_BUFFERS 4
+
+#define DLB_TYPE_AUDIO_DEC_BIN_THREADING (dlb_audio_dec_bin_threading_get_type())
+static GType
+dlb_audio_dec_bin_threading_get_type (void)
+{
+  static GType threading_type = 0;
+  static const GEnumValue threading_types[] = {
+    {DLB_AUDIO_DEC_BIN_THREADING_SINGLE, "Single", "single"},
+    {DLB_AUDIO_DEC_BIN_THREADING_PIPELINED, "Pipelined", "pipelined"},
+    {0, NULL, NULL}
+  };
+
+  if (!threading_type) {
+    threading_type =
+        g_enum_register_static ("DlbAudioDecBinThreading", threading_types);
+  }
+
+  return threading_type;
+}
+
 #define CHMASK(ch) (GST_AUDIO_CHANNEL_POSITION_MASK (ch))
 
 static const guint64 allowed_mixer_output_masks[4] = {
@@ -94,16 +135,17 @@ static void dlb_audio_dec_bin_set_property (GObject * object, guint prop_id,
 static void dlb_audio_dec_bin_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void dlb_audio_dec_bin_dispose (GObject * object);
+static void dlb_audio_dec_bin_handle_message (GstBin * bin,
+    GstMessage * message);
 
 static gboolean dlb_audio_dec_bin_add_children (DlbAudioDecBin * decbin);
 static gboolean dlb_audio_dec_bin_add_decoder_chain (DlbAudioDecBin * decbin);
+static void dlb_audio_dec_bin_remove_decoder_chain (DlbAudioDecBin * decbin);
 static void dlb_audio_dec_bin_sync_children_properties (DlbAudioDecBin *
     decbin);
 static gboolean dlb_audio_dec_bin_start (DlbAudioDecBin * decbin);
 static void dlb_audio_dec_bin_stop (DlbAudioDecBin * decbin);
 
-static GstPadProbeReturn dlb_audio_dec_bin_on_add_oar (GstPad * pad,
-    GstPadProbeInfo * info, gpointer user_data);
 static GstPadProbeReturn dlb_audio_dec_bin_on_dec_finish_flush (GstPad * pad,
     GstPadProbeInfo * info, gpointer user_data);
 static GstPadProbeReturn dlb_audio_dec_bin_on_dec_start_flush (GstPad * pad,
@@ -119,6 +161,7 @@ dlb_audio_dec_bin_class_init (DlbAudioDecBinClass * klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBinClass *bin_class = GST_BIN_CLASS (klass);
 
   parent_class = (GstBinClass *) g_type_class_peek_parent (klass);
 
@@ -130,6 +173,8 @@ dlb_audio_dec_bin_class_init (DlbAudioDecBinClass * klass)
   object_class->get_property =
       GST_DEBUG_FUNCPTR (dlb_audio_dec_bin_get_property);
   object_class->dispose = GST_DEBUG_FUNCPTR (dlb_audio_dec_bin_dispose);
+  bin_class->handle_message =
+      GST_DEBUG_FUNCPTR (dlb_audio_dec_bin_handle_message);
 
   gst_element_class_add_static_pad_template (element_class, &sink_template);
   gst_element_class_add_static_pad_template (element_class, &src_template);
@@ -144,6 +189,42 @@ dlb_audio_dec_bin_class_init (DlbAudioDecBinClass * klass)
   g_object_class_override_property (object_class, PROP_DRC_CUT, "drc-cut");
   g_object_class_override_property (object_class, PROP_DRC_BOOST, "drc-boost");
   g_object_class_override_property (object_class, PROP_DMX_ENABLE, "dmx-enable");
+
+  g_object_class_install_property (object_class, PROP_INPUT_CAPS,
+      g_param_spec_boxed ("input-caps", "Input caps",
+          "Caps of the incoming stream when known in advance, the decoder "
+          "chain is then built without typefind when leaving NULL or READY, "
+          "NULL - detect the stream type", GST_TYPE_CAPS,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_THREADING,
+      g_param_spec_enum ("threading", "Threading",
+          "Threading policy, pipelined runs decoding and rendering on their "
+          "own threads, applied when leaving NULL or READY",
+          DLB_TYPE_AUDIO_DEC_BIN_THREADING,
+          DEFAULT_THREADING, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_DECODER_AFFINITY,
+      g_param_spec_uint64 ("decoder-affinity", "Decoder thread affinity",
+          "CPU mask of the pipelined decoding thread, (0) - any CPU",
+          0, G_MAXUINT64, 0, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_RENDER_AFFINITY,
+      g_param_spec_uint64 ("render-affinity", "Render thread affinity",
+          "CPU mask of the pipelined rendering thread, (0) - any CPU",
+          0, G_MAXUINT64, 0, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (object_class, PROP_THREAD_PRIORITY,
+      g_param_spec_int ("thread-priority", "Thread priority",
+          "SCHED_FIFO priority of the pipelined threads, "
+          "(0) - keep the default scheduling policy",
+          0, 99, DEFAULT_THREAD_PRIORITY,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -152,12 +233,22 @@ dlb_audio_dec_bin_init (DlbAudioDecBin * decbin)
   GstPadTemplate *tmpl;
 
   decbin->stream = NULL;
+  decbin->input_caps = NULL;
+  decbin->skip_typefind = FALSE;
+  decbin->reconfigure = FALSE;
   decbin->typefind = NULL;
   decbin->parser = NULL;
   decbin->dec = NULL;
   decbin->oar = NULL;
   decbin->conv = NULL;
   decbin->capsfilter = NULL;
+  decbin->dec_queue = NULL;
+  decbin->render_queue = NULL;
+
+  decbin->threading = DEFAULT_THREADING;
+  decbin->decoder_affinity = 0;
+  decbin->render_affinity = 0;
+  decbin->thread_priority = DEFAULT_THREAD_PRIORITY;
 
   decbin->caps_seqnum = 0;
   decbin->dec_probe_id = 0;
@@ -188,6 +279,7 @@ dlb_audio_dec_bin_change_state (GstElement * element, GstStateChange trans)
 {
   GstStateChangeReturn ret = GST_STATE_CHANGE_SUCCESS;
   DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN (element);
+  gboolean reconfigure;
 
   GST_DEBUG_OBJECT (decbin, "Changing state: %s => %s",
       gst_element_state_get_name (GST_STATE_TRANSITION_CURRENT (trans)),
@@ -198,6 +290,18 @@ dlb_audio_dec_bin_change_state (GstElement * element, GstStateChange trans)
       if (dlb_audio_dec_bin_start (decbin) == FALSE)
         return GST_STATE_CHANGE_FAILURE;
       break;
+    case GST_STATE_CHANGE_READY_TO_PAUSED:
+      GST_OBJECT_LOCK (decbin);
+      reconfigure = decbin->reconfigure;
+      GST_OBJECT_UNLOCK (decbin);
+
+      /* input-caps or threading changed in READY */
+      if (reconfigure) {
+        dlb_audio_dec_bin_stop (decbin);
+        if (dlb_audio_dec_bin_start (decbin) == FALSE)
+          return GST_STATE_CHANGE_FAILURE;
+      }
+      break;
     default:
       break;
   }
@@ -236,6 +340,33 @@ dlb_audio_dec_bin_set_property (GObject * object, guint prop_id,
     case PROP_DMX_ENABLE:
       decbin->dmxenable = g_value_get_boolean (value);
       break;
+    case PROP_INPUT_CAPS:
+      GST_OBJECT_LOCK (decbin);
+      gst_caps_replace (&decbin->input_caps, gst_value_get_caps (value));
+      decbin->reconfigure = TRUE;
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_THREADING:
+      GST_OBJECT_LOCK (decbin);
+      decbin->threading = g_value_get_enum (value);
+      decbin->reconfigure = TRUE;
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_DECODER_AFFINITY:
+      GST_OBJECT_LOCK (decbin);
+      decbin->decoder_affinity = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_RENDER_AFFINITY:
+      GST_OBJECT_LOCK (decbin);
+      decbin->render_affinity = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_THREAD_PRIORITY:
+      GST_OBJECT_LOCK (decbin);
+      decbin->thread_priority = g_value_get_int (value);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -266,6 +397,31 @@ dlb_audio_dec_bin_get_property (GObject * object, guint prop_id,
     case PROP_DMX_ENABLE:
       g_value_set_boolean (value, decbin->dmxenable);
       break;
+    case PROP_INPUT_CAPS:
+      GST_OBJECT_LOCK (decbin);
+      gst_value_set_caps (value, decbin->input_caps);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_THREADING:
+      GST_OBJECT_LOCK (decbin);
+      g_value_set_enum (value, decbin->threading);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_DECODER_AFFINITY:
+      GST_OBJECT_LOCK (decbin);
+      g_value_set_uint64 (value, decbin->decoder_affinity);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_RENDER_AFFINITY:
+      GST_OBJECT_LOCK (decbin);
+      g_value_set_uint64 (value, decbin->render_affinity);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
+    case PROP_THREAD_PRIORITY:
+      GST_OBJECT_LOCK (decbin);
+      g_value_set_int (value, decbin->thread_priority);
+      GST_OBJECT_UNLOCK (decbin);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -277,6 +433,8 @@ dlb_audio_dec_bin_dispose (GObject * object)
 {
   DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN (object);
   g_free (decbin->stream);
+  decbin->stream = NULL;
+  gst_caps_replace (&decbin->input_caps, NULL);
 
   G_OBJECT_CLASS (dlb_audio_dec_bin_parent_class)->dispose (object);
 }
@@ -460,6 +618,37 @@ missing_element_print_info (DlbAudioDecBin * decbin, const gchar * factory)
   GST_WARNING_OBJECT (decbin, "Creating internal elements failed");
 }
 
+/* first element of the decoder chain and the element the decoder feeds,
+ * the stage queues when pipelined */
+static GstElement *
+dlb_audio_dec_bin_input_head (DlbAudioDecBin * decbin)
+{
+  return decbin->dec_queue ? decbin->dec_queue : decbin->parser;
+}
+
+static GstElement *
+dlb_audio_dec_bin_render_head (DlbAudioDecBin * decbin)
+{
+  if (decbin->render_queue)
+    return decbin->render_queue;
+
+  return decbin->oar ? decbin->oar : decbin->conv;
+}
+
+static gboolean
+dlb_audio_dec_bin_set_sink_target (DlbAudioDecBin * decbin,
+    GstElement * element)
+{
+  GstPad *pad = gst_element_get_static_pad (element, "sink");
+  gboolean ret = gst_ghost_pad_set_target (GST_GHOST_PAD (decbin->sink), pad);
+
+  if (!ret)
+    GST_ERROR_OBJECT (decbin, "couldn't set sinkpad target");
+
+  gst_object_unref (pad);
+  return ret;
+}
+
 static gboolean
 dlb_audio_dec_bin_add_children (DlbAudioDecBin * decbin)
 {
@@ -470,7 +659,7 @@ dlb_audio_dec_bin_add_children (DlbAudioDecBin * decbin)
   if ((decbin->typefind = gst_element_factory_make (factory, NULL)) == NULL)
     goto missing_element;
 
-  factory = "audioconvert";
+  factory = "dlbchmix";
   if ((decbin->conv = gst_element_factory_make (factory, NULL)) == NULL)
     goto missing_element;
 
@@ -484,10 +673,20 @@ dlb_audio_dec_bin_add_children (DlbAudioDecBin * decbin)
   if (!gst_element_link (decbin->conv, decbin->capsfilter))
     GST_ERROR_OBJECT (decbin, "couldn't link elements");
 
-  pad = gst_element_get_static_pad (decbin->typefind, "sink");
-  if (!gst_ghost_pad_set_target (GST_GHOST_PAD (decbin->sink), pad))
-    GST_ERROR_OBJECT (decbin->src, "couldn't set sinkpad target");
-  gst_object_unref (pad);
+  /* the renderer stays in the chain and bypasses channel based audio, so
+   * switching between object and channel based streams needs no relinking,
+   * it is only needed for object based streams */
+  if ((decbin->oar = gst_element_factory_make ("dlboar", NULL))) {
+    gst_bin_add (GST_BIN (decbin), decbin->oar);
+
+    if (!gst_element_link (decbin->oar, decbin->conv))
+      GST_ERROR_OBJECT (decbin, "couldn't link elements");
+  } else {
+    GST_WARNING_OBJECT (decbin, "dlboar not available, object based audio "
+        "will not be rendered");
+  }
+
+  dlb_audio_dec_bin_set_sink_target (decbin, decbin->typefind);
 
   pad = gst_element_get_static_pad (decbin->capsfilter, "src");
   if (!gst_ghost_pad_set_target (GST_GHOST_PAD (decbin->src), pad))
@@ -509,7 +708,9 @@ dlb_audio_dec_bin_add_decoder_chain (DlbAudioDecBin * decbin)
   const gchar *parser = NULL;
 
   if (!g_strcmp0 (decbin->stream, "audio/x-ac3") ||
-      !g_strcmp0 (decbin->stream, "audio/x-eac3")) {
+      !g_strcmp0 (decbin->stream, "audio/x-eac3") ||
+      !g_strcmp0 (decbin->stream, "audio/ac3") ||
+      !g_strcmp0 (decbin->stream, "audio/eac3")) {
     decoder = "dlbac3dec";
     parser = "dlbac3parse";
   } else if (!g_strcmp0 (decbin->stream, "audio/x-ac4-raw")) {
@@ -534,10 +735,21 @@ dlb_audio_dec_bin_add_decoder_chain (DlbAudioDecBin * decbin)
     goto missing_decoder;
 
   gst_bin_add_many (GST_BIN (decbin), decbin->parser, decbin->dec, NULL);
-  gst_element_link_many (decbin->typefind, decbin->parser, decbin->dec, NULL);
+  gst_element_link (decbin->parser, decbin->dec);
+
+  if (decbin->dec_queue)
+    gst_element_link (decbin->dec_queue, decbin->parser);
+
+  /* a stage queue stays linked to typefind across decoder changes */
+  srcpad = gst_element_get_static_pad (decbin->typefind, "src");
+  if (!decbin->skip_typefind && !gst_pad_is_linked (srcpad))
+    gst_element_link (decbin->typefind, dlb_audio_dec_bin_input_head (decbin));
+  gst_object_unref (srcpad);
 
   dlb_audio_dec_bin_sync_children_properties (decbin);
 
+  gst_element_link (decbin->dec, dlb_audio_dec_bin_render_head (decbin));
+
   srcpad = gst_element_get_static_pad (decbin->dec, "src");
   decbin->dec_probe_id = gst_pad_add_probe (srcpad,
       GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
@@ -561,95 +773,19 @@ missing_decoder:
   return FALSE;
 }
 
-static GstPadProbeReturn
-dlb_audio_dec_bin_on_oar_finish_flush (GstPad * pad, GstPadProbeInfo * info,
-    gpointer user_data)
+static void
+dlb_audio_dec_bin_remove_decoder_chain (DlbAudioDecBin * decbin)
 {
-  DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN_CAST (user_data);
-  GstPad *srcpad;
-  GstCaps *caps;
-
-  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_DATA (info)) != GST_EVENT_EOS)
-    return GST_PAD_PROBE_PASS;
-
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-  gst_element_set_state (decbin->oar, GST_STATE_NULL);
+  gst_element_set_state (decbin->parser, GST_STATE_NULL);
+  gst_element_set_state (decbin->dec, GST_STATE_NULL);
 
   /* remove unlinks automatically */
-  GST_DEBUG_OBJECT (decbin, "removing %" GST_PTR_FORMAT, decbin->oar);
-  gst_bin_remove (GST_BIN (decbin), decbin->oar);
-  decbin->oar = NULL;
-
-  gst_element_link_many (decbin->dec, decbin->conv, decbin->capsfilter, NULL);
-  gst_element_sync_state_with_parent (decbin->conv);
-
-  srcpad = gst_element_get_static_pad (decbin->dec, "src");
-  caps = gst_pad_get_current_caps (srcpad);
-
-  setup_mixer (decbin, caps);
-
-  gst_object_unref (srcpad);
-  gst_caps_unref (caps);
-
-  return GST_PAD_PROBE_DROP;
-}
-
-static GstPadProbeReturn
-dlb_audio_dec_bin_on_oar_start_flush (GstPad * pad, GstPadProbeInfo * info,
-    gpointer user_data)
-{
-  DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN_CAST (user_data);
-  GstPad *srcpad, *sinkpad;
-
-  GST_DEBUG_OBJECT (decbin, "start flushing, pad is blocked");
-
-  /* remove the probe first */
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-
-  /* install new probe for EOS */
-  srcpad = gst_element_get_static_pad (decbin->oar, "src");
-  gst_pad_add_probe (srcpad,
-      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
-      dlb_audio_dec_bin_on_oar_finish_flush, user_data, NULL);
-
-  /* push EOS into the element, the probe will be fired when the
-   * EOS leaves the effect and it has thus drained all of its data */
-  sinkpad = gst_element_get_static_pad (decbin->oar, "sink");
-  gst_pad_send_event (sinkpad, gst_event_new_eos ());
-
-  gst_object_unref (srcpad);
-  gst_object_unref (sinkpad);
-
-  return GST_PAD_PROBE_OK;
-}
-
-static GstPadProbeReturn
-dlb_audio_dec_bin_on_add_oar (GstPad * pad,
-    GstPadProbeInfo * info, gpointer user_data)
-{
-  DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN_CAST (user_data);
-
-  GST_DEBUG_OBJECT (decbin, "adding oar, pad is blocked");
-
-  /* remove the probe first, unlink elements */
-  gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-  gst_element_unlink_many (decbin->dec, decbin->conv, decbin->capsfilter, NULL);
-
-  decbin->oar = gst_element_factory_make ("dlboar", NULL);
-  if (decbin->oar == NULL)
-    goto missing_element;
-
-  reset_mixer (decbin);
-
-  gst_bin_add (GST_BIN (decbin), decbin->oar);
-  gst_element_link_many (decbin->dec, decbin->oar, decbin->capsfilter, NULL);
-  gst_element_sync_state_with_parent (decbin->oar);
-
-  return GST_PAD_PROBE_DROP;
+  GST_DEBUG_OBJECT (decbin, "removing %" GST_PTR_FORMAT, decbin->dec);
+  gst_bin_remove (GST_BIN (decbin), decbin->parser);
+  gst_bin_remove (GST_BIN (decbin), decbin->dec);
 
-missing_element:
-  missing_element_print_info (decbin, "dlboar");
-  return GST_PAD_PROBE_DROP;
+  decbin->parser = NULL;
+  decbin->dec = NULL;
 }
 
 static GstPadProbeReturn
@@ -657,25 +793,16 @@ dlb_audio_dec_bin_on_dec_finish_flush (GstPad * pad, GstPadProbeInfo * info,
     gpointer user_data)
 {
   DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN_CAST (user_data);
-  GstElement *peer;
 
   if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_DATA (info)) != GST_EVENT_EOS)
     return GST_PAD_PROBE_PASS;
 
   gst_pad_remove_probe (pad, GST_PAD_PROBE_INFO_ID (info));
-  gst_element_set_state (decbin->parser, GST_STATE_NULL);
-  gst_element_set_state (decbin->dec, GST_STATE_NULL);
-
-  /* remove unlinks automatically */
-  GST_DEBUG_OBJECT (decbin, "removing %" GST_PTR_FORMAT, decbin->dec);
-  gst_bin_remove (GST_BIN (decbin), decbin->parser);
-  gst_bin_remove (GST_BIN (decbin), decbin->dec);
+  dlb_audio_dec_bin_remove_decoder_chain (decbin);
 
   dlb_audio_dec_bin_add_decoder_chain (decbin);
   GST_DEBUG_OBJECT (decbin, "added  %" GST_PTR_FORMAT, decbin->dec);
 
-  peer = decbin->oar ? decbin->oar : decbin->conv;
-  gst_element_link (decbin->dec, peer);
   gst_element_set_state (decbin->dec, GST_STATE_PLAYING);
 
   return GST_PAD_PROBE_DROP;
@@ -756,19 +883,16 @@ dlb_audio_dec_bin_on_dec_caps (GstPad * pad,
 
   /* downstream element can decode metadata we should pass it through */
   if (upstream_meta && downstream_meta) {
+    gst_element_unlink (decbin->dec, dlb_audio_dec_bin_render_head (decbin));
     gst_element_unlink (decbin->conv, decbin->capsfilter);
     gst_element_link (decbin->dec, decbin->capsfilter);
   } else if (upstream_meta && decbin->oar == NULL) {
-    /* object based audio, there is no oar yet */
-    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
-        dlb_audio_dec_bin_on_add_oar, decbin, NULL);
-  } else if (!upstream_meta && decbin->oar != NULL) {
-    /* channel based audio, remove oar */
-    gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM,
-        dlb_audio_dec_bin_on_oar_start_flush, decbin, NULL);
-  } else if (!upstream_meta) {
-    /* channel based audio */
-    gst_element_link (decbin->dec, decbin->conv);
+    missing_element_print_info (decbin, "dlboar");
+  } else if (upstream_meta) {
+    /* object based audio, the renderer picks the output layout */
+    reset_mixer (decbin);
+  } else {
+    /* channel based audio, the renderer bypasses it */
     setup_mixer (decbin, caps);
   }
 
@@ -785,8 +909,10 @@ dlb_audio_dec_bin_on_type_found (GstElement * typefind, guint probability,
   GstPadTemplate *dec_tmpl = gst_static_pad_template_get (&sink_template);
   GstCaps *dec_caps = gst_pad_template_get_caps (dec_tmpl);
 
+  /* the chain is swapped from the thread feeding the parser */
   GstPad *sinkpad = gst_element_get_static_pad (typefind, "sink");
-  GstPad *srcpad = gst_element_get_static_pad (typefind, "src");
+  GstPad *srcpad = gst_element_get_static_pad (decbin->dec_queue ?
+      decbin->dec_queue : typefind, "src");
 
   stream = gst_structure_get_name (gst_caps_get_structure (caps, 0));
   reconf = g_strcmp0 (stream, decbin->stream);
@@ -819,11 +945,143 @@ exit:
   gst_caps_unref (dec_caps);
 }
 
+static GstElement *
+dlb_audio_dec_bin_make_stage_queue (DlbAudioDecBin * decbin,
+    const gchar * name)
+{
+  GstElement *queue = gst_element_factory_make ("queue", name);
+
+  if (queue == NULL) {
+    missing_element_print_info (decbin, "queue");
+    return NULL;
+  }
+
+  g_object_set (queue, "max-size-buffers", STAGE_QUEUE_BUFFERS,
+      "max-size-bytes", 0, "max-size-time", G_GUINT64_CONSTANT (0),
+      "silent", TRUE, NULL);
+
+  gst_bin_add (GST_BIN (decbin), queue);
+  return queue;
+}
+
+/* inserts or removes the stage queues, the decoder chain is rebuilt around
+ * them */
+static gboolean
+dlb_audio_dec_bin_setup_threading (DlbAudioDecBin * decbin)
+{
+  gboolean pipelined;
+
+  GST_OBJECT_LOCK (decbin);
+  pipelined = decbin->threading == DLB_AUDIO_DEC_BIN_THREADING_PIPELINED;
+  GST_OBJECT_UNLOCK (decbin);
+
+  if (pipelined == (decbin->dec_queue != NULL))
+    return TRUE;
+
+  if (decbin->dec)
+    dlb_audio_dec_bin_remove_decoder_chain (decbin);
+
+  if (!pipelined) {
+    gst_element_set_state (decbin->dec_queue, GST_STATE_NULL);
+    gst_element_set_state (decbin->render_queue, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (decbin), decbin->dec_queue);
+    gst_bin_remove (GST_BIN (decbin), decbin->render_queue);
+
+    decbin->dec_queue = NULL;
+    decbin->render_queue = NULL;
+    return TRUE;
+  }
+
+  decbin->dec_queue = dlb_audio_dec_bin_make_stage_queue (decbin, "decqueue");
+  decbin->render_queue =
+      dlb_audio_dec_bin_make_stage_queue (decbin, "renderqueue");
+
+  if (!decbin->dec_queue || !decbin->render_queue)
+    return FALSE;
+
+  if (!gst_element_link (decbin->render_queue,
+          decbin->oar ? decbin->oar : decbin->conv)) {
+    GST_ERROR_OBJECT (decbin, "couldn't link elements");
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (decbin, "pipelined decoding and rendering");
+  return TRUE;
+}
+
+/* builds parser and decoder for the known stream type, so the first buffer
+ * goes straight into the parser */
+static gboolean
+dlb_audio_dec_bin_build_from_caps (DlbAudioDecBin * decbin, GstCaps * caps)
+{
+  GstPadTemplate *dec_tmpl = gst_static_pad_template_get (&sink_template);
+  GstCaps *dec_caps = gst_pad_template_get_caps (dec_tmpl);
+  const gchar *stream;
+  gboolean ret = FALSE;
+
+  if (gst_caps_is_empty (caps) || gst_caps_is_any (caps) ||
+      !gst_caps_can_intersect (caps, dec_caps)) {
+    GST_WARNING_OBJECT (decbin, "cannot handle input caps %" GST_PTR_FORMAT
+        ", using typefind", caps);
+    goto exit;
+  }
+
+  stream = gst_structure_get_name (gst_caps_get_structure (caps, 0));
+
+  if (decbin->dec && g_strcmp0 (stream, decbin->stream))
+    dlb_audio_dec_bin_remove_decoder_chain (decbin);
+  else if (decbin->dec)
+    gst_element_unlink (decbin->typefind,
+        dlb_audio_dec_bin_input_head (decbin));
+
+  g_free (decbin->stream);
+  decbin->stream = g_strdup (stream);
+  decbin->skip_typefind = TRUE;
+
+  if (decbin->dec == NULL && !dlb_audio_dec_bin_add_decoder_chain (decbin))
+    goto exit;
+
+  GST_DEBUG_OBJECT (decbin, "built %s decoder chain without typefind", stream);
+  ret = dlb_audio_dec_bin_set_sink_target (decbin,
+      dlb_audio_dec_bin_input_head (decbin));
+
+exit:
+  gst_object_unref (dec_tmpl);
+  gst_caps_unref (dec_caps);
+  return ret;
+}
+
 static gboolean
 dlb_audio_dec_bin_start (DlbAudioDecBin * decbin)
 {
+  GstCaps *caps = NULL;
+  gboolean hinted;
+
   GST_DEBUG_OBJECT (decbin, "start");
 
+  if (!dlb_audio_dec_bin_setup_threading (decbin))
+    return FALSE;
+
+  GST_OBJECT_LOCK (decbin);
+  gst_caps_replace (&caps, decbin->input_caps);
+  decbin->reconfigure = FALSE;
+  GST_OBJECT_UNLOCK (decbin);
+
+  hinted = caps && dlb_audio_dec_bin_build_from_caps (decbin, caps);
+  gst_caps_replace (&caps, NULL);
+
+  if (hinted)
+    return TRUE;
+
+  /* a chain built without typefind is rebuilt once the type is found */
+  if (decbin->skip_typefind) {
+    decbin->skip_typefind = FALSE;
+    dlb_audio_dec_bin_set_sink_target (decbin, decbin->typefind);
+
+    if (decbin->dec)
+      dlb_audio_dec_bin_remove_decoder_chain (decbin);
+  }
+
   decbin->have_type_id = g_signal_connect (decbin->typefind, "have-type",
       G_CALLBACK (dlb_audio_dec_bin_on_type_found), decbin);
 
@@ -843,6 +1101,129 @@ dlb_audio_dec_bin_stop (DlbAudioDecBin * decbin)
   decbin->have_type = FALSE;
 }
 
+#ifdef __linux__
+/* scheduling of a pooled thread before a stage ran on it */
+typedef struct
+{
+  gboolean affinity_saved;
+  cpu_set_t affinity;
+  gboolean policy_saved;
+  gint policy;
+  struct sched_param param;
+} DlbStageThreadState;
+
+static GPrivate stage_thread_state = G_PRIVATE_INIT (g_free);
+#endif
+
+/* stage threads announce themselves from inside the new thread, so the
+ * scheduling settings apply to the calling thread. Threads come from the
+ * default task pool and are given back as they were on leave. */
+static void
+dlb_audio_dec_bin_setup_stage_thread (DlbAudioDecBin * decbin,
+    GstElement * owner)
+{
+#ifdef __linux__
+  DlbStageThreadState *state;
+#endif
+  guint64 affinity;
+  gint priority;
+
+  GST_OBJECT_LOCK (decbin);
+  affinity = owner == decbin->dec_queue ?
+      decbin->decoder_affinity : decbin->render_affinity;
+  priority = decbin->thread_priority;
+  GST_OBJECT_UNLOCK (decbin);
+
+#ifdef __linux__
+  state = g_new0 (DlbStageThreadState, 1);
+
+  if (affinity) {
+    cpu_set_t set;
+    gint cpu;
+
+    state->affinity_saved =
+        !sched_getaffinity (0, sizeof (state->affinity), &state->affinity);
+
+    CPU_ZERO (&set);
+    for (cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu) {
+      if (affinity & (G_GUINT64_CONSTANT (1) << cpu))
+        CPU_SET (cpu, &set);
+    }
+
+    if (sched_setaffinity (0, sizeof (set), &set))
+      GST_WARNING_OBJECT (decbin, "setting %s affinity failed: %s",
+          GST_ELEMENT_NAME (owner), g_strerror (errno));
+  }
+
+  if (priority) {
+    struct sched_param param;
+
+    state->policy = sched_getscheduler (0);
+    state->policy_saved = state->policy != -1
+        && !sched_getparam (0, &state->param);
+
+    memset (&param, 0, sizeof (param));
+    param.sched_priority = priority;
+
+    if (sched_setscheduler (0, SCHED_FIFO, &param))
+      GST_WARNING_OBJECT (decbin, "setting %s SCHED_FIFO priority failed: %s",
+          GST_ELEMENT_NAME (owner), g_strerror (errno));
+  }
+
+  g_private_replace (&stage_thread_state, state);
+#else
+  if (affinity || priority)
+    GST_WARNING_OBJECT (decbin, "thread affinity and priority unsupported");
+#endif
+}
+
+static void
+dlb_audio_dec_bin_restore_stage_thread (DlbAudioDecBin * decbin,
+    GstElement * owner)
+{
+#ifdef __linux__
+  DlbStageThreadState *state = g_private_get (&stage_thread_state);
+
+  if (!state)
+    return;
+
+  if (state->affinity_saved
+      && sched_setaffinity (0, sizeof (state->affinity), &state->affinity))
+    GST_WARNING_OBJECT (decbin, "restoring %s affinity failed: %s",
+        GST_ELEMENT_NAME (owner), g_strerror (errno));
+
+  if (state->policy_saved
+      && sched_setscheduler (0, state->policy, &state->param))
+    GST_WARNING_OBJECT (decbin, "restoring %s scheduling failed: %s",
+        GST_ELEMENT_NAME (owner), g_strerror (errno));
+
+  g_private_replace (&stage_thread_state, NULL);
+#endif
+}
+
+static void
+dlb_audio_dec_bin_handle_message (GstBin * bin, GstMessage * message)
+{
+  DlbAudioDecBin *decbin = DLB_AUDIO_DEC_BIN (bin);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_STREAM_STATUS) {
+    GstStreamStatusType type;
+    GstElement *owner;
+
+    gst_message_parse_stream_status (message, &type, &owner);
+
+    if (owner && (owner == decbin->dec_queue
+            || owner == decbin->render_queue)) {
+      if (type == GST_STREAM_STATUS_TYPE_ENTER)
+        dlb_audio_dec_bin_setup_stage_thread (decbin, owner);
+      else if (type == GST_STREAM_STATUS_TYPE_LEAVE)
+        dlb_audio_dec_bin_restore_stage_thread (decbin, owner);
+    }
+  }
+
+  GST_BIN_CLASS (parent_class)->handle_message (bin, message);
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
@@ -855,6 +1236,10 @@ plugin_init (GstPlugin * plugin)
           DLB_TYPE_AUDIO_DEC_BIN))
     return FALSE;
 
+  if (!gst_element_register (plugin, "dlbchmix", GST_RANK_NONE,
+          DLB_TYPE_CH_MIX))
+    return FALSE;
+
   return TRUE;
 }
 
@@ -34,6 +34,19 @@ G_BEGIN_DECLS
 typedef struct _DlbAudioDecBin DlbAudioDecBin;
 typedef struct _DlbAudioDecBinClass DlbAudioDecBinClass;
 
+/**
+ * DlbAudioDecBinThreading:
+ * @DLB_AUDIO_DEC_BIN_THREADING_SINGLE: all stages run on the upstream
+ *          streaming thread
+ * @DLB_AUDIO_DEC_BIN_THREADING_PIPELINED: decoding and rendering run on
+ *          their own threads behind bounded queues
+ */
+typedef enum
+{
+  DLB_AUDIO_DEC_BIN_THREADING_SINGLE,
+  DLB_AUDIO_DEC_BIN_THREADING_PIPELINED,
+} DlbAudioDecBinThreading;
+
 struct _DlbAudioDecBin
 {
   GstBin bin;
@@ -42,6 +55,10 @@ struct _DlbAudioDecBin
   GstPad *src;
 
   gchar *stream;
+  GstCaps *input_caps;
+  gboolean skip_typefind;
+  /* input-caps or threading changed since the chain was set up */
+  gboolean reconfigure;
   gint outmode;
   gint drcmode;
   gdouble drccut;
@@ -56,6 +73,14 @@ struct _DlbAudioDecBin
   GstElement *conv;
   GstElement *capsfilter;
 
+  /* pipelined threading, queues feeding the decoder and render stages */
+  DlbAudioDecBinThreading threading;
+  guint64 decoder_affinity;
+  guint64 render_affinity;
+  gint thread_priority;
+  GstElement *dec_queue;
+  GstElement *render_queue;
+
   guint32 caps_seqnum;
 
   gboolean have_type;
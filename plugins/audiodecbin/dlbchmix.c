@@ -0,0 +1,445 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "dlbchmix.h"
+
+GST_DEBUG_CATEGORY_STATIC (dlb_ch_mix_debug_category);
+#define GST_CAT_DEFAULT dlb_ch_mix_debug_category
+
+#define ALLOWED_CAPS                                                    \
+  "audio/x-raw, "                                                       \
+    "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",     \
+                        "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, " \
+    "channels = (int) [ 1, 64 ], "                                      \
+    "rate = (int) [ 1, MAX ], "                                         \
+    "layout = (string) interleaved"
+
+enum
+{
+  PROP_0,
+  PROP_MIX_MATRIX,
+};
+
+/* prototypes */
+static void dlb_ch_mix_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec);
+static void dlb_ch_mix_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec);
+static void dlb_ch_mix_finalize (GObject * object);
+static GstCaps *dlb_ch_mix_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean dlb_ch_mix_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
+static gboolean dlb_ch_mix_get_unit_size (GstBaseTransform * trans,
+    GstCaps * caps, gsize * size);
+static GstFlowReturn dlb_ch_mix_transform (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+static GstFlowReturn dlb_ch_mix_transform_ip (GstBaseTransform * trans,
+    GstBuffer * buf);
+
+/* pad templates */
+static GstStaticPadTemplate dlb_ch_mix_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (ALLOWED_CAPS)
+    );
+
+static GstStaticPadTemplate dlb_ch_mix_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (ALLOWED_CAPS)
+    );
+
+/* class initialization */
+
+G_DEFINE_TYPE_WITH_CODE (DlbChMix, dlb_ch_mix, GST_TYPE_BASE_TRANSFORM,
+    GST_DEBUG_CATEGORY_INIT (dlb_ch_mix_debug_category, "dlbchmix", 0,
+        "debug category for channel mix element"));
+
+static void
+dlb_ch_mix_class_init (DlbChMixClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_ch_mix_src_template);
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_ch_mix_sink_template);
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Dolby channel mixer", "Filter/Converter/Audio",
+      "Remaps, duplicates and mixes channels with a sparse mix matrix",
+      "Dolby Support <support@dolby.com>");
+
+  gobject_class->set_property = dlb_ch_mix_set_property;
+  gobject_class->get_property = dlb_ch_mix_get_property;
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (dlb_ch_mix_finalize);
+
+  g_object_class_install_property (gobject_class, PROP_MIX_MATRIX,
+      gst_param_spec_array ("mix-matrix", "Input/output channel matrix",
+          "Transformation matrix for input/output channels, empty keeps "
+          "the channels as they are, applied with the next caps",
+          gst_param_spec_array ("matrix-rows", "rows", "rows",
+              g_param_spec_float ("matrix-cols", "cols", "cols",
+                  -1, 1, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  base_transform_class->transform_caps =
+      GST_DEBUG_FUNCPTR (dlb_ch_mix_transform_caps);
+  base_transform_class->set_caps = GST_DEBUG_FUNCPTR (dlb_ch_mix_set_caps);
+  base_transform_class->get_unit_size =
+      GST_DEBUG_FUNCPTR (dlb_ch_mix_get_unit_size);
+  base_transform_class->transform = GST_DEBUG_FUNCPTR (dlb_ch_mix_transform);
+  base_transform_class->transform_ip =
+      GST_DEBUG_FUNCPTR (dlb_ch_mix_transform_ip);
+  base_transform_class->transform_ip_on_passthrough = FALSE;
+}
+
+static void
+dlb_ch_mix_init (DlbChMix * chmix)
+{
+  chmix->matrix = NULL;
+  chmix->in_channels = 0;
+  chmix->out_channels = 0;
+  chmix->mix = NULL;
+
+  gst_audio_info_init (&chmix->ininfo);
+  gst_audio_info_init (&chmix->outinfo);
+}
+
+static void
+dlb_ch_mix_finalize (GObject * object)
+{
+  DlbChMix *chmix = DLB_CH_MIX (object);
+
+  g_free (chmix->matrix);
+  dlb_channel_mix_free (chmix->mix);
+
+  G_OBJECT_CLASS (dlb_ch_mix_parent_class)->finalize (object);
+}
+
+static gboolean
+dlb_ch_mix_parse_matrix (DlbChMix * chmix, const GValue * value)
+{
+  guint rows, cols, i, j;
+  gfloat *matrix;
+
+  rows = gst_value_array_get_size (value);
+  cols = rows ? gst_value_array_get_size (gst_value_array_get_value (value,
+          0)) : 0;
+
+  if (!rows || !cols) {
+    matrix = NULL;
+    rows = cols = 0;
+    goto done;
+  }
+
+  if (rows > 64 || cols > 64)
+    goto size_error;
+
+  matrix = g_new (gfloat, rows * cols);
+
+  for (i = 0; i < rows; ++i) {
+    const GValue *row = gst_value_array_get_value (value, i);
+
+    if (gst_value_array_get_size (row) != cols) {
+      g_free (matrix);
+      goto size_error;
+    }
+
+    for (j = 0; j < cols; ++j)
+      matrix[i * cols + j] =
+          g_value_get_float (gst_value_array_get_value (row, j));
+  }
+
+done:
+  GST_OBJECT_LOCK (chmix);
+  g_free (chmix->matrix);
+  chmix->matrix = matrix;
+  chmix->in_channels = cols;
+  chmix->out_channels = rows;
+  GST_OBJECT_UNLOCK (chmix);
+
+  return TRUE;
+
+size_error:
+  g_warning ("mix-matrix rows must have equal length of up to 64 gains");
+  return FALSE;
+}
+
+static void
+dlb_ch_mix_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbChMix *chmix = DLB_CH_MIX (object);
+
+  switch (property_id) {
+    case PROP_MIX_MATRIX:
+      /* takes effect with the next caps, so audio still queued in the old
+       * format upstream is not mixed with a matrix meant for the new one */
+      dlb_ch_mix_parse_matrix (chmix, value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static void
+dlb_ch_mix_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  DlbChMix *chmix = DLB_CH_MIX (object);
+  GValue row = G_VALUE_INIT, val = G_VALUE_INIT;
+  gint i, j;
+
+  switch (property_id) {
+    case PROP_MIX_MATRIX:
+      g_value_init (&row, GST_TYPE_ARRAY);
+      g_value_init (&val, G_TYPE_FLOAT);
+
+      GST_OBJECT_LOCK (chmix);
+      for (i = 0; i < chmix->out_channels; ++i) {
+        for (j = 0; j < chmix->in_channels; ++j) {
+          g_value_set_float (&val,
+              chmix->matrix[i * chmix->in_channels + j]);
+          gst_value_array_append_value (&row, &val);
+        }
+
+        gst_value_array_append_value (value, &row);
+        g_value_reset (&row);
+      }
+      GST_OBJECT_UNLOCK (chmix);
+
+      g_value_unset (&row);
+      g_value_unset (&val);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+static GstCaps *
+dlb_ch_mix_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  DlbChMix *chmix = DLB_CH_MIX (trans);
+  GstCaps *othercaps;
+  guint64 mask;
+  gint channels, inchannels;
+  guint i;
+
+  GST_OBJECT_LOCK (chmix);
+  channels = chmix->out_channels;
+  GST_OBJECT_UNLOCK (chmix);
+
+  /* without a matrix the layout passes through as it is. Upstream stays
+   * unrestricted, the matrix for new input is usually set once its caps
+   * are known and is checked in set_caps */
+  othercaps = gst_caps_copy (caps);
+  for (i = 0; channels && i < gst_caps_get_size (othercaps); ++i) {
+    GstStructure *s = gst_caps_get_structure (othercaps, i);
+
+    /* positions of the input are kept when the count does not change,
+     * other mixes get the default layout of the output count */
+    if (!gst_structure_get_int (s, "channels", &inchannels)
+        || inchannels != channels
+        || !gst_structure_get (s, "channel-mask", GST_TYPE_BITMASK, &mask,
+            NULL))
+      mask = gst_audio_channel_get_fallback_mask (channels);
+
+    gst_structure_remove_fields (s, "channels", "channel-mask", NULL);
+    if (direction == GST_PAD_SINK) {
+      gst_structure_set (s, "channels", G_TYPE_INT, channels, NULL);
+      if (channels > 1)
+        gst_structure_set (s, "channel-mask", GST_TYPE_BITMASK, mask, NULL);
+    }
+  }
+
+  GST_DEBUG_OBJECT (chmix,
+      "transformed %" GST_PTR_FORMAT " into %" GST_PTR_FORMAT, caps, othercaps);
+
+  if (filter) {
+    GstCaps *intersect;
+
+    intersect = gst_caps_intersect_full (filter, othercaps,
+        GST_CAPS_INTERSECT_FIRST);
+    gst_caps_unref (othercaps);
+
+    return intersect;
+  } else {
+    return othercaps;
+  }
+}
+
+static gboolean
+dlb_ch_mix_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  DlbChMix *chmix = DLB_CH_MIX (trans);
+  DlbChannelMix *mix;
+  GstAudioInfo in, out;
+  gfloat *matrix;
+  gint i;
+
+  GST_DEBUG_OBJECT (chmix, "incaps %" GST_PTR_FORMAT ", outcaps %"
+      GST_PTR_FORMAT, incaps, outcaps);
+
+  if (!gst_audio_info_from_caps (&in, incaps))
+    goto incaps_error;
+  if (!gst_audio_info_from_caps (&out, outcaps))
+    goto outcaps_error;
+
+  GST_OBJECT_LOCK (chmix);
+  if (chmix->matrix) {
+    if (in.channels != chmix->in_channels ||
+        out.channels != chmix->out_channels) {
+      GST_OBJECT_UNLOCK (chmix);
+      goto matrix_error;
+    }
+
+    mix = dlb_channel_mix_new (chmix->matrix, in.channels, out.channels);
+  } else {
+    if (in.channels != out.channels) {
+      GST_OBJECT_UNLOCK (chmix);
+      goto matrix_error;
+    }
+
+    matrix = g_new0 (gfloat, in.channels * in.channels);
+    for (i = 0; i < in.channels; ++i)
+      matrix[i * in.channels + i] = 1.0f;
+
+    mix = dlb_channel_mix_new (matrix, in.channels, out.channels);
+    g_free (matrix);
+  }
+  GST_OBJECT_UNLOCK (chmix);
+
+  dlb_channel_mix_free (chmix->mix);
+  chmix->mix = mix;
+  chmix->ininfo = in;
+  chmix->outinfo = out;
+
+  GST_INFO_OBJECT (chmix, "mixing %d to %d channels, kind %d", in.channels,
+      out.channels, dlb_channel_mix_get_kind (mix));
+
+  /* permutations are done within the input buffer */
+  gst_base_transform_set_passthrough (trans,
+      dlb_channel_mix_get_kind (mix) == DLB_CHANNEL_MIX_IDENTITY);
+  gst_base_transform_set_in_place (trans, in.channels == out.channels);
+
+  return TRUE;
+
+  /* ERROR */
+incaps_error:
+  GST_ERROR_OBJECT (trans, "invalid incaps");
+  return FALSE;
+
+outcaps_error:
+  GST_ERROR_OBJECT (trans, "invalid outcaps");
+  return FALSE;
+
+matrix_error:
+  GST_ERROR_OBJECT (trans, "mix matrix does not match %d to %d channels",
+      in.channels, out.channels);
+  return FALSE;
+}
+
+static gboolean
+dlb_ch_mix_get_unit_size (GstBaseTransform * trans, GstCaps * caps,
+    gsize * size)
+{
+  GstAudioInfo info;
+
+  if (!gst_audio_info_from_caps (&info, caps))
+    goto caps_error;
+
+  *size = GST_AUDIO_INFO_BPF (&info);
+
+  return TRUE;
+
+  /* Error */
+caps_error:
+  GST_ERROR_OBJECT (trans, "invalid caps");
+  return FALSE;
+}
+
+static GstFlowReturn
+dlb_ch_mix_transform (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  DlbChMix *chmix = DLB_CH_MIX (trans);
+  GstMapInfo inmap, outmap;
+  gsize samples;
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  samples = inmap.size / GST_AUDIO_INFO_BPF (&chmix->ininfo);
+
+  /* all supported formats are signed, silence is zero */
+  if (GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))
+    memset (outmap.data, 0, outmap.size);
+  else
+    dlb_channel_mix_process (chmix->mix, inmap.data, outmap.data, samples,
+        GST_AUDIO_INFO_FORMAT (&chmix->ininfo));
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (inbuf, &inmap);
+
+  return GST_FLOW_OK;
+}
+
+static GstFlowReturn
+dlb_ch_mix_transform_ip (GstBaseTransform * trans, GstBuffer * buf)
+{
+  DlbChMix *chmix = DLB_CH_MIX (trans);
+  GstMapInfo map;
+  gsize samples;
+
+  if (GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP))
+    return GST_FLOW_OK;
+
+  gst_buffer_map (buf, &map, GST_MAP_READWRITE);
+
+  samples = map.size / GST_AUDIO_INFO_BPF (&chmix->ininfo);
+  dlb_channel_mix_process (chmix->mix, map.data, map.data, samples,
+      GST_AUDIO_INFO_FORMAT (&chmix->ininfo));
+
+  gst_buffer_unmap (buf, &map);
+
+  return GST_FLOW_OK;
+}
@@ -0,0 +1,64 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+
+#ifndef _DLB_CH_MIX_H
+#define _DLB_CH_MIX_H
+
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+#include "dlbchannelmix.h"
+
+G_BEGIN_DECLS
+#define DLB_TYPE_CH_MIX   (dlb_ch_mix_get_type())
+#define DLB_CH_MIX(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),DLB_TYPE_CH_MIX,DlbChMix))
+#define DLB_CH_MIX_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),DLB_TYPE_CH_MIX,DlbChMixClass))
+#define DLB_IS_CH_MIX(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),DLB_TYPE_CH_MIX))
+#define DLB_IS_CH_MIX_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),DLB_TYPE_CH_MIX))
+typedef struct _DlbChMix DlbChMix;
+typedef struct _DlbChMixClass DlbChMixClass;
+
+struct _DlbChMix
+{
+  GstBaseTransform base_ch_mix;
+
+  /* mix matrix, out_channels rows of in_channels gains, protected by
+   * object lock. Empty matrix keeps the channels as they are */
+  gfloat *matrix;
+  gint in_channels;
+  gint out_channels;
+
+  /* Input/Output audio info */
+  GstAudioInfo ininfo;
+  GstAudioInfo outinfo;
+
+  DlbChannelMix *mix;
+};
+
+struct _DlbChMixClass
+{
+  GstBaseTransformClass base_ch_mix_class;
+};
+
+GType dlb_ch_mix_get_type (void);
+
+G_END_DECLS
+#endif
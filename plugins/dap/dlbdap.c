@@ -41,6 +41,10 @@ GST_DEBUG_CATEGORY_STATIC (dlb_dap_debug_category);
                         "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, " \
     "channels = (int) { 2, 6, 8, 10, 12 }, "                            \
     "rate = (int) { 48000, 32000, 44100, 96000, 192000 }, "             \
+    "layout = (string) { interleaved, non-interleaved }; "              \
+    DLB_AUDIO_LFRACT_CAPS_NAME ", "                                     \
+    "channels = (int) { 2, 6, 8, 10, 12 }, "                            \
+    "rate = (int) { 48000, 32000, 44100, 96000, 192000 }, "             \
     "layout = (string) { interleaved, non-interleaved }"
 
 #define DLB_DAP_SRC_CAPS                                                \
@@ -79,6 +83,9 @@ static gboolean dlb_dap_get_unit_size (GstBaseTransform * trans,
     GstCaps * caps, gsize * size);
 static void dlb_dap_close (DlbDap * dap);
 static gboolean dlb_dap_open (DlbDap * dap);
+static void dlb_dap_switch_reset (DlbDap * dap);
+static GstStateChangeReturn dlb_dap_change_state (GstElement * element,
+    GstStateChange transition);
 static gboolean dlb_dap_start (GstBaseTransform * trans);
 static gboolean dlb_dap_stop (GstBaseTransform * trans);
 static gboolean dlb_dap_sink_event (GstBaseTransform * trans, GstEvent * event);
@@ -86,6 +93,9 @@ static gboolean dlb_dap_src_event (GstBaseTransform * trans, GstEvent * event);
 static GstFlowReturn dlb_dap_push_drain (DlbDap * dap);
 static GstFlowReturn dlb_dap_transform (GstBaseTransform * trans,
     GstBuffer * inbuf, GstBuffer * outbuf);
+static GstPad *dlb_dap_request_new_pad (GstElement * element,
+    GstPadTemplate * templ, const gchar * req_name, const GstCaps * caps);
+static void dlb_dap_release_pad (GstElement * element, GstPad * pad);
 
 enum
 {
@@ -128,8 +138,40 @@ enum
   PROP_DISCARD_LATENCY,
   PROP_FORCE_ORDER,
   PROP_JSON_CONFIG,
+  PROP_CROSSFADE_BLOCKS,
+  PROP_STATS,
+  PROP_ZONE_THREADS,
+  PROP_SILENCE_THRESHOLD,
+  PROP_IDLE_TIMEOUT,
+};
+
+#define DEFAULT_CROSSFADE_BLOCKS 0
+#define DEFAULT_ZONE_THREADS 0
+#define DEFAULT_SILENCE_THRESHOLD 0.0
+#define DEFAULT_IDLE_TIMEOUT GST_CLOCK_TIME_NONE
+
+/* negotiation results kept, enough for both pads of a few streams */
+#define DLB_DAP_CAPS_CACHE_SIZE 16
+
+/* groups of settings pushed to DAP instances */
+enum
+{
+  DLB_DAP_SETTINGS_PROFILE = 1 << 0,
+  DLB_DAP_SETTINGS_GAINS = 1 << 1,
+  DLB_DAP_SETTINGS_VIRTUALIZER = 1 << 2,
+  DLB_DAP_SETTINGS_ALL = 0x7,
 };
 
+/* updates the field only if the value really changes, changed groups are
+ * accumulated in local variable groups */
+#define UPDATE_SETTING(params, field, val, group)                             \
+  G_STMT_START {                                                              \
+    if ((params)->field != (val)) {                                           \
+      (params)->field = (val);                                                \
+      groups |= (group);                                                      \
+    }                                                                         \
+  } G_STMT_END
+
 /* pad templates */
 
 static GstStaticPadTemplate dlb_dap_src_template =
@@ -138,6 +180,12 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS (DLB_DAP_SRC_CAPS));
 
+static GstStaticPadTemplate dlb_dap_zone_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (DLB_DAP_SRC_CAPS));
+
 static GstStaticPadTemplate dlb_dap_sink_template =
 GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
@@ -149,6 +197,89 @@ G_DEFINE_TYPE_WITH_CODE (DlbDap, dlb_dap, GST_TYPE_BASE_TRANSFORM,
     GST_DEBUG_CATEGORY_INIT (dlb_dap_debug_category, "dlbdap", 0,
         "debug category for dap element"));
 
+G_DEFINE_TYPE (DlbDapZonePad, dlb_dap_zone_pad, GST_TYPE_PAD);
+
+enum
+{
+  PROP_ZONE_PAD_0,
+  PROP_ZONE_PAD_VIRTUALIZER_ENABLE,
+};
+
+static void
+dlb_dap_zone_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  DlbDapZonePad *zone = DLB_DAP_ZONE_PAD (object);
+
+  switch (prop_id) {
+    case PROP_ZONE_PAD_VIRTUALIZER_ENABLE:
+      GST_OBJECT_LOCK (zone);
+      g_value_set_boolean (value, zone->virtualizer_enable);
+      GST_OBJECT_UNLOCK (zone);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+dlb_dap_zone_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbDapZonePad *zone = DLB_DAP_ZONE_PAD (object);
+
+  switch (prop_id) {
+    case PROP_ZONE_PAD_VIRTUALIZER_ENABLE:
+      GST_OBJECT_LOCK (zone);
+      zone->virtualizer_enable = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (zone);
+
+      /* zone instance is reopened by the streaming thread */
+      g_atomic_int_set (&zone->negotiate, TRUE);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+dlb_dap_zone_pad_init (DlbDapZonePad * zone)
+{
+  zone->virtualizer_enable = FALSE;
+  zone->negotiate = TRUE;
+  zone->instance = NULL;
+  zone->instance_virtualizer_enable = FALSE;
+  zone->outbufsz = 0;
+  zone->prefill = 0;
+  zone->latency_samples = 0;
+  zone->latency_time = 0;
+  zone->outbuf = NULL;
+  zone->task = NULL;
+  zone->task_caps = NULL;
+  zone->pool = NULL;
+  zone->pool_size = 0;
+
+  gst_audio_info_init (&zone->outinfo);
+}
+
+static void
+dlb_dap_zone_pad_class_init (DlbDapZonePadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = dlb_dap_zone_pad_set_property;
+  gobject_class->get_property = dlb_dap_zone_pad_get_property;
+
+  g_object_class_install_property (gobject_class,
+      PROP_ZONE_PAD_VIRTUALIZER_ENABLE,
+      g_param_spec_boolean ("virtualizer-enable", "Virtualizer enable",
+          "Enables or disables the speaker virtualizer for this zone", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_PLAYING));
+}
+
 typedef unsigned int uint;
 
 #define G_TYPE_int G_TYPE_INT
@@ -279,14 +410,17 @@ static void
 dlb_dap_class_init (DlbDapClass * klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
   GstBaseTransformClass *base_transform_class =
       GST_BASE_TRANSFORM_CLASS (klass);
 
   /* Setting up pads and setting metadata should be moved to
      base_class_init if you intend to subclass this class. */
-  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+  gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&dlb_dap_src_template));
-  gst_element_class_add_pad_template (GST_ELEMENT_CLASS (klass),
+  gst_element_class_add_static_pad_template_with_gtype (element_class,
+      &dlb_dap_zone_template, DLB_TYPE_DAP_ZONE_PAD);
+  gst_element_class_add_pad_template (element_class,
       gst_static_pad_template_get (&dlb_dap_sink_template));
 
   gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
@@ -297,6 +431,9 @@ dlb_dap_class_init (DlbDapClass * klass)
   gobject_class->set_property = dlb_dap_set_property;
   gobject_class->get_property = dlb_dap_get_property;
   gobject_class->finalize = dlb_dap_finalize;
+  element_class->request_new_pad =
+      GST_DEBUG_FUNCPTR (dlb_dap_request_new_pad);
+  element_class->release_pad = GST_DEBUG_FUNCPTR (dlb_dap_release_pad);
   base_transform_class->transform_caps =
       GST_DEBUG_FUNCPTR (dlb_dap_transform_caps);
   base_transform_class->set_caps = GST_DEBUG_FUNCPTR (dlb_dap_set_caps);
@@ -305,6 +442,7 @@ dlb_dap_class_init (DlbDapClass * klass)
       GST_DEBUG_FUNCPTR (dlb_dap_transform_size);
   base_transform_class->get_unit_size =
       GST_DEBUG_FUNCPTR (dlb_dap_get_unit_size);
+  element_class->change_state = GST_DEBUG_FUNCPTR (dlb_dap_change_state);
   base_transform_class->start = GST_DEBUG_FUNCPTR (dlb_dap_start);
   base_transform_class->stop = GST_DEBUG_FUNCPTR (dlb_dap_stop);
   base_transform_class->sink_event = GST_DEBUG_FUNCPTR (dlb_dap_sink_event);
@@ -322,7 +460,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Speaker virtualizer front angle",
           "The absolute horizontal angle of front loudspeakers from the "
           "central listening position",
-          0, 30, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_VIRT_SURROUND_SPEAKER_ANGLE,
@@ -330,7 +469,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Speaker virtualizer surround angle",
           "The absolute horizontal angle of surround loudspeakers from the "
           "central listening position",
-          0, 30, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE,
@@ -338,7 +478,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Speaker virtualizer rear surround angle",
           "The absolute horizontal angle of surround loudspeakers from the "
           "central listening position",
-          0, 30, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_VIRT_HEIGHT_SPEAKER_ANGLE,
@@ -346,7 +487,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Speaker virtualizer height angle",
           "The absolute horizontal angle of height loudspeakers from the "
           "central listening position",
-          0, 30, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE,
@@ -354,7 +496,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Speaker virtualizer rear height angle",
           "The absolute horizontal angle of height loudspeakers from the "
           "central listening position",
-          0, 30, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_HEIGHT_FILTER_ENABLE,
       g_param_spec_boolean ("height-filter-enable", "Height filter enable",
@@ -372,28 +515,32 @@ dlb_dap_class_init (DlbDapClass * klass)
           "The amount of bass enhancement boost applied by Bass Enhancer "
           "represented as a fixed point number with 4 fractional bits "
           "[0.0, 24.0] dB",
-          0, 384, 192, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 384, 192,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_BASS_ENHANCER_CUTOFF_FREQ,
       g_param_spec_int ("bass-enhancer-cutoff-freq",
           "Bass enhancer cutoff frequency",
           "Bass enhancement cutoff frequency used by Bass Enhancer",
-          20, 2000, 200, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          20, 2000, 200,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_BASS_ENHANCER_WIDTH,
       g_param_spec_int ("bass-enhancer-width", "Bass enhancer width",
           "The width of the bass enhancement boost curve used by Bass Enhancer "
           "represented as a fixed point number with 4 fractional bits "
           "[0.125, 4.0] Octaves",
-          2, 64, 16, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          2, 64, 16,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_CALIBRATION_BOOST,
       g_param_spec_int ("calibration-boost", "Calibration boost",
           "Calibration Boost is an extra gain which is applied to the signal "
           "represented as a fixed point number with 4 fractional bits "
           "[0.0, 12.0] dB",
-          0, 192, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 192, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_DIALOG_ENHANCER_ENABLE,
       g_param_spec_boolean ("dialog-enhancer-enable", "Dialog enhancer enable",
@@ -404,7 +551,8 @@ dlb_dap_class_init (DlbDapClass * klass)
       g_param_spec_int ("dialog-enhancer-amount", "Dialog enhancer amount",
           "The strength of the Dialog Enhancer effect represented as a fixed "
           "point number with 4 fractional bits [0.0, 1.0]",
-          0, 16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 16, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_DIALOG_ENHANCER_DUCKING,
       g_param_spec_int ("dialog-enhancer-ducking",
@@ -412,7 +560,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "The degree of suppression of channels that don't contain dialog, "
           "represented as a fixed point number with 4 fractional bits "
           "[0.00, 1.00]",
-          0, 16, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 16, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_GEQ_ENABLE,
       g_param_spec_boolean ("geq-enable", "GEQ enable",
@@ -452,7 +601,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Specifies the strength of the Intelligent Equalizer effect to apply, "
           "represented as a fixed point number with 4 fractional bits "
           "[0.00, 1.00]",
-          0, 16, 10, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 16, 10,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_IEQ_FREQS,
       gst_param_spec_array ("ieq-freqs",
@@ -515,21 +665,24 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Pre-gain specifies the amount of gain which has been applied to the "
           "signal before entering the signal chain, represented as a fixed "
           "point number with 4 fractional bits [-130.0, 30.0] dB",
-          -2080, 480, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_POSTGAIN,
       g_param_spec_int ("postgain", "Postgain",
           "Post-gain specifies the amount of gain which will be applied to the "
           "signal externally after leaving the signal chain, represented as a "
           "fixed point number with 4 fractional bits [-130.0, 30.0] dB",
-          -2080, 480, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_SYSGAIN,
       g_param_spec_int ("sysgain", "System gain",
           "System gain specifies the amount of gain which be applied by the "
           "signal chain represented as a fixed point number with 4 fractional "
           "bits [-130.0, 30.0] dB",
-          -2080, 480, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_SURROUND_DECODER_ENABLE,
@@ -550,7 +703,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Surround Compressor boost to be used. This boost is applied only to "
           "signals passing through the Speaker Virtualizer, represented as a fixed "
           "point number with 4 fractional bits [0.00, 6.00] dB",
-          0, 96, 0, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 96, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class, PROP_VOLMAX_BOOST,
       g_param_spec_int ("volmax-boost",
@@ -559,7 +713,8 @@ dlb_dap_class_init (DlbDapClass * klass)
           "maximization will be performed only if Volume Leveler is enabled, "
           "this is represented as a fixed point number with 4 fractional bits "
           "[0.0, 12.0] dB, default 9.0 dB",
-          0, 192, 144, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 192, 144,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_VOLUME_LEVELER_ENABLE,
@@ -572,7 +727,8 @@ dlb_dap_class_init (DlbDapClass * klass)
       g_param_spec_int ("volume-leveler-amount", "Volume leveler amount",
           "Specifies how aggressive the leveler is in attempting to reach the "
           "output target level",
-          0, 10, 7, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+          0, 10, 7,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
   g_object_class_install_property (gobject_class,
       PROP_DISCARD_LATENCY,
@@ -594,6 +750,44 @@ dlb_dap_class_init (DlbDapClass * klass)
           "Path to json configuration file.",
           NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_CROSSFADE_BLOCKS,
+      g_param_spec_uint ("crossfade-blocks",
+          "Crossfade blocks",
+          "Number of processing blocks used to crossfade between old and new "
+          "DAP instance when virtualizer-enable or serialized config changes "
+          "while running, (0) - new instance replaces the old one without "
+          "crossfade",
+          0, 1024, DEFAULT_CROSSFADE_BLOCKS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Configuration switching and library call statistics",
+          GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_ZONE_THREADS,
+      g_param_spec_uint ("zone-threads", "Zone threads",
+          "Number of worker threads processing src_%u zones in parallel with "
+          "the main output, (0) - zones are processed in the streaming thread",
+          0, 16, DEFAULT_ZONE_THREADS,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SILENCE_THRESHOLD,
+      g_param_spec_double ("silence-threshold", "Silence threshold",
+          "Peak input amplitude, relative to full scale, treated as silence "
+          "by the idle bypass, (0) - digital silence only",
+          0.0, 1.0, DEFAULT_SILENCE_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("idle-timeout", "Idle timeout",
+          "Duration of silent or GAP input in nanoseconds after which "
+          "processing is bypassed and GAP buffers are produced, never for "
+          "native format input, (-1) - disable bypass",
+          0, G_MAXUINT64, DEFAULT_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_tag_register ("surround-decoder-enable", GST_TAG_FLAG_META,
       G_TYPE_BOOLEAN, "surround-decoder-enable tag",
       "a tag that indicates if surround-decoder is enabled", NULL);
@@ -603,6 +797,8 @@ static void
 dlb_dap_init (DlbDap * dap)
 {
   GstBaseTransform *trans = GST_BASE_TRANSFORM (dap);
+  DlbDapParams params;
+
   gst_base_transform_set_prefer_passthrough (trans, FALSE);
   gst_base_transform_set_gap_aware (trans, TRUE);
 
@@ -611,10 +807,15 @@ dlb_dap_init (DlbDap * dap)
   gst_audio_info_init (&dap->ininfo);
   gst_audio_info_init (&dap->outinfo);
 
-  dlb_dap_virtualizer_settings_init (&dap->virt_conf);
-  dlb_dap_profile_settings_init (&dap->profile);
+  memset (&params, 0, sizeof (params));
+  dlb_dap_virtualizer_settings_init (&params.virt_conf);
+  dlb_dap_profile_settings_init (&params.profile);
+
+  dap->params = dlb_param_mailbox_new (sizeof (params), &params);
+  dap->applied = dlb_param_mailbox_read (dap->params, NULL);
 
   dap->adapter = gst_adapter_new ();
+  dap->caps_cache = dlb_caps_cache_new (DLB_DAP_CAPS_CACHE_SIZE);
   dap->transform_blocks = 0;
   dap->inbufsz = 0;
   dap->outbufsz = 0;
@@ -627,28 +828,121 @@ dlb_dap_init (DlbDap * dap)
 
   dap->serialized_config = NULL;
   dap->json_config_path = NULL;
+  dap->json_config = NULL;
   dap->global_conf.profile = NULL;
+
+  dap->config_loader = dlb_config_loader_new (dlb_dap_parse_json_config,
+      (GDestroyNotify) dlb_dap_json_config_free, dlb_dap_json_config_loaded,
+      dap);
+
+  dap->crossfade_blocks = DEFAULT_CROSSFADE_BLOCKS;
+  dap->switch_pool = NULL;
+  dap->switch_pending = FALSE;
+  dap->switch_task = NULL;
+  dap->instance_virtualizer_enable = FALSE;
+  dap->instance_serialized_config = NULL;
+  dap->switch_virtualizer_enable = FALSE;
+  dap->switch_serialized_config = NULL;
+  dap->next_instance = NULL;
+  dap->fade_buffer = NULL;
+  dap->fade_ramp = NULL;
+  dap->fade_ramp_len = 0;
+  dap->switches = 0;
+  dap->crossfade_samples = 0;
+  dap->crossfade_time = 0;
+
+  dap->silence_threshold = DEFAULT_SILENCE_THRESHOLD;
+  dap->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+  dap->audible_end = 0;
+  dap->silent_samples = 0;
+  dap->idle = FALSE;
+  dap->bypassed_blocks = 0;
+
+  dap->zones = NULL;
+  dap->zone_serial = 0;
+  dap->zones_busy = FALSE;
+  dap->zones_groups = 0;
+  dap->drain_samples = 0;
+  dap->zone_threads = DEFAULT_ZONE_THREADS;
+  dap->zone_pool = NULL;
+  dap->zones_pending = 0;
+  dap->zone_indata = NULL;
+  g_mutex_init (&dap->zone_lock);
+  g_cond_init (&dap->zone_cond);
 }
 
 static void
-dlb_dap_update_state_unlocked (DlbDap * dap)
+dlb_dap_apply_settings (DlbDap * dap, dlb_dap * instance, guint groups)
+{
+  const DlbDapParams *params = dap->applied;
+
+  if (groups & DLB_DAP_SETTINGS_PROFILE)
+    dlb_dap_set_profile_settings (instance, &params->profile);
+
+  if (groups & DLB_DAP_SETTINGS_GAINS)
+    dlb_dap_set_gain_settings (instance, &params->gains);
+
+  if ((groups & DLB_DAP_SETTINGS_VIRTUALIZER) && (!dap->serialized_config
+          || dap->global_conf.override_virtualizer_settings))
+    dlb_dap_set_virtualizer_settings (instance, &params->virt_conf);
+}
+
+static void
+dlb_dap_zone_apply_settings (DlbDap * dap, DlbDapZonePad * zone,
+    guint groups)
+{
+  const DlbDapParams *params = dap->applied;
+
+  /* zones are not created from serialized config, so virtualizer settings
+   * are always taken from properties */
+  if (groups & DLB_DAP_SETTINGS_PROFILE)
+    dlb_dap_set_profile_settings (zone->instance, &params->profile);
+
+  if (groups & DLB_DAP_SETTINGS_GAINS)
+    dlb_dap_set_gain_settings (zone->instance, &params->gains);
+
+  if (groups & DLB_DAP_SETTINGS_VIRTUALIZER)
+    dlb_dap_set_virtualizer_settings (zone->instance, &params->virt_conf);
+}
+
+/* must be called with dap->lock held */
+static void
+dlb_dap_zones_apply_settings_unlocked (DlbDap * dap, guint groups)
 {
-  if (dap->dap_instance) {
-    dlb_dap_set_profile_settings (dap->dap_instance, &dap->profile);
-    dlb_dap_set_gain_settings (dap->dap_instance, &dap->gains);
+  GList *l;
 
-    if (!dap->serialized_config ||
-        dap->global_conf.override_virtualizer_settings)
-      dlb_dap_set_virtualizer_settings (dap->dap_instance, &dap->virt_conf);
+  for (l = dap->zones; l; l = l->next) {
+    DlbDapZonePad *zone = l->data;
+
+    if (zone->instance)
+      dlb_dap_zone_apply_settings (dap, zone, groups);
   }
 }
 
+/* picks up latest published settings and pushes only groups changed since
+ * last update, never blocks on property setters */
 static void
-dlb_dap_update_state (DlbDap * dap)
+dlb_dap_update_state_unlocked (DlbDap * dap)
 {
-  g_mutex_lock (&dap->lock);
-  dlb_dap_update_state_unlocked (dap);
-  g_mutex_unlock (&dap->lock);
+  guint groups;
+
+  dap->applied = dlb_param_mailbox_read (dap->params, &groups);
+
+  if (G_LIKELY (!groups))
+    return;
+
+  if (dap->dap_instance)
+    dlb_dap_apply_settings (dap, dap->dap_instance, groups);
+
+  /* keep the instance we are crossfading to in sync */
+  if (dap->next_instance)
+    dlb_dap_apply_settings (dap, dap->next_instance, groups);
+
+  /* zone instances may be running on worker threads right now */
+  if (dap->zones_busy)
+    dap->zones_groups |= groups;
+  else
+    dlb_dap_zones_apply_settings_unlocked (dap, groups);
 }
 
 static void
@@ -686,351 +980,529 @@ dlb_dap_post_stream_info_message (DlbDap * dap, gchar * audio_codec,
 }
 
 static gboolean
-dlb_dap_get_serialized_config_from_json (DlbDap * dap, int rate,
-    gboolean virtualizer_enable, gboolean force)
+dlb_dap_select_serialized_config (DlbDap * dap, gint rate,
+    gboolean virtualizer_enable)
 {
-  GError *error = NULL;
-
-  GST_DEBUG_OBJECT (dap, "Parsing serialized config from %s",
-      dap->json_config_path);
-
-  if (dap->serialized_config && !force)
-    return TRUE;
-
-  if (dap->serialized_config)
-    g_free (dap->serialized_config);
-
-  dap->serialized_config =
-      dlb_dap_json_parse_serialized_config (dap->json_config_path,
-      rate, virtualizer_enable, &error);
-
-  if (error) {
-    GST_ELEMENT_WARNING (dap, LIBRARY, SETTINGS, ("%s: %d", error->message,
-            error->code), ("JSON parsing failed"));
+  dap->serialized_config = NULL;
 
-    g_error_free (error);
-    return FALSE;
-  }
+  if (dap->json_config)
+    dap->serialized_config =
+        dlb_dap_json_config_get_serialized (dap->json_config, rate,
+        virtualizer_enable);
 
-  return TRUE;
+  return dap->serialized_config != NULL;
 }
 
-static gboolean
-dlb_dap_get_config_from_json (DlbDap * dap)
+/* called from the config loader thread */
+static gpointer
+dlb_dap_parse_json_config (const gchar * filename, gpointer user_data,
+    GError ** error)
 {
-  GError *error = NULL;
-  gint virtualizer_enable = 0;
-
-  GST_DEBUG_OBJECT (dap, "Parsing config from %s", dap->json_config_path);
+  return dlb_dap_json_config_load (filename, error);
+}
 
-  g_free (dap->global_conf.profile);
-  dap->global_conf.profile = NULL;
+/* called from the config loader thread */
+static void
+dlb_dap_json_config_loaded (const gchar * filename, gconstpointer data,
+    const GError * error, gpointer user_data)
+{
+  DlbDap *dap = DLB_DAP (user_data);
+  const dlb_dap_json_config *config = data;
+  GBytes *serialized_config;
 
-  dlb_dap_json_parse_config (dap->json_config_path, &dap->global_conf,
-      &dap->virt_conf, &dap->gains, &dap->profile, &error);
+  gint channels, virtualizer_enable = 0;
+  guint64 channel_mask;
+  dlb_dap_channel_format fmt;
 
   if (error)
     goto parsing_error;
 
-  if (dap->global_conf.use_serialized_settings) {
-    gint channels, ret;
-    guint64 channel_mask;
-    dlb_dap_channel_format fmt;
+  GST_DEBUG_OBJECT (dap, "Parsed config from %s", filename);
 
-    ret = dlb_dap_get_serialized_config_from_json (dap, 48000,
-        dap->global_conf.virtualizer_enable, FALSE);
+  if (!config->global.use_serialized_settings)
+    return;
 
-    if (!ret)
-      goto config_error;
+  serialized_config = dlb_dap_json_config_get_serialized (config, 48000,
+      config->global.virtualizer_enable);
 
-    dlb_dap_preprocess_serialized_config (dap->serialized_config,
-        &fmt, &channels, &virtualizer_enable);
+  if (!serialized_config)
+    goto config_error;
 
-    dap_format_to_channel_mask (&fmt, &channel_mask);
+  dlb_dap_preprocess_serialized_config (g_bytes_get_data (serialized_config,
+          NULL), &fmt, &channels, &virtualizer_enable);
 
-    dlb_dap_post_serialized_info_message (dap, channels, channel_mask,
-        virtualizer_enable);
-  }
+  dap_format_to_channel_mask (&fmt, &channel_mask);
 
-  dap->virtualizer_enable = dap->global_conf.virtualizer_enable;
-  dlb_dap_update_state (dap);
+  dlb_dap_post_serialized_info_message (dap, channels, channel_mask,
+      virtualizer_enable);
 
-  return TRUE;
+  return;
 
 parsing_error:
   GST_ELEMENT_WARNING (dap, LIBRARY, SETTINGS, ("%s: %d", error->message,
           error->code), ("JSON parsing failed"));
-
-  g_error_free (error);
-  return FALSE;
+  return;
 
 config_error:
   GST_ELEMENT_WARNING (dap, LIBRARY, SETTINGS, (NULL),
       ("Could not find serialized config for given settings: rate %d, virt: %d",
-          48000, virtualizer_enable));
+          48000, config->global.virtualizer_enable));
+}
 
-  return FALSE;
+/* must be called with dap->lock held */
+static void
+dlb_dap_apply_json_config_unlocked (DlbDap * dap, dlb_dap_json_config * config)
+{
+  DlbDapParams *params;
+  gint rate = dap->ininfo.rate ? dap->ininfo.rate : 48000;
+  gboolean was_serialized = dap->global_conf.use_serialized_settings;
+  gint channels, virtualizer_enable;
+  dlb_dap_channel_format fmt;
+
+  if (config != dap->json_config) {
+    dlb_dap_json_config_free (dap->json_config);
+    dap->json_config = config;
+  }
+
+  g_free (dap->global_conf.profile);
+  dap->global_conf.profile = NULL;
+
+  if (config->sections & DLB_DAP_JSON_SECTION_GLOBAL) {
+    dap->global_conf = config->global;
+    dap->global_conf.profile = g_strdup (config->global.profile);
+  }
+
+  params = dlb_param_mailbox_lock (dap->params);
+  if (config->sections & DLB_DAP_JSON_SECTION_VIRTUALIZER)
+    params->virt_conf = config->virt;
+  if (config->sections & DLB_DAP_JSON_SECTION_GAINS)
+    params->gains = config->gains;
+  if (config->sections & DLB_DAP_JSON_SECTION_PROFILE)
+    params->profile = config->profile;
+  dlb_param_mailbox_unlock (dap->params, DLB_DAP_SETTINGS_ALL);
+
+  if (dap->global_conf.use_serialized_settings)
+    dlb_dap_select_serialized_config (dap, rate,
+        dap->global_conf.virtualizer_enable);
+  else
+    dap->serialized_config = NULL;
+
+  dap->virtualizer_enable = dap->global_conf.virtualizer_enable;
+  dlb_caps_cache_invalidate (dap->caps_cache);
+
+  /* output layout of the running stream may change, running instance is
+   * kept until set_caps () reopens DAP for the new layout */
+  if (GST_AUDIO_INFO_IS_VALID (&dap->outinfo)) {
+    channels = GST_AUDIO_INFO_CHANNELS (&dap->outinfo);
+
+    if (dap->serialized_config)
+      dlb_dap_preprocess_serialized_config (g_bytes_get_data
+          (dap->serialized_config, NULL), &fmt, &channels,
+          &virtualizer_enable);
+
+    if (was_serialized != dap->global_conf.use_serialized_settings ||
+        channels != GST_AUDIO_INFO_CHANNELS (&dap->outinfo)) {
+      GST_DEBUG_OBJECT (dap, "Output format changed, renegotiating");
+      dap->output_changed = TRUE;
+      gst_base_transform_reconfigure_src (GST_BASE_TRANSFORM_CAST (dap));
+    }
+  }
+
+  dlb_dap_update_state_unlocked (dap);
 }
 
-void
-dlb_dap_set_property (GObject * object, guint property_id,
+/* picks up config published by the loader, never blocks on file I/O,
+ * must be called with dap->lock held */
+static gboolean
+dlb_dap_update_json_config_unlocked (DlbDap * dap)
+{
+  dlb_dap_json_config *config = dlb_config_loader_take (dap->config_loader);
+
+  if (G_LIKELY (!config))
+    return FALSE;
+
+  GST_DEBUG_OBJECT (dap, "Applying config from %s", dap->json_config_path);
+  dlb_dap_apply_json_config_unlocked (dap, config);
+
+  return TRUE;
+}
+
+/* waits for the file requested by the setter, so that properties read
+ * back reflect it. Never called from the streaming thread. */
+static void
+dlb_dap_sync_json_config (DlbDap * dap)
+{
+  dlb_config_loader_wait (dap->config_loader);
+
+  g_mutex_lock (&dap->lock);
+  dlb_dap_update_json_config_unlocked (dap);
+  g_mutex_unlock (&dap->lock);
+}
+
+/* updates writer copy of dynamic settings, returns changed groups */
+static guint
+dlb_dap_set_param (GObject * object, DlbDapParams * params, guint property_id,
     const GValue * value, GParamSpec * pspec)
 {
-  DlbDap *dap = DLB_DAP (object);
+  guint groups = 0;
 
   switch (property_id) {
-    case PROP_VIRTUALIZER_ENABLE:
-      dap->virtualizer_enable = g_value_get_boolean (value);
-      break;
     case PROP_VIRT_FRONT_SPEAKER_ANGLE:
-      dap->virt_conf.front_speaker_angle = g_value_get_int (value);
+      UPDATE_SETTING (params, virt_conf.front_speaker_angle,
+          g_value_get_int (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_VIRT_SURROUND_SPEAKER_ANGLE:
-      dap->virt_conf.surround_speaker_angle = g_value_get_int (value);
+      UPDATE_SETTING (params, virt_conf.surround_speaker_angle,
+          g_value_get_int (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE:
-      dap->virt_conf.rear_surround_speaker_angle = g_value_get_int (value);
+      UPDATE_SETTING (params, virt_conf.rear_surround_speaker_angle,
+          g_value_get_int (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_VIRT_HEIGHT_SPEAKER_ANGLE:
-      dap->virt_conf.height_speaker_angle = g_value_get_int (value);
+      UPDATE_SETTING (params, virt_conf.height_speaker_angle,
+          g_value_get_int (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE:
-      dap->virt_conf.rear_height_speaker_angle = g_value_get_int (value);
+      UPDATE_SETTING (params, virt_conf.rear_height_speaker_angle,
+          g_value_get_int (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_HEIGHT_FILTER_ENABLE:
-      dap->virt_conf.height_filter_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, virt_conf.height_filter_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_VIRTUALIZER);
       break;
     case PROP_BASS_ENHANCER_ENABLE:
-      dap->profile.bass_enhancer_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.bass_enhancer_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_BASS_ENHANCER_BOOST:
-      dap->profile.bass_enhancer_boost = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.bass_enhancer_boost,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_BASS_ENHANCER_CUTOFF_FREQ:
-      dap->profile.bass_enhancer_cutoff_frequency = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.bass_enhancer_cutoff_frequency,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_BASS_ENHANCER_WIDTH:
-      dap->profile.bass_enhancer_width = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.bass_enhancer_width,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_CALIBRATION_BOOST:
-      dap->profile.calibration_boost = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.calibration_boost,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_DIALOG_ENHANCER_ENABLE:
-      dap->profile.dialog_enhancer_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.dialog_enhancer_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_DIALOG_ENHANCER_AMOUNT:
-      dap->profile.dialog_enhancer_amount = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.dialog_enhancer_amount,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_DIALOG_ENHANCER_DUCKING:
-      dap->profile.dialog_enhancer_ducking = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.dialog_enhancer_ducking,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_GEQ_ENABLE:
-      dap->profile.graphic_equalizer_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.graphic_equalizer_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_GEQ_FREQS:
-      fill_data_array_uint (dap->profile.graphic_equalizer_bands,
-          &dap->profile.graphic_equalizer_bands_num, value);
+      fill_data_array_uint (params->profile.graphic_equalizer_bands,
+          &params->profile.graphic_equalizer_bands_num, value);
+      groups |= DLB_DAP_SETTINGS_PROFILE;
       break;
     case PROP_GEQ_GAINS:
-      fill_data_array_int (dap->profile.graphic_equalizer_gains,
-          &dap->profile.graphic_equalizer_bands_num, value);
+      fill_data_array_int (params->profile.graphic_equalizer_gains,
+          &params->profile.graphic_equalizer_bands_num, value);
+      groups |= DLB_DAP_SETTINGS_PROFILE;
       break;
     case PROP_IEQ_ENABLE:
-      dap->profile.ieq_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.ieq_enable, g_value_get_boolean (value),
+          DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_IEQ_AMOUNT:
-      dap->profile.ieq_amount = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.ieq_amount, g_value_get_int (value),
+          DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_IEQ_FREQS:
-      fill_data_array_uint (dap->profile.ieq_bands, &dap->profile.ieq_bands_num,
-          value);
+      fill_data_array_uint (params->profile.ieq_bands,
+          &params->profile.ieq_bands_num, value);
+      groups |= DLB_DAP_SETTINGS_PROFILE;
       break;
     case PROP_IEQ_GAINS:
-      fill_data_array_int (dap->profile.ieq_gains, &dap->profile.ieq_bands_num,
-          value);
+      fill_data_array_int (params->profile.ieq_gains,
+          &params->profile.ieq_bands_num, value);
+      groups |= DLB_DAP_SETTINGS_PROFILE;
       break;
     case PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE:
-      dap->profile.mi_dialog_enhancer_steering_enable =
-          g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.mi_dialog_enhancer_steering_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_MI_DV_LEVELER_STEERING_ENABLE:
-      dap->profile.mi_dv_leveler_steering_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.mi_dv_leveler_steering_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_MI_IEQ_STEERING_ENABLE:
-      dap->profile.mi_ieq_steering_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.mi_ieq_steering_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE:
-      dap->profile.mi_surround_compressor_steering_enable =
-          g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.mi_surround_compressor_steering_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_PREGAIN:
-      dap->gains.pregain = g_value_get_int (value);
+      UPDATE_SETTING (params, gains.pregain, g_value_get_int (value),
+          DLB_DAP_SETTINGS_GAINS);
       break;
     case PROP_POSTGAIN:
-      dap->gains.postgain = g_value_get_int (value);
+      UPDATE_SETTING (params, gains.postgain, g_value_get_int (value),
+          DLB_DAP_SETTINGS_GAINS);
       break;
     case PROP_SYSGAIN:
-      dap->gains.system_gain = g_value_get_int (value);
+      UPDATE_SETTING (params, gains.system_gain, g_value_get_int (value),
+          DLB_DAP_SETTINGS_GAINS);
       break;
     case PROP_SURROUND_DECODER_ENABLE:
-      dap->profile.surround_decoder_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.surround_decoder_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE:
-      dap->profile.surround_decoder_center_spreading_enable =
-          g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.surround_decoder_center_spreading_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_SURROUND_BOOST:
-      dap->profile.surround_boost = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.surround_boost, g_value_get_int (value),
+          DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_VOLMAX_BOOST:
-      dap->profile.volmax_boost = g_value_get_int (value);
+      UPDATE_SETTING (params, profile.volmax_boost, g_value_get_int (value),
+          DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_VOLUME_LEVELER_ENABLE:
-      dap->profile.volume_leveler_enable = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.volume_leveler_enable,
+          g_value_get_boolean (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     case PROP_VOLUME_LEVELER_AMOUNT:
-      dap->profile.volume_leveler_amount = g_value_get_int (value);
-      break;
-    case PROP_JSON_CONFIG:
-      g_free (dap->json_config_path);
-      dap->json_config_path = g_strdup (g_value_get_string (value));
-      dlb_dap_get_config_from_json (dap);
-      break;
-    case PROP_DISCARD_LATENCY:
-      dap->discard_latency = g_value_get_boolean (value);
-      break;
-    case PROP_FORCE_ORDER:
-      dap->force_order = g_value_get_boolean (value);
+      UPDATE_SETTING (params, profile.volume_leveler_amount,
+          g_value_get_int (value), DLB_DAP_SETTINGS_PROFILE);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
   }
 
-  dlb_dap_update_state (dap);
+  return groups;
 }
 
-void
-dlb_dap_get_property (GObject * object, guint property_id,
-    GValue * value, GParamSpec * pspec)
+static void
+dlb_dap_get_param (GObject * object, const DlbDapParams * params,
+    guint property_id, GValue * value, GParamSpec * pspec)
 {
-  DlbDap *dap = DLB_DAP (object);
-
   switch (property_id) {
-    case PROP_VIRTUALIZER_ENABLE:
-      g_value_set_boolean (value, dap->virtualizer_enable);
-      break;
     case PROP_VIRT_FRONT_SPEAKER_ANGLE:
-      g_value_set_int (value, dap->virt_conf.front_speaker_angle);
+      g_value_set_int (value, params->virt_conf.front_speaker_angle);
       break;
     case PROP_VIRT_SURROUND_SPEAKER_ANGLE:
-      g_value_set_int (value, dap->virt_conf.surround_speaker_angle);
+      g_value_set_int (value, params->virt_conf.surround_speaker_angle);
       break;
     case PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE:
-      g_value_set_int (value, dap->virt_conf.rear_surround_speaker_angle);
+      g_value_set_int (value, params->virt_conf.rear_surround_speaker_angle);
       break;
     case PROP_VIRT_HEIGHT_SPEAKER_ANGLE:
-      g_value_set_int (value, dap->virt_conf.height_speaker_angle);
+      g_value_set_int (value, params->virt_conf.height_speaker_angle);
       break;
     case PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE:
-      g_value_set_int (value, dap->virt_conf.rear_height_speaker_angle);
+      g_value_set_int (value, params->virt_conf.rear_height_speaker_angle);
       break;
     case PROP_HEIGHT_FILTER_ENABLE:
-      g_value_set_boolean (value, dap->virt_conf.height_filter_enable);
+      g_value_set_boolean (value, params->virt_conf.height_filter_enable);
       break;
     case PROP_BASS_ENHANCER_ENABLE:
-      g_value_set_boolean (value, dap->profile.bass_enhancer_enable);
+      g_value_set_boolean (value, params->profile.bass_enhancer_enable);
       break;
     case PROP_BASS_ENHANCER_BOOST:
-      g_value_set_int (value, dap->profile.bass_enhancer_boost);
+      g_value_set_int (value, params->profile.bass_enhancer_boost);
       break;
     case PROP_BASS_ENHANCER_CUTOFF_FREQ:
-      g_value_set_int (value, dap->profile.bass_enhancer_cutoff_frequency);
+      g_value_set_int (value, params->profile.bass_enhancer_cutoff_frequency);
       break;
     case PROP_BASS_ENHANCER_WIDTH:
-      g_value_set_int (value, dap->profile.bass_enhancer_width);
+      g_value_set_int (value, params->profile.bass_enhancer_width);
       break;
     case PROP_CALIBRATION_BOOST:
-      g_value_set_int (value, dap->profile.calibration_boost);
+      g_value_set_int (value, params->profile.calibration_boost);
       break;
     case PROP_DIALOG_ENHANCER_ENABLE:
-      g_value_set_boolean (value, dap->profile.dialog_enhancer_enable);
+      g_value_set_boolean (value, params->profile.dialog_enhancer_enable);
       break;
     case PROP_DIALOG_ENHANCER_AMOUNT:
-      g_value_set_int (value, dap->profile.dialog_enhancer_amount);
+      g_value_set_int (value, params->profile.dialog_enhancer_amount);
       break;
     case PROP_DIALOG_ENHANCER_DUCKING:
-      g_value_set_int (value, dap->profile.dialog_enhancer_ducking);
+      g_value_set_int (value, params->profile.dialog_enhancer_ducking);
       break;
     case PROP_GEQ_ENABLE:
-      g_value_set_boolean (value, dap->profile.graphic_equalizer_enable);
+      g_value_set_boolean (value, params->profile.graphic_equalizer_enable);
       break;
     case PROP_GEQ_FREQS:
-      fill_gst_value_array_uint (value, dap->profile.graphic_equalizer_bands,
-          dap->profile.graphic_equalizer_bands_num);
+      fill_gst_value_array_uint (value, params->profile.graphic_equalizer_bands,
+          params->profile.graphic_equalizer_bands_num);
       break;
     case PROP_GEQ_GAINS:
-      fill_gst_value_array_int (value, dap->profile.graphic_equalizer_gains,
-          dap->profile.graphic_equalizer_bands_num);
+      fill_gst_value_array_int (value, params->profile.graphic_equalizer_gains,
+          params->profile.graphic_equalizer_bands_num);
       break;
     case PROP_IEQ_ENABLE:
-      g_value_set_boolean (value, dap->profile.ieq_enable);
+      g_value_set_boolean (value, params->profile.ieq_enable);
       break;
     case PROP_IEQ_AMOUNT:
-      g_value_set_int (value, dap->profile.ieq_amount);
+      g_value_set_int (value, params->profile.ieq_amount);
       break;
     case PROP_IEQ_FREQS:
-      fill_gst_value_array_uint (value, dap->profile.ieq_bands,
-          dap->profile.ieq_bands_num);
+      fill_gst_value_array_uint (value, params->profile.ieq_bands,
+          params->profile.ieq_bands_num);
       break;
     case PROP_IEQ_GAINS:
-      fill_gst_value_array_int (value, dap->profile.ieq_gains,
-          dap->profile.ieq_bands_num);
+      fill_gst_value_array_int (value, params->profile.ieq_gains,
+          params->profile.ieq_bands_num);
       break;
     case PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE:
       g_value_set_boolean (value,
-          dap->profile.mi_dialog_enhancer_steering_enable);
+          params->profile.mi_dialog_enhancer_steering_enable);
       break;
     case PROP_MI_DV_LEVELER_STEERING_ENABLE:
-      g_value_set_boolean (value, dap->profile.mi_dv_leveler_steering_enable);
+      g_value_set_boolean (value,
+          params->profile.mi_dv_leveler_steering_enable);
       break;
     case PROP_MI_IEQ_STEERING_ENABLE:
-      g_value_set_boolean (value, dap->profile.mi_ieq_steering_enable);
+      g_value_set_boolean (value, params->profile.mi_ieq_steering_enable);
       break;
     case PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE:
       g_value_set_boolean (value,
-          dap->profile.mi_surround_compressor_steering_enable);
+          params->profile.mi_surround_compressor_steering_enable);
       break;
     case PROP_PREGAIN:
-      g_value_set_int (value, dap->gains.pregain);
+      g_value_set_int (value, params->gains.pregain);
       break;
     case PROP_POSTGAIN:
-      g_value_set_int (value, dap->gains.postgain);
+      g_value_set_int (value, params->gains.postgain);
       break;
     case PROP_SYSGAIN:
-      g_value_set_int (value, dap->gains.system_gain);
+      g_value_set_int (value, params->gains.system_gain);
       break;
     case PROP_SURROUND_DECODER_ENABLE:
-      g_value_set_boolean (value, dap->profile.surround_decoder_enable);
+      g_value_set_boolean (value, params->profile.surround_decoder_enable);
       break;
     case PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE:
       g_value_set_boolean (value,
-          dap->profile.surround_decoder_center_spreading_enable);
+          params->profile.surround_decoder_center_spreading_enable);
       break;
     case PROP_SURROUND_BOOST:
-      g_value_set_int (value, dap->profile.surround_boost);
+      g_value_set_int (value, params->profile.surround_boost);
       break;
     case PROP_VOLMAX_BOOST:
-      g_value_set_int (value, dap->profile.volmax_boost);
+      g_value_set_int (value, params->profile.volmax_boost);
       break;
     case PROP_VOLUME_LEVELER_ENABLE:
-      g_value_set_boolean (value, dap->profile.volume_leveler_enable);
+      g_value_set_boolean (value, params->profile.volume_leveler_enable);
       break;
     case PROP_VOLUME_LEVELER_AMOUNT:
-      g_value_set_int (value, dap->profile.volume_leveler_amount);
+      g_value_set_int (value, params->profile.volume_leveler_amount);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+void
+dlb_dap_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbDap *dap = DLB_DAP (object);
+  DlbDapParams *params;
+  guint groups;
+
+  switch (property_id) {
+    case PROP_VIRTUALIZER_ENABLE:
+      g_mutex_lock (&dap->lock);
+      dap->virtualizer_enable = g_value_get_boolean (value);
+      dlb_caps_cache_invalidate (dap->caps_cache);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_JSON_CONFIG:
+      /* file is parsed on the loader thread and picked up at block
+       * boundary, or by the first property read */
+      g_mutex_lock (&dap->lock);
+      g_free (dap->json_config_path);
+      dap->json_config_path = g_strdup (g_value_get_string (value));
+      dlb_config_loader_set_filename (dap->config_loader,
+          dap->json_config_path);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_DISCARD_LATENCY:
+      dap->discard_latency = g_value_get_boolean (value);
+      break;
+    case PROP_FORCE_ORDER:
+      dap->force_order = g_value_get_boolean (value);
+      break;
+    case PROP_CROSSFADE_BLOCKS:
+      g_mutex_lock (&dap->lock);
+      dap->crossfade_blocks = g_value_get_uint (value);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_ZONE_THREADS:
+      g_mutex_lock (&dap->lock);
+      dap->zone_threads = g_value_get_uint (value);
+
+      /* pool is idle while lock is held, recreated on demand */
+      if (dap->zone_pool) {
+        g_thread_pool_free (dap->zone_pool, FALSE, TRUE);
+        dap->zone_pool = NULL;
+      }
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_SILENCE_THRESHOLD:
+      g_mutex_lock (&dap->lock);
+      dap->silence_threshold = g_value_get_double (value);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      g_mutex_lock (&dap->lock);
+      dap->idle_timeout = g_value_get_uint64 (value);
+      g_mutex_unlock (&dap->lock);
+      break;
+    default:
+      /* published without waiting for the streaming thread, pushed to DAP
+       * instances at next block boundary */
+      params = dlb_param_mailbox_lock (dap->params);
+      groups = dlb_dap_set_param (object, params, property_id, value, pspec);
+      dlb_param_mailbox_unlock (dap->params, groups);
+      break;
+  }
+}
+
+void
+dlb_dap_get_property (GObject * object, guint property_id,
+    GValue * value, GParamSpec * pspec)
+{
+  DlbDap *dap = DLB_DAP (object);
+  DlbDapParams *params;
+  GstStructure *stats;
+  guint block_samples = 0, latency_samples = 0;
+
+  switch (property_id) {
+    case PROP_VIRTUALIZER_ENABLE:
+      dlb_dap_sync_json_config (dap);
+      g_mutex_lock (&dap->lock);
+      g_value_set_boolean (value, dap->virtualizer_enable);
+      g_mutex_unlock (&dap->lock);
       break;
     case PROP_JSON_CONFIG:
+      g_mutex_lock (&dap->lock);
       g_value_set_string (value, dap->json_config_path);
+      g_mutex_unlock (&dap->lock);
       break;
     case PROP_DISCARD_LATENCY:
       g_value_set_boolean (value, dap->discard_latency);
@@ -1038,8 +1510,50 @@ dlb_dap_get_property (GObject * object, guint property_id,
     case PROP_FORCE_ORDER:
       g_value_set_boolean (value, dap->force_order);
       break;
+    case PROP_CROSSFADE_BLOCKS:
+      g_value_set_uint (value, dap->crossfade_blocks);
+      break;
+    case PROP_ZONE_THREADS:
+      g_value_set_uint (value, dap->zone_threads);
+      break;
+    case PROP_SILENCE_THRESHOLD:
+      g_mutex_lock (&dap->lock);
+      g_value_set_double (value, dap->silence_threshold);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      g_mutex_lock (&dap->lock);
+      g_value_set_uint64 (value, dap->idle_timeout);
+      g_mutex_unlock (&dap->lock);
+      break;
+    case PROP_STATS:
+      g_mutex_lock (&dap->lock);
+      if (dap->dap_instance) {
+        block_samples = dlb_dap_query_block_samples (dap->dap_instance);
+        latency_samples = dlb_dap_query_latency (dap->dap_instance);
+      }
+
+      stats = gst_structure_new ("dlbdap-stats",
+          "switches", G_TYPE_UINT, dap->switches,
+          "switching", G_TYPE_BOOLEAN,
+          dap->switch_pending || dap->next_instance != NULL,
+          "crossfade-samples", G_TYPE_UINT64, dap->crossfade_samples,
+          "crossfade-time", G_TYPE_UINT64, dap->crossfade_time,
+          "idle", G_TYPE_BOOLEAN, dap->idle,
+          "bypassed-blocks", G_TYPE_UINT64, dap->bypassed_blocks,
+          "block-samples", G_TYPE_UINT, block_samples,
+          "latency-samples", G_TYPE_UINT, latency_samples, NULL);
+      g_mutex_unlock (&dap->lock);
+#ifdef DLB_DAP_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_dap_query_stats);
+#endif
+      g_value_take_boxed (value, stats);
+      break;
     default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      dlb_dap_sync_json_config (dap);
+      params = dlb_param_mailbox_lock (dap->params);
+      dlb_dap_get_param (object, params, property_id, value, pspec);
+      dlb_param_mailbox_unlock (dap->params, 0);
       break;
   }
 }
@@ -1049,9 +1563,25 @@ dlb_dap_finalize (GObject * object)
 {
   DlbDap *dap = DLB_DAP (object);
 
+  dlb_config_loader_free (dap->config_loader);
+  dlb_dap_switch_reset (dap);
+  g_free (dap->fade_ramp);
+  dlb_param_mailbox_free (dap->params);
+  dlb_caps_cache_free (dap->caps_cache);
+  dlb_dap_json_config_free (dap->json_config);
+
+  if (dap->instance_serialized_config)
+    g_bytes_unref (dap->instance_serialized_config);
+
+  if (dap->zone_pool)
+    g_thread_pool_free (dap->zone_pool, FALSE, TRUE);
+
+  g_list_free_full (dap->zones, gst_object_unref);
+
   g_free (dap->json_config_path);
-  g_free (dap->serialized_config);
   g_free (dap->global_conf.profile);
+  g_mutex_clear (&dap->zone_lock);
+  g_cond_clear (&dap->zone_cond);
   g_mutex_clear (&dap->lock);
   g_object_unref (dap->adapter);
 
@@ -1065,6 +1595,10 @@ add_format_to_structure (GstCapsFeatures * features,
   GstStructure *s = (GstStructure *) user_data;
   const GValue *format;
 
+  /* native format input converts to any output format */
+  if (gst_structure_has_name (other, DLB_AUDIO_LFRACT_CAPS_NAME))
+    return TRUE;
+
   if ((format = gst_structure_get_value (s, "format")))
     gst_structure_set_value (other, "format", format);
 
@@ -1135,12 +1669,25 @@ dlb_dap_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
   dlb_dap_channel_format infmt, outfmt;
   guint64 outchmask = 0, inchmask = 0;
   int channels, rate;
+  gboolean cacheable;
+  guint cookie = 0;
 
   GST_DEBUG_OBJECT (dap, "Transform caps (direction %d)", direction);
 
   if (!(s = gst_caps_get_structure (caps, 0)))
     return NULL;
 
+  g_mutex_lock (&dap->lock);
+  dlb_dap_update_json_config_unlocked (dap);
+  cacheable = !dap->global_conf.use_serialized_settings;
+  g_mutex_unlock (&dap->lock);
+
+  /* serialized config is selected here for the stream rate, so such
+   * results are always derived again */
+  if (cacheable && (othercaps = dlb_caps_cache_lookup (dap->caps_cache,
+              direction, caps, filter, &cookie)))
+    return othercaps;
+
   if (direction == GST_PAD_SRC) {
     /* transform caps going upstream */
     othercaps = gst_static_pad_template_get_caps (&dlb_dap_sink_template);
@@ -1159,6 +1706,10 @@ dlb_dap_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
       dap_format_to_channel_mask (&infmt, &inchmask);
 
       othercaps = caps_add_channel_configuration (othercaps, s, inchmask);
+
+      /* native format from other Dolby elements is preferred */
+      othercaps = gst_caps_merge (dlb_audio_caps_to_lfract (othercaps),
+          othercaps);
     }
   } else {
     /* transform caps going downstream */
@@ -1170,13 +1721,12 @@ dlb_dap_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
 
       GstStructure *other = gst_caps_get_structure (othercaps, 0);
 
-      dlb_dap_get_serialized_config_from_json (dap, rate,
-          dap->virtualizer_enable, TRUE);
-
-      if (!dap->serialized_config)
+      if (!dlb_dap_select_serialized_config (dap, rate,
+              dap->virtualizer_enable))
         goto config_error;
 
-      dlb_dap_preprocess_serialized_config (dap->serialized_config,
+      dlb_dap_preprocess_serialized_config (g_bytes_get_data
+          (dap->serialized_config, NULL),
           &dap->outfmt, &channels, &dap->virtualizer_enable);
 
       gst_structure_set (other, "channels", G_TYPE_INT, channels,
@@ -1199,11 +1749,15 @@ dlb_dap_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
     gst_caps_unref (othercaps);
     GST_DEBUG_OBJECT (dap, "Intersection %" GST_PTR_FORMAT, intersect);
 
-    return intersect;
-  } else {
-    return othercaps;
+    othercaps = intersect;
   }
 
+  if (cacheable)
+    dlb_caps_cache_insert (dap->caps_cache, direction, caps, filter,
+        othercaps, cookie);
+
+  return othercaps;
+
 config_error:
   GST_ERROR_OBJECT (dap, "Could not find serialized config for given settings: "
       "rate %d, virt: %d", rate, dap->virtualizer_enable);
@@ -1212,32 +1766,284 @@ config_error:
   return NULL;
 }
 
-static gboolean
-dlb_dap_open (DlbDap * dap)
+/* Runtime configuration switching. New instance is created on a worker
+ * thread, then both instances run until the new one fills its latency and
+ * the output is crossfaded over crossfade-blocks with equal-power gains.
+ * With no crossfade blocks it takes over at the block boundary where it
+ * becomes ready. */
+typedef struct
 {
+  gint ref_count;
+  gint done;
   dlb_dap_init_info info;
+  GBytes *serialized_config;
+  gboolean retire;
 
-  info.virtualizer_enable = dap->virtualizer_enable;
-  info.sample_rate = dap->ininfo.rate;
-  info.output_format = dap->outfmt;
-  info.serialized_config = dap->serialized_config;
+  /* instance built by the task, or the retired one to release */
+  dlb_dap *instance;
+} DlbDapSwitchTask;
 
-  if (!dap->dap_instance) {
-    dap->dap_instance = dlb_dap_new (&info);
+static gboolean
+serialized_config_equal (GBytes * a, GBytes * b)
+{
+  return a == b || (a && b && g_bytes_equal (a, b));
+}
 
-    if (!dap->dap_instance) {
+static DlbDapSwitchTask *
+dlb_dap_switch_task_ref (DlbDapSwitchTask * task)
+{
+  g_atomic_int_inc (&task->ref_count);
+  return task;
+}
+
+/* result which was never picked up is released with the task */
+static void
+dlb_dap_switch_task_unref (DlbDapSwitchTask * task)
+{
+  if (!g_atomic_int_dec_and_test (&task->ref_count))
+    return;
+
+  if (task->instance)
+    dlb_dap_free (task->instance);
+
+  if (task->serialized_config)
+    g_bytes_unref (task->serialized_config);
+
+  g_slice_free (DlbDapSwitchTask, task);
+}
+
+static void
+dlb_dap_switch_task_func (gpointer data, gpointer user_data)
+{
+  DlbDapSwitchTask *task = data;
+
+  if (task->retire) {
+    dlb_dap_free (task->instance);
+    task->instance = NULL;
+  } else {
+    task->instance = dlb_dap_new (&task->info);
+    g_atomic_int_set (&task->done, 1);
+  }
+
+  dlb_dap_switch_task_unref (task);
+}
+
+static void
+dlb_dap_switch_push_task (DlbDap * dap, DlbDapSwitchTask * task)
+{
+  if (!dap->switch_pool)
+    dap->switch_pool = g_thread_pool_new (dlb_dap_switch_task_func, NULL, 1,
+        FALSE, NULL);
+
+  g_thread_pool_push (dap->switch_pool, task, NULL);
+}
+
+static void
+dlb_dap_switch_retire (DlbDap * dap, dlb_dap * instance)
+{
+  DlbDapSwitchTask *task = g_slice_new0 (DlbDapSwitchTask);
+
+  task->ref_count = 1;
+  task->retire = TRUE;
+  task->instance = instance;
+  dlb_dap_switch_push_task (dap, task);
+}
+
+static void
+dlb_dap_switch_reset (DlbDap * dap)
+{
+  /* pending instance creation is not waited for, its result is dropped
+   * once done. Queued tasks are completed by the pool in background. */
+  if (dap->switch_pool) {
+    g_thread_pool_free (dap->switch_pool, FALSE, FALSE);
+    dap->switch_pool = NULL;
+  }
+
+  g_clear_pointer (&dap->switch_task, dlb_dap_switch_task_unref);
+
+  if (dap->next_instance)
+    dlb_dap_free (dap->next_instance);
+
+  g_clear_pointer (&dap->switch_serialized_config, g_bytes_unref);
+  g_clear_pointer (&dap->fade_buffer, g_free);
+
+  dap->switch_pending = FALSE;
+  dap->next_instance = NULL;
+}
+
+static void
+dlb_dap_switch_handover (DlbDap * dap)
+{
+  GST_DEBUG_OBJECT (dap, "Switch finished, releasing old DAP instance");
+
+  /* release of the old instance is kept away from the streaming thread */
+  dlb_dap_switch_retire (dap, dap->dap_instance);
+
+  dap->dap_instance = dap->next_instance;
+  dap->next_instance = NULL;
+
+  dap->instance_virtualizer_enable = dap->switch_virtualizer_enable;
+  g_clear_pointer (&dap->instance_serialized_config, g_bytes_unref);
+  dap->instance_serialized_config = dap->switch_serialized_config;
+  dap->switch_serialized_config = NULL;
+
+  dap->switches++;
+}
+
+/* must be called with dap->lock held, at block boundary */
+static void
+dlb_dap_switch_check_unlocked (DlbDap * dap)
+{
+  DlbDapSwitchTask *task;
+  dlb_dap *instance;
+
+  if (!dap->dap_instance || dap->next_instance || dap->output_changed)
+    return;
+
+  if (dap->switch_pending) {
+    task = dap->switch_task;
+    if (!g_atomic_int_get (&task->done))
+      return;
+
+    instance = task->instance;
+    task->instance = NULL;
+    g_clear_pointer (&dap->switch_task, dlb_dap_switch_task_unref);
+    dap->switch_pending = FALSE;
+
+    if (!instance) {
+      GST_ELEMENT_WARNING (dap, LIBRARY, INIT, (NULL),
+          ("Failed to open DAP for configuration switch"));
+      return;
+    }
+
+    /* without crossfade the new instance takes over right away */
+    if (!dap->crossfade_blocks) {
+      GST_DEBUG_OBJECT (dap, "Configuration changed, replacing DAP instance");
+
+      dlb_dap_apply_settings (dap, instance, DLB_DAP_SETTINGS_ALL);
+      dap->next_instance = instance;
+      dlb_dap_switch_handover (dap);
+      return;
+    }
+
+    GST_DEBUG_OBJECT (dap, "Crossfading to new DAP instance");
+
+    if (!dap->fade_buffer)
+      dap->fade_buffer = g_malloc (dap->outbufsz);
+
+    dap->next_instance = instance;
+    dap->fade_prime = dlb_dap_query_latency (instance);
+    dap->fade_pos = 0;
+    dap->fade_len =
+        dap->crossfade_blocks * dlb_dap_query_block_samples (instance);
+
+    if (dap->fade_ramp_len != dap->fade_len) {
+      g_free (dap->fade_ramp);
+      dap->fade_ramp = dlb_audio_crossfade_ramp_new (dap->fade_len);
+      dap->fade_ramp_len = dap->fade_len;
+    }
+
+    dlb_dap_apply_settings (dap, instance, DLB_DAP_SETTINGS_ALL);
+    return;
+  }
+
+  if (dap->virtualizer_enable == dap->instance_virtualizer_enable &&
+      serialized_config_equal (dap->serialized_config,
+          dap->instance_serialized_config))
+    return;
+
+  GST_DEBUG_OBJECT (dap, "Configuration changed, creating new DAP instance");
+
+  task = g_slice_new0 (DlbDapSwitchTask);
+  task->ref_count = 1;
+  task->info.virtualizer_enable = dap->virtualizer_enable;
+  task->info.sample_rate = dap->ininfo.rate;
+  task->info.output_format = dap->outfmt;
+
+  if (dap->serialized_config) {
+    task->serialized_config = g_bytes_ref (dap->serialized_config);
+    task->info.serialized_config =
+        g_bytes_get_data (task->serialized_config, NULL);
+  }
+
+  dap->switch_virtualizer_enable = dap->virtualizer_enable;
+  g_clear_pointer (&dap->switch_serialized_config, g_bytes_unref);
+  if (dap->serialized_config)
+    dap->switch_serialized_config = g_bytes_ref (dap->serialized_config);
+
+  dap->switch_pending = TRUE;
+  dap->switch_task = dlb_dap_switch_task_ref (task);
+  dlb_dap_switch_push_task (dap, task);
+}
+
+/* must be called with dap->lock held */
+static void
+dlb_dap_crossfade_block (DlbDap * dap, dlb_buffer * in, guint8 * outdata)
+{
+  gint64 start = g_get_monotonic_time ();
+  gint frames = dap->outbufsz / GST_AUDIO_INFO_BPF (&dap->outinfo);
+  dlb_buffer *out;
+
+  out = dlb_buffer_new_wrapped (dap->fade_buffer, &dap->outinfo,
+      !dap->force_order);
+  dlb_dap_process (dap->next_instance, &dap->infmt, in, out);
+  dlb_buffer_free (out);
+
+  if (dap->fade_prime > 0) {
+    /* output of new instance is valid once its latency is filled */
+    dap->fade_prime -= frames;
+  } else {
+    dlb_audio_crossfade (outdata, dap->fade_buffer, frames, &dap->outinfo,
+        dap->fade_ramp, dap->fade_pos, dap->fade_len);
+
+    dap->fade_pos += frames;
+  }
+
+  dap->crossfade_samples += frames;
+  dap->crossfade_time +=
+      (g_get_monotonic_time () - start) * GST_USECOND;
+
+  if (dap->fade_pos >= dap->fade_len)
+    dlb_dap_switch_handover (dap);
+}
+
+static gboolean
+dlb_dap_open (DlbDap * dap)
+{
+  dlb_dap_init_info info;
+
+  info.virtualizer_enable = dap->virtualizer_enable;
+  info.sample_rate = dap->ininfo.rate;
+  info.output_format = dap->outfmt;
+  info.serialized_config = dap->serialized_config ?
+      g_bytes_get_data (dap->serialized_config, NULL) : NULL;
+
+  if (!dap->dap_instance) {
+    dap->dap_instance = dlb_dap_new (&info);
+
+    if (!dap->dap_instance) {
       GST_ELEMENT_ERROR (dap, LIBRARY, INIT, (NULL), ("Failed to open DAP"));
       return FALSE;
     }
+
+    dap->instance_virtualizer_enable = dap->virtualizer_enable;
+    g_clear_pointer (&dap->instance_serialized_config, g_bytes_unref);
+    if (dap->serialized_config)
+      dap->instance_serialized_config = g_bytes_ref (dap->serialized_config);
   }
 
-  dlb_dap_update_state (dap);
+  g_mutex_lock (&dap->lock);
+  dlb_dap_update_state_unlocked (dap);
+  dlb_dap_apply_settings (dap, dap->dap_instance, DLB_DAP_SETTINGS_ALL);
+  g_mutex_unlock (&dap->lock);
   return TRUE;
 }
 
 static void
 dlb_dap_close (DlbDap * dap)
 {
+  dlb_dap_switch_reset (dap);
+
   if (dap->dap_instance)
     dlb_dap_free (dap->dap_instance);
 
@@ -1251,16 +2057,23 @@ dlb_dap_set_caps (GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
   GstAudioInfo in, out;
   gsize blocksz, latency;
   guint64 inchmask, outchmask;
+  gboolean in_lfract;
 
   GST_DEBUG_OBJECT (dap, "incaps %" GST_PTR_FORMAT ", outcaps %" GST_PTR_FORMAT,
       incaps, outcaps);
 
-  if (!gst_audio_info_from_caps (&in, incaps))
+  if (!dlb_audio_info_from_caps (&in, incaps, &in_lfract))
     goto incaps_error;
   if (!gst_audio_info_from_caps (&out, outcaps))
     goto outcaps_error;
 
   dlb_dap_push_drain (dap);
+  dlb_dap_switch_reset (dap);
+
+  /* zones follow input rate and format, renegotiated on next buffer */
+  g_mutex_lock (&dap->lock);
+  dlb_dap_zones_close_unlocked (dap);
+  g_mutex_unlock (&dap->lock);
 
   gst_audio_channel_positions_to_mask (in.position, in.channels,
       FALSE, &inchmask);
@@ -1271,6 +2084,8 @@ dlb_dap_set_caps (GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
   channel_mask_to_dap_format (outchmask, &dap->outfmt);
   dap->ininfo = in;
   dap->outinfo = out;
+  dap->in_lfract = in_lfract;
+  dap->output_changed = FALSE;
 
   if (!dlb_dap_open (dap))
     return FALSE;
@@ -1384,8 +2199,9 @@ static gboolean
 dlb_dap_get_unit_size (GstBaseTransform * trans, GstCaps * caps, gsize * size)
 {
   GstAudioInfo info;
+  gboolean lfract;
 
-  if (!gst_audio_info_from_caps (&info, caps))
+  if (!dlb_audio_info_from_caps (&info, caps, &lfract))
     goto caps_error;
 
   *size = GST_AUDIO_INFO_BPF (&info);
@@ -1403,8 +2219,11 @@ dlb_dap_start (GstBaseTransform * trans)
 {
   DlbDap *dap = DLB_DAP (trans);
 
-  if (dap->json_config_path)
-    dlb_dap_get_config_from_json (dap);
+  /* settings reset by stop () are restored from already parsed config */
+  g_mutex_lock (&dap->lock);
+  if (!dlb_dap_update_json_config_unlocked (dap) && dap->json_config)
+    dlb_dap_apply_json_config_unlocked (dap, dap->json_config);
+  g_mutex_unlock (&dap->lock);
 
   return TRUE;
 }
@@ -1417,6 +2236,19 @@ dlb_dap_stop (GstBaseTransform * trans)
   dlb_dap_close (dap);
   gst_adapter_clear (dap->adapter);
 
+  g_mutex_lock (&dap->lock);
+  dlb_dap_zones_close_unlocked (dap);
+
+  dap->audible_end = 0;
+  dap->silent_samples = 0;
+  dap->idle = FALSE;
+
+  if (dap->zone_pool) {
+    g_thread_pool_free (dap->zone_pool, FALSE, TRUE);
+    dap->zone_pool = NULL;
+  }
+  g_mutex_unlock (&dap->lock);
+
   gst_audio_info_init (&dap->ininfo);
   gst_audio_info_init (&dap->outinfo);
 
@@ -1461,20 +2293,572 @@ dlb_dap_get_input_timing (DlbDap * dap, GstClockTime * timestamp,
 }
 
 static void
-dlb_dap_set_output_timing (DlbDap * dap, GstBuffer * outbuf,
+dlb_dap_set_output_timing (GstAudioInfo * outinfo, GstBuffer * outbuf,
     GstClockTime timestamp, guint64 offset)
 {
   gsize outsize = gst_buffer_get_size (outbuf);
-  gint outsamples = outsize / dap->outinfo.bpf;
+  gint outsamples = outsize / outinfo->bpf;
 
   GST_BUFFER_PTS (outbuf) = timestamp;
   GST_BUFFER_DURATION (outbuf) =
-      gst_util_uint64_scale_int (outsamples, GST_SECOND, dap->outinfo.rate);
+      gst_util_uint64_scale_int (outsamples, GST_SECOND, outinfo->rate);
 
   GST_BUFFER_OFFSET (outbuf) = offset;
   GST_BUFFER_OFFSET_END (outbuf) = offset + outsamples;
 }
 
+/* secondary output zones */
+static void
+dlb_dap_zone_close (DlbDapZonePad * zone)
+{
+  if (zone->instance)
+    dlb_dap_free (zone->instance);
+
+  zone->instance = NULL;
+  g_atomic_int_set (&zone->negotiate, TRUE);
+
+  /* instance being built is released with the task */
+  g_clear_pointer (&zone->task, dlb_dap_switch_task_unref);
+  gst_clear_caps (&zone->task_caps);
+
+  if (zone->pool) {
+    gst_buffer_pool_set_active (zone->pool, FALSE);
+    gst_clear_object (&zone->pool);
+  }
+  zone->pool_size = 0;
+}
+
+/* buffers are recycled across transform calls, the pool is replaced when
+ * the zone output size changes */
+static GstBuffer *
+dlb_dap_zone_acquire_buffer (DlbDapZonePad * zone, gsize size)
+{
+  GstStructure *config;
+  GstBuffer *buf = NULL;
+
+  if (G_UNLIKELY (!zone->pool || zone->pool_size != size)) {
+    if (zone->pool) {
+      gst_buffer_pool_set_active (zone->pool, FALSE);
+      gst_object_unref (zone->pool);
+    }
+
+    zone->pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (zone->pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+
+    if (!gst_buffer_pool_set_config (zone->pool, config) ||
+        !gst_buffer_pool_set_active (zone->pool, TRUE)) {
+      gst_clear_object (&zone->pool);
+      zone->pool_size = 0;
+      return NULL;
+    }
+
+    zone->pool_size = size;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (zone->pool, &buf, NULL) != GST_FLOW_OK)
+    return NULL;
+
+  return buf;
+}
+
+/* must be called with dap->lock held */
+static void
+dlb_dap_zones_close_unlocked (DlbDap * dap)
+{
+  GList *l;
+
+  for (l = dap->zones; l; l = l->next)
+    dlb_dap_zone_close (l->data);
+}
+
+static GList *
+dlb_dap_zones_ref (DlbDap * dap)
+{
+  GList *zones;
+
+  g_mutex_lock (&dap->lock);
+  zones = g_list_copy_deep (dap->zones, (GCopyFunc) gst_object_ref, NULL);
+  g_mutex_unlock (&dap->lock);
+
+  return zones;
+}
+
+static void
+dlb_dap_zone_push_events (DlbDap * dap, DlbDapZonePad * zone, GstCaps * caps)
+{
+  GstPad *pad = GST_PAD_CAST (zone);
+  GstEvent *event;
+  gchar *stream_id;
+
+  if ((event = gst_pad_get_sticky_event (pad, GST_EVENT_STREAM_START, 0))) {
+    gst_event_unref (event);
+  } else {
+    stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT_CAST (dap),
+        GST_PAD_NAME (pad));
+    gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+    g_free (stream_id);
+  }
+
+  gst_pad_push_event (pad, gst_event_new_caps (caps));
+
+  event = gst_pad_get_sticky_event (GST_BASE_TRANSFORM_SINK_PAD (dap),
+      GST_EVENT_SEGMENT, 0);
+  if (event)
+    gst_pad_push_event (pad, event);
+}
+
+/* queries output caps and starts building a zone instance on the switch
+ * pool, called from the streaming thread, without dap->lock */
+static void
+dlb_dap_zone_negotiate (DlbDap * dap, DlbDapZonePad * zone)
+{
+  GstPad *pad = GST_PAD_CAST (zone);
+  GstCaps *templcaps, *caps;
+  GstStructure *s;
+  GstAudioInfo info;
+
+  DlbDapSwitchTask *task;
+  dlb_dap_channel_format outfmt;
+  guint64 outchmask;
+  gboolean virtualizer_enable;
+
+  g_atomic_int_set (&zone->negotiate, FALSE);
+
+  /* rate and sample format follow the input */
+  s = gst_structure_new ("audio/x-raw",
+      "format", G_TYPE_STRING, GST_AUDIO_INFO_NAME (&dap->ininfo),
+      "rate", G_TYPE_INT, GST_AUDIO_INFO_RATE (&dap->ininfo), NULL);
+
+  templcaps = gst_caps_make_writable (gst_pad_get_pad_template_caps (pad));
+  gst_caps_map_in_place (templcaps, add_format_to_structure, s);
+  gst_caps_map_in_place (templcaps, add_rate_to_structure, s);
+  gst_structure_free (s);
+
+  caps = gst_pad_peer_query_caps (pad, templcaps);
+  gst_caps_unref (templcaps);
+
+  if (gst_caps_is_empty (caps))
+    goto caps_error;
+
+  caps = gst_caps_fixate (caps);
+  if (!gst_audio_info_from_caps (&info, caps))
+    goto caps_error;
+
+  gst_audio_channel_positions_to_mask (info.position, info.channels,
+      FALSE, &outchmask);
+  channel_mask_to_dap_format (outchmask, &outfmt);
+
+  if (!is_format_valid (&outfmt))
+    goto caps_error;
+
+  GST_OBJECT_LOCK (zone);
+  virtualizer_enable = zone->virtualizer_enable;
+  GST_OBJECT_UNLOCK (zone);
+
+  g_mutex_lock (&dap->lock);
+
+  /* pad was released in the meantime */
+  if (!g_list_find (dap->zones, zone))
+    goto released;
+
+  /* a build already started for another output is dropped */
+  g_clear_pointer (&zone->task, dlb_dap_switch_task_unref);
+  gst_clear_caps (&zone->task_caps);
+
+  /* reconfigure with unchanged output keeps the running instance */
+  if (zone->instance && gst_audio_info_is_equal (&info, &zone->outinfo)
+      && virtualizer_enable == zone->instance_virtualizer_enable)
+    goto released;
+
+  GST_DEBUG_OBJECT (zone, "Opening DAP for %" GST_PTR_FORMAT, caps);
+
+  task = g_slice_new0 (DlbDapSwitchTask);
+  task->ref_count = 1;
+  task->info.sample_rate = GST_AUDIO_INFO_RATE (&dap->ininfo);
+  task->info.virtualizer_enable = virtualizer_enable;
+  task->info.output_format = outfmt;
+  task->info.serialized_config = NULL;
+
+  zone->task = dlb_dap_switch_task_ref (task);
+  zone->task_caps = caps;
+  zone->task_info = info;
+  dlb_dap_switch_push_task (dap, task);
+  g_mutex_unlock (&dap->lock);
+  return;
+
+released:
+  g_mutex_unlock (&dap->lock);
+  gst_caps_unref (caps);
+  return;
+
+caps_error:
+  GST_ELEMENT_WARNING (dap, CORE, NEGOTIATION, (NULL),
+      ("No supported output format for zone %s", GST_PAD_NAME (pad)));
+  gst_caps_unref (caps);
+}
+
+/* installs the instance built for the zone once it is ready, its caps are
+ * pushed first. Called from the streaming thread at buffer boundary,
+ * without dap->lock. */
+static void
+dlb_dap_zone_attach (DlbDap * dap, DlbDapZonePad * zone)
+{
+  DlbDapSwitchTask *task;
+  GstAudioInfo info;
+  GstCaps *caps;
+
+  dlb_dap_channel_format outfmt;
+  dlb_dap *instance;
+  gsize blocksz;
+  gboolean virtualizer_enable;
+
+  g_mutex_lock (&dap->lock);
+  task = zone->task;
+  if (!task || !g_atomic_int_get (&task->done)) {
+    g_mutex_unlock (&dap->lock);
+    return;
+  }
+
+  instance = task->instance;
+  task->instance = NULL;
+  virtualizer_enable = task->info.virtualizer_enable;
+  outfmt = task->info.output_format;
+  g_clear_pointer (&zone->task, dlb_dap_switch_task_unref);
+
+  caps = zone->task_caps;
+  zone->task_caps = NULL;
+  info = zone->task_info;
+  g_mutex_unlock (&dap->lock);
+
+  if (!instance)
+    goto open_error;
+
+  GST_DEBUG_OBJECT (zone, "Negotiated %" GST_PTR_FORMAT, caps);
+
+  dlb_dap_zone_push_events (dap, zone, caps);
+  gst_caps_unref (caps);
+
+  g_mutex_lock (&dap->lock);
+
+  /* pad was released in the meantime */
+  if (!g_list_find (dap->zones, zone)) {
+    g_mutex_unlock (&dap->lock);
+    dlb_dap_switch_retire (dap, instance);
+    return;
+  }
+
+  if (zone->instance)
+    dlb_dap_switch_retire (dap, zone->instance);
+
+  /* all instances share block size and latency for the given rate, so zone
+   * output stays aligned with the main output */
+  blocksz = dlb_dap_query_block_samples (instance);
+
+  zone->instance = instance;
+  zone->instance_virtualizer_enable = virtualizer_enable;
+  zone->outinfo = info;
+  zone->outfmt = outfmt;
+  zone->outbufsz = blocksz * GST_AUDIO_INFO_BPF (&info);
+  zone->latency_samples =
+      dap->discard_latency ? dlb_dap_query_latency (instance) : 0;
+  zone->latency_time = gst_util_uint64_scale_int (zone->latency_samples,
+      GST_SECOND, GST_AUDIO_INFO_RATE (&info));
+  zone->prefill = zone->latency_samples;
+
+  dlb_dap_zone_apply_settings (dap, zone, DLB_DAP_SETTINGS_ALL);
+  g_mutex_unlock (&dap->lock);
+  return;
+
+open_error:
+  GST_ELEMENT_WARNING (dap, LIBRARY, INIT, (NULL),
+      ("Failed to open DAP for zone %s", GST_PAD_NAME (zone)));
+  gst_caps_unref (caps);
+}
+
+static void
+dlb_dap_zones_negotiate (DlbDap * dap)
+{
+  GList *zones, *l;
+
+  zones = dlb_dap_zones_ref (dap);
+
+  for (l = zones; l; l = l->next) {
+    DlbDapZonePad *zone = l->data;
+
+    if (gst_pad_check_reconfigure (GST_PAD_CAST (zone)) ||
+        g_atomic_int_get (&zone->negotiate))
+      dlb_dap_zone_negotiate (dap, zone);
+
+    dlb_dap_zone_attach (dap, zone);
+  }
+
+  g_list_free_full (zones, gst_object_unref);
+}
+
+static dlb_buffer *
+dlb_dap_wrap_input (DlbDap * dap, const guint8 * data)
+{
+  dlb_buffer *buf = dlb_buffer_new_wrapped (data, &dap->ininfo, TRUE);
+
+  if (buf && dap->in_lfract)
+    buf->data_type = DLB_BUFFER_LFRACT;
+
+  return buf;
+}
+
+static void
+dlb_dap_zone_process (DlbDap * dap, DlbDapZonePad * zone,
+    const guint8 * indata)
+{
+  gint i;
+
+  for (i = 0; i < dap->transform_blocks; ++i) {
+    dlb_buffer *in, *out;
+
+    in = dlb_dap_wrap_input (dap, indata + i * dap->inbufsz);
+    out = dlb_buffer_new_wrapped (zone->outmap.data + i * zone->outbufsz,
+        &zone->outinfo, !dap->force_order);
+
+    dlb_dap_process (zone->instance, &dap->infmt, in, out);
+
+    dlb_buffer_free (in);
+    dlb_buffer_free (out);
+  }
+}
+
+static void
+dlb_dap_zone_task_func (gpointer data, gpointer user_data)
+{
+  DlbDap *dap = user_data;
+
+  dlb_dap_zone_process (dap, data, dap->zone_indata);
+
+  g_mutex_lock (&dap->zone_lock);
+  if (--dap->zones_pending == 0)
+    g_cond_signal (&dap->zone_cond);
+  g_mutex_unlock (&dap->zone_lock);
+}
+
+/* must be called with dap->lock held, input stays mapped until
+ * dlb_dap_zones_finish_unlocked returns */
+static void
+dlb_dap_zones_start_unlocked (DlbDap * dap, const guint8 * indata)
+{
+  GList *l;
+
+  dap->zone_indata = indata;
+
+  for (l = dap->zones; l; l = l->next) {
+    DlbDapZonePad *zone = l->data;
+
+    if (!zone->instance)
+      continue;
+
+    zone->outbuf = dlb_dap_zone_acquire_buffer (zone,
+        dap->transform_blocks * zone->outbufsz);
+    if (G_UNLIKELY (!zone->outbuf)) {
+      GST_WARNING_OBJECT (zone, "Failed to allocate output buffer");
+      continue;
+    }
+
+    gst_buffer_map (zone->outbuf, &zone->outmap, GST_MAP_WRITE);
+
+    if (!dap->zone_threads)
+      continue;
+
+    if (!dap->zone_pool)
+      dap->zone_pool = g_thread_pool_new (dlb_dap_zone_task_func, dap,
+          dap->zone_threads, FALSE, NULL);
+
+    g_mutex_lock (&dap->zone_lock);
+    dap->zones_pending++;
+    g_mutex_unlock (&dap->zone_lock);
+
+    dap->zones_busy = TRUE;
+    g_thread_pool_push (dap->zone_pool, zone, NULL);
+  }
+}
+
+/* must be called with dap->lock held */
+static void
+dlb_dap_zones_finish_unlocked (DlbDap * dap, GstClockTime timestamp,
+    guint64 offset, GPtrArray * pads, GPtrArray * buffers)
+{
+  GList *l;
+
+  if (dap->zones_busy) {
+    g_mutex_lock (&dap->zone_lock);
+    while (dap->zones_pending)
+      g_cond_wait (&dap->zone_cond, &dap->zone_lock);
+    g_mutex_unlock (&dap->zone_lock);
+  }
+
+  for (l = dap->zones; l; l = l->next) {
+    DlbDapZonePad *zone = l->data;
+    GstBuffer *outbuf = zone->outbuf;
+    GstClockTime ts = timestamp;
+    guint64 off = offset;
+    gsize outsize;
+
+    if (!outbuf)
+      continue;
+
+    if (!dap->zones_busy)
+      dlb_dap_zone_process (dap, zone, dap->zone_indata);
+
+    gst_buffer_unmap (outbuf, &zone->outmap);
+    zone->outbuf = NULL;
+
+    outsize = gst_buffer_get_size (outbuf);
+
+    if (G_UNLIKELY (zone->prefill)) {
+      gsize bpf = GST_AUDIO_INFO_BPF (&zone->outinfo);
+      gsize trim = MIN (zone->prefill * bpf, outsize);
+      gint delay = zone->latency_samples - zone->prefill;
+
+      /* latency may span several buffers, output lags the input by what
+       * was discarded before this one */
+      gst_buffer_resize (outbuf, trim, outsize - trim);
+      zone->prefill -= trim / bpf;
+
+      ts -= gst_util_uint64_scale_int (delay, GST_SECOND,
+          GST_AUDIO_INFO_RATE (&zone->outinfo));
+      off -= delay;
+
+      if (!gst_buffer_get_size (outbuf)) {
+        gst_buffer_unref (outbuf);
+        continue;
+      }
+    } else {
+      ts -= zone->latency_time;
+      off -= zone->latency_samples;
+    }
+
+    if (G_UNLIKELY (dap->drain_samples)) {
+      outsize = dap->drain_samples * GST_AUDIO_INFO_BPF (&zone->outinfo);
+      gst_buffer_resize (outbuf, 0, MIN (outsize,
+              gst_buffer_get_size (outbuf)));
+    }
+
+    dlb_dap_set_output_timing (&zone->outinfo, outbuf, ts, off);
+
+    g_ptr_array_add (pads, gst_object_ref (zone));
+    g_ptr_array_add (buffers, outbuf);
+  }
+
+  dap->zones_busy = FALSE;
+  dap->zone_indata = NULL;
+
+  if (dap->zones_groups) {
+    dlb_dap_zones_apply_settings_unlocked (dap, dap->zones_groups);
+    dap->zones_groups = 0;
+  }
+}
+
+static void
+dlb_dap_zones_push (DlbDap * dap, GPtrArray * pads, GPtrArray * buffers)
+{
+  GstFlowReturn ret;
+  guint i;
+
+  for (i = 0; i < pads->len; ++i) {
+    GstPad *pad = g_ptr_array_index (pads, i);
+
+    /* secondary zones never stop the main output */
+    ret = gst_pad_push (pad, g_ptr_array_index (buffers, i));
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED &&
+        ret != GST_FLOW_FLUSHING)
+      GST_WARNING_OBJECT (pad, "Pushing failed: %s", gst_flow_get_name (ret));
+
+    gst_object_unref (pad);
+  }
+
+  g_ptr_array_free (pads, TRUE);
+  g_ptr_array_free (buffers, TRUE);
+}
+
+static void
+dlb_dap_zones_push_event (DlbDap * dap, GstEvent * event)
+{
+  GList *zones, *l;
+
+  zones = dlb_dap_zones_ref (dap);
+
+  /* not negotiated zones pick up segment when caps are set */
+  for (l = zones; l; l = l->next) {
+    DlbDapZonePad *zone = l->data;
+
+    if (gst_pad_has_current_caps (GST_PAD_CAST (zone)))
+      gst_pad_push_event (GST_PAD_CAST (zone), gst_event_ref (event));
+  }
+
+  g_list_free_full (zones, gst_object_unref);
+}
+
+static GstPad *
+dlb_dap_request_new_pad (GstElement * element, GstPadTemplate * templ,
+    const gchar * req_name, const GstCaps * caps)
+{
+  DlbDap *dap = DLB_DAP (element);
+  GstPad *pad;
+  gchar *name;
+
+  g_mutex_lock (&dap->lock);
+  if (req_name)
+    name = g_strdup (req_name);
+  else
+    name = g_strdup_printf ("src_%u", dap->zone_serial++);
+  g_mutex_unlock (&dap->lock);
+
+  pad = g_object_new (DLB_TYPE_DAP_ZONE_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
+  g_free (name);
+
+  if (GST_STATE (element) > GST_STATE_READY)
+    gst_pad_set_active (pad, TRUE);
+
+  if (!gst_element_add_pad (element, pad))
+    goto error;
+
+  g_mutex_lock (&dap->lock);
+  dap->zones = g_list_append (dap->zones, gst_object_ref (pad));
+  g_mutex_unlock (&dap->lock);
+
+  GST_DEBUG_OBJECT (dap, "new pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+
+error:
+  {
+    GST_DEBUG_OBJECT (element, "could not create/add pad");
+    return NULL;
+  }
+}
+
+static void
+dlb_dap_release_pad (GstElement * element, GstPad * pad)
+{
+  DlbDap *dap = DLB_DAP (element);
+  DlbDapZonePad *zone = DLB_DAP_ZONE_PAD (pad);
+  GList *link;
+
+  GST_DEBUG_OBJECT (dap, "release pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  g_mutex_lock (&dap->lock);
+  if ((link = g_list_find (dap->zones, zone))) {
+    dap->zones = g_list_delete_link (dap->zones, link);
+    dlb_dap_zone_close (zone);
+  }
+  g_mutex_unlock (&dap->lock);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (element, pad);
+
+  if (link)
+    gst_object_unref (zone);
+}
+
 static void
 dlb_dap_handle_tag_list (DlbDap * dap, GstTagList * taglist)
 {
@@ -1482,6 +2866,8 @@ dlb_dap_handle_tag_list (DlbDap * dap, GstTagList * taglist)
   guint64 offset;
   gchar *audio_codec = NULL;
   gboolean object_audio = FALSE;
+  gboolean surround_decoder_enable;
+  DlbDapParams *params;
 
   if (gst_tag_list_get_string (taglist, "audio-codec", &audio_codec)) {
     gst_tag_list_get_boolean (taglist, "object-audio", &object_audio);
@@ -1489,17 +2875,21 @@ dlb_dap_handle_tag_list (DlbDap * dap, GstTagList * taglist)
     GST_DEBUG_OBJECT (dap, "audio_codec %s, object-audio %d", audio_codec,
         object_audio);
 
+    params = dlb_param_mailbox_lock (dap->params);
+    surround_decoder_enable = params->profile.surround_decoder_enable;
+
     if (strstr (audio_codec, "E-AC-3") || strstr (audio_codec, "AC-3")) {
-      dap->profile.volume_leveler_in_target = -496;
+      params->profile.volume_leveler_in_target = -496;
       gst_tag_list_add (taglist, GST_TAG_MERGE_REPLACE,
-          "surround-decoder-enable", dap->profile.surround_decoder_enable,
-          NULL);
+          "surround-decoder-enable", surround_decoder_enable, NULL);
     } else if (dap->ininfo.channels > 2) {
-      dap->profile.volume_leveler_in_target = -432;
+      params->profile.volume_leveler_in_target = -432;
     } else {
-      dap->profile.volume_leveler_in_target = -320;
+      params->profile.volume_leveler_in_target = -320;
     }
 
+    dlb_param_mailbox_unlock (dap->params, DLB_DAP_SETTINGS_PROFILE);
+
     dlb_dap_get_input_timing (dap, &timestamp, &offset);
 
     if (dap->ininfo.bpf && dap->ininfo.rate) {
@@ -1509,9 +2899,8 @@ dlb_dap_handle_tag_list (DlbDap * dap, GstTagList * taglist)
     }
 
     dlb_dap_post_stream_info_message (dap, audio_codec, object_audio,
-        dap->profile.surround_decoder_enable, timestamp);
+        surround_decoder_enable, timestamp);
 
-    dlb_dap_update_state (dap);
     g_free (audio_codec);
   }
 }
@@ -1540,6 +2929,12 @@ dlb_dap_sink_event (GstBaseTransform * trans, GstEvent * event)
       break;
   }
 
+  /* zones send their own stream-start and caps */
+  if (GST_EVENT_IS_DOWNSTREAM (event) &&
+      GST_EVENT_TYPE (event) != GST_EVENT_STREAM_START &&
+      GST_EVENT_TYPE (event) != GST_EVENT_CAPS)
+    dlb_dap_zones_push_event (dap, event);
+
   return GST_BASE_TRANSFORM_CLASS (dlb_dap_parent_class)->sink_event (trans,
       event);
 }
@@ -1597,7 +2992,7 @@ dlb_dap_push_drain (DlbDap * dap)
     gst_object_unref (allocator);
 
   dlb_dap_get_input_timing (dap, &timestamp, &offset);
-  dlb_dap_set_output_timing (dap, inbuf, timestamp, offset);
+  dlb_dap_set_output_timing (&dap->outinfo, inbuf, timestamp, offset);
 
   ret =
       GST_BASE_TRANSFORM_CLASS (dlb_dap_parent_class)->prepare_output_buffer
@@ -1606,7 +3001,11 @@ dlb_dap_push_drain (DlbDap * dap)
   if (ret != GST_FLOW_OK)
     goto outbuf_error;
 
+  /* zones are trimmed to the same amount of samples */
+  dap->drain_samples = outsize / dap->outinfo.bpf;
   ret = dlb_dap_transform (trans, inbuf, outbuf);
+  dap->drain_samples = 0;
+
   if (ret != GST_FLOW_OK)
     goto transform_error;
 
@@ -1631,23 +3030,110 @@ outbuf_error:
   return ret;
 }
 
+/* tells whether the block can bypass the library. Instances are left alone
+ * only after they processed silence for idle-timeout plus their latency, so
+ * their internal state has decayed. Must be called with dap->lock held. */
+static gboolean
+dlb_dap_idle_check_unlocked (DlbDap * dap, const guint8 * indata, gint block)
+{
+  gsize start = block * dap->inbufsz;
+  gsize samples = dap->inbufsz / GST_AUDIO_INFO_BPF (&dap->ininfo);
+  guint64 decay;
+
+  /* samples of the native format are opaque, silence is not recognized */
+  if (!GST_CLOCK_TIME_IS_VALID (dap->idle_timeout) || dap->in_lfract)
+    return FALSE;
+
+  /* data appended by GAP buffers is known to be silent */
+  if (start < dap->audible_end && !dlb_audio_is_silent (indata + start,
+          samples, &dap->ininfo, dap->silence_threshold)) {
+    if (G_UNLIKELY (dap->idle))
+      GST_DEBUG_OBJECT (dap, "Input is audible, leaving idle state");
+
+    dap->idle = FALSE;
+    dap->silent_samples = 0;
+    return FALSE;
+  }
+
+  /* zones and crossfades need the instances running */
+  if (dap->zones || dap->next_instance) {
+    dap->idle = FALSE;
+    dap->silent_samples = 0;
+    return FALSE;
+  }
+
+  if (dap->idle)
+    return TRUE;
+
+  decay = gst_util_uint64_scale_int (dap->idle_timeout,
+      GST_AUDIO_INFO_RATE (&dap->ininfo), GST_SECOND);
+  decay += dlb_dap_query_latency (dap->dap_instance);
+
+  if (dap->silent_samples < decay) {
+    dap->silent_samples += samples;
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (dap, "Input is silent, entering idle state");
+  dap->idle = TRUE;
+  return TRUE;
+}
+
+/* must be called with dap->lock held, property changes made by controller
+ * are published to the mailbox and picked up at the same block boundary */
+static void
+dlb_dap_sync_values_unlocked (DlbDap * dap, GstClockTime timestamp,
+    gint block)
+{
+  GstSegment *segment = &GST_BASE_TRANSFORM_CAST (dap)->segment;
+  GstClockTime stream_time;
+  gsize blocksz = dap->inbufsz / GST_AUDIO_INFO_BPF (&dap->ininfo);
+
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+    return;
+
+  timestamp += gst_util_uint64_scale_int (block * blocksz, GST_SECOND,
+      GST_AUDIO_INFO_RATE (&dap->ininfo));
+  stream_time = gst_segment_to_stream_time (segment, GST_FORMAT_TIME,
+      timestamp);
+
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time))
+    return;
+
+  gst_object_sync_values (GST_OBJECT_CAST (dap), stream_time);
+}
+
 static GstFlowReturn
 dlb_dap_transform (GstBaseTransform * trans, GstBuffer * inbuf,
     GstBuffer * outbuf)
 {
   DlbDap *dap = DLB_DAP (trans);
   GstMapInfo outmap;
-  gint i;
+  GPtrArray *zonepads = NULL, *zonebufs = NULL;
+  const guint8 *indata;
+  gboolean sync;
+  gint i, bypassed = 0;
+  gsize flushed;
 
   GstClockTime timestamp;
   guint64 offset;
   gsize outsize;
 
+  dlb_dap_zones_negotiate (dap);
+
   g_mutex_lock (&dap->lock);
 
+  /* renegotiation kept the caps, running layout stays valid */
+  if (G_UNLIKELY (dap->output_changed) &&
+      !gst_pad_needs_reconfigure (GST_BASE_TRANSFORM_SRC_PAD (trans)))
+    dap->output_changed = FALSE;
+
   gst_buffer_ref (inbuf);
   gst_adapter_push (dap->adapter, inbuf);
 
+  if (!GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))
+    dap->audible_end = gst_adapter_available (dap->adapter);
+
   if (G_UNLIKELY (gst_adapter_available (dap->adapter) <= dap->prefill) ||
       dap->transform_blocks == 0)
     goto no_output;
@@ -1655,24 +3141,71 @@ dlb_dap_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   dlb_dap_get_input_timing (dap, &timestamp, &offset);
   gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
 
+  /* all blocks are staged once and shared by every output zone */
+  indata = gst_adapter_map (dap->adapter,
+      dap->transform_blocks * dap->inbufsz);
+
+  if (G_UNLIKELY (dap->zones)) {
+    zonepads = g_ptr_array_new ();
+    zonebufs = g_ptr_array_new ();
+    dlb_dap_zones_start_unlocked (dap, indata);
+  }
+
+  sync = gst_object_has_active_control_bindings (GST_OBJECT_CAST (dap));
+
   for (i = 0; i < dap->transform_blocks; ++i) {
     dlb_buffer *in, *out;
-    const guint8 *indata = gst_adapter_map (dap->adapter, dap->inbufsz);
-    const guint8 *outdata = outmap.data + i * dap->outbufsz;
+    guint8 *outdata;
+
+    /* hot reloaded json config, automation and property changes are
+     * applied at block boundary */
+    dlb_dap_update_json_config_unlocked (dap);
+
+    if (G_UNLIKELY (sync))
+      dlb_dap_sync_values_unlocked (dap, timestamp, i);
+
+    dlb_dap_update_state_unlocked (dap);
+
+    outdata = outmap.data + i * dap->outbufsz;
 
-    in = dlb_buffer_new_wrapped (indata, &dap->ininfo, TRUE);
+    dlb_dap_switch_check_unlocked (dap);
+
+    if (dlb_dap_idle_check_unlocked (dap, indata, i)) {
+      memset (outdata, 0, dap->outbufsz);
+      dap->bypassed_blocks++;
+      bypassed++;
+      continue;
+    }
+
+    in = dlb_dap_wrap_input (dap, indata + i * dap->inbufsz);
     out = dlb_buffer_new_wrapped (outdata, &dap->outinfo, !dap->force_order);
 
     dlb_dap_process (dap->dap_instance, &dap->infmt, in, out);
 
-    gst_adapter_unmap (dap->adapter);
-    gst_adapter_flush (dap->adapter, dap->inbufsz);
+    if (dap->next_instance)
+      dlb_dap_crossfade_block (dap, in, outdata);
+
     dlb_buffer_free (in);
     dlb_buffer_free (out);
   }
 
+  if (G_UNLIKELY (zonepads))
+    dlb_dap_zones_finish_unlocked (dap, timestamp, offset, zonepads,
+        zonebufs);
+
+  gst_adapter_unmap (dap->adapter);
+  gst_adapter_flush (dap->adapter, dap->transform_blocks * dap->inbufsz);
   gst_buffer_unmap (outbuf, &outmap);
 
+  flushed = dap->transform_blocks * dap->inbufsz;
+  dap->audible_end = dap->audible_end > flushed ?
+      dap->audible_end - flushed : 0;
+
+  if (bypassed == dap->transform_blocks)
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
+  else
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+
   if (G_UNLIKELY (dap->prefill)) {
     outsize = gst_buffer_get_size (outbuf);
     outsize -= dap->latency;
@@ -1685,12 +3218,16 @@ dlb_dap_transform (GstBaseTransform * trans, GstBuffer * inbuf,
     offset -= dap->latency_samples;
   }
 
-  dlb_dap_set_output_timing (dap, outbuf, timestamp, offset);
+  dlb_dap_set_output_timing (&dap->outinfo, outbuf, timestamp, offset);
 
   GST_LOG_OBJECT (dap, "inbuf %" GST_PTR_FORMAT ", outbuf %" GST_PTR_FORMAT,
       inbuf, outbuf);
 
   g_mutex_unlock (&dap->lock);
+
+  if (G_UNLIKELY (zonepads))
+    dlb_dap_zones_push (dap, zonepads, zonebufs);
+
   return GST_FLOW_OK;
 
 no_output:
@@ -1699,14 +3236,26 @@ no_output:
 }
 
 
-static gboolean
-plugin_init (GstPlugin * plugin)
+static GstStateChangeReturn
+dlb_dap_change_state (GstElement * element, GstStateChange transition)
 {
 #ifdef DLB_DAP_OPEN_DYNLIB
-  if (dlb_dap_try_open_dynlib ())
-    return FALSE;
+  /* vendor library is bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY
+      && dlb_dap_try_open_dynlib ()) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load DAP library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
 #endif
 
+  return GST_ELEMENT_CLASS (dlb_dap_parent_class)->change_state (element,
+      transition);
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
   if (!gst_element_register (plugin, "dlbdap", GST_RANK_PRIMARY, GST_TYPE_DAP))
     return FALSE;
 
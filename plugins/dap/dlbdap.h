@@ -26,6 +26,9 @@
 #include <gst/audio/audio.h>
 
 #include "dlbdapjson.h"
+#include "dlbconfigloader.h"
+#include "dlbparammailbox.h"
+#include "dlbcapscache.h"
 #include "dlb_dap.h"
 
 G_BEGIN_DECLS
@@ -36,9 +39,26 @@ G_BEGIN_DECLS
 #define GST_IS_DAP(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),GST_TYPE_DAP))
 #define GST_IS_DAP_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),GST_TYPE_DAP))
 
+#define DLB_TYPE_DAP_ZONE_PAD            (dlb_dap_zone_pad_get_type())
+#define DLB_DAP_ZONE_PAD(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),DLB_TYPE_DAP_ZONE_PAD,DlbDapZonePad))
+#define DLB_IS_DAP_ZONE_PAD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),DLB_TYPE_DAP_ZONE_PAD))
+
 typedef struct _DlbDap DlbDap;
 typedef struct _DlbDapClass DlbDapClass;
 
+typedef struct _DlbDapZonePad DlbDapZonePad;
+typedef struct _DlbDapZonePadClass DlbDapZonePadClass;
+
+typedef struct _DlbDapParams DlbDapParams;
+
+/* dynamic settings exchanged through the parameter mailbox */
+struct _DlbDapParams
+{
+  dlb_dap_virtualizer_settings virt_conf;
+  dlb_dap_gain_settings gains;
+  dlb_dap_profile_settings profile;
+};
+
 struct _DlbDap
 {
   GstBaseTransform base_dap;
@@ -47,6 +67,8 @@ struct _DlbDap
   GMutex lock;
   GstAudioInfo ininfo;
   GstAudioInfo outinfo;
+  /* input samples in the library native format */
+  gboolean in_lfract;
   GstAdapter *adapter;
 
   gint transform_blocks;
@@ -68,14 +90,72 @@ struct _DlbDap
   gboolean virtualizer_enable;
 
   dlb_dap_global_settings global_conf;
-  dlb_dap_virtualizer_settings virt_conf;
-  dlb_dap_gain_settings gains;
-  dlb_dap_profile_settings profile;
+  /* json config changed output layout, renegotiation pending */
+  gboolean output_changed;
+
+  /* transform_caps results, dropped when virtualizer or json config change */
+  DlbCapsCache *caps_cache;
 
-  guchar *serialized_config;
+  /* published by property setters, picked up at block boundary */
+  DlbParamMailbox *params;
+  /* snapshot pushed to DAP instances, protected by lock */
+  const DlbDapParams *applied;
 
-  /* json config path */
+  /* owned by json_config */
+  GBytes *serialized_config;
+
+  /* json config path and its parsed content */
   gchar *json_config_path;
+  dlb_dap_json_config *json_config;
+  DlbConfigLoader *config_loader;
+
+  /* runtime configuration switching */
+  guint crossfade_blocks;
+  GThreadPool *switch_pool;
+  gboolean switch_pending;
+  gpointer switch_task;
+
+  /* config of running instance and of the one being built */
+  gboolean instance_virtualizer_enable;
+  GBytes *instance_serialized_config;
+  gboolean switch_virtualizer_enable;
+  GBytes *switch_serialized_config;
+
+  dlb_dap *next_instance;
+  guint8 *fade_buffer;
+  gint fade_prime;
+  gint fade_pos;
+  gint fade_len;
+  gfloat *fade_ramp;
+  gint fade_ramp_len;
+
+  guint switches;
+  guint64 crossfade_samples;
+  GstClockTime crossfade_time;
+
+  /* silence bypass, protected by lock */
+  gdouble silence_threshold;
+  GstClockTime idle_timeout;
+  gsize audible_end;
+  guint64 silent_samples;
+  gboolean idle;
+  guint64 bypassed_blocks;
+
+  /* secondary output zones (request src pads), protected by lock */
+  GList *zones;
+  guint zone_serial;
+  gboolean zones_busy;
+  /* mailbox groups read while zones were busy */
+  guint zones_groups;
+  gint drain_samples;
+
+  /* optional parallel processing of zones */
+  guint zone_threads;
+  GThreadPool *zone_pool;
+  GMutex zone_lock;
+  GCond zone_cond;
+  gint zones_pending;
+  const guint8 *zone_indata;
 };
 
 struct _DlbDapClass
@@ -85,6 +165,50 @@ struct _DlbDapClass
 
 GType dlb_dap_get_type (void);
 
+/**
+ * DlbDapZonePad:
+ *
+ * Request src pad with its own DAP instance and output format, fed from
+ * the same input as the always src pad.
+ */
+struct _DlbDapZonePad
+{
+  GstPad parent;
+
+  gboolean virtualizer_enable;
+
+  /*< private >*/
+  gint negotiate;
+
+  GstAudioInfo outinfo;
+  dlb_dap_channel_format outfmt;
+  dlb_dap *instance;
+  gboolean instance_virtualizer_enable;
+  gsize outbufsz;
+
+  /* latency samples still to be discarded */
+  gint prefill;
+  gint latency_samples;
+  GstClockTime latency_time;
+
+  /* instance being built on the switch pool and the caps it is for */
+  gpointer task;
+  GstCaps *task_caps;
+  GstAudioInfo task_info;
+
+  GstBuffer *outbuf;
+  GstMapInfo outmap;
+  GstBufferPool *pool;
+  gsize pool_size;
+};
+
+struct _DlbDapZonePadClass
+{
+  GstPadClass parent_class;
+};
+
+GType dlb_dap_zone_pad_get_type (void);
+
 G_END_DECLS
 
 #endif
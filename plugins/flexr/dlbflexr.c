@@ -22,6 +22,9 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+#include <string.h>
+
 #include "dlbflexr.h"
 #include "dlbaudiometa.h"
 #include "dlbutils.h"
@@ -32,6 +35,27 @@ GST_DEBUG_CATEGORY_STATIC (GST_CAT_DEFAULT);
 #define DEFAULT_PAD_GAIN (1.0)
 #define DEFAULT_PAD_UPMIX (FALSE)
 #define DEFAULT_FORCE_ORDER (TRUE)
+#define DEFAULT_PAD_DRIFT_COMPENSATION (FALSE)
+#define DEFAULT_PAD_DRIFT_TARGET (20 * GST_MSECOND)
+
+/* drift controller, the fill error is smoothed over ~20 buffers and the
+ * correction stays within +-1000 ppm, which is inaudible. Rates passed to
+ * the resampler are scaled for sub-ppm resolution. */
+#define DRIFT_RATE_SCALE 100
+#define DRIFT_SMOOTHING 0.05
+#define DRIFT_KP 0.05
+#define DRIFT_KI (DRIFT_KP * DRIFT_KP / 4)
+#define DRIFT_MAX_CORRECTION 0.001
+
+/* groups of settings published to the streaming thread */
+enum
+{
+  DLB_FLEXR_PARAMS_INTERNAL_USER_GAIN = 1 << 0,
+  DLB_FLEXR_PARAMS_CONTENT_NORMALIZATION_GAIN = 1 << 1,
+  DLB_FLEXR_PARAMS_EXT_GAIN = 1 << 2,
+  DLB_FLEXR_PARAMS_EXT_GAIN_STEP = 1 << 3,
+  DLB_FLEXR_PARAMS_ACTIVE_CHANNELS = 1 << 4,
+};
 
 enum
 {
@@ -42,10 +66,25 @@ enum
   PROP_PAD_UPMIX,
   PROP_PAD_FORCE_ORDER,
   PROP_PAD_INTERP_MODE,
+  PROP_PAD_DRIFT_COMPENSATION,
+  PROP_PAD_DRIFT_TARGET,
 };
 
 G_DEFINE_TYPE (DlbFlexrPad, dlb_flexr_pad, GST_TYPE_AUDIO_AGGREGATOR_PAD);
 
+/* input converted to F32 in library channel order by the pad's upstream
+ * thread, attached to the buffer it was prepared from */
+typedef struct
+{
+  GstBuffer *buffer;
+  GstMapInfo map;
+  dlb_buffer *block;
+  gint bpf;
+  dlb_flexr_object_metadata md;
+} DlbFlexrPrepared;
+
+static GQuark dlb_flexr_prepared_quark;
+
 #define DLB_TYPE_FLEXR_INTERP_MODE (dlb_flexr_interp_mode_get_type())
 static GType
 dlb_flexr_interp_mode_get_type (void)
@@ -70,16 +109,21 @@ dlb_flexr_pad_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
   DlbFlexrPad *pad = DLB_FLEXR_PAD (object);
+  DlbFlexrPadParams *params;
 
   switch (prop_id) {
     case PROP_PAD_STREAM_CONFIG:
       g_value_set_string (value, pad->config_path);
       break;
     case PROP_PAD_INTERNAL_USER_GAIN:
-      g_value_set_double (value, pad->internal_user_gain);
+      params = dlb_param_mailbox_lock (pad->params);
+      g_value_set_double (value, params->internal_user_gain);
+      dlb_param_mailbox_unlock (pad->params, 0);
       break;
     case PROP_PAD_CONTENT_NORMALIZATION_GAIN:
-      g_value_set_double (value, pad->content_normalization_gain);
+      params = dlb_param_mailbox_lock (pad->params);
+      g_value_set_double (value, params->content_normalization_gain);
+      dlb_param_mailbox_unlock (pad->params, 0);
       break;
     case PROP_PAD_FORCE_ORDER:
       g_value_set_boolean (value, pad->force_order);
@@ -90,6 +134,16 @@ dlb_flexr_pad_get_property (GObject * object, guint prop_id,
     case PROP_PAD_INTERP_MODE:
       g_value_set_enum (value, pad->interp);
       break;
+    case PROP_PAD_DRIFT_COMPENSATION:
+      GST_OBJECT_LOCK (pad);
+      g_value_set_boolean (value, pad->drift_enable);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    case PROP_PAD_DRIFT_TARGET:
+      GST_OBJECT_LOCK (pad);
+      g_value_set_uint64 (value, pad->drift_target);
+      GST_OBJECT_UNLOCK (pad);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -101,29 +155,38 @@ dlb_flexr_pad_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
 {
   DlbFlexrPad *pad = DLB_FLEXR_PAD (object);
+  DlbFlexrPadParams *params;
+  guint groups = 0;
 
   switch (prop_id) {
     case PROP_PAD_STREAM_CONFIG:
       GST_OBJECT_LOCK (pad);
       g_free (pad->config_path);
       pad->config_path = g_strdup (g_value_get_string (value));
-      g_hash_table_add (pad->props_set,
-          GINT_TO_POINTER (PROP_PAD_STREAM_CONFIG));
       GST_OBJECT_UNLOCK (pad);
+
+      /* new config is picked up by the streaming thread once it is read */
+      dlb_config_loader_set_filename (pad->config_loader,
+          g_value_get_string (value));
       break;
     case PROP_PAD_INTERNAL_USER_GAIN:
-      GST_OBJECT_LOCK (pad);
-      pad->internal_user_gain = g_value_get_double (value);
-      g_hash_table_add (pad->props_set,
-          GINT_TO_POINTER (PROP_PAD_INTERNAL_USER_GAIN));
-      GST_OBJECT_UNLOCK (pad);
+      /* never waits for the streaming thread, which holds the pad lock while
+       * mixing. Controller syncs values at each block, push only real
+       * changes. */
+      params = dlb_param_mailbox_lock (pad->params);
+      if (params->internal_user_gain != g_value_get_double (value)) {
+        params->internal_user_gain = g_value_get_double (value);
+        groups = DLB_FLEXR_PARAMS_INTERNAL_USER_GAIN;
+      }
+      dlb_param_mailbox_unlock (pad->params, groups);
       break;
     case PROP_PAD_CONTENT_NORMALIZATION_GAIN:
-      GST_OBJECT_LOCK (pad);
-      pad->content_normalization_gain = g_value_get_double (value);
-      g_hash_table_add (pad->props_set,
-          GINT_TO_POINTER (PROP_PAD_CONTENT_NORMALIZATION_GAIN));
-      GST_OBJECT_UNLOCK (pad);
+      params = dlb_param_mailbox_lock (pad->params);
+      if (params->content_normalization_gain != g_value_get_double (value)) {
+        params->content_normalization_gain = g_value_get_double (value);
+        groups = DLB_FLEXR_PARAMS_CONTENT_NORMALIZATION_GAIN;
+      }
+      dlb_param_mailbox_unlock (pad->params, groups);
       break;
     case PROP_PAD_FORCE_ORDER:
       GST_OBJECT_LOCK (pad);
@@ -143,23 +206,496 @@ dlb_flexr_pad_set_property (GObject * object, guint prop_id,
       g_hash_table_add (pad->props_set, GINT_TO_POINTER (PROP_PAD_INTERP_MODE));
       GST_OBJECT_UNLOCK (pad);
       break;
+    case PROP_PAD_DRIFT_COMPENSATION:
+      GST_OBJECT_LOCK (pad);
+      pad->drift_enable = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (pad);
+      break;
+    case PROP_PAD_DRIFT_TARGET:
+      GST_OBJECT_LOCK (pad);
+      pad->drift_target = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (pad);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+/* called from the config loader thread */
+static gpointer
+dlb_flexr_pad_read_config (const gchar * filename, gpointer user_data,
+    GError ** error)
+{
+  gchar *contents = NULL;
+  gsize length;
+
+  if (!g_file_get_contents (filename, &contents, &length, error))
+    return NULL;
+
+  return g_bytes_new_take (contents, length);
+}
+
+/* called from the config loader thread */
+static void
+dlb_flexr_pad_config_loaded (const gchar * filename, gconstpointer config,
+    const GError * error, gpointer user_data)
+{
+  DlbFlexrPad *pad = DLB_FLEXR_PAD (user_data);
+
+  if (error)
+    GST_WARNING_OBJECT (pad, "Reading stream config %s failed: %s", filename,
+        error->message);
+  else
+    GST_DEBUG_OBJECT (pad, "Read stream config %s", filename);
+}
+
+/* must be called with pad object lock held */
+static gboolean
+dlb_flexr_pad_update_config (DlbFlexrPad * pad)
+{
+  GBytes *config = dlb_config_loader_take (pad->config_loader);
+
+  if (G_LIKELY (!config))
+    return FALSE;
+
+  if (pad->config)
+    g_bytes_unref (pad->config);
+
+  pad->config = config;
+  return TRUE;
+}
+
+static gboolean
+dlb_flexr_is_upstream_live (GstAggregatorPad * aggpad)
+{
+  GstQuery *query = gst_query_new_latency ();
+  gboolean live = FALSE;
+
+  if (gst_pad_peer_query (GST_PAD_CAST (aggpad), query))
+    gst_query_parse_latency (query, &live, NULL, NULL);
+
+  gst_query_unref (query);
+  return live;
+}
+
+static void
+dlb_flexr_prepared_free (gpointer data)
+{
+  DlbFlexrPrepared *prep = data;
+
+  dlb_buffer_free (prep->block);
+  gst_buffer_unmap (prep->buffer, &prep->map);
+  gst_buffer_unref (prep->buffer);
+
+  g_slice_free (DlbFlexrPrepared, prep);
+}
+
+static void
+dlb_flexr_pool_clear (GstBufferPool ** pool, gsize * poolsize)
+{
+  if (*pool) {
+    gst_buffer_pool_set_active (*pool, FALSE);
+    gst_clear_object (pool);
+  }
+
+  *poolsize = 0;
+}
+
+/* replaces the pool by a larger one when a bigger buffer is needed,
+ * buffers still in use are freed once returned to the old one */
+static GstBuffer *
+dlb_flexr_pool_acquire (GstBufferPool ** pool, gsize * poolsize, gsize size)
+{
+  GstAllocationParams params;
+  GstStructure *config;
+  GstBuffer *buf = NULL;
+
+  if (G_UNLIKELY (!*pool || *poolsize < size)) {
+    dlb_flexr_pool_clear (pool, poolsize);
+
+    /* aligned for vectorized processing in the library */
+    gst_allocation_params_init (&params);
+    params.align = 31;
+
+    *pool = gst_buffer_pool_new ();
+    config = gst_buffer_pool_get_config (*pool);
+    gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+    gst_buffer_pool_config_set_allocator (config, NULL, &params);
+
+    if (!gst_buffer_pool_set_config (*pool, config) ||
+        !gst_buffer_pool_set_active (*pool, TRUE)) {
+      gst_clear_object (pool);
+      return NULL;
+    }
+
+    *poolsize = size;
+  }
+
+  if (gst_buffer_pool_acquire_buffer (*pool, &buf, NULL) != GST_FLOW_OK)
+    return NULL;
+
+  gst_buffer_set_size (buf, size);
+  return buf;
+}
+
+static void
+dlb_flexr_pad_setup_prepare (DlbFlexrPad * pad, GstCaps * caps)
+{
+  GstAudioChannelPosition pos[64];
+  GstAudioInfo in, out;
+  gboolean force_order;
+
+  if (pad->converter) {
+    gst_audio_converter_free (pad->converter);
+    pad->converter = NULL;
+  }
+
+  dlb_flexr_pool_clear (&pad->prep_pool, &pad->prep_pool_size);
+
+  if (!gst_audio_info_from_caps (&in, caps))
+    return;
+
+  GST_OBJECT_LOCK (pad);
+  force_order = pad->force_order;
+  GST_OBJECT_UNLOCK (pad);
+
+  memcpy (pos, in.position, sizeof (pos[0]) * in.channels);
+
+  /* unsupported layouts are reported by set_caps */
+  if (force_order && !dlb_audio_channel_positions_to_dlb_order (in.position,
+          in.channels, pos))
+    return;
+
+  /* Dolby order is not a valid GStreamer order, set positions directly */
+  gst_audio_info_set_format (&out, GST_AUDIO_FORMAT_F32, in.rate, in.channels,
+      NULL);
+  memcpy (out.position, pos, sizeof (pos[0]) * in.channels);
+  out.flags = in.flags;
+
+  /* the library takes such input as it is */
+  if (gst_audio_info_is_equal (&in, &out))
+    return;
+
+  pad->converter =
+      gst_audio_converter_new (GST_AUDIO_CONVERTER_FLAG_NONE, &in, &out, NULL);
+  pad->prepinfo = out;
+  pad->inbpf = GST_AUDIO_INFO_BPF (&in);
+
+  GST_DEBUG_OBJECT (pad, "Preparing input as %s in %s order",
+      GST_AUDIO_INFO_NAME (&out), force_order ? "Dolby" : "stream");
+}
+
+static void
+dlb_flexr_pad_prepare_buffer (DlbFlexrPad * pad, GstBuffer * buf)
+{
+  DlbFlexrPrepared *prep;
+  DlbObjectAudioMeta *meta;
+  GstBuffer *prepbuf;
+  GstMapInfo inmap;
+  gpointer in[1], out[1];
+  gsize frames;
+  gint bpf;
+
+  frames = gst_buffer_get_size (buf) / pad->inbpf;
+  bpf = GST_AUDIO_INFO_BPF (&pad->prepinfo);
+
+  prepbuf = dlb_flexr_pool_acquire (&pad->prep_pool, &pad->prep_pool_size,
+      frames * bpf);
+  if (G_UNLIKELY (!prepbuf)) {
+    GST_WARNING_OBJECT (pad, "Failed to allocate prepared input");
+    return;
+  }
+
+  prep = g_slice_new0 (DlbFlexrPrepared);
+  prep->bpf = bpf;
+  prep->buffer = prepbuf;
+  prep->block = dlb_buffer_new (&pad->prepinfo);
+
+  gst_buffer_map (prep->buffer, &prep->map, GST_MAP_READWRITE);
+  gst_buffer_map (buf, &inmap, GST_MAP_READ);
+
+  in[0] = inmap.data;
+  out[0] = prep->map.data;
+  gst_audio_converter_samples (pad->converter, GST_AUDIO_CONVERTER_FLAG_NONE,
+      in, frames, out, frames);
+
+  gst_buffer_unmap (buf, &inmap);
+
+  if ((meta = dlb_audio_object_meta_get (buf))) {
+    prep->md.offset = meta->offset;
+    prep->md.payload = meta->payload;
+    prep->md.payload_size = meta->size;
+  }
+
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (buf),
+      dlb_flexr_prepared_quark, prep, dlb_flexr_prepared_free);
+}
+
+static void
+dlb_flexr_pad_reset_drift (DlbFlexrPad * pad)
+{
+  pad->drift_base = GST_CLOCK_TIME_NONE;
+  pad->drift_samples = 0;
+  pad->drift_error = 0.0;
+  pad->drift_integral = 0.0;
+  pad->drift_out_rate = pad->drift_rate * DRIFT_RATE_SCALE;
+
+  if (pad->resampler)
+    gst_audio_converter_update_config (pad->resampler,
+        pad->drift_rate * DRIFT_RATE_SCALE, pad->drift_out_rate, NULL);
+}
+
+static void
+dlb_flexr_pad_setup_drift (DlbFlexrPad * pad, GstCaps * caps)
+{
+  GstCapsFeatures *features;
+  GstAudioInfo info;
+  gboolean enable;
+
+  if (pad->resampler) {
+    gst_audio_converter_free (pad->resampler);
+    pad->resampler = NULL;
+  }
+
+  dlb_flexr_pool_clear (&pad->drift_pool, &pad->drift_pool_size);
+
+  GST_OBJECT_LOCK (pad);
+  enable = pad->drift_enable;
+  GST_OBJECT_UNLOCK (pad);
+
+  if (!enable || !gst_audio_info_from_caps (&info, caps))
+    return;
+
+  /* object metadata refers to sample positions, objects are not resampled */
+  features = gst_caps_get_features (caps, 0);
+  if (features && gst_caps_features_contains (features,
+          DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META)) {
+    GST_WARNING_OBJECT (pad, "Drift compensation not supported for objects");
+    return;
+  }
+
+  if (!dlb_flexr_is_upstream_live (GST_AGGREGATOR_PAD (pad))) {
+    GST_DEBUG_OBJECT (pad, "Upstream is not live, no drift to compensate");
+    return;
+  }
+
+  pad->resampler =
+      gst_audio_converter_new (GST_AUDIO_CONVERTER_FLAG_VARIABLE_RATE, &info,
+      &info, NULL);
+  pad->drift_rate = GST_AUDIO_INFO_RATE (&info);
+  pad->drift_bpf = GST_AUDIO_INFO_BPF (&info);
+
+  dlb_flexr_pad_reset_drift (pad);
+
+  GST_DEBUG_OBJECT (pad, "Compensating drift of %s",
+      GST_AUDIO_INFO_NAME (&info));
+}
+
+/* clock is cached while PLAYING, so it is not looked up for every buffer */
+static void
+dlb_flexr_pad_set_clock (DlbFlexrPad * pad, GstClock * clock,
+    GstClockTime base_time)
+{
+  GST_OBJECT_LOCK (pad);
+  gst_object_replace ((GstObject **) & pad->drift_clock, (GstObject *) clock);
+  pad->drift_base_time = base_time;
+  GST_OBJECT_UNLOCK (pad);
+}
+
+/* measures how far the data already pushed reaches ahead of the clock and
+ * lets a PI controller adjust the resampling ratio to keep it at the target.
+ * The resampled buffer continues the timeline of the previous ones, so the
+ * aggregator never sees gaps or overlaps. */
+static GstBuffer *
+dlb_flexr_pad_compensate_drift (DlbFlexrPad * pad, GstBuffer * buf)
+{
+  GstClockTimeDiff running = -1;
+  GstClockTime now, target, duration, start, end;
+  GstBuffer *outbuf;
+  GstMapInfo inmap, outmap;
+  gpointer in[1], out[1];
+  gsize inframes, outframes;
+  gdouble fill, correction;
+  gint out_rate;
+
+  if (pad->drift_segment.format != GST_FORMAT_TIME)
+    return buf;
+
+  GST_OBJECT_LOCK (pad);
+  if (pad->drift_clock)
+    running = GST_CLOCK_DIFF (pad->drift_base_time,
+        gst_clock_get_time (pad->drift_clock));
+  target = pad->drift_target;
+  GST_OBJECT_UNLOCK (pad);
+
+  /* not running yet */
+  if (running < 0)
+    return buf;
+
+  now = running;
+
+  inframes = gst_buffer_get_size (buf) / pad->drift_bpf;
+  duration = gst_util_uint64_scale_int (inframes, GST_SECOND, pad->drift_rate);
+
+  if (!GST_CLOCK_TIME_IS_VALID (pad->drift_base)
+      || GST_BUFFER_IS_DISCONT (buf)) {
+    dlb_flexr_pad_reset_drift (pad);
+
+    /* start with the target already queued */
+    pad->drift_base = now + target > duration ? now + target - duration : 0;
+  } else {
+    end = pad->drift_base + gst_util_uint64_scale_int (pad->drift_samples,
+        GST_SECOND, pad->drift_rate);
+
+    fill = (gdouble) GST_CLOCK_DIFF (now, end) / GST_SECOND;
+    pad->drift_error += DRIFT_SMOOTHING *
+        (fill - (gdouble) target / GST_SECOND - pad->drift_error);
+
+    /* integral is limited to what the correction can use */
+    pad->drift_integral += pad->drift_error * duration / GST_SECOND;
+    pad->drift_integral = CLAMP (pad->drift_integral,
+        -DRIFT_MAX_CORRECTION / DRIFT_KI, DRIFT_MAX_CORRECTION / DRIFT_KI);
+
+    /* too much queued, produce fewer samples */
+    correction = DRIFT_KP * pad->drift_error + DRIFT_KI * pad->drift_integral;
+    correction = CLAMP (correction, -DRIFT_MAX_CORRECTION,
+        DRIFT_MAX_CORRECTION);
+
+    out_rate = lround (pad->drift_rate * DRIFT_RATE_SCALE * (1.0 - correction));
+    if (out_rate != pad->drift_out_rate) {
+      GST_LOG_OBJECT (pad, "fill %f s, correction %f ppm", fill,
+          correction * 1e6);
+
+      gst_audio_converter_update_config (pad->resampler,
+          pad->drift_rate * DRIFT_RATE_SCALE, out_rate, NULL);
+      pad->drift_out_rate = out_rate;
+    }
+  }
+
+  outframes = gst_audio_converter_get_out_frames (pad->resampler, inframes);
+  outbuf = dlb_flexr_pool_acquire (&pad->drift_pool, &pad->drift_pool_size,
+      outframes * pad->drift_bpf);
+  if (G_UNLIKELY (!outbuf)) {
+    GST_WARNING_OBJECT (pad, "Failed to allocate compensated buffer");
+    return buf;
+  }
+
+  /* drop input prepared when the buffer was last used */
+  gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (outbuf),
+      dlb_flexr_prepared_quark, NULL, NULL);
+
+  gst_buffer_copy_into (outbuf, buf, GST_BUFFER_COPY_FLAGS, 0, -1);
+
+  gst_buffer_map (buf, &inmap, GST_MAP_READ);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  in[0] = inmap.data;
+  out[0] = outmap.data;
+  gst_audio_converter_samples (pad->resampler, GST_AUDIO_CONVERTER_FLAG_NONE,
+      in, inframes, out, outframes);
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (buf, &inmap);
+  gst_buffer_unref (buf);
+
+  start = pad->drift_base + gst_util_uint64_scale_int (pad->drift_samples,
+      GST_SECOND, pad->drift_rate);
+  pad->drift_samples += outframes;
+  end = pad->drift_base + gst_util_uint64_scale_int (pad->drift_samples,
+      GST_SECOND, pad->drift_rate);
+
+  GST_BUFFER_PTS (outbuf) = gst_segment_position_from_running_time
+      (&pad->drift_segment, GST_FORMAT_TIME, start);
+  GST_BUFFER_DTS (outbuf) = GST_CLOCK_TIME_NONE;
+  GST_BUFFER_DURATION (outbuf) = end - start;
+
+  return outbuf;
+}
+
+/* runs in the upstream streaming thread, so streams are prepared in parallel
+ * and the aggregator thread only hands blocks over to the library */
+static GstPadProbeReturn
+dlb_flexr_pad_prepare_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  DlbFlexrPad *flexrpad = DLB_FLEXR_PAD (pad);
+  GstBuffer *buf;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT (info);
+    GstCaps *caps;
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_CAPS) {
+      gst_event_parse_caps (event, &caps);
+      dlb_flexr_pad_setup_prepare (flexrpad, caps);
+      dlb_flexr_pad_setup_drift (flexrpad, caps);
+    } else if (GST_EVENT_TYPE (event) == GST_EVENT_SEGMENT) {
+      gst_event_copy_segment (event, &flexrpad->drift_segment);
+      dlb_flexr_pad_reset_drift (flexrpad);
+    }
+
+    return GST_PAD_PROBE_OK;
+  }
+
+  buf = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (flexrpad->resampler) {
+    buf = dlb_flexr_pad_compensate_drift (flexrpad, buf);
+    GST_PAD_PROBE_INFO_DATA (info) = buf;
+  }
+
+  if (!flexrpad->converter || GST_BUFFER_FLAG_IS_SET (buf, GST_BUFFER_FLAG_GAP))
+    return GST_PAD_PROBE_OK;
+
+  /* prepared data must not be shared with other consumers of the buffer */
+  buf = gst_buffer_make_writable (buf);
+  GST_PAD_PROBE_INFO_DATA (info) = buf;
+
+  dlb_flexr_pad_prepare_buffer (flexrpad, buf);
+
+  return GST_PAD_PROBE_OK;
+}
+
 static void
 dlb_flexr_pad_init (DlbFlexrPad * pad)
 {
+  DlbFlexrPadParams params = { DEFAULT_PAD_GAIN, DEFAULT_PAD_GAIN };
+
   pad->stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+  pad->next_stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+  pad->pending = 0;
   pad->props_set = g_hash_table_new (g_direct_hash, g_direct_equal);
+  pad->config_loader = dlb_config_loader_new (dlb_flexr_pad_read_config,
+      (GDestroyNotify) g_bytes_unref, dlb_flexr_pad_config_loaded, pad);
+  pad->config = NULL;
 
   pad->config_path = NULL;
   pad->force_order = 1;
   pad->upmix = 1;
-  pad->internal_user_gain = 1;
-  pad->content_normalization_gain = 1;
+  pad->params = dlb_param_mailbox_new (sizeof (params), &params);
+
+  pad->converter = NULL;
+  pad->prep_pool = NULL;
+  pad->prep_pool_size = 0;
+  pad->inbpf = 0;
+  gst_audio_info_init (&pad->prepinfo);
+
+  pad->drift_enable = DEFAULT_PAD_DRIFT_COMPENSATION;
+  pad->drift_target = DEFAULT_PAD_DRIFT_TARGET;
+  pad->resampler = NULL;
+  pad->drift_pool = NULL;
+  pad->drift_pool_size = 0;
+  pad->drift_clock = NULL;
+  pad->drift_base_time = 0;
+  pad->drift_rate = 0;
+  pad->drift_bpf = 0;
+  gst_segment_init (&pad->drift_segment, GST_FORMAT_TIME);
+  dlb_flexr_pad_reset_drift (pad);
+
+  gst_pad_add_probe (GST_PAD_CAST (pad), GST_PAD_PROBE_TYPE_BUFFER |
+      GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, dlb_flexr_pad_prepare_probe, NULL,
+      NULL);
 }
 
 static void
@@ -167,9 +703,25 @@ dlb_flexr_pad_finalize (GObject * object)
 {
   DlbFlexrPad *flexrpad = DLB_FLEXR_PAD (object);
 
+  dlb_config_loader_free (flexrpad->config_loader);
   g_hash_table_destroy (flexrpad->props_set);
+  dlb_param_mailbox_free (flexrpad->params);
   g_free (flexrpad->config_path);
 
+  if (flexrpad->converter)
+    gst_audio_converter_free (flexrpad->converter);
+
+  dlb_flexr_pool_clear (&flexrpad->prep_pool, &flexrpad->prep_pool_size);
+
+  if (flexrpad->resampler)
+    gst_audio_converter_free (flexrpad->resampler);
+
+  dlb_flexr_pool_clear (&flexrpad->drift_pool, &flexrpad->drift_pool_size);
+  gst_clear_object (&flexrpad->drift_clock);
+
+  if (flexrpad->config)
+    g_bytes_unref (flexrpad->config);
+
   G_OBJECT_CLASS (dlb_flexr_pad_parent_class)->finalize (object);
 }
 
@@ -182,6 +734,8 @@ dlb_flexr_pad_class_init (DlbFlexrPadClass * klass)
   gobject_class->get_property = dlb_flexr_pad_get_property;
   gobject_class->finalize = dlb_flexr_pad_finalize;
 
+  dlb_flexr_prepared_quark = g_quark_from_static_string ("dlb-flexr-prepared");
+
   g_object_class_install_property (gobject_class, PROP_PAD_STREAM_CONFIG,
       g_param_spec_string ("stream-config", "Stream configuration",
           "Serialized stream configuration file for this pad", NULL,
@@ -205,6 +759,22 @@ dlb_flexr_pad_class_init (DlbFlexrPadClass * klass)
           DEFAULT_FORCE_ORDER,
           G_PARAM_READWRITE | G_PARAM_CONSTRUCT | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_PAD_DRIFT_COMPENSATION,
+      g_param_spec_boolean ("drift-compensation", "Drift compensation",
+          "Resample live input to follow the pipeline clock, keeping "
+          "drift-target of data queued on this pad",
+          DEFAULT_PAD_DRIFT_COMPENSATION,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject_class, PROP_PAD_DRIFT_TARGET,
+      g_param_spec_uint64 ("drift-target", "Drift target",
+          "Amount of data in nanoseconds kept queued ahead of the clock when "
+          "drift-compensation is enabled", 0, G_MAXUINT64,
+          DEFAULT_PAD_DRIFT_TARGET,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
   g_object_class_install_property (gobject_class, PROP_PAD_INTERNAL_USER_GAIN,
       g_param_spec_double ("internal-user-gain", "Internal User Gain",
           "The gain as determined by user preference for this pad", 0.0, 10.0,
@@ -220,6 +790,133 @@ dlb_flexr_pad_class_init (DlbFlexrPadClass * klass)
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 }
 
+enum
+{
+  PROP_SPLIT_PAD_0,
+  PROP_SPLIT_PAD_CHANNELS_MASK,
+};
+
+#define DEFAULT_SPLIT_CHANNELS_MASK G_MAXUINT64
+
+G_DEFINE_TYPE (DlbFlexrSplitPad, dlb_flexr_split_pad, GST_TYPE_PAD);
+
+static void
+dlb_flexr_split_pad_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  DlbFlexrSplitPad *split = DLB_FLEXR_SPLIT_PAD (object);
+
+  switch (prop_id) {
+    case PROP_SPLIT_PAD_CHANNELS_MASK:
+      GST_OBJECT_LOCK (split);
+      g_value_set_uint64 (value, split->channels_mask);
+      GST_OBJECT_UNLOCK (split);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+dlb_flexr_split_pad_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbFlexrSplitPad *split = DLB_FLEXR_SPLIT_PAD (object);
+
+  switch (prop_id) {
+    case PROP_SPLIT_PAD_CHANNELS_MASK:
+      GST_OBJECT_LOCK (split);
+      split->channels_mask = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (split);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* caps are dictated by the main output, everything else is answered by
+ * the element's src pad */
+static gboolean
+dlb_flexr_split_pad_query (GstPad * pad, GstObject * parent, GstQuery * query)
+{
+  GstAggregator *agg = GST_AGGREGATOR (parent);
+  GstCaps *filter, *caps;
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_CAPS:
+      gst_query_parse_caps (query, &filter);
+
+      if (!(caps = gst_pad_get_current_caps (pad)))
+        caps = gst_pad_get_pad_template_caps (pad);
+
+      if (filter) {
+        GstCaps *tmp = gst_caps_intersect_full (filter, caps,
+            GST_CAPS_INTERSECT_FIRST);
+
+        gst_caps_unref (caps);
+        caps = tmp;
+      }
+
+      gst_query_set_caps_result (query, caps);
+      gst_caps_unref (caps);
+      return TRUE;
+    case GST_QUERY_ACCEPT_CAPS:
+      return gst_pad_query_default (pad, parent, query);
+    default:
+      return gst_pad_query (GST_AGGREGATOR_SRC_PAD (agg), query);
+  }
+}
+
+static gboolean
+dlb_flexr_split_pad_event (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  GstAggregator *agg = GST_AGGREGATOR (parent);
+
+  /* output format follows the main src pad, nothing to renegotiate */
+  if (GST_EVENT_TYPE (event) == GST_EVENT_RECONFIGURE) {
+    gst_event_unref (event);
+    return TRUE;
+  }
+
+  return gst_pad_send_event (GST_AGGREGATOR_SRC_PAD (agg), event);
+}
+
+static void
+dlb_flexr_split_pad_init (DlbFlexrSplitPad * split)
+{
+  split->channels_mask = DEFAULT_SPLIT_CHANNELS_MASK;
+  split->caps_pending = FALSE;
+  split->outbuf = NULL;
+
+  gst_audio_info_init (&split->outinfo);
+
+  GST_OBJECT_FLAG_SET (split, GST_PAD_FLAG_NEED_PARENT);
+  gst_pad_set_query_function (GST_PAD_CAST (split),
+      GST_DEBUG_FUNCPTR (dlb_flexr_split_pad_query));
+  gst_pad_set_event_function (GST_PAD_CAST (split),
+      GST_DEBUG_FUNCPTR (dlb_flexr_split_pad_event));
+}
+
+static void
+dlb_flexr_split_pad_class_init (DlbFlexrSplitPadClass * klass)
+{
+  GObjectClass *gobject_class = (GObjectClass *) klass;
+
+  gobject_class->set_property = dlb_flexr_split_pad_set_property;
+  gobject_class->get_property = dlb_flexr_split_pad_get_property;
+
+  g_object_class_install_property (gobject_class,
+      PROP_SPLIT_PAD_CHANNELS_MASK,
+      g_param_spec_uint64 ("channels-mask", "Channels mask",
+          "A bitmask of rendered output channels carried by this pad, in "
+          "rendering order. Bits beyond the rendered channel count are "
+          "ignored", 0, G_MAXUINT64, DEFAULT_SPLIT_CHANNELS_MASK,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+}
+
 enum
 {
   PROP_0,
@@ -228,16 +925,25 @@ enum
   PROP_ACTIVE_CHANNELS_MASK,
   PROP_EXTERNAL_USER_GAIN,
   PROP_EXTERNAL_USER_GAIN_BY_STEP,
+  PROP_LATENCY,
+  PROP_STATS,
 };
 
 #define EXT_USER_GAIN_BY_STEP_DISABLE (-1)
+#define DEFAULT_LATENCY (0)
+
+/* rendering blocks crossfaded when switching active channels */
+#define SWITCH_CROSSFADE_BLOCKS (8)
+
+/* sink caps query results kept, one per distinct filter */
+#define DLB_FLEXR_CAPS_CACHE_SIZE (8)
 
 #define SRC_CAPS                                                        \
   "audio/x-raw, "                                                       \
     "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",     \
                         "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, " \
     "channels = (int) [ 1, 32 ], "                                      \
-    "rate = (int) 48000, "                                              \
+    "rate = (int) [ 8000, 192000 ], "                                   \
     "layout = (string) interleaved;"                                    \
 
 #define SINK_CAPS                                                       \
@@ -245,13 +951,13 @@ enum
     "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",     \
                         "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, " \
     "channels = (int) {1, 2, 6, 8, 10, 12 }, "                          \
-    "rate = (int) 48000, "                                              \
+    "rate = (int) [ 8000, 192000 ], "                                   \
     "layout = (string) interleaved; "                                   \
   "audio/x-raw(" DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META "), "          \
     "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",     \
                         "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, " \
     "channels = (int) [ 1, 32 ], "                                      \
-    "rate = (int) 48000, "                                              \
+    "rate = (int) [ 8000, 192000 ], "                                   \
     "layout = (string) interleaved;"                                    \
 
 static GstStaticPadTemplate dlb_flexr_src_template =
@@ -261,9 +967,16 @@ GST_STATIC_PAD_TEMPLATE ("src",
     GST_STATIC_CAPS (SRC_CAPS)
     );
 
-static GstStaticPadTemplate dlb_flexr_sink_template =
-GST_STATIC_PAD_TEMPLATE ("sink_%u",
-    GST_PAD_SINK,
+static GstStaticPadTemplate dlb_flexr_split_template =
+GST_STATIC_PAD_TEMPLATE ("src_%u",
+    GST_PAD_SRC,
+    GST_PAD_REQUEST,
+    GST_STATIC_CAPS (SRC_CAPS)
+    );
+
+static GstStaticPadTemplate dlb_flexr_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink_%u",
+    GST_PAD_SINK,
     GST_PAD_REQUEST,
     GST_STATIC_CAPS (SINK_CAPS)
     );
@@ -293,8 +1006,9 @@ static void dlb_flexr_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec);
 static void dlb_flexr_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec);
-static gboolean dlb_flexr_open (DlbFlexr * flexr);
+static gboolean dlb_flexr_open (DlbFlexr * flexr, gint rate, gboolean live);
 static void dlb_flexr_close (DlbFlexr * flexr);
+static void dlb_flexr_switch_reset (DlbFlexr * flexr);
 static gboolean dlb_flexr_set_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad,
     GstCaps * caps);
 static GstCaps *dlb_flexr_get_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad,
@@ -308,6 +1022,10 @@ static GstFlowReturn dlb_flexr_update_src_caps (GstAggregator * agg,
 static GstPad *dlb_flexr_request_new_pad (GstElement * element,
     GstPadTemplate * temp, const gchar * req_name, const GstCaps * caps);
 static void dlb_flexr_release_pad (GstElement * element, GstPad * pad);
+static GstStateChangeReturn dlb_flexr_change_state (GstElement * element,
+    GstStateChange transition);
+static GstPadProbeReturn dlb_flexr_split_probe (GstPad * pad,
+    GstPadProbeInfo * info, gpointer user_data);
 static gboolean dlb_flexr_aggregate_one_buffer (GstAudioAggregator * aagg,
     GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
     GstBuffer * outbuf, guint out_offset, guint num_samples);
@@ -328,6 +1046,8 @@ dlb_flexr_class_init (DlbFlexrClass * klass)
       &dlb_flexr_src_template, GST_TYPE_AUDIO_AGGREGATOR_PAD);
   gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
       &dlb_flexr_sink_template, DLB_TYPE_FLEXR_PAD);
+  gst_element_class_add_static_pad_template_with_gtype (gstelement_class,
+      &dlb_flexr_split_template, DLB_TYPE_FLEXR_SPLIT_PAD);
   gst_element_class_set_static_metadata (gstelement_class, "Flexr",
       "Generic/Audio", "Renders and mixes multiple audio streams",
       "Dolby Support <support@dolby.com>");
@@ -340,16 +1060,17 @@ dlb_flexr_class_init (DlbFlexrClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_ACTIVE_CHANNELS_ENABLE,
       g_param_spec_boolean ("active-channels-enable", "Active channels enable",
-          "Enable filtering of render channels", FALSE,
+          "Enable filtering of render channels, changes are crossfaded",
+          FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
-          GST_PARAM_MUTABLE_READY));
+          GST_PARAM_MUTABLE_PLAYING));
 
   g_object_class_install_property (gobject_class, PROP_ACTIVE_CHANNELS_MASK,
       g_param_spec_uint64 ("active-channels-mask", "Active channels mask",
           "A bitmask of channels that will be rendered when active-channels-enable = TRUE",
           1, G_MAXUINT64, 1,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
-          GST_PARAM_MUTABLE_READY));
+          GST_PARAM_MUTABLE_PLAYING));
 
   g_object_class_install_property (gobject_class, PROP_EXTERNAL_USER_GAIN,
       g_param_spec_double ("external-user-gain", "External User Gain",
@@ -367,8 +1088,23 @@ dlb_flexr_class_init (DlbFlexrClass * klass)
           G_MAXINT32, EXT_USER_GAIN_BY_STEP_DISABLE,
           G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_LATENCY,
+      g_param_spec_uint64 ("latency", "Latency",
+          "Duration of output buffers in nanoseconds when upstream is not "
+          "live, rounded up to a multiple of the rendering block. Live "
+          "streams always use a single block, (0) - single block",
+          0, G_MAXUINT64, DEFAULT_LATENCY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Library call statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+
   gstelement_class->request_new_pad = GST_DEBUG_FUNCPTR (dlb_flexr_request_new_pad);
   gstelement_class->release_pad = GST_DEBUG_FUNCPTR (dlb_flexr_release_pad);
+  gstelement_class->change_state = GST_DEBUG_FUNCPTR (dlb_flexr_change_state);
 
   agg_class->sink_query = GST_DEBUG_FUNCPTR (dlb_flexr_sink_query);
   agg_class->sink_event = GST_DEBUG_FUNCPTR (dlb_flexr_sink_event);
@@ -379,17 +1115,40 @@ dlb_flexr_class_init (DlbFlexrClass * klass)
 static void
 dlb_flexr_init (DlbFlexr * flexr)
 {
-  flexr->active_channels_enable = FALSE;
-  flexr->active_channels_mask = 0x1;
+  DlbFlexrParams params = { EXT_USER_GAIN_BY_STEP_DISABLE, 1, FALSE, 0x1 };
+
   flexr->flexr_instance = NULL;
+  flexr->device_config = NULL;
   flexr->flushing_streams = NULL;
+  flexr->released_streams = NULL;
   flexr->config_path = NULL;
   flexr->channels = 0;
   flexr->streams = 0;
   flexr->latency = 0;
   flexr->blksize = 0;
-  flexr->ext_gain = 1;
-  flexr->ext_gain_step = EXT_USER_GAIN_BY_STEP_DISABLE;
+  flexr->rate = 0;
+  flexr->output_latency = DEFAULT_LATENCY;
+  flexr->outblocks = 1;
+  flexr->outpos = 0;
+  flexr->ready_pads = 0;
+  flexr->instance_active_enable = FALSE;
+  flexr->instance_active_mask = 0x1;
+  flexr->switch_pool = NULL;
+  flexr->switch_pending = FALSE;
+  flexr->switch_task = NULL;
+  flexr->next_instance = NULL;
+  flexr->fade_buffer = NULL;
+  flexr->fade_ramp = NULL;
+  flexr->fade_ramp_len = 0;
+  flexr->split_pads = NULL;
+  flexr->split_serial = 0;
+  flexr->params = dlb_param_mailbox_new (sizeof (params), &params);
+  flexr->caps_cache = dlb_caps_cache_new (DLB_FLEXR_CAPS_CACHE_SIZE);
+
+  /* request src pads are fed as the main output goes out */
+  gst_pad_add_probe (GST_AGGREGATOR_SRC_PAD (flexr),
+      GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+      GST_PAD_PROBE_TYPE_EVENT_FLUSH, dlb_flexr_split_probe, flexr, NULL);
 }
 
 static void
@@ -398,17 +1157,77 @@ dlb_flexr_finalize (GObject * object)
   DlbFlexr *flexr = DLB_FLEXR (object);
 
   dlb_flexr_close (flexr);
+  g_free (flexr->fade_ramp);
+  dlb_param_mailbox_free (flexr->params);
+  dlb_caps_cache_free (flexr->caps_cache);
   g_free (flexr->config_path);
 
   G_OBJECT_CLASS (dlb_flexr_parent_class)->finalize (object);
 }
 
+static void
+dlb_flexr_apply_ext_gain (DlbFlexr * flexr, dlb_flexr * instance,
+    const DlbFlexrParams * params, guint groups)
+{
+  if (groups & DLB_FLEXR_PARAMS_EXT_GAIN) {
+    GST_DEBUG_OBJECT (flexr, "Updating external user gain %f",
+        params->ext_gain);
+    dlb_flexr_set_external_user_gain (instance, params->ext_gain);
+  }
+
+  if ((groups & DLB_FLEXR_PARAMS_EXT_GAIN_STEP)
+      && params->ext_gain_step != EXT_USER_GAIN_BY_STEP_DISABLE) {
+    int steps = dlb_flexr_query_ext_gain_steps (instance);
+    int step = MIN (steps - 1, params->ext_gain_step);
+    dlb_flexr_set_external_user_gain_by_step (instance, step);
+  }
+}
+
+/* external gain of a new instance, the step takes precedence when set */
+static void
+dlb_flexr_init_ext_gain (DlbFlexr * flexr, dlb_flexr * instance,
+    const DlbFlexrParams * params)
+{
+  if (params->ext_gain_step != EXT_USER_GAIN_BY_STEP_DISABLE)
+    dlb_flexr_apply_ext_gain (flexr, instance, params,
+        DLB_FLEXR_PARAMS_EXT_GAIN_STEP);
+  else
+    dlb_flexr_apply_ext_gain (flexr, instance, params,
+        DLB_FLEXR_PARAMS_EXT_GAIN);
+}
+
+/* one output buffer plus the deepest queue kept by drift compensating
+ * pads */
+static void
+dlb_flexr_update_latency (DlbFlexr * flexr)
+{
+  GstClockTime latency, target = 0;
+  GList *l;
+
+  GST_OBJECT_LOCK (flexr);
+  for (l = GST_ELEMENT_CAST (flexr)->sinkpads; l; l = l->next) {
+    DlbFlexrPad *pad = DLB_FLEXR_PAD (l->data);
+
+    GST_OBJECT_LOCK (pad);
+    if (pad->drift_enable)
+      target = MAX (target, pad->drift_target);
+    GST_OBJECT_UNLOCK (pad);
+  }
+
+  latency = gst_util_uint64_scale_int_ceil (flexr->outblocks * flexr->blksize,
+      GST_SECOND, flexr->rate);
+  GST_OBJECT_UNLOCK (flexr);
+
+  gst_aggregator_set_latency (GST_AGGREGATOR (flexr), latency + target,
+      latency + target);
+}
+
 static gboolean
-dlb_flexr_open (DlbFlexr * flexr)
+dlb_flexr_open (DlbFlexr * flexr, gint rate, gboolean live)
 {
-  GstAggregator *agg;
   GstAudioAggregator *aagg;
   dlb_flexr_init_info info = { 0 };
+  const DlbFlexrParams *params;
   guint64 duration;
 
   GError *error = NULL;
@@ -422,47 +1241,69 @@ dlb_flexr_open (DlbFlexr * flexr)
   if (error != NULL)
     goto config_error;
 
-  info.active_channels_enable = flexr->active_channels_enable;
-  info.active_channels_mask = flexr->active_channels_mask;
+  /* kept for instances created when active channels change */
+  flexr->device_config = g_bytes_new_take (contents, length);
+
+  GST_OBJECT_LOCK (flexr);
+  params = dlb_param_mailbox_read (flexr->params, NULL);
+
+  info.rate = rate;
+  info.active_channels_enable = params->active_channels_enable;
+  info.active_channels_mask = params->active_channels_mask;
   info.serialized_config = (guint8 *) contents;
   info.serialized_config_size = length;
 
   flexr->flexr_instance = dlb_flexr_new (&info);
-  if (!flexr->flexr_instance)
+  if (!flexr->flexr_instance) {
+    GST_OBJECT_UNLOCK (flexr);
     goto mixer_error;
-
-  if (flexr->ext_gain_step != EXT_USER_GAIN_BY_STEP_DISABLE) {
-    int steps = dlb_flexr_query_ext_gain_steps (flexr->flexr_instance);
-    int step = MIN (steps - 1, flexr->ext_gain_step);
-    dlb_flexr_set_external_user_gain_by_step (flexr->flexr_instance, step);
-  } else {
-    dlb_flexr_set_external_user_gain (flexr->flexr_instance, flexr->ext_gain);
   }
 
+  dlb_flexr_init_ext_gain (flexr, flexr->flexr_instance, params);
+  flexr->instance_active_enable = params->active_channels_enable;
+  flexr->instance_active_mask = params->active_channels_mask;
+  GST_OBJECT_UNLOCK (flexr);
+
   flexr->channels = dlb_flexr_query_num_outputs (flexr->flexr_instance);
   flexr->latency = dlb_flexr_query_latency (flexr->flexr_instance);
   flexr->blksize = dlb_flexr_query_outblk_samples (flexr->flexr_instance);
 
-  duration = gst_util_uint64_scale_int_ceil (flexr->blksize, GST_SECOND, 48000);
+  /* live playback gets the lowest latency, otherwise larger buffers reduce
+   * per buffer overhead */
+  duration = gst_util_uint64_scale_int_ceil (flexr->blksize, GST_SECOND, rate);
+
+  GST_OBJECT_LOCK (flexr);
+  flexr->rate = rate;
+  flexr->outblocks = 1;
+  flexr->outpos = 0;
+  if (!live && flexr->output_latency > duration)
+    flexr->outblocks = (flexr->output_latency + duration - 1) / duration;
+  GST_OBJECT_UNLOCK (flexr);
+
+  /* sink caps are restricted to the rendering rate from now on */
+  dlb_caps_cache_invalidate (flexr->caps_cache);
+
+  duration = gst_util_uint64_scale_int_ceil (flexr->outblocks * flexr->blksize,
+      GST_SECOND, rate);
 
-  agg = GST_AGGREGATOR (flexr);
-  gst_aggregator_set_latency (agg, duration, duration);
+  GST_DEBUG_OBJECT (flexr, "Rendering %d blocks of %d samples per buffer at "
+      "%d Hz%s", flexr->outblocks, flexr->blksize, rate, live ? ", live" : "");
+
+  dlb_flexr_update_latency (flexr);
 
   aagg = GST_AUDIO_AGGREGATOR (flexr);
   g_object_set (G_OBJECT (aagg), "output-buffer-duration", duration, NULL);
 
-  g_free (contents);
   return TRUE;
 
 mixer_error:
   GST_ELEMENT_ERROR (flexr, LIBRARY, INIT, (NULL), ("Failed to open FLEXR"));
-  g_free (contents);
+  g_clear_pointer (&flexr->device_config, g_bytes_unref);
   return FALSE;
 
 path_error:
   GST_ELEMENT_ERROR (flexr, LIBRARY, INIT, (NULL),
       ("device-config property cannot be empty"));
-  g_free (contents);
   return FALSE;
 
 config_error:
@@ -476,12 +1317,19 @@ config_error:
 static void
 dlb_flexr_close (DlbFlexr * flexr)
 {
+  dlb_flexr_switch_reset (flexr);
   dlb_flexr_free (flexr->flexr_instance);
+  g_clear_pointer (&flexr->device_config, g_bytes_unref);
 
   flexr->flexr_instance = NULL;
   flexr->channels = 0;
   flexr->streams = 0;
 
+  GST_OBJECT_LOCK (flexr);
+  flexr->rate = 0;
+  GST_OBJECT_UNLOCK (flexr);
+  dlb_caps_cache_invalidate (flexr->caps_cache);
+
   g_list_free (flexr->flushing_streams);
   flexr->flushing_streams = NULL;
 }
@@ -491,22 +1339,44 @@ dlb_flexr_get_property (GObject * object, guint prop_id,
     GValue * value, GParamSpec * pspec)
 {
   DlbFlexr *flexr = DLB_FLEXR (object);
+  DlbFlexrParams *params;
+  GstStructure *stats;
 
   switch (prop_id) {
     case PROP_DEVICE_CONFIG:
       g_value_set_string (value, flexr->config_path);
       break;
     case PROP_ACTIVE_CHANNELS_ENABLE:
-      g_value_set_boolean (value, flexr->active_channels_enable);
+      params = dlb_param_mailbox_lock (flexr->params);
+      g_value_set_boolean (value, params->active_channels_enable);
+      dlb_param_mailbox_unlock (flexr->params, 0);
       break;
     case PROP_ACTIVE_CHANNELS_MASK:
-      g_value_set_uint64 (value, flexr->active_channels_mask);
+      params = dlb_param_mailbox_lock (flexr->params);
+      g_value_set_uint64 (value, params->active_channels_mask);
+      dlb_param_mailbox_unlock (flexr->params, 0);
       break;
     case PROP_EXTERNAL_USER_GAIN:
-      g_value_set_double (value, flexr->ext_gain);
+      params = dlb_param_mailbox_lock (flexr->params);
+      g_value_set_double (value, params->ext_gain);
+      dlb_param_mailbox_unlock (flexr->params, 0);
       break;
     case PROP_EXTERNAL_USER_GAIN_BY_STEP:
-      g_value_set_int (value, flexr->ext_gain_step);
+      params = dlb_param_mailbox_lock (flexr->params);
+      g_value_set_int (value, params->ext_gain_step);
+      dlb_param_mailbox_unlock (flexr->params, 0);
+      break;
+    case PROP_LATENCY:
+      GST_OBJECT_LOCK (flexr);
+      g_value_set_uint64 (value, flexr->output_latency);
+      GST_OBJECT_UNLOCK (flexr);
+      break;
+    case PROP_STATS:
+      stats = gst_structure_new_empty ("dlbflexr-stats");
+#ifdef DLB_FLEXR_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_flexr_query_stats);
+#endif
+      g_value_take_boxed (value, stats);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -515,80 +1385,764 @@ dlb_flexr_get_property (GObject * object, guint prop_id,
 }
 
 static void
-dlb_flexr_set_property (GObject * object, guint prop_id,
-    const GValue * value, GParamSpec * pspec)
+dlb_flexr_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbFlexr *flexr = DLB_FLEXR (object);
+  DlbFlexrParams *params;
+  guint groups = 0;
+
+  switch (prop_id) {
+    case PROP_DEVICE_CONFIG:
+      GST_OBJECT_LOCK (flexr);
+      g_free (flexr->config_path);
+      flexr->config_path = g_strdup (g_value_get_string (value));
+      GST_OBJECT_UNLOCK (flexr);
+      break;
+    case PROP_ACTIVE_CHANNELS_ENABLE:
+      /* running instance is replaced at the next output buffer boundary */
+      params = dlb_param_mailbox_lock (flexr->params);
+      if (params->active_channels_enable != g_value_get_boolean (value)) {
+        params->active_channels_enable = g_value_get_boolean (value);
+        groups = DLB_FLEXR_PARAMS_ACTIVE_CHANNELS;
+      }
+      dlb_param_mailbox_unlock (flexr->params, groups);
+      break;
+    case PROP_ACTIVE_CHANNELS_MASK:
+      params = dlb_param_mailbox_lock (flexr->params);
+      if (params->active_channels_mask != g_value_get_uint64 (value)) {
+        params->active_channels_mask = g_value_get_uint64 (value);
+        groups = DLB_FLEXR_PARAMS_ACTIVE_CHANNELS;
+      }
+      dlb_param_mailbox_unlock (flexr->params, groups);
+      break;
+    case PROP_EXTERNAL_USER_GAIN:
+      /* applied by the streaming thread at next block */
+      params = dlb_param_mailbox_lock (flexr->params);
+      if (params->ext_gain != g_value_get_double (value)) {
+        params->ext_gain = g_value_get_double (value);
+        groups = DLB_FLEXR_PARAMS_EXT_GAIN;
+      }
+      dlb_param_mailbox_unlock (flexr->params, groups);
+      break;
+    case PROP_EXTERNAL_USER_GAIN_BY_STEP:
+      params = dlb_param_mailbox_lock (flexr->params);
+      if (params->ext_gain_step != g_value_get_int (value)) {
+        params->ext_gain_step = g_value_get_int (value);
+        groups = DLB_FLEXR_PARAMS_EXT_GAIN_STEP;
+      }
+      dlb_param_mailbox_unlock (flexr->params, groups);
+      break;
+    case PROP_LATENCY:
+      GST_OBJECT_LOCK (flexr);
+      flexr->output_latency = g_value_get_uint64 (value);
+      GST_OBJECT_UNLOCK (flexr);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+/* must be called with object lock held */
+static gboolean
+dlb_flexr_pad_pushed (DlbFlexr * flexr, DlbFlexrPad * pad, gint samples)
+{
+  if (pad->pending < flexr->blksize && pad->pending + samples >= flexr->blksize)
+    flexr->ready_pads++;
+
+  pad->pending += samples;
+
+  return flexr->ready_pads == GST_ELEMENT_CAST (flexr)->numsinkpads;
+}
+
+/* must be called with object lock held */
+static void
+dlb_flexr_pad_reset_pending (DlbFlexr * flexr, DlbFlexrPad * pad)
+{
+  if (pad->pending >= flexr->blksize)
+    flexr->ready_pads--;
+
+  pad->pending = 0;
+}
+
+/* each stream gave one block to the output, must be called with object
+ * lock held */
+static void
+dlb_flexr_consume_block (DlbFlexr * flexr)
+{
+  GList *l = GST_ELEMENT_CAST (flexr)->sinkpads;
+
+  flexr->ready_pads = 0;
+
+  for (; l; l = l->next) {
+    DlbFlexrPad *flexrpad = DLB_FLEXR_PAD (l->data);
+
+    flexrpad->pending = MAX (flexrpad->pending - flexr->blksize, 0);
+    if (flexrpad->pending >= flexr->blksize)
+      flexr->ready_pads++;
+  }
+}
+
+/* must be called with object lock held */
+static void
+dlb_flexr_reset_pending (DlbFlexr * flexr)
+{
+  GList *l = GST_ELEMENT_CAST (flexr)->sinkpads;
+
+  for (; l; l = l->next)
+    DLB_FLEXR_PAD (l->data)->pending = 0;
+
+  flexr->ready_pads = 0;
+  flexr->outpos = 0;
+}
+
+/* must be called with object lock held */
+static gboolean
+dlb_flexr_all_drained (DlbFlexr * flexr)
+{
+  GList *l = GST_ELEMENT_CAST (flexr)->sinkpads;
+
+  for (; l; l = l->next) {
+    if (DLB_FLEXR_PAD (l->data)->pending)
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* Runtime active channels switching. The renderer takes the active channels
+ * at creation only, so a new instance is created on a worker thread, gets
+ * all streams once every stream rendered what it was given, and both
+ * instances run until the new one fills its latency and the output is
+ * crossfaded. */
+typedef struct
+{
+  gint ref_count;
+  gint done;
+  dlb_flexr_init_info info;
+  GBytes *device_config;
+  gboolean retire;
+
+  /* instance built by the task, or the retired one to release */
+  dlb_flexr *instance;
+} DlbFlexrSwitchTask;
+
+static DlbFlexrSwitchTask *
+dlb_flexr_switch_task_ref (DlbFlexrSwitchTask * task)
+{
+  g_atomic_int_inc (&task->ref_count);
+  return task;
+}
+
+/* result which was never picked up is released with the task */
+static void
+dlb_flexr_switch_task_unref (DlbFlexrSwitchTask * task)
+{
+  if (!g_atomic_int_dec_and_test (&task->ref_count))
+    return;
+
+  if (task->instance)
+    dlb_flexr_free (task->instance);
+
+  if (task->device_config)
+    g_bytes_unref (task->device_config);
+
+  g_slice_free (DlbFlexrSwitchTask, task);
+}
+
+static void
+dlb_flexr_switch_task_func (gpointer data, gpointer user_data)
+{
+  DlbFlexrSwitchTask *task = data;
+
+  if (task->retire) {
+    dlb_flexr_free (task->instance);
+    task->instance = NULL;
+  } else {
+    task->instance = dlb_flexr_new (&task->info);
+    g_atomic_int_set (&task->done, 1);
+  }
+
+  dlb_flexr_switch_task_unref (task);
+}
+
+static void
+dlb_flexr_switch_push_task (DlbFlexr * flexr, DlbFlexrSwitchTask * task)
+{
+  if (!flexr->switch_pool)
+    flexr->switch_pool = g_thread_pool_new (dlb_flexr_switch_task_func, NULL,
+        1, FALSE, NULL);
+
+  g_thread_pool_push (flexr->switch_pool, task, NULL);
+}
+
+static void
+dlb_flexr_switch_retire (DlbFlexr * flexr, dlb_flexr * instance)
+{
+  DlbFlexrSwitchTask *task = g_slice_new0 (DlbFlexrSwitchTask);
+
+  /* release is kept away from the streaming thread */
+  task->ref_count = 1;
+  task->retire = TRUE;
+  task->instance = instance;
+  dlb_flexr_switch_push_task (flexr, task);
+}
+
+/* must be called with object lock held */
+static void
+dlb_flexr_clear_next_streams (DlbFlexr * flexr)
+{
+  GList *l = GST_ELEMENT_CAST (flexr)->sinkpads;
+
+  for (; l; l = l->next)
+    DLB_FLEXR_PAD (l->data)->next_stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+}
+
+/* drops a crossfade in progress, it starts over at the next boundary */
+static void
+dlb_flexr_switch_abort (DlbFlexr * flexr)
+{
+  GST_OBJECT_LOCK (flexr);
+  dlb_flexr_clear_next_streams (flexr);
+  g_list_free (flexr->released_streams);
+  flexr->released_streams = NULL;
+  GST_OBJECT_UNLOCK (flexr);
+
+  if (!flexr->next_instance)
+    return;
+
+  GST_DEBUG_OBJECT (flexr, "Streams changed, restarting crossfade");
+
+  dlb_flexr_switch_retire (flexr, flexr->next_instance);
+  flexr->next_instance = NULL;
+}
+
+static void
+dlb_flexr_switch_reset (DlbFlexr * flexr)
+{
+  dlb_flexr_switch_abort (flexr);
+
+  /* pending instance creation is not waited for, its result is dropped
+   * once done. Queued tasks are completed by the pool in background. */
+  if (flexr->switch_pool) {
+    g_thread_pool_free (flexr->switch_pool, FALSE, FALSE);
+    flexr->switch_pool = NULL;
+  }
+
+  g_clear_pointer (&flexr->switch_task, dlb_flexr_switch_task_unref);
+  g_clear_pointer (&flexr->fade_buffer, g_free);
+
+  flexr->switch_pending = FALSE;
+}
+
+/* adds every stream of the running instance to the new one */
+static gboolean
+dlb_flexr_switch_start (DlbFlexr * flexr, dlb_flexr * instance,
+    const DlbFlexrParams * params)
+{
+  GList *l;
+
+  if (dlb_flexr_query_num_outputs (instance) != flexr->channels ||
+      dlb_flexr_query_outblk_samples (instance) != flexr->blksize)
+    return FALSE;
+
+  GST_OBJECT_LOCK (flexr);
+  for (l = GST_ELEMENT_CAST (flexr)->sinkpads; l; l = l->next) {
+    DlbFlexrPad *pad = DLB_FLEXR_PAD (l->data);
+    const DlbFlexrPadParams *padparams;
+    dlb_flexr_stream_info info;
+    const guint8 *data;
+    gsize length;
+
+    if (!pad->stream)
+      continue;
+
+    GST_OBJECT_LOCK (pad);
+    data = g_bytes_get_data (pad->config, &length);
+    dlb_flexr_stream_info_init (&info, data, length);
+
+    info.upmix_enable = pad->upmix;
+    info.interp = pad->interp;
+    info.format = pad->fmt;
+
+    pad->next_stream = dlb_flexr_add_stream (instance, &info);
+    GST_OBJECT_UNLOCK (pad);
+
+    if (!pad->next_stream) {
+      dlb_flexr_clear_next_streams (flexr);
+      GST_OBJECT_UNLOCK (flexr);
+      return FALSE;
+    }
+
+    /* latest values, the mailbox is left for the running stream */
+    padparams = dlb_param_mailbox_lock (pad->params);
+    dlb_flexr_set_internal_user_gain (instance, pad->next_stream,
+        padparams->internal_user_gain);
+    dlb_flexr_set_content_norm_gain (instance, pad->next_stream,
+        padparams->content_normalization_gain);
+    dlb_param_mailbox_unlock (pad->params, 0);
+  }
+  GST_OBJECT_UNLOCK (flexr);
+
+  dlb_flexr_init_ext_gain (flexr, instance, params);
+
+  flexr->next_instance = instance;
+  flexr->fade_prime = dlb_flexr_query_latency (instance);
+  flexr->fade_pos = 0;
+  flexr->fade_len = SWITCH_CROSSFADE_BLOCKS * flexr->blksize;
+
+  if (flexr->fade_ramp_len != flexr->fade_len) {
+    g_free (flexr->fade_ramp);
+    flexr->fade_ramp = dlb_audio_crossfade_ramp_new (flexr->fade_len);
+    flexr->fade_ramp_len = flexr->fade_len;
+  }
+
+  return TRUE;
+}
+
+/* must be called from the aggregator thread when all streams are drained */
+static void
+dlb_flexr_switch_check (DlbFlexr * flexr, const DlbFlexrParams * params)
+{
+  DlbFlexrSwitchTask *task;
+  dlb_flexr *instance;
+  gsize length;
+
+  if (!flexr->flexr_instance || flexr->next_instance)
+    return;
+
+  if (flexr->switch_pending) {
+    task = flexr->switch_task;
+    if (!g_atomic_int_get (&task->done))
+      return;
+
+    instance = task->instance;
+    task->instance = NULL;
+    g_clear_pointer (&flexr->switch_task, dlb_flexr_switch_task_unref);
+    flexr->switch_pending = FALSE;
+
+    if (instance && dlb_flexr_switch_start (flexr, instance, params)) {
+      GST_DEBUG_OBJECT (flexr, "Crossfading to new FLEXR instance");
+      return;
+    }
+
+    GST_ELEMENT_WARNING (flexr, LIBRARY, INIT, (NULL),
+        ("Failed to switch active channels to 0x%" G_GINT64_MODIFIER "x",
+            flexr->switch_active_mask));
+
+    if (instance)
+      dlb_flexr_switch_retire (flexr, instance);
+
+    /* not retried until the settings change again */
+    flexr->instance_active_enable = flexr->switch_active_enable;
+    flexr->instance_active_mask = flexr->switch_active_mask;
+    return;
+  }
+
+  if (params->active_channels_enable == flexr->instance_active_enable &&
+      params->active_channels_mask == flexr->instance_active_mask)
+    return;
+
+  GST_DEBUG_OBJECT (flexr, "Active channels changed, creating new FLEXR "
+      "instance");
+
+  task = g_slice_new0 (DlbFlexrSwitchTask);
+  task->ref_count = 1;
+  task->device_config = g_bytes_ref (flexr->device_config);
+  task->info.rate = flexr->rate;
+  task->info.active_channels_enable = params->active_channels_enable;
+  task->info.active_channels_mask = params->active_channels_mask;
+  task->info.serialized_config =
+      g_bytes_get_data (task->device_config, &length);
+  task->info.serialized_config_size = length;
+
+  flexr->switch_active_enable = params->active_channels_enable;
+  flexr->switch_active_mask = params->active_channels_mask;
+  flexr->switch_pending = TRUE;
+  flexr->switch_task = dlb_flexr_switch_task_ref (task);
+  dlb_flexr_switch_push_task (flexr, task);
+}
+
+static void
+dlb_flexr_switch_handover (DlbFlexr * flexr)
+{
+  GList *l, *flushing;
+
+  GST_DEBUG_OBJECT (flexr, "Crossfade finished, releasing old FLEXR instance");
+
+  dlb_flexr_switch_retire (flexr, flexr->flexr_instance);
+
+  GST_OBJECT_LOCK (flexr);
+  for (l = GST_ELEMENT_CAST (flexr)->sinkpads; l; l = l->next) {
+    DlbFlexrPad *pad = DLB_FLEXR_PAD (l->data);
+
+    pad->stream = pad->next_stream;
+    pad->next_stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+  }
+
+  flexr->flexr_instance = flexr->next_instance;
+  flexr->next_instance = NULL;
+
+  flexr->instance_active_enable = flexr->switch_active_enable;
+  flexr->instance_active_mask = flexr->switch_active_mask;
+
+  /* switch only starts with no stream flushing, what is left belongs to
+   * pads released since the last block. Their old handles went away with
+   * the old instance, the new ones are flushed by the new instance. */
+  flushing = flexr->flushing_streams;
+  flexr->flushing_streams = flexr->released_streams;
+  flexr->released_streams = NULL;
+  flexr->streams += g_list_length (flexr->flushing_streams);
+  GST_OBJECT_UNLOCK (flexr);
+
+  flexr->streams -= g_list_length (flushing);
+  g_list_free (flushing);
+}
+
+/* renders the block of the new instance and mixes it into outdata */
+static void
+dlb_flexr_crossfade_block (DlbFlexr * flexr, guint8 * outdata,
+    GstAudioInfo * outinfo)
+{
+  dlb_buffer *out;
+  gint samples;
+
+  if (!flexr->fade_buffer)
+    flexr->fade_buffer =
+        g_malloc (flexr->blksize * GST_AUDIO_INFO_BPF (outinfo));
+
+  out = dlb_buffer_new (outinfo);
+  dlb_buffer_map_memory (out, flexr->fade_buffer);
+  dlb_flexr_generate_output (flexr->next_instance, out, &samples);
+  dlb_buffer_free (out);
+
+  if (flexr->fade_prime > 0) {
+    /* output of new instance is valid once its latency is filled */
+    flexr->fade_prime -= flexr->blksize;
+  } else {
+    dlb_audio_crossfade (outdata, flexr->fade_buffer, flexr->blksize,
+        outinfo, flexr->fade_ramp, flexr->fade_pos, flexr->fade_len);
+
+    flexr->fade_pos += flexr->blksize;
+  }
+
+  if (flexr->fade_pos >= flexr->fade_len)
+    dlb_flexr_switch_handover (flexr);
+}
+
+/* output layout of a split pad for the main output format, must be called
+ * with the element lock held */
+static gboolean
+dlb_flexr_split_setup (DlbFlexrSplitPad * split, const GstAudioInfo * srcinfo)
+{
+  GstAudioChannelPosition position[64];
+  GstAudioInfo info;
+  guint64 mask;
+  gint i, channels = 0;
+
+  GST_OBJECT_LOCK (split);
+  mask = split->channels_mask;
+  GST_OBJECT_UNLOCK (split);
+
+  for (i = 0; i < GST_AUDIO_INFO_CHANNELS (srcinfo) && i < 64; ++i) {
+    if (!(mask & (G_GUINT64_CONSTANT (1) << i)))
+      continue;
+
+    split->map[channels] = i;
+    position[channels++] = GST_AUDIO_INFO_IS_UNPOSITIONED (srcinfo) ?
+        GST_AUDIO_CHANNEL_POSITION_NONE : srcinfo->position[i];
+  }
+
+  if (!channels)
+    return FALSE;
+
+  gst_audio_info_init (&info);
+  gst_audio_info_set_format (&info, GST_AUDIO_INFO_FORMAT (srcinfo),
+      GST_AUDIO_INFO_RATE (srcinfo), channels, position);
+
+  if (!gst_audio_info_is_equal (&info, &split->outinfo)) {
+    GST_DEBUG_OBJECT (split, "Carrying %d of %d output channels", channels,
+        GST_AUDIO_INFO_CHANNELS (srcinfo));
+
+    split->outinfo = info;
+    split->caps_pending = TRUE;
+  }
+
+  return TRUE;
+}
+
+/* must be called with the element lock held */
+static void
+dlb_flexr_split_alloc (DlbFlexrSplitPad * split, gint frames)
+{
+  split->outbuf = gst_buffer_new_allocate (NULL,
+      frames * GST_AUDIO_INFO_BPF (&split->outinfo), NULL);
+  gst_buffer_map (split->outbuf, &split->outmap, GST_MAP_WRITE);
+
+  /* blocks that are not rendered stay silent, all output formats are
+   * signed */
+  memset (split->outmap.data, 0, split->outmap.size);
+}
+
+/* must be called with the element lock held */
+static void
+dlb_flexr_split_clear (DlbFlexrSplitPad * split)
+{
+  if (!split->outbuf)
+    return;
+
+  gst_buffer_unmap (split->outbuf, &split->outmap);
+  gst_buffer_unref (split->outbuf);
+  split->outbuf = NULL;
+}
+
+#define SPLIT_SCATTER(type)                                                    \
+  {                                                                            \
+    const type *s = (const type *) src;                                        \
+    type *d = (type *) dst;                                                    \
+                                                                               \
+    for (i = 0; i < frames; ++i) {                                             \
+      for (c = 0; c < channels; ++c)                                           \
+        d[c] = s[map[c]];                                                      \
+      s += srcchannels;                                                        \
+      d += channels;                                                           \
+    }                                                                          \
+  }
+
+/* picks the pad's channels out of an interleaved block in a single pass,
+ * sample words are copied as is, so float formats need no special case */
+static void
+dlb_flexr_split_scatter (DlbFlexrSplitPad * split, const guint8 * src,
+    const GstAudioInfo * srcinfo, guint8 * dst, gint frames)
+{
+  const gint *map = split->map;
+  gint channels = GST_AUDIO_INFO_CHANNELS (&split->outinfo);
+  gint srcchannels = GST_AUDIO_INFO_CHANNELS (srcinfo);
+  gint i, c;
+
+  switch (GST_AUDIO_INFO_WIDTH (srcinfo)) {
+    case 16:
+      SPLIT_SCATTER (guint16);
+      break;
+    case 32:
+      SPLIT_SCATTER (guint32);
+      break;
+    case 64:
+      SPLIT_SCATTER (guint64);
+      break;
+    default:
+      g_assert_not_reached ();
+  }
+}
+
+/* copies a rendered block to the split pads while it is still in cache,
+ * must be called with the element lock held */
+static void
+dlb_flexr_split_block (DlbFlexr * flexr, const guint8 * block,
+    const GstAudioInfo * srcinfo, gint frames)
+{
+  GList *l;
+
+  for (l = flexr->split_pads; l; l = l->next) {
+    DlbFlexrSplitPad *split = l->data;
+    guint8 *dst;
+
+    if (!split->outbuf) {
+      if (!dlb_flexr_split_setup (split, srcinfo))
+        continue;
+
+      dlb_flexr_split_alloc (split, frames);
+    }
+
+    dst = split->outmap.data + flexr->outpos *
+        GST_AUDIO_INFO_BPF (&split->outinfo);
+    dlb_flexr_split_scatter (split, block, srcinfo, dst, flexr->blksize);
+  }
+}
+
+static GList *
+dlb_flexr_split_pads_ref (DlbFlexr * flexr)
+{
+  GList *pads;
+
+  GST_OBJECT_LOCK (flexr);
+  pads = g_list_copy_deep (flexr->split_pads, (GCopyFunc) gst_object_ref,
+      NULL);
+  GST_OBJECT_UNLOCK (flexr);
+
+  return pads;
+}
+
+static void
+dlb_flexr_split_push_stream_start (DlbFlexr * flexr, GstPad * pad)
+{
+  GstEvent *event;
+  gchar *stream_id;
+
+  if ((event = gst_pad_get_sticky_event (pad, GST_EVENT_STREAM_START, 0))) {
+    gst_event_unref (event);
+    return;
+  }
+
+  stream_id = gst_pad_create_stream_id (pad, GST_ELEMENT_CAST (flexr),
+      GST_PAD_NAME (pad));
+  gst_pad_push_event (pad, gst_event_new_stream_start (stream_id));
+  g_free (stream_id);
+}
+
+static void
+dlb_flexr_split_push_events (DlbFlexr * flexr, GstPad * pad, GstCaps * caps)
+{
+  GstEvent *event;
+
+  dlb_flexr_split_push_stream_start (flexr, pad);
+  gst_pad_push_event (pad, gst_event_new_caps (caps));
+
+  event = gst_pad_get_sticky_event (GST_AGGREGATOR_SRC_PAD (flexr),
+      GST_EVENT_SEGMENT, 0);
+  if (event)
+    gst_pad_push_event (pad, event);
+}
+
+static void
+dlb_flexr_split_push_event (DlbFlexr * flexr, GstEvent * event)
 {
-  DlbFlexr *flexr = DLB_FLEXR (object);
+  GList *pads, *l;
 
-  switch (prop_id) {
-    case PROP_DEVICE_CONFIG:
-      GST_OBJECT_LOCK (flexr);
-      g_free (flexr->config_path);
-      flexr->config_path = g_strdup (g_value_get_string (value));
-      GST_OBJECT_UNLOCK (flexr);
-      break;
-    case PROP_ACTIVE_CHANNELS_ENABLE:
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_FLUSH_STOP:
       GST_OBJECT_LOCK (flexr);
-      flexr->active_channels_enable = g_value_get_boolean (value);
+      for (l = flexr->split_pads; l; l = l->next)
+        dlb_flexr_split_clear (l->data);
       GST_OBJECT_UNLOCK (flexr);
       break;
-    case PROP_ACTIVE_CHANNELS_MASK:
-      GST_OBJECT_LOCK (flexr);
-      flexr->active_channels_mask = g_value_get_uint64 (value);
-      GST_OBJECT_UNLOCK (flexr);
+    case GST_EVENT_FLUSH_START:
+    case GST_EVENT_SEGMENT:
+    case GST_EVENT_EOS:
       break;
-    case PROP_EXTERNAL_USER_GAIN:
-      GST_OBJECT_LOCK (flexr);
-      flexr->ext_gain = g_value_get_double (value);
+    default:
+      return;
+  }
 
-      if (flexr->flexr_instance)
-        dlb_flexr_set_external_user_gain (flexr->flexr_instance,
-            flexr->ext_gain);
+  pads = dlb_flexr_split_pads_ref (flexr);
 
-      GST_OBJECT_UNLOCK (flexr);
-      break;
-    case PROP_EXTERNAL_USER_GAIN_BY_STEP:
-      GST_OBJECT_LOCK (flexr);
-      flexr->ext_gain_step = g_value_get_int (value);
+  /* not negotiated pads pick up segment when caps are set, but still have
+   * to finish */
+  for (l = pads; l; l = l->next) {
+    GstPad *pad = l->data;
 
-      if (flexr->flexr_instance) {
-        int steps = dlb_flexr_query_ext_gain_steps (flexr->flexr_instance);
-        int step = MIN (steps - 1, flexr->ext_gain_step);
-        dlb_flexr_set_external_user_gain_by_step (flexr->flexr_instance, step);
-      }
-      GST_OBJECT_UNLOCK (flexr);
-      break;
-    default:
-      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
-      break;
+    if (GST_EVENT_TYPE (event) == GST_EVENT_EOS)
+      dlb_flexr_split_push_stream_start (flexr, pad);
+    else if (!gst_pad_has_current_caps (pad))
+      continue;
+
+    gst_pad_push_event (pad, gst_event_ref (event));
   }
+
+  g_list_free_full (pads, gst_object_unref);
 }
 
-static gboolean
-dlb_flexr_are_all_pads_ready (DlbFlexr * flexr)
+/* hands the split pad buffers over as the main output buffer they were
+ * rendered with goes out, pads without rendered data get silence. Pushes
+ * happen on the aggregator thread, so as with tee every output needs its
+ * own queue downstream to preroll. */
+static GstPadProbeReturn
+dlb_flexr_split_probe (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
 {
-  GList *l = GST_ELEMENT_CAST (flexr)->sinkpads;
+  DlbFlexr *flexr = DLB_FLEXR (user_data);
+  GstAudioAggregatorPad *srcpad = GST_AUDIO_AGGREGATOR_PAD (pad);
+  GPtrArray *pads, *buffers, *caps;
+  GstFlowReturn ret;
+  GstBuffer *buf;
+  GList *l;
+  guint i;
+
+  if (GST_PAD_PROBE_INFO_TYPE (info) & (GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM |
+          GST_PAD_PROBE_TYPE_EVENT_FLUSH)) {
+    dlb_flexr_split_push_event (flexr, GST_PAD_PROBE_INFO_EVENT (info));
+    return GST_PAD_PROBE_OK;
+  }
 
-  for (; l; l = l->next) {
-    DlbFlexrPad *flexrpad = DLB_FLEXR_PAD (l->data);
-    gint samples;
+  buf = GST_PAD_PROBE_INFO_BUFFER (info);
 
-    samples = dlb_flexr_query_pushed_samples (flexr->flexr_instance,
-        flexrpad->stream);
+  pads = g_ptr_array_new ();
+  buffers = g_ptr_array_new ();
+  caps = g_ptr_array_new ();
 
-    if (samples < flexr->blksize)
-      return FALSE;
+  GST_OBJECT_LOCK (flexr);
+  for (l = flexr->split_pads; l; l = l->next) {
+    DlbFlexrSplitPad *split = l->data;
+
+    if (!split->outbuf) {
+      if (!dlb_flexr_split_setup (split, &srcpad->info))
+        continue;
+
+      dlb_flexr_split_alloc (split, gst_buffer_get_size (buf) /
+          GST_AUDIO_INFO_BPF (&srcpad->info));
+    }
+
+    gst_buffer_unmap (split->outbuf, &split->outmap);
+    gst_buffer_copy_into (split->outbuf, buf, GST_BUFFER_COPY_FLAGS |
+        GST_BUFFER_COPY_TIMESTAMPS, 0, -1);
+
+    g_ptr_array_add (pads, gst_object_ref (split));
+    g_ptr_array_add (buffers, split->outbuf);
+    g_ptr_array_add (caps, split->caps_pending ?
+        gst_audio_info_to_caps (&split->outinfo) : NULL);
+
+    split->outbuf = NULL;
+    split->caps_pending = FALSE;
   }
+  GST_OBJECT_UNLOCK (flexr);
 
-  return TRUE;
+  for (i = 0; i < pads->len; ++i) {
+    GstPad *splitpad = g_ptr_array_index (pads, i);
+    GstCaps *splitcaps = g_ptr_array_index (caps, i);
+
+    if (splitcaps) {
+      GST_DEBUG_OBJECT (splitpad, "Negotiated %" GST_PTR_FORMAT, splitcaps);
+      dlb_flexr_split_push_events (flexr, splitpad, splitcaps);
+      gst_caps_unref (splitcaps);
+    }
+
+    /* split outputs never stop the main output */
+    ret = gst_pad_push (splitpad, g_ptr_array_index (buffers, i));
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED &&
+        ret != GST_FLOW_FLUSHING)
+      GST_WARNING_OBJECT (splitpad, "Pushing failed: %s",
+          gst_flow_get_name (ret));
+
+    gst_object_unref (splitpad);
+  }
+
+  g_ptr_array_free (pads, TRUE);
+  g_ptr_array_free (buffers, TRUE);
+  g_ptr_array_free (caps, TRUE);
+
+  return GST_PAD_PROBE_OK;
 }
 
+/* must be called from the aggregator thread, released pads queue their
+ * streams here under the object lock */
 static void
 dlb_flexr_check_flushing_streams (DlbFlexr * flexr)
 {
-  GList *walk, *next;
+  GList *walk, *next, *flushing;
+  gboolean released;
+
+  GST_OBJECT_LOCK (flexr);
+  flushing = flexr->flushing_streams;
+  flexr->flushing_streams = NULL;
+  released = flexr->released_streams != NULL;
+  GST_OBJECT_UNLOCK (flexr);
+
+  /* new instance is built again without the released streams */
+  if (released)
+    dlb_flexr_switch_abort (flexr);
 
-  for (walk = flexr->flushing_streams; walk; walk = next) {
+  for (walk = flushing; walk; walk = next) {
     dlb_flexr_stream_handle h = GPOINTER_TO_UINT (walk->data);
     next = g_list_next (walk);
 
@@ -596,57 +2150,48 @@ dlb_flexr_check_flushing_streams (DlbFlexr * flexr)
       GST_INFO_OBJECT (flexr, "Stream finished flushing, removing");
       dlb_flexr_rm_stream (flexr->flexr_instance, h);
 
-      flexr->flushing_streams =
-          g_list_delete_link (flexr->flushing_streams, walk);
+      flushing = g_list_delete_link (flushing, walk);
       flexr->streams--;
     }
   }
+
+  GST_OBJECT_LOCK (flexr);
+  flexr->flushing_streams = g_list_concat (flushing, flexr->flushing_streams);
+  GST_OBJECT_UNLOCK (flexr);
 }
 
+/* stream changes picked up under the pad lock, the library is then called
+ * without holding it */
+typedef struct
+{
+  GBytes *config;
+  dlb_flexr_interp_mode interp;
+  const DlbFlexrPadParams *params;
+  guint groups;
+  dlb_flexr_stream_handle stream;
+  dlb_flexr_stream_handle next_stream;
+} DlbFlexrStreamUpdate;
+
+/* must be called with element and pad object locks held */
 static void
-dlb_flexr_update_stream (DlbFlexr * flexr, DlbFlexrPad * pad)
+dlb_flexr_take_stream_update (DlbFlexrPad * pad, DlbFlexrStreamUpdate * update)
 {
-  dlb_flexr *df = flexr->flexr_instance;
-  dlb_flexr_stream_handle h = pad->stream;
-
   GHashTableIter iter;
   gpointer prop_id;
 
+  update->config = NULL;
+  if (dlb_flexr_pad_update_config (pad))
+    update->config = g_bytes_ref (pad->config);
+
+  update->interp = pad->interp;
+  update->params = dlb_param_mailbox_read (pad->params, &update->groups);
+  update->stream = pad->stream;
+  update->next_stream = pad->next_stream;
+
   g_hash_table_iter_init (&iter, pad->props_set);
 
   while (g_hash_table_iter_next (&iter, &prop_id, &prop_id)) {
     switch (GPOINTER_TO_INT (prop_id)) {
-      case PROP_PAD_STREAM_CONFIG:{
-        GError *error = NULL;
-        gchar *contents = NULL;
-        gsize length;
-
-        GST_DEBUG_OBJECT (flexr, "Updating stream config %s", pad->config_path);
-        g_file_get_contents (pad->config_path, &contents, &length, &error);
-
-        if (error != NULL) {
-          GST_WARNING_OBJECT (flexr, "Stream config update failed: %s",
-              error->message);
-          g_error_free (error);
-          break;
-        }
-
-        dlb_flexr_set_render_config (df, h, (guint8 *) contents, length,
-            pad->interp, 1);
-        g_free (contents);
-        break;
-      }
-      case PROP_PAD_INTERNAL_USER_GAIN:
-        GST_DEBUG_OBJECT (flexr, "Updating internal user gain %f",
-            pad->internal_user_gain);
-        dlb_flexr_set_internal_user_gain (df, h, pad->internal_user_gain);
-        break;
-      case PROP_PAD_CONTENT_NORMALIZATION_GAIN:
-        GST_DEBUG_OBJECT (flexr, "Updating content normalization gain %f",
-            pad->content_normalization_gain);
-        dlb_flexr_set_content_norm_gain (df, h,
-            pad->content_normalization_gain);
-        break;
       case PROP_PAD_FORCE_ORDER:
         break;
       case PROP_PAD_UPMIX:
@@ -662,35 +2207,122 @@ dlb_flexr_update_stream (DlbFlexr * flexr, DlbFlexrPad * pad)
   g_hash_table_remove_all (pad->props_set);
 }
 
+static void
+dlb_flexr_update_stream (DlbFlexr * flexr, DlbFlexrPad * pad,
+    DlbFlexrStreamUpdate * update)
+{
+  /* during crossfade both instances render the stream */
+  dlb_flexr *df[2] = { flexr->flexr_instance, flexr->next_instance };
+  dlb_flexr_stream_handle h[2] = { update->stream, update->next_stream };
+  gint i, n = flexr->next_instance && update->next_stream ? 2 : 1;
+  const DlbFlexrPadParams *params = update->params;
+
+  if (update->config) {
+    gsize length;
+    const guint8 *data = g_bytes_get_data (update->config, &length);
+
+    GST_DEBUG_OBJECT (pad, "Updating stream config");
+    for (i = 0; i < n; ++i)
+      dlb_flexr_set_render_config (df[i], h[i], data, length, update->interp,
+          1);
+
+    g_bytes_unref (update->config);
+  }
+
+  if (update->groups & DLB_FLEXR_PARAMS_INTERNAL_USER_GAIN) {
+    GST_DEBUG_OBJECT (flexr, "Updating internal user gain %f",
+        params->internal_user_gain);
+    for (i = 0; i < n; ++i)
+      dlb_flexr_set_internal_user_gain (df[i], h[i],
+          params->internal_user_gain);
+  }
+
+  if (update->groups & DLB_FLEXR_PARAMS_CONTENT_NORMALIZATION_GAIN) {
+    GST_DEBUG_OBJECT (flexr, "Updating content normalization gain %f",
+        params->content_normalization_gain);
+    for (i = 0; i < n; ++i)
+      dlb_flexr_set_content_norm_gain (df[i], h[i],
+          params->content_normalization_gain);
+  }
+}
+
+/* must be called with element object lock held */
+static gboolean
+dlb_flexr_pad_add_stream (DlbFlexr * flexr, DlbFlexrPad * pad,
+    GBytes * config)
+{
+  const DlbFlexrPadParams *params;
+  dlb_flexr_stream_info info;
+  const guint8 *data;
+  gsize length;
+
+  data = g_bytes_get_data (config, &length);
+  dlb_flexr_stream_info_init (&info, data, length);
+
+  info.upmix_enable = pad->upmix;
+  info.interp = pad->interp;
+  info.format = pad->fmt;
+
+  pad->deferred = FALSE;
+  pad->stream = dlb_flexr_add_stream (flexr->flexr_instance, &info);
+  dlb_flexr_pad_reset_pending (flexr, pad);
+  if (!pad->stream)
+    return FALSE;
+
+  /* new stream starts with the latest published gains */
+  params = dlb_param_mailbox_read (pad->params, NULL);
+  dlb_flexr_set_internal_user_gain (flexr->flexr_instance, pad->stream,
+      params->internal_user_gain);
+  dlb_flexr_set_content_norm_gain (flexr->flexr_instance, pad->stream,
+      params->content_normalization_gain);
+
+  flexr->streams++;
+  g_hash_table_remove_all (pad->props_set);
+
+  return TRUE;
+}
+
 static gboolean
 dlb_flexr_set_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad, GstCaps * caps)
 {
   DlbFlexrPad *pad = DLB_FLEXR_PAD (aggpad);
-  dlb_flexr_stream_info info;
   dlb_flexr_input_format fmt;
 
   GstCapsFeatures *features = NULL;
-  GError *error = NULL;
-  gchar *contents = NULL;
-  gsize length;
-  gboolean ret;
+  GBytes *config = NULL;
+  gboolean ret = TRUE;
   gboolean have_meta = FALSE;
+  gint rate;
 
   GST_DEBUG_OBJECT (flexr, "Adding stream for caps %" GST_PTR_FORMAT, caps);
 
+  /* new instance gets the stream when the crossfade restarts */
+  dlb_flexr_switch_abort (flexr);
+
+  if (!gst_structure_get_int (gst_caps_get_structure (caps, 0), "rate", &rate))
+    goto rate_error;
+
   /* for the first stream open flexr mixer */
   if (!flexr->flexr_instance) {
-    ret = dlb_flexr_open (flexr);
+    ret = dlb_flexr_open (flexr, rate, dlb_flexr_is_upstream_live (aggpad));
     if (!ret)
       return FALSE;
   }
 
+  /* streams are mixed without resampling */
+  if (rate != flexr->rate)
+    goto rate_error;
+
   if (!pad->config_path)
     goto path_error;
 
-  g_file_get_contents (pad->config_path, &contents, &length, &error);
-  if (error != NULL)
-    goto config_error;
+  /* stream config is read on the loader thread and never waited for here,
+   * a newer one replaces it at block boundary */
+  GST_OBJECT_LOCK (pad);
+  dlb_flexr_pad_update_config (pad);
+  if (pad->config)
+    config = g_bytes_ref (pad->config);
+  GST_OBJECT_UNLOCK (pad);
 
   if ((features = gst_caps_get_features (caps, 0))) {
     have_meta =
@@ -740,36 +2372,34 @@ dlb_flexr_set_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad, GstCaps * caps)
   }
 
   GST_OBJECT_LOCK (flexr);
-  /* already initialized */
-  if (pad->stream && pad->fmt != fmt) {
+  /* already initialized, old stream renders what it was given */
+  if (pad->stream) {
     flexr->flushing_streams =
         g_list_append (flexr->flushing_streams, GUINT_TO_POINTER (pad->stream));
     pad->stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
   }
 
-  dlb_flexr_stream_info_init (&info, (guint8 *) contents, length);
-
-  info.upmix_enable = pad->upmix;
-  info.interp = pad->interp;
-  info.format = fmt;
-
-  pad->stream = dlb_flexr_add_stream (flexr->flexr_instance, &info);
-  if (!pad->stream)
-    goto stream_error;
+  pad->fmt = fmt;
 
-  dlb_flexr_set_internal_user_gain (flexr->flexr_instance, pad->stream,
-      pad->internal_user_gain);
-  dlb_flexr_set_content_norm_gain (flexr->flexr_instance, pad->stream,
-      pad->content_normalization_gain);
+  if (config) {
+    GST_DEBUG_OBJECT (flexr, "adding new %s stream",
+        have_meta ? "object" : "channel");
+    ret = dlb_flexr_pad_add_stream (flexr, pad, config);
+    g_bytes_unref (config);
+  } else {
+    /* pad renders silence until the aggregator thread picks up its config */
+    GST_DEBUG_OBJECT (flexr, "stream config not read yet, deferring stream");
+    dlb_flexr_pad_reset_pending (flexr, pad);
+    pad->deferred = TRUE;
+  }
 
-  GST_DEBUG_OBJECT (flexr, "adding new %s stream",
-      have_meta ? "object" : "channel");
+  GST_OBJECT_UNLOCK (flexr);
 
-  flexr->streams++;
-  g_hash_table_remove_all (pad->props_set);
-  g_free (contents);
+  if (!ret)
+    goto stream_error;
 
-  GST_OBJECT_UNLOCK (flexr);
+  /* pad may keep extra data queued */
+  dlb_flexr_update_latency (flexr);
 
   return TRUE;
 
@@ -779,23 +2409,20 @@ path_error:
   return FALSE;
 
 stream_error:
-  GST_OBJECT_UNLOCK (flexr);
   GST_ELEMENT_ERROR (flexr, LIBRARY, INIT, (NULL), ("Failed to add stream"));
-  g_free (contents);
   return FALSE;
 
 format_error:
   GST_ERROR_OBJECT (flexr, "invalid format set as caps: %" GST_PTR_FORMAT,
       caps);
 
-  g_free (contents);
+  if (config)
+    g_bytes_unref (config);
   return FALSE;
 
-config_error:
-  GST_ELEMENT_ERROR (flexr, RESOURCE, OPEN_READ, ("%s: %d", error->message,
-          error->code), ("Reading Stream config failed"));
-
-  g_error_free (error);
+rate_error:
+  GST_ERROR_OBJECT (flexr, "rate of %" GST_PTR_FORMAT " differs from "
+      "rendering rate %d", caps, flexr->rate);
   return FALSE;
 }
 
@@ -812,8 +2439,13 @@ dlb_flexr_sink_event (GstAggregator * agg, GstAggregatorPad * aggpad,
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_STOP:
     case GST_EVENT_EOS:
+      dlb_flexr_switch_abort (flexr);
       if (flexr->flexr_instance)
         dlb_flexr_reset (flexr->flexr_instance);
+
+      GST_OBJECT_LOCK (flexr);
+      dlb_flexr_reset_pending (flexr);
+      GST_OBJECT_UNLOCK (flexr);
       break;
     case GST_EVENT_CAPS:
     {
@@ -838,15 +2470,30 @@ dlb_flexr_get_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad,
     GstCaps * filter)
 {
   GstPad *pad = GST_PAD_CAST (aggpad);
-  GstCaps *tmpl = gst_pad_get_pad_template_caps (pad);
-
-  GstStructure *s0 = gst_caps_get_structure (tmpl, 0);
-  GstCaps *result = gst_caps_copy_nth (tmpl, 1);
+  GstCaps *tmpl, *result;
+  GstStructure *s0;
 
   gint i, N = G_N_ELEMENTS (allowed_input_channel_masks);
+  guint cookie;
+  gint rate;
 
   GST_INFO_OBJECT (flexr, "Getting caps with filter %" GST_PTR_FORMAT, filter);
 
+  /* all sink pads share the template and the rendering rate, the cache is
+   * invalidated when the renderer is opened or closed */
+  result = dlb_caps_cache_lookup (flexr->caps_cache, GST_PAD_SINK, NULL,
+      filter, &cookie);
+  if (result)
+    return result;
+
+  GST_OBJECT_LOCK (flexr);
+  rate = flexr->rate;
+  GST_OBJECT_UNLOCK (flexr);
+
+  tmpl = gst_pad_get_pad_template_caps (pad);
+  s0 = gst_caps_get_structure (tmpl, 0);
+  result = gst_caps_copy_nth (tmpl, 1);
+
   /* unwrap channel based caps for each channel mask */
   for (i = 0; i < N; ++i) {
     GstStructure *s = gst_structure_copy (s0);
@@ -860,6 +2507,10 @@ dlb_flexr_get_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad,
     result = gst_caps_merge_structure (result, s);
   }
 
+  /* streams are mixed without resampling */
+  if (rate)
+    gst_caps_set_simple (result, "rate", G_TYPE_INT, rate, NULL);
+
   if (filter) {
     GstCaps *tmp = gst_caps_intersect_full (filter, result,
         GST_CAPS_INTERSECT_FIRST);
@@ -870,6 +2521,9 @@ dlb_flexr_get_caps (DlbFlexr * flexr, GstAggregatorPad * aggpad,
 
   GST_INFO_OBJECT (flexr, "returned sink caps : %" GST_PTR_FORMAT, result);
 
+  dlb_caps_cache_insert (flexr->caps_cache, GST_PAD_SINK, NULL, filter, result,
+      cookie);
+
   gst_caps_unref (tmpl);
   return result;
 }
@@ -914,7 +2568,14 @@ dlb_flexr_update_src_caps (GstAggregator * agg, GstCaps * caps, GstCaps ** ret)
   /* we need to know number of ouput channels at this point, so if mixer is
    * not opened yet, open it now */
   if (!flexr->flexr_instance) {
-    if (!dlb_flexr_open (flexr)) {
+    GstStructure *tmp = gst_structure_copy (gst_caps_get_structure (caps, 0));
+    gint rate = 48000;
+
+    gst_structure_fixate_field_nearest_int (tmp, "rate", rate);
+    gst_structure_get_int (tmp, "rate", &rate);
+    gst_structure_free (tmp);
+
+    if (!dlb_flexr_open (flexr, rate, FALSE)) {
       return GST_FLOW_ERROR;
     }
   }
@@ -924,8 +2585,9 @@ dlb_flexr_update_src_caps (GstAggregator * agg, GstCaps * caps, GstCaps ** ret)
   *ret = gst_caps_copy (caps);
   s = gst_caps_get_structure (*ret, 0);
 
-  gst_structure_set (s, "channels", G_TYPE_INT, flexr->channels, "layout",
-      G_TYPE_STRING, "interleaved", "channel-mask", GST_TYPE_BITMASK,
+  gst_structure_set (s, "channels", G_TYPE_INT, flexr->channels, "rate",
+      G_TYPE_INT, flexr->rate, "layout", G_TYPE_STRING, "interleaved",
+      "channel-mask", GST_TYPE_BITMASK,
       gst_audio_channel_get_fallback_mask (flexr->channels), NULL);
 
   GST_OBJECT_UNLOCK (flexr);
@@ -933,13 +2595,79 @@ dlb_flexr_update_src_caps (GstAggregator * agg, GstCaps * caps, GstCaps ** ret)
   return GST_FLOW_OK;
 }
 
+static GstPad *
+dlb_flexr_request_split_pad (DlbFlexr * flexr, GstPadTemplate * templ,
+    const gchar * req_name)
+{
+  GstElement *element = GST_ELEMENT_CAST (flexr);
+  GstPad *pad;
+  gchar *name;
+
+  GST_OBJECT_LOCK (flexr);
+  if (req_name)
+    name = g_strdup (req_name);
+  else
+    name = g_strdup_printf ("src_%u", flexr->split_serial++);
+  GST_OBJECT_UNLOCK (flexr);
+
+  pad = g_object_new (DLB_TYPE_FLEXR_SPLIT_PAD, "name", name,
+      "direction", templ->direction, "template", templ, NULL);
+  g_free (name);
+
+  if (GST_STATE (element) > GST_STATE_READY)
+    gst_pad_set_active (pad, TRUE);
+
+  if (!gst_element_add_pad (element, pad))
+    goto error;
+
+  GST_OBJECT_LOCK (flexr);
+  flexr->split_pads = g_list_append (flexr->split_pads, gst_object_ref (pad));
+  GST_OBJECT_UNLOCK (flexr);
+
+  GST_DEBUG_OBJECT (flexr, "new pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  return pad;
+
+error:
+  {
+    GST_DEBUG_OBJECT (flexr, "could not create/add pad");
+    return NULL;
+  }
+}
+
+static void
+dlb_flexr_release_split_pad (DlbFlexr * flexr, GstPad * pad)
+{
+  DlbFlexrSplitPad *split = DLB_FLEXR_SPLIT_PAD (pad);
+  GList *link;
+
+  GST_DEBUG_OBJECT (flexr, "release pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+
+  GST_OBJECT_LOCK (flexr);
+  if ((link = g_list_find (flexr->split_pads, split))) {
+    flexr->split_pads = g_list_delete_link (flexr->split_pads, link);
+    dlb_flexr_split_clear (split);
+  }
+  GST_OBJECT_UNLOCK (flexr);
+
+  gst_pad_set_active (pad, FALSE);
+  gst_element_remove_pad (GST_ELEMENT_CAST (flexr), pad);
+
+  if (link)
+    gst_object_unref (split);
+}
+
 static GstPad *
 dlb_flexr_request_new_pad (GstElement * element, GstPadTemplate * templ,
     const gchar * req_name, const GstCaps * caps)
 {
   DlbFlexr *flexr = DLB_FLEXR (element);
+  DlbFlexrPad *newpad;
+
+  if (GST_PAD_TEMPLATE_DIRECTION (templ) == GST_PAD_SRC)
+    return dlb_flexr_request_split_pad (flexr, templ, req_name);
 
-  DlbFlexrPad *newpad = (DlbFlexrPad *)
+  newpad = (DlbFlexrPad *)
       GST_ELEMENT_CLASS (parent_class)->request_new_pad (element,
       templ, req_name, caps);
 
@@ -949,6 +2677,12 @@ dlb_flexr_request_new_pad (GstElement * element, GstPadTemplate * templ,
   gst_child_proxy_child_added (GST_CHILD_PROXY (element), G_OBJECT (newpad),
       GST_OBJECT_NAME (newpad));
 
+  /* pads requested while PLAYING do not see the state change */
+  GST_OBJECT_LOCK (element);
+  if (GST_STATE (element) == GST_STATE_PLAYING)
+    dlb_flexr_pad_set_clock (newpad, element->clock, element->base_time);
+  GST_OBJECT_UNLOCK (element);
+
   GST_DEBUG_OBJECT (flexr, "new pad %s:%s", GST_DEBUG_PAD_NAME (newpad));
 
   return GST_PAD_CAST (newpad);
@@ -964,21 +2698,72 @@ static void
 dlb_flexr_release_pad (GstElement * element, GstPad * pad)
 {
   DlbFlexr *flexr = DLB_FLEXR (element);
-  DlbFlexrPad *sinkpad = DLB_FLEXR_PAD (pad);
+  DlbFlexrPad *sinkpad;
+
+  if (DLB_IS_FLEXR_SPLIT_PAD (pad)) {
+    dlb_flexr_release_split_pad (flexr, pad);
+    return;
+  }
+
+  sinkpad = DLB_FLEXR_PAD (pad);
 
   GST_DEBUG_OBJECT (flexr, "release pad %s:%s", GST_DEBUG_PAD_NAME (pad));
 
+  /* streams are removed by the aggregator thread, the running one renders
+   * what it was given first */
+  GST_OBJECT_LOCK (flexr);
   if (sinkpad->stream) {
-    dlb_flexr_rm_stream (flexr->flexr_instance, sinkpad->stream);
+    flexr->flushing_streams = g_list_append (flexr->flushing_streams,
+        GUINT_TO_POINTER (sinkpad->stream));
     sinkpad->stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
   }
 
+  sinkpad->deferred = FALSE;
+
+  if (sinkpad->next_stream) {
+    flexr->released_streams = g_list_append (flexr->released_streams,
+        GUINT_TO_POINTER (sinkpad->next_stream));
+    sinkpad->next_stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+  }
+
+  dlb_flexr_pad_reset_pending (flexr, sinkpad);
+  GST_OBJECT_UNLOCK (flexr);
+
   gst_child_proxy_child_removed (GST_CHILD_PROXY (flexr), G_OBJECT (pad),
       GST_OBJECT_NAME (pad));
 
   GST_ELEMENT_CLASS (parent_class)->release_pad (element, pad);
 }
 
+/* brings controlled properties to the position of the chunk being pushed,
+ * changed values are applied by dlb_flexr_update_stream */
+static void
+dlb_flexr_sync_values (DlbFlexr * flexr, DlbFlexrPad * pad, GstBuffer * inbuf,
+    guint in_offset)
+{
+  GstAggregatorPad *aggpad = GST_AGGREGATOR_PAD (pad);
+  GstAudioInfo *info = &GST_AUDIO_AGGREGATOR_PAD (pad)->info;
+  GstClockTime timestamp = GST_BUFFER_PTS (inbuf);
+  GstClockTime stream_time;
+
+  if (!GST_CLOCK_TIME_IS_VALID (timestamp) || !GST_AUDIO_INFO_RATE (info))
+    return;
+
+  timestamp += gst_util_uint64_scale_int (in_offset, GST_SECOND,
+      GST_AUDIO_INFO_RATE (info));
+  stream_time = gst_segment_to_stream_time (&aggpad->segment, GST_FORMAT_TIME,
+      timestamp);
+
+  if (!GST_CLOCK_TIME_IS_VALID (stream_time))
+    return;
+
+  if (gst_object_has_active_control_bindings (GST_OBJECT_CAST (pad)))
+    gst_object_sync_values (GST_OBJECT_CAST (pad), stream_time);
+
+  if (gst_object_has_active_control_bindings (GST_OBJECT_CAST (flexr)))
+    gst_object_sync_values (GST_OBJECT_CAST (flexr), stream_time);
+}
+
 static gboolean
 dlb_flexr_aggregate_one_buffer (GstAudioAggregator * aagg,
     GstAudioAggregatorPad * aaggpad, GstBuffer * inbuf, guint in_offset,
@@ -998,56 +2783,164 @@ dlb_flexr_aggregate_one_buffer (GstAudioAggregator * aagg,
   dlb_buffer *in, *out;
   gint samples;
 
+  DlbFlexrPrepared *prep;
   dlb_flexr_object_metadata md = { 0 };
-  dlb_flexr_stream_handle stream = flexrpad->stream;
+  dlb_flexr_stream_handle stream, next_stream;
+  DlbFlexrStreamUpdate update;
+  const DlbFlexrParams *params;
+  gboolean force_order, ready, drained, deferred, added;
+  guint groups;
+  gint outbpf;
 
   const guint8 *indata;
-  const guint8 *outdata;
+  guint8 *outdata;
+
+  /* must be done before taking object locks, setters take them too */
+  dlb_flexr_sync_values (flexr, flexrpad, inbuf, in_offset);
 
+  /* pick up settings, the library is only ever called from the aggregator
+   * thread, so locks are not held while it processes */
   GST_OBJECT_LOCK (aagg);
   GST_OBJECT_LOCK (aaggpad);
+  dlb_flexr_take_stream_update (flexrpad, &update);
+  force_order = flexrpad->force_order;
+  deferred = flexrpad->deferred;
+  GST_OBJECT_UNLOCK (aaggpad);
+  GST_OBJECT_UNLOCK (aagg);
 
-  dlb_flexr_update_stream (flexr, flexrpad);
+  params = dlb_param_mailbox_read (flexr->params, &groups);
+  if (G_UNLIKELY (groups)) {
+    dlb_flexr_apply_ext_gain (flexr, flexr->flexr_instance, params, groups);
+    if (flexr->next_instance)
+      dlb_flexr_apply_ext_gain (flexr, flexr->next_instance, params, groups);
+  }
 
-  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
-  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  /* stream config was not read when caps were set */
+  if (G_UNLIKELY (deferred && update.config)) {
+    dlb_flexr_switch_abort (flexr);
+
+    GST_OBJECT_LOCK (aagg);
+    added = dlb_flexr_pad_add_stream (flexr, flexrpad, update.config);
+    update.stream = flexrpad->stream;
+    update.next_stream = DLB_FLEXR_STREAM_HANDLE_INVALID;
+    GST_OBJECT_UNLOCK (aagg);
+
+    g_clear_pointer (&update.config, g_bytes_unref);
+    if (!added) {
+      GST_ELEMENT_ERROR (flexr, LIBRARY, INIT, (NULL),
+          ("Failed to add stream"));
+      goto done;
+    }
+
+    GST_DEBUG_OBJECT (flexrpad, "Added deferred stream");
+    dlb_flexr_update_latency (flexr);
+  } else if (G_UNLIKELY (deferred)) {
+    /* counts as silence so that other streams keep being rendered */
+    GST_OBJECT_LOCK (aagg);
+    ready = dlb_flexr_pad_pushed (flexr, flexrpad, num_samples);
+    GST_OBJECT_UNLOCK (aagg);
+
+    goto render;
+  }
 
-  indata = inmap.data + in_offset * GST_AUDIO_INFO_BPF (&sinkpad->info);
-  outdata = outmap.data;
+  /* pad was released, its stream is being removed */
+  if (G_UNLIKELY (!update.stream)) {
+    g_clear_pointer (&update.config, g_bytes_unref);
+    goto done;
+  }
+
+  dlb_flexr_update_stream (flexr, flexrpad, &update);
+  stream = update.stream;
+  next_stream = flexr->next_instance ? update.next_stream : 0;
 
   GST_LOG_OBJECT (flexrpad, "mixing %u samples, in_offset %u, out_offset %u",
       num_samples, in_offset, out_offset);
 
-  if ((meta = dlb_audio_object_meta_get (inbuf))) {
-    md.offset = meta->offset;
-    md.payload = meta->payload;
-    md.payload_size = meta->size;
+  prep = gst_mini_object_get_qdata (GST_MINI_OBJECT_CAST (inbuf),
+      dlb_flexr_prepared_quark);
+
+  if (G_LIKELY (prep)) {
+    dlb_buffer_map_memory (prep->block, prep->map.data + in_offset * prep->bpf);
+    dlb_flexr_push_stream (flexr->flexr_instance, stream, &prep->md,
+        prep->block, num_samples);
+    if (next_stream)
+      dlb_flexr_push_stream (flexr->next_instance, next_stream, &prep->md,
+          prep->block, num_samples);
+  } else {
+    gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+    indata = inmap.data + in_offset * GST_AUDIO_INFO_BPF (&sinkpad->info);
+
+    if ((meta = dlb_audio_object_meta_get (inbuf))) {
+      md.offset = meta->offset;
+      md.payload = meta->payload;
+      md.payload_size = meta->size;
+    }
+
+    in = dlb_buffer_new_wrapped (indata, &sinkpad->info, force_order);
+    dlb_flexr_push_stream (flexr->flexr_instance, stream, &md, in, num_samples);
+    if (next_stream)
+      dlb_flexr_push_stream (flexr->next_instance, next_stream, &md, in,
+          num_samples);
+
+    dlb_buffer_free (in);
+    gst_buffer_unmap (inbuf, &inmap);
   }
 
-  in = dlb_buffer_new_wrapped (indata, &sinkpad->info, flexrpad->force_order);
-  dlb_flexr_push_stream (flexr->flexr_instance, stream, &md, in, num_samples);
+  GST_OBJECT_LOCK (aagg);
+  ready = dlb_flexr_pad_pushed (flexr, flexrpad, num_samples);
+  GST_OBJECT_UNLOCK (aagg);
+
+render:
+  if (!ready)
+    goto done;
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_READWRITE);
+  outbpf = GST_AUDIO_INFO_BPF (&srcpad->info);
+  out = dlb_buffer_new (&srcpad->info);
 
-  if (dlb_flexr_are_all_pads_ready (flexr)) {
+  /* output buffer may span several rendering blocks */
+  while (ready && (flexr->outpos + flexr->blksize) * outbpf <= outmap.size) {
     GST_LOG_OBJECT (flexr, "All pads ready... processing streams");
 
-    out = dlb_buffer_new_wrapped (outdata, &srcpad->info, FALSE);
+    outdata = outmap.data + flexr->outpos * outbpf;
+    dlb_buffer_map_memory (out, outdata);
     dlb_flexr_generate_output (flexr->flexr_instance, out, &samples);
     dlb_flexr_check_flushing_streams (flexr);
 
-    dlb_buffer_free (out);
+    if (flexr->next_instance)
+      dlb_flexr_crossfade_block (flexr, outdata, &srcpad->info);
+
+    GST_OBJECT_LOCK (aagg);
+    dlb_flexr_split_block (flexr, outdata, &srcpad->info,
+        outmap.size / outbpf);
+    dlb_flexr_consume_block (flexr);
+    ready = flexr->ready_pads == GST_ELEMENT_CAST (flexr)->numsinkpads;
+    GST_OBJECT_UNLOCK (aagg);
+
+    flexr->outpos += flexr->blksize;
     ret = TRUE;
   }
 
-  GST_LOG_OBJECT (flexr, "inbuf %" GST_PTR_FORMAT ", outbuf %" GST_PTR_FORMAT,
-      inbuf, outbuf);
+  if (flexr->outpos * outbpf >= outmap.size)
+    flexr->outpos = 0;
 
-  dlb_buffer_free (in);
-  gst_buffer_unmap (inbuf, &inmap);
+  dlb_buffer_free (out);
   gst_buffer_unmap (outbuf, &outmap);
 
-  GST_OBJECT_UNLOCK (aaggpad);
+  /* new instance can only take over streams with nothing left to render,
+   * streams of released pads finish flushing first */
+  GST_OBJECT_LOCK (aagg);
+  drained = !flexr->outpos && !flexr->flushing_streams
+      && dlb_flexr_all_drained (flexr);
   GST_OBJECT_UNLOCK (aagg);
 
+  if (drained)
+    dlb_flexr_switch_check (flexr, params);
+
+done:
+  GST_LOG_OBJECT (flexr, "inbuf %" GST_PTR_FORMAT ", outbuf %" GST_PTR_FORMAT,
+      inbuf, outbuf);
+
   return ret;
 }
 
@@ -1092,15 +2985,52 @@ dlb_flexr_child_proxy_init (gpointer g_iface, gpointer iface_data)
   iface->get_children_count = dlb_flexr_child_proxy_get_children_count;
 }
 
-static gboolean
-plugin_init (GstPlugin * plugin)
+static void
+dlb_flexr_update_clocks (DlbFlexr * flexr, gboolean playing)
+{
+  GstElement *element = GST_ELEMENT_CAST (flexr);
+  GstClock *clock = playing ? gst_element_get_clock (element) : NULL;
+  GstClockTime base_time = gst_element_get_base_time (element);
+  GList *l;
+
+  GST_OBJECT_LOCK (flexr);
+  for (l = element->sinkpads; l; l = l->next)
+    dlb_flexr_pad_set_clock (DLB_FLEXR_PAD (l->data), clock, base_time);
+  GST_OBJECT_UNLOCK (flexr);
+
+  if (clock)
+    gst_object_unref (clock);
+}
+
+static GstStateChangeReturn
+dlb_flexr_change_state (GstElement * element, GstStateChange transition)
 {
+  GstStateChangeReturn ret;
 
 #ifdef DLB_FLEXR_OPEN_DYNLIB
-  if (dlb_flexr_try_open_dynlib ())
-    return FALSE;
+  /* vendor library is bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY
+      && dlb_flexr_try_open_dynlib ()) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load FLEXR library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
 #endif
 
+  if (transition == GST_STATE_CHANGE_PAUSED_TO_PLAYING)
+    dlb_flexr_update_clocks (DLB_FLEXR (element), TRUE);
+
+  ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+  if (transition == GST_STATE_CHANGE_PLAYING_TO_PAUSED)
+    dlb_flexr_update_clocks (DLB_FLEXR (element), FALSE);
+
+  return ret;
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
   GST_DEBUG_CATEGORY_INIT (GST_CAT_DEFAULT, "dlbflexr", 0,
       "audio rendering element");
 
@@ -25,6 +25,9 @@
 #include <gst/audio/audio.h>
 #include <gst/audio/gstaudioaggregator.h>
 
+#include "dlbconfigloader.h"
+#include "dlbparammailbox.h"
+#include "dlbcapscache.h"
 #include "dlb_flexr.h"
 
 G_BEGIN_DECLS
@@ -42,6 +45,25 @@ typedef struct _DlbFlexrClass        DlbFlexrClass;
 typedef struct _DlbFlexrPad DlbFlexrPad;
 typedef struct _DlbFlexrPadClass DlbFlexrPadClass;
 
+typedef struct _DlbFlexrSplitPad DlbFlexrSplitPad;
+typedef struct _DlbFlexrSplitPadClass DlbFlexrSplitPadClass;
+
+typedef struct _DlbFlexrParams DlbFlexrParams;
+typedef struct _DlbFlexrPadParams DlbFlexrPadParams;
+
+/* settings exchanged through the parameter mailboxes */
+struct _DlbFlexrParams {
+  gint ext_gain_step;
+  gdouble ext_gain;
+  gboolean active_channels_enable;
+  guint64 active_channels_mask;
+};
+
+struct _DlbFlexrPadParams {
+  gdouble internal_user_gain;
+  gdouble content_normalization_gain;
+};
+
 /**
  * DlbFlexr:
  *
@@ -57,15 +79,55 @@ struct _DlbFlexr {
   gint streams;
   gint latency;
   gint blksize;
-  gint ext_gain_step;
-  gdouble ext_gain;
+  gint rate;
 
-  gchar *config_path;
+  /* requested output latency in non-live mode */
+  GstClockTime output_latency;
+  /* rendering blocks per output buffer, samples already written to it */
+  gint outblocks;
+  gint outpos;
 
-  gboolean active_channels_enable;
-  guint64 active_channels_mask;
+  /* published by property setters, picked up at block boundary */
+  DlbParamMailbox *params;
+
+  /* sink caps query results */
+  DlbCapsCache *caps_cache;
 
+  gchar *config_path;
+  /* device config content the running instance was opened with */
+  GBytes *device_config;
+
+  /* streams of released pads, removed by the aggregator thread, protected
+   * by object lock */
   GList *flushing_streams;
+  GList *released_streams;
+
+  /* sink pads with a full block pushed, protected by object lock */
+  gint ready_pads;
+
+  /* active channels of the running instance */
+  gboolean instance_active_enable;
+  guint64 instance_active_mask;
+
+  /* runtime active channels switching */
+  GThreadPool *switch_pool;
+  gboolean switch_pending;
+  gpointer switch_task;
+  gboolean switch_active_enable;
+  guint64 switch_active_mask;
+
+  dlb_flexr *next_instance;
+  guint8 *fade_buffer;
+  gint fade_prime;
+  gint fade_pos;
+  gint fade_len;
+  gfloat *fade_ramp;
+  gint fade_ramp_len;
+
+  /* request src pads carrying subsets of output channels, protected by
+   * object lock */
+  GList *split_pads;
+  guint split_serial;
 };
 
 struct _DlbFlexrClass {
@@ -86,17 +148,56 @@ struct _DlbFlexrPad {
 
   gchar *config_path;
   gboolean upmix;
-  gdouble internal_user_gain;
-  gdouble content_normalization_gain;
 
   /*< private >*/
   GHashTable *props_set;
+  DlbParamMailbox *params;
+
+  /* stream config content, read on the loader thread */
+  DlbConfigLoader *config_loader;
+  GBytes *config;
 
   gboolean force_order;
 
   dlb_flexr_input_format fmt;
   dlb_flexr_stream_handle stream;
   dlb_flexr_interp_mode interp;
+  /* caps were set before stream config was read, protected by element
+   * lock */
+  gboolean deferred;
+
+  /* stream of the instance being crossfaded to, protected by element lock */
+  dlb_flexr_stream_handle next_stream;
+
+  /* samples pushed since last output block, protected by element lock */
+  gint pending;
+
+  /* input preparation, used by the upstream streaming thread only */
+  GstAudioConverter *converter;
+  GstAudioInfo prepinfo;
+  gint inbpf;
+  GstBufferPool *prep_pool;
+  gsize prep_pool_size;
+
+  /* drift compensation settings and clock of the running pipeline,
+   * protected by pad object lock */
+  gboolean drift_enable;
+  GstClockTime drift_target;
+  GstClock *drift_clock;
+  GstClockTime drift_base_time;
+
+  /* drift compensation, used by the upstream streaming thread only */
+  GstAudioConverter *resampler;
+  GstBufferPool *drift_pool;
+  gsize drift_pool_size;
+  GstSegment drift_segment;
+  gint drift_rate;
+  gint drift_bpf;
+  gint drift_out_rate;
+  GstClockTime drift_base;
+  guint64 drift_samples;
+  gdouble drift_error;
+  gdouble drift_integral;
 };
 
 struct _DlbFlexrPadClass {
@@ -104,6 +205,37 @@ struct _DlbFlexrPadClass {
 };
 
 GType dlb_flexr_pad_get_type (void);
+
+#define DLB_TYPE_FLEXR_SPLIT_PAD            (dlb_flexr_split_pad_get_type())
+#define DLB_FLEXR_SPLIT_PAD(obj)            (G_TYPE_CHECK_INSTANCE_CAST((obj),DLB_TYPE_FLEXR_SPLIT_PAD,DlbFlexrSplitPad))
+#define DLB_IS_FLEXR_SPLIT_PAD(obj)         (G_TYPE_CHECK_INSTANCE_TYPE((obj),DLB_TYPE_FLEXR_SPLIT_PAD))
+
+/**
+ * DlbFlexrSplitPad:
+ *
+ * Request src pad carrying the output channels selected by channels-mask,
+ * interleaved in their rendering order.
+ */
+struct _DlbFlexrSplitPad {
+  GstPad parent;
+
+  guint64 channels_mask;
+
+  /*< private >*/
+  /* output layout and buffer being filled, protected by element lock */
+  GstAudioInfo outinfo;
+  gint map[64];
+  gboolean caps_pending;
+
+  GstBuffer *outbuf;
+  GstMapInfo outmap;
+};
+
+struct _DlbFlexrSplitPadClass {
+  GstPadClass parent_class;
+};
+
+GType dlb_flexr_split_pad_get_type (void);
 G_END_DECLS
 
 
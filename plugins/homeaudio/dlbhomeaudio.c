@@ -0,0 +1,2179 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/**
+ * SECTION:element-dlbhomeaudio
+ *
+ * Decodes AC-3 and E-AC-3, renders object audio and post-processes the
+ * result in a single element. Blocks are handed from the decoder to the
+ * renderer and to DAP as #dlb_buffer views of shared scratch memory, so no
+ * GstBuffer, caps negotiation or channel reordering happens in between.
+ *
+ * <refsect2>
+ * <title>Example launch line</title>
+ * |[
+ * gst-launch-1.0 filesrc location=in.ec3 ! dlbac3parse ! dlbhomeaudio \
+ *     virtualizer-enable=true ! \
+ *     capsfilter caps="audio/x-raw,channels=6" ! wavenc ! \
+ *     filesink location=out.wav
+ * ]|
+ * </refsect2>
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include <gst/gst.h>
+
+#include "dlbhomeaudio.h"
+
+GST_DEBUG_CATEGORY_STATIC (dlb_home_audio_debug_category);
+#define GST_CAT_DEFAULT dlb_home_audio_debug_category
+
+#define UDCMSK(mask) (DLB_UDC_CHANNEL_MASK (mask))
+#define GSTMSK(ch) (GST_AUDIO_CHANNEL_POSITION_MASK (ch))
+#define OARMSK(ch) (DLB_OAR_SPEAKER_CONFIG_MASK (ch))
+
+/* all scratch regions start at the alignment required by the decoder */
+#define SCRATCH_ALIGN(size)                                                    \
+  (((size) + DLB_UDC_OUTBUF_MEMORY_ALIGNMENT - 1) &                            \
+      ~((gsize) DLB_UDC_OUTBUF_MEMORY_ALIGNMENT - 1))
+
+#define MAX_FRAME_SAMPLES                                                      \
+  (DLB_UDC_MAX_BLOCKS_PER_FRAME * DLB_UDC_SAMPLES_PER_BLOCK)
+
+/* groups of settings published to the streaming thread */
+enum
+{
+  DLB_HOME_AUDIO_PARAMS_DECODER_STATIC = 1 << 0,
+  DLB_HOME_AUDIO_PARAMS_DECODER_DYNAMIC = 1 << 1,
+  DLB_HOME_AUDIO_PARAMS_RENDERER = 1 << 2,
+  DLB_HOME_AUDIO_PARAMS_DAP_STATIC = 1 << 3,
+  DLB_HOME_AUDIO_PARAMS_DAP_GAINS = 1 << 4,
+  DLB_HOME_AUDIO_PARAMS_DAP_PROFILE = 1 << 5,
+  DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER = 1 << 6,
+};
+
+enum
+{
+  PROP_0,
+  PROP_OUT_MODE,
+  PROP_DRC_MODE,
+  PROP_DRC_CUT,
+  PROP_DRC_BOOST,
+  PROP_DMX_ENABLE,
+  PROP_LIMITER_ENABLE,
+  PROP_VIRTUALIZER_ENABLE,
+  PROP_PREGAIN,
+  PROP_POSTGAIN,
+  PROP_SYSGAIN,
+  PROP_BASS_ENHANCER_ENABLE,
+  PROP_DIALOG_ENHANCER_ENABLE,
+  PROP_DIALOG_ENHANCER_AMOUNT,
+  PROP_SURROUND_DECODER_ENABLE,
+  PROP_VOLUME_LEVELER_ENABLE,
+  PROP_VOLUME_LEVELER_AMOUNT,
+  PROP_STATS,
+  PROP_JSON_CONFIG,
+  PROP_VIRT_FRONT_SPEAKER_ANGLE,
+  PROP_VIRT_SURROUND_SPEAKER_ANGLE,
+  PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE,
+  PROP_VIRT_HEIGHT_SPEAKER_ANGLE,
+  PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE,
+  PROP_HEIGHT_FILTER_ENABLE,
+  PROP_BASS_ENHANCER_BOOST,
+  PROP_BASS_ENHANCER_CUTOFF_FREQ,
+  PROP_BASS_ENHANCER_WIDTH,
+  PROP_CALIBRATION_BOOST,
+  PROP_DIALOG_ENHANCER_DUCKING,
+  PROP_GEQ_ENABLE,
+  PROP_GEQ_FREQS,
+  PROP_GEQ_GAINS,
+  PROP_IEQ_ENABLE,
+  PROP_IEQ_AMOUNT,
+  PROP_IEQ_FREQS,
+  PROP_IEQ_GAINS,
+  PROP_MI_IEQ_STEERING_ENABLE,
+  PROP_MI_DV_LEVELER_STEERING_ENABLE,
+  PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE,
+  PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE,
+  PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE,
+  PROP_SURROUND_BOOST,
+  PROP_VOLMAX_BOOST,
+  PROP_DISCARD_LATENCY,
+  PROP_FORCE_ORDER,
+};
+
+static const guint64 allowed_output_channel_masks[] = {
+  DLB_CHANNEL_MASK_2_0, DLB_CHANNEL_MASK_5_1, DLB_CHANNEL_MASK_5_1_2,
+  DLB_CHANNEL_MASK_7_1, DLB_CHANNEL_MASK_5_1_4, DLB_CHANNEL_MASK_7_1_2,
+  DLB_CHANNEL_MASK_7_1_4,
+};
+
+/* public prototypes */
+static void dlb_home_audio_set_property (GObject * object,
+    guint property_id, const GValue * value, GParamSpec * pspec);
+static void dlb_home_audio_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec);
+static void dlb_home_audio_finalize (GObject * object);
+static GstStateChangeReturn dlb_home_audio_change_state (GstElement *
+    element, GstStateChange transition);
+static gboolean dlb_home_audio_start (GstAudioDecoder * decoder);
+static gboolean dlb_home_audio_stop (GstAudioDecoder * decoder);
+static gboolean dlb_home_audio_set_format (GstAudioDecoder * decoder,
+    GstCaps * caps);
+static GstFlowReturn dlb_home_audio_handle_frame (GstAudioDecoder * decoder,
+    GstBuffer * inbuf);
+static void dlb_home_audio_flush (GstAudioDecoder * decoder, gboolean hard);
+
+/* private prototypes */
+static gboolean update_params (DlbHomeAudio * self);
+static gboolean update_decoder_params (DlbHomeAudio * self);
+static void apply_dap_settings (DlbHomeAudio * self, guint groups);
+static void close_chain (DlbHomeAudio * self);
+static GstFlowReturn drain (DlbHomeAudio * self);
+static void load_json_config (DlbHomeAudio * self, const gchar * filename);
+
+#define DLB_HOME_AUDIO_SRC_CAPS                                         \
+  "audio/x-raw, "                                                       \
+    "format = (string) " GST_AUDIO_NE (F32) ", "                        \
+    "channels = (int) [ 2, 12 ], "                                      \
+    "rate = (int) { 32000, 44100, 48000 }, "                            \
+    "layout = (string) interleaved"
+
+#define DLB_HOME_AUDIO_SINK_CAPS                                        \
+  "audio/x-ac3, "                                                       \
+    "framed = (boolean) true, "                                         \
+    "rate = (int) [ 1, 655350 ]; "                                      \
+  "audio/x-eac3, "                                                      \
+    "framed = (boolean) true, "                                         \
+    "rate = (int) [ 1, 655350 ]"                                        \
+
+#define G_TYPE_int G_TYPE_INT
+#define G_TYPE_uint G_TYPE_UINT
+
+#define MAKE_ARRAY_HELPERS(type)                                               \
+static void                                                                    \
+fill_gst_value_array_##type (GValue *array, const type *data, guint size)      \
+{                                                                              \
+  GValue val = G_VALUE_INIT;                                                   \
+  g_value_init (&val, G_TYPE_##type);                                          \
+  for (guint i = 0; i < size; ++i) {                                           \
+    g_value_set_##type (&val, data[i]);                                        \
+    gst_value_array_append_value (array, &val);                                \
+  }                                                                            \
+  g_value_unset (&val);                                                        \
+}                                                                              \
+                                                                               \
+static void                                                                    \
+fill_data_array_##type (type *data, guint *size, guint max,                    \
+    const GValue *value_array)                                                 \
+{                                                                              \
+  *size = MIN (gst_value_array_get_size (value_array), max);                   \
+                                                                               \
+  for (guint i = 0; i < *size; ++i) {                                          \
+    const GValue *val = gst_value_array_get_value (value_array, i);            \
+    data[i] = g_value_get_##type (val);                                        \
+  }                                                                            \
+}
+
+MAKE_ARRAY_HELPERS (int)
+MAKE_ARRAY_HELPERS (uint)
+#undef G_TYPE_int
+#undef G_TYPE_uint
+
+/* pad templates */
+static GstStaticPadTemplate dlb_home_audio_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (DLB_HOME_AUDIO_SRC_CAPS)
+    );
+
+static GstStaticPadTemplate dlb_home_audio_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (DLB_HOME_AUDIO_SINK_CAPS)
+    );
+
+/* class initialization */
+G_DEFINE_TYPE_WITH_CODE (DlbHomeAudio, dlb_home_audio, GST_TYPE_AUDIO_DECODER,
+    G_IMPLEMENT_INTERFACE (DLB_TYPE_AUDIO_DECODER, NULL));
+
+static void
+dlb_home_audio_class_init (DlbHomeAudioClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstAudioDecoderClass *audio_decoder_class = GST_AUDIO_DECODER_CLASS (klass);
+
+  gobject_class->set_property = dlb_home_audio_set_property;
+  gobject_class->get_property = dlb_home_audio_get_property;
+  gobject_class->finalize = dlb_home_audio_finalize;
+  GST_ELEMENT_CLASS (klass)->change_state =
+      GST_DEBUG_FUNCPTR (dlb_home_audio_change_state);
+  audio_decoder_class->start = GST_DEBUG_FUNCPTR (dlb_home_audio_start);
+  audio_decoder_class->stop = GST_DEBUG_FUNCPTR (dlb_home_audio_stop);
+  audio_decoder_class->set_format =
+      GST_DEBUG_FUNCPTR (dlb_home_audio_set_format);
+  audio_decoder_class->handle_frame =
+      GST_DEBUG_FUNCPTR (dlb_home_audio_handle_frame);
+  audio_decoder_class->flush = GST_DEBUG_FUNCPTR (dlb_home_audio_flush);
+
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_home_audio_src_template);
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_home_audio_sink_template);
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Dolby Home Audio Processor", "Codec/Decoder/Audio",
+      "Decode, render and post-process E-AC-3 and AC-3 audio stream",
+      "Dolby Support <support@dolby.com>");
+
+  /* install properties */
+  g_object_class_override_property (gobject_class, PROP_OUT_MODE, "out-mode");
+  g_object_class_override_property (gobject_class, PROP_DRC_MODE, "drc-mode");
+  g_object_class_override_property (gobject_class, PROP_DRC_CUT, "drc-cut");
+  g_object_class_override_property (gobject_class, PROP_DRC_BOOST, "drc-boost");
+  g_object_class_override_property (gobject_class, PROP_DMX_ENABLE, "dmx-enable");
+
+  g_object_class_install_property (gobject_class, PROP_LIMITER_ENABLE,
+      g_param_spec_boolean ("limiter-enable",
+          "Object audio renderer limiter",
+          "Enable object audio renderer limiter", TRUE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VIRTUALIZER_ENABLE,
+      g_param_spec_boolean ("virtualizer-enable", "Virtualizer enable",
+          "Enables or disables the speaker virtualizer", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VIRT_FRONT_SPEAKER_ANGLE,
+      g_param_spec_int ("virtualizer-front-speaker-angle",
+          "Speaker virtualizer front angle",
+          "The absolute horizontal angle of front loudspeakers from the "
+          "central listening position",
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_VIRT_SURROUND_SPEAKER_ANGLE,
+      g_param_spec_int ("virtualizer-surround-speaker-angle",
+          "Speaker virtualizer surround angle",
+          "The absolute horizontal angle of surround loudspeakers from the "
+          "central listening position",
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE,
+      g_param_spec_int ("virtualizer-rear-surround-speaker-angle",
+          "Speaker virtualizer rear surround angle",
+          "The absolute horizontal angle of surround loudspeakers from the "
+          "central listening position",
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_VIRT_HEIGHT_SPEAKER_ANGLE,
+      g_param_spec_int ("virtualizer-height-speaker-angle",
+          "Speaker virtualizer height angle",
+          "The absolute horizontal angle of height loudspeakers from the "
+          "central listening position",
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE,
+      g_param_spec_int ("virtualizer-rear-height-speaker-angle",
+          "Speaker virtualizer rear height angle",
+          "The absolute horizontal angle of height loudspeakers from the "
+          "central listening position",
+          0, 30, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_HEIGHT_FILTER_ENABLE,
+      g_param_spec_boolean ("height-filter-enable", "Height filter enable",
+          "Enable the perceptual height filter", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_PREGAIN,
+      g_param_spec_int ("pregain", "Pregain",
+          "Pre-gain specifies the amount of gain which has been applied to the "
+          "signal before entering the signal chain, represented as a fixed "
+          "point number with 4 fractional bits [-130.0, 30.0] dB",
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_POSTGAIN,
+      g_param_spec_int ("postgain", "Postgain",
+          "Post-gain specifies the amount of gain which will be applied to the "
+          "signal externally after leaving the signal chain, represented as a "
+          "fixed point number with 4 fractional bits [-130.0, 30.0] dB",
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SYSGAIN,
+      g_param_spec_int ("sysgain", "System gain",
+          "System gain specifies the amount of gain which be applied by the "
+          "signal chain represented as a fixed point number with 4 fractional "
+          "bits [-130.0, 30.0] dB",
+          -2080, 480, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BASS_ENHANCER_ENABLE,
+      g_param_spec_boolean ("bass-enhancer-enable", "Bass enhancer enable",
+          "Enable bass enhancer.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BASS_ENHANCER_BOOST,
+      g_param_spec_int ("bass-enhancer-boost",
+          "Bass enhancer boost",
+          "The amount of bass enhancement boost applied by Bass Enhancer "
+          "represented as a fixed point number with 4 fractional bits "
+          "[0.0, 24.0] dB",
+          0, 384, 192,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_BASS_ENHANCER_CUTOFF_FREQ,
+      g_param_spec_int ("bass-enhancer-cutoff-freq",
+          "Bass enhancer cutoff frequency",
+          "Bass enhancement cutoff frequency used by Bass Enhancer",
+          20, 2000, 200,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_BASS_ENHANCER_WIDTH,
+      g_param_spec_int ("bass-enhancer-width", "Bass enhancer width",
+          "The width of the bass enhancement boost curve used by Bass Enhancer "
+          "represented as a fixed point number with 4 fractional bits "
+          "[0.125, 4.0] Octaves",
+          2, 64, 16,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_CALIBRATION_BOOST,
+      g_param_spec_int ("calibration-boost", "Calibration boost",
+          "Calibration Boost is an extra gain which is applied to the signal "
+          "represented as a fixed point number with 4 fractional bits "
+          "[0.0, 12.0] dB",
+          0, 192, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DIALOG_ENHANCER_ENABLE,
+      g_param_spec_boolean ("dialog-enhancer-enable", "Dialog enhancer enable",
+          "Enable dialog enhancer.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DIALOG_ENHANCER_AMOUNT,
+      g_param_spec_int ("dialog-enhancer-amount", "Dialog enhancer amount",
+          "The strength of the Dialog Enhancer effect represented as a fixed "
+          "point number with 4 fractional bits [0.0, 1.0]",
+          0, 16, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DIALOG_ENHANCER_DUCKING,
+      g_param_spec_int ("dialog-enhancer-ducking",
+          "Dialog enhancer ducking",
+          "The degree of suppression of channels that don't contain dialog, "
+          "represented as a fixed point number with 4 fractional bits "
+          "[0.00, 1.00]",
+          0, 16, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GEQ_ENABLE,
+      g_param_spec_boolean ("geq-enable", "GEQ enable",
+          "Enable graphic equalizer.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GEQ_FREQS,
+      gst_param_spec_array ("geq-freqs",
+          "Graphic EQ band center frequencies",
+          "An array of values which contain center frequencies at which the "
+          "gain values should be applied.",
+          g_param_spec_uint ("band-freq-element",
+              "Center frequencies array element",
+              "Element of the center frequencies array.",
+              20, 20000, 20,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_GEQ_GAINS,
+      gst_param_spec_array ("geq-gains", "Graphic EQ band gains",
+          "An array of values which contain the gains for each of the "
+          "processing channels, represented as a fixed point numbers with "
+          "4 fractional bits [-36.0, 36.0]",
+          g_param_spec_int ("band-gain-element",
+              "Gains array element", "Element of the gains array.",
+              -576, 576, 0,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IEQ_ENABLE,
+      g_param_spec_boolean ("ieq-enable", "IEQ enable",
+          "Enable inelligent equalizer.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IEQ_AMOUNT,
+      g_param_spec_int ("ieq-amount", "Intelligent equalizer amount",
+          "Specifies the strength of the Intelligent Equalizer effect to "
+          "apply, represented as a fixed point number with 4 fractional bits "
+          "[0.00, 1.00]",
+          0, 16, 10,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IEQ_FREQS,
+      gst_param_spec_array ("ieq-freqs",
+          "Intelligent EQ band center frequencies",
+          "An array of values which contain center frequencies at which the "
+          "gain values should be applied.",
+          g_param_spec_uint ("band-freq-element",
+              "Center frequencies array element",
+              "Element of the center frequencies array.",
+              20, 20000, 20,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IEQ_GAINS,
+      gst_param_spec_array ("ieq-gains",
+          "Intelligent EQ band gains",
+          "An array of values which contain the gains for each of the "
+          "processing channels.",
+          g_param_spec_int ("band-gain-element", "Gains array element",
+              "Element of the gains array represented as a fixed point number "
+              "with 4 fractional bits [-30.0, 30.00] dB",
+              -480, 480, 0,
+              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS),
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MI_IEQ_STEERING_ENABLE,
+      g_param_spec_boolean ("mi-ieq-steering-enable",
+          "MI intelligent equalizer steering enable",
+          "If enabled, the parameters in Intelligent Equalizer will be updated "
+          "based on the information from Media Intelligence.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MI_DV_LEVELER_STEERING_ENABLE,
+      g_param_spec_boolean ("mi-dv-leveler-steering-enable",
+          "MI volume leveler steering enable",
+          "If enabled, the parameters in the Volume Leveler will be updated "
+          "based on the information from Media Intelligence.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE,
+      g_param_spec_boolean ("mi-dialog-enhancer-steering-enable",
+          "MI dialog enhancer steering enable",
+          "If enabled, the parameters in the Dialog Enhancer will be updated "
+          "based on the information from Media Intelligence.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE,
+      g_param_spec_boolean ("mi-surround-compressor-steering-enable",
+          "MI surround compressor steering enable",
+          "If enabled, the parameters in the Surround Compressor will be "
+          "updated based on the information from Media Intelligence.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_SURROUND_DECODER_ENABLE,
+      g_param_spec_boolean ("surround-decoder-enable",
+          "Surround decoder enable",
+          "Enable surround decoder.", TRUE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE,
+      g_param_spec_boolean ("surround-decoder-cs-enable",
+          "Surround decoder center spread enable",
+          "Enable surround decoder center spreading.", TRUE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SURROUND_BOOST,
+      g_param_spec_int ("surround-boost", "Surround boost",
+          "Surround Compressor boost to be used. This boost is applied only to "
+          "signals passing through the Speaker Virtualizer, represented as a "
+          "fixed point number with 4 fractional bits [0.00, 6.00] dB",
+          0, 96, 0,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOLMAX_BOOST,
+      g_param_spec_int ("volmax-boost",
+          "Volume maximizer boost",
+          "The boost gain applied to the signal in the signal chain. Volume "
+          "maximization will be performed only if Volume Leveler is enabled, "
+          "this is represented as a fixed point number with 4 fractional bits "
+          "[0.0, 12.0] dB, default 9.0 dB",
+          0, 192, 144,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class,
+      PROP_VOLUME_LEVELER_ENABLE,
+      g_param_spec_boolean ("volume-leveler-enable",
+          "Volume leveler enable",
+          "Volume leveler enable or disable.", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_VOLUME_LEVELER_AMOUNT,
+      g_param_spec_int ("volume-leveler-amount", "Volume leveler amount",
+          "Specifies how aggressive the leveler is in attempting to reach the "
+          "output target level",
+          0, 10, 7,
+          G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_DISCARD_LATENCY,
+      g_param_spec_boolean ("discard-latency", "Discard latency",
+          "Discard initial latency zeros of DAP and the renderer from the "
+          "output and push the delayed tail on drain", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_FORCE_ORDER,
+      g_param_spec_boolean ("force-order", "Force order",
+          "Force Dolby specific channel order at the output", FALSE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_JSON_CONFIG,
+      g_param_spec_string ("json-config",
+          "Json config path",
+          "Path to json configuration file, sections it contains override "
+          "the DAP properties set before",
+          NULL, G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Library call statistics of UDC, OAR and DAP", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+}
+
+static void
+dlb_home_audio_init (DlbHomeAudio * self)
+{
+  DlbHomeAudioParams params;
+
+  memset (&params, 0, sizeof (params));
+  params.outmode = DLB_AUDIO_DECODER_OUT_MODE_RAW;
+  params.drc_mode = DLB_AUDIO_DECODER_DRC_MODE_DEFAULT;
+  params.dmx_enable = TRUE;
+  dlb_udc_drc_settings_init (&params.drc);
+  params.limiter_enable = TRUE;
+  params.virtualizer_enable = FALSE;
+  dlb_dap_virtualizer_settings_init (&params.virt);
+  dlb_dap_profile_settings_init (&params.profile);
+
+  self->params = dlb_param_mailbox_new (sizeof (params), &params);
+  self->applied = dlb_param_mailbox_read (self->params, NULL);
+
+  self->metadata_buffer = g_malloc (DLB_UDC_MAX_MD_SIZE);
+
+  gst_audio_info_init (&self->dapinfo);
+  gst_audio_info_init (&self->renderinfo);
+  gst_audio_info_init (&self->outinfo);
+
+  gst_audio_decoder_set_needs_format (GST_AUDIO_DECODER (self), TRUE);
+  gst_audio_decoder_set_estimate_rate (GST_AUDIO_DECODER (self), TRUE);
+  gst_audio_decoder_set_use_default_pad_acceptcaps (GST_AUDIO_DECODER_CAST
+      (self), TRUE);
+
+  GST_PAD_SET_ACCEPT_TEMPLATE (GST_AUDIO_DECODER_SINK_PAD (self));
+}
+
+static void
+dlb_home_audio_set_property (GObject * object, guint property_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (object);
+  DlbHomeAudioParams *params;
+  guint groups = 0;
+
+  /* sections of the file are published through the mailbox as well */
+  if (property_id == PROP_JSON_CONFIG) {
+    load_json_config (self, g_value_get_string (value));
+    return;
+  }
+
+  /* chain is reconfigured by the streaming thread at frame boundary */
+  params = dlb_param_mailbox_lock (self->params);
+
+  switch (property_id) {
+    case PROP_OUT_MODE:
+      params->outmode = g_value_get_enum (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DECODER_STATIC;
+      break;
+    case PROP_DRC_MODE:
+      params->drc_mode = g_value_get_enum (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DECODER_DYNAMIC;
+      break;
+    case PROP_DRC_CUT:
+      params->drc.cut = g_value_get_double (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DECODER_DYNAMIC;
+      break;
+    case PROP_DRC_BOOST:
+      params->drc.boost = g_value_get_double (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DECODER_DYNAMIC;
+      break;
+    case PROP_DMX_ENABLE:
+      params->dmx_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DECODER_STATIC;
+      break;
+    case PROP_LIMITER_ENABLE:
+      params->limiter_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_RENDERER;
+      break;
+    case PROP_VIRTUALIZER_ENABLE:
+      params->virtualizer_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_STATIC;
+      break;
+    case PROP_VIRT_FRONT_SPEAKER_ANGLE:
+      params->virt.front_speaker_angle = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_VIRT_SURROUND_SPEAKER_ANGLE:
+      params->virt.surround_speaker_angle = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE:
+      params->virt.rear_surround_speaker_angle = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_VIRT_HEIGHT_SPEAKER_ANGLE:
+      params->virt.height_speaker_angle = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE:
+      params->virt.rear_height_speaker_angle = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_HEIGHT_FILTER_ENABLE:
+      params->virt.height_filter_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+      break;
+    case PROP_PREGAIN:
+      params->gains.pregain = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_GAINS;
+      break;
+    case PROP_POSTGAIN:
+      params->gains.postgain = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_GAINS;
+      break;
+    case PROP_SYSGAIN:
+      params->gains.system_gain = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_GAINS;
+      break;
+    case PROP_BASS_ENHANCER_ENABLE:
+      params->profile.bass_enhancer_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_BASS_ENHANCER_BOOST:
+      params->profile.bass_enhancer_boost = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_BASS_ENHANCER_CUTOFF_FREQ:
+      params->profile.bass_enhancer_cutoff_frequency = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_BASS_ENHANCER_WIDTH:
+      params->profile.bass_enhancer_width = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_CALIBRATION_BOOST:
+      params->profile.calibration_boost = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_DIALOG_ENHANCER_ENABLE:
+      params->profile.dialog_enhancer_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_DIALOG_ENHANCER_AMOUNT:
+      params->profile.dialog_enhancer_amount = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_DIALOG_ENHANCER_DUCKING:
+      params->profile.dialog_enhancer_ducking = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_GEQ_ENABLE:
+      params->profile.graphic_equalizer_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_GEQ_FREQS:
+      fill_data_array_uint (params->profile.graphic_equalizer_bands,
+          &params->profile.graphic_equalizer_bands_num,
+          DLB_DAP_GRAPHIC_EQUALIZER_MAX_BANDS_NUM, value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_GEQ_GAINS:
+      fill_data_array_int (params->profile.graphic_equalizer_gains,
+          &params->profile.graphic_equalizer_bands_num,
+          DLB_DAP_GRAPHIC_EQUALIZER_MAX_BANDS_NUM, value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_IEQ_ENABLE:
+      params->profile.ieq_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_IEQ_AMOUNT:
+      params->profile.ieq_amount = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_IEQ_FREQS:
+      fill_data_array_uint (params->profile.ieq_bands,
+          &params->profile.ieq_bands_num, DLB_DAP_IEQ_MAX_BANDS_NUM, value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_IEQ_GAINS:
+      fill_data_array_int (params->profile.ieq_gains,
+          &params->profile.ieq_bands_num, DLB_DAP_IEQ_MAX_BANDS_NUM, value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_MI_IEQ_STEERING_ENABLE:
+      params->profile.mi_ieq_steering_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_MI_DV_LEVELER_STEERING_ENABLE:
+      params->profile.mi_dv_leveler_steering_enable =
+          g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE:
+      params->profile.mi_dialog_enhancer_steering_enable =
+          g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE:
+      params->profile.mi_surround_compressor_steering_enable =
+          g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_SURROUND_DECODER_ENABLE:
+      params->profile.surround_decoder_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE:
+      params->profile.surround_decoder_center_spreading_enable =
+          g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_SURROUND_BOOST:
+      params->profile.surround_boost = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_VOLMAX_BOOST:
+      params->profile.volmax_boost = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_VOLUME_LEVELER_ENABLE:
+      params->profile.volume_leveler_enable = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_VOLUME_LEVELER_AMOUNT:
+      params->profile.volume_leveler_amount = g_value_get_int (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+      break;
+    case PROP_DISCARD_LATENCY:
+      params->discard_latency = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_STATIC;
+      break;
+    case PROP_FORCE_ORDER:
+      params->force_order = g_value_get_boolean (value);
+      groups = DLB_HOME_AUDIO_PARAMS_DAP_STATIC;
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  dlb_param_mailbox_unlock (self->params, groups);
+}
+
+static void
+dlb_home_audio_get_property (GObject * object,
+    guint property_id, GValue * value, GParamSpec * pspec)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (object);
+  DlbHomeAudioParams *params;
+  GstStructure *stats;
+
+  if (property_id == PROP_JSON_CONFIG) {
+    GST_OBJECT_LOCK (self);
+    g_value_set_string (value, self->json_config_path);
+    GST_OBJECT_UNLOCK (self);
+    return;
+  }
+
+  params = dlb_param_mailbox_lock (self->params);
+
+  switch (property_id) {
+    case PROP_OUT_MODE:
+      g_value_set_enum (value, params->outmode);
+      break;
+    case PROP_DRC_MODE:
+      g_value_set_enum (value, params->drc_mode);
+      break;
+    case PROP_DRC_CUT:
+      g_value_set_double (value, params->drc.cut);
+      break;
+    case PROP_DRC_BOOST:
+      g_value_set_double (value, params->drc.boost);
+      break;
+    case PROP_DMX_ENABLE:
+      g_value_set_boolean (value, params->dmx_enable);
+      break;
+    case PROP_LIMITER_ENABLE:
+      g_value_set_boolean (value, params->limiter_enable);
+      break;
+    case PROP_VIRTUALIZER_ENABLE:
+      g_value_set_boolean (value, params->virtualizer_enable);
+      break;
+    case PROP_VIRT_FRONT_SPEAKER_ANGLE:
+      g_value_set_int (value, params->virt.front_speaker_angle);
+      break;
+    case PROP_VIRT_SURROUND_SPEAKER_ANGLE:
+      g_value_set_int (value, params->virt.surround_speaker_angle);
+      break;
+    case PROP_VIRT_REAR_SURROUND_SPEAKER_ANGLE:
+      g_value_set_int (value, params->virt.rear_surround_speaker_angle);
+      break;
+    case PROP_VIRT_HEIGHT_SPEAKER_ANGLE:
+      g_value_set_int (value, params->virt.height_speaker_angle);
+      break;
+    case PROP_VIRT_REAR_HEIGHT_SPEAKER_ANGLE:
+      g_value_set_int (value, params->virt.rear_height_speaker_angle);
+      break;
+    case PROP_HEIGHT_FILTER_ENABLE:
+      g_value_set_boolean (value, params->virt.height_filter_enable);
+      break;
+    case PROP_PREGAIN:
+      g_value_set_int (value, params->gains.pregain);
+      break;
+    case PROP_POSTGAIN:
+      g_value_set_int (value, params->gains.postgain);
+      break;
+    case PROP_SYSGAIN:
+      g_value_set_int (value, params->gains.system_gain);
+      break;
+    case PROP_BASS_ENHANCER_ENABLE:
+      g_value_set_boolean (value, params->profile.bass_enhancer_enable);
+      break;
+    case PROP_BASS_ENHANCER_BOOST:
+      g_value_set_int (value, params->profile.bass_enhancer_boost);
+      break;
+    case PROP_BASS_ENHANCER_CUTOFF_FREQ:
+      g_value_set_int (value, params->profile.bass_enhancer_cutoff_frequency);
+      break;
+    case PROP_BASS_ENHANCER_WIDTH:
+      g_value_set_int (value, params->profile.bass_enhancer_width);
+      break;
+    case PROP_CALIBRATION_BOOST:
+      g_value_set_int (value, params->profile.calibration_boost);
+      break;
+    case PROP_DIALOG_ENHANCER_ENABLE:
+      g_value_set_boolean (value, params->profile.dialog_enhancer_enable);
+      break;
+    case PROP_DIALOG_ENHANCER_AMOUNT:
+      g_value_set_int (value, params->profile.dialog_enhancer_amount);
+      break;
+    case PROP_DIALOG_ENHANCER_DUCKING:
+      g_value_set_int (value, params->profile.dialog_enhancer_ducking);
+      break;
+    case PROP_GEQ_ENABLE:
+      g_value_set_boolean (value, params->profile.graphic_equalizer_enable);
+      break;
+    case PROP_GEQ_FREQS:
+      fill_gst_value_array_uint (value, params->profile.graphic_equalizer_bands,
+          params->profile.graphic_equalizer_bands_num);
+      break;
+    case PROP_GEQ_GAINS:
+      fill_gst_value_array_int (value, params->profile.graphic_equalizer_gains,
+          params->profile.graphic_equalizer_bands_num);
+      break;
+    case PROP_IEQ_ENABLE:
+      g_value_set_boolean (value, params->profile.ieq_enable);
+      break;
+    case PROP_IEQ_AMOUNT:
+      g_value_set_int (value, params->profile.ieq_amount);
+      break;
+    case PROP_IEQ_FREQS:
+      fill_gst_value_array_uint (value, params->profile.ieq_bands,
+          params->profile.ieq_bands_num);
+      break;
+    case PROP_IEQ_GAINS:
+      fill_gst_value_array_int (value, params->profile.ieq_gains,
+          params->profile.ieq_bands_num);
+      break;
+    case PROP_MI_IEQ_STEERING_ENABLE:
+      g_value_set_boolean (value, params->profile.mi_ieq_steering_enable);
+      break;
+    case PROP_MI_DV_LEVELER_STEERING_ENABLE:
+      g_value_set_boolean (value,
+          params->profile.mi_dv_leveler_steering_enable);
+      break;
+    case PROP_MI_DIALOG_ENHANCER_STEERING_ENABLE:
+      g_value_set_boolean (value,
+          params->profile.mi_dialog_enhancer_steering_enable);
+      break;
+    case PROP_MI_SURROUND_COMPRESSOR_STEERING_ENABLE:
+      g_value_set_boolean (value,
+          params->profile.mi_surround_compressor_steering_enable);
+      break;
+    case PROP_SURROUND_DECODER_ENABLE:
+      g_value_set_boolean (value, params->profile.surround_decoder_enable);
+      break;
+    case PROP_SURROUND_DECODER_CENTER_SPREAD_ENABLE:
+      g_value_set_boolean (value,
+          params->profile.surround_decoder_center_spreading_enable);
+      break;
+    case PROP_SURROUND_BOOST:
+      g_value_set_int (value, params->profile.surround_boost);
+      break;
+    case PROP_VOLMAX_BOOST:
+      g_value_set_int (value, params->profile.volmax_boost);
+      break;
+    case PROP_VOLUME_LEVELER_ENABLE:
+      g_value_set_boolean (value, params->profile.volume_leveler_enable);
+      break;
+    case PROP_VOLUME_LEVELER_AMOUNT:
+      g_value_set_int (value, params->profile.volume_leveler_amount);
+      break;
+    case PROP_DISCARD_LATENCY:
+      g_value_set_boolean (value, params->discard_latency);
+      break;
+    case PROP_FORCE_ORDER:
+      g_value_set_boolean (value, params->force_order);
+      break;
+    case PROP_STATS:
+      stats = gst_structure_new_empty ("dlbhomeaudio-stats");
+#ifdef DLB_UDC_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_udc_query_stats);
+#endif
+#ifdef DLB_OAR_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_oar_query_stats);
+#endif
+#ifdef DLB_DAP_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_dap_query_stats);
+#endif
+      g_value_take_boxed (value, stats);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+
+  dlb_param_mailbox_unlock (self->params, 0);
+}
+
+static void
+dlb_home_audio_finalize (GObject * object)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (object);
+
+  g_free (self->metadata_buffer);
+  dlb_param_mailbox_free (self->params);
+  dlb_dap_json_config_free (self->json_config);
+  g_free (self->json_config_path);
+
+  G_OBJECT_CLASS (dlb_home_audio_parent_class)->finalize (object);
+}
+
+static dlb_udc_output_mode
+get_udc_output_mode (DlbAudioDecoderOutMode outmode)
+{
+  switch (outmode) {
+    case DLB_AUDIO_DECODER_OUT_MODE_2_0:
+      return DLB_UDC_OUTPUT_MODE_2_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_2_1:
+      return DLB_UDC_OUTPUT_MODE_2_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_3_0:
+      return DLB_UDC_OUTPUT_MODE_3_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_3_1:
+      return DLB_UDC_OUTPUT_MODE_3_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_4_0:
+      return DLB_UDC_OUTPUT_MODE_4_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_4_1:
+      return DLB_UDC_OUTPUT_MODE_4_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_5_0:
+      return DLB_UDC_OUTPUT_MODE_5_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_5_1:
+      return DLB_UDC_OUTPUT_MODE_5_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_6_0:
+      return DLB_UDC_OUTPUT_MODE_6_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_6_1:
+      return DLB_UDC_OUTPUT_MODE_6_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_7_0:
+      return DLB_UDC_OUTPUT_MODE_7_0;
+    case DLB_AUDIO_DECODER_OUT_MODE_7_1:
+      return DLB_UDC_OUTPUT_MODE_7_1;
+    case DLB_AUDIO_DECODER_OUT_MODE_CORE:
+      return DLB_UDC_OUTPUT_MODE_CORE;
+    case DLB_AUDIO_DECODER_OUT_MODE_RAW:
+      return DLB_UDC_OUTPUT_MODE_RAW;
+    default:
+      return DLB_UDC_OUTPUT_MODE_2_0;
+  }
+}
+
+/* positions in the order the decoder writes channels */
+static void
+udc_channel_mask_to_positions (guint64 channel_mask, gint channels,
+    GstAudioChannelPosition * pos)
+{
+  static const struct
+  {
+    guint64 mask;
+    GstAudioChannelPosition pos;
+  } map[] = {
+    {UDCMSK (LEFT), GST_AUDIO_CHANNEL_POSITION_FRONT_LEFT},
+    {UDCMSK (RIGHT), GST_AUDIO_CHANNEL_POSITION_FRONT_RIGHT},
+    {UDCMSK (CENTER), GST_AUDIO_CHANNEL_POSITION_FRONT_CENTER},
+    {UDCMSK (LFE), GST_AUDIO_CHANNEL_POSITION_LFE1},
+    {UDCMSK (SIDE_LEFT), GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT},
+    {UDCMSK (SIDE_RIGHT), GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT},
+    {UDCMSK (BACK_LEFT), GST_AUDIO_CHANNEL_POSITION_REAR_LEFT},
+    {UDCMSK (BACK_RIGHT), GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT},
+    {UDCMSK (CENTER_FRONT_LEFT),
+        GST_AUDIO_CHANNEL_POSITION_FRONT_LEFT_OF_CENTER},
+    {UDCMSK (CENTER_FRONT_RIGHT),
+        GST_AUDIO_CHANNEL_POSITION_FRONT_RIGHT_OF_CENTER},
+    {UDCMSK (BACK_CENTER), GST_AUDIO_CHANNEL_POSITION_REAR_CENTER},
+    {UDCMSK (TOP_SURROUND), GST_AUDIO_CHANNEL_POSITION_TOP_CENTER},
+    {UDCMSK (SIDE_DIRECT_LEFT), GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT},
+    {UDCMSK (SIDE_DIRECT_RIGHT), GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT},
+    {UDCMSK (WIDE_LEFT), GST_AUDIO_CHANNEL_POSITION_WIDE_LEFT},
+    {UDCMSK (WIDE_RIGHT), GST_AUDIO_CHANNEL_POSITION_WIDE_RIGHT},
+    {UDCMSK (VERTICAL_HEIGHT_LEFT), GST_AUDIO_CHANNEL_POSITION_TOP_FRONT_LEFT},
+    {UDCMSK (VERTICAL_HEIGHT_RIGHT),
+        GST_AUDIO_CHANNEL_POSITION_TOP_FRONT_RIGHT},
+    {UDCMSK (VERTICAL_HEIGHT_CENTER),
+        GST_AUDIO_CHANNEL_POSITION_TOP_FRONT_CENTER},
+    {UDCMSK (TOP_SURROUND_LEFT), GST_AUDIO_CHANNEL_POSITION_TOP_SIDE_LEFT},
+    {UDCMSK (TOP_SURROUND_RIGHT), GST_AUDIO_CHANNEL_POSITION_TOP_SIDE_RIGHT},
+    {UDCMSK (LFE2), GST_AUDIO_CHANNEL_POSITION_LFE2},
+  };
+  gint channel = 0;
+  guint i;
+
+  if (0 == channel_mask && 1 == channels) {
+    pos[0] = GST_AUDIO_CHANNEL_POSITION_MONO;
+    return;
+  }
+
+  for (i = 0; i < G_N_ELEMENTS (map) && channel < channels; ++i) {
+    if (channel_mask & map[i].mask)
+      pos[channel++] = map[i].pos;
+  }
+
+  g_assert (channel == channels);
+}
+
+/* get number of channels from channel mask */
+static gint
+get_channels (guint64 channel_mask)
+{
+  gint channels = 0;
+
+  while (channel_mask) {
+    channels += channel_mask & G_GUINT64_CONSTANT (1);
+    channel_mask >>= 1;
+  }
+
+  return channels;
+}
+
+static void
+channel_mask_to_dap_format (guint64 channel_mask,
+    dlb_dap_channel_format * format)
+{
+  guint64 top = GSTMSK (TOP_SIDE_LEFT) | GSTMSK (TOP_SIDE_RIGHT) |
+      GSTMSK (TOP_FRONT_LEFT) | GSTMSK (TOP_FRONT_RIGHT) |
+      GSTMSK (TOP_REAR_LEFT) | GSTMSK (TOP_REAR_RIGHT) | GSTMSK (TOP_CENTER);
+  guint64 floor = GSTMSK (FRONT_LEFT) | GSTMSK (FRONT_RIGHT) |
+      GSTMSK (FRONT_CENTER) | GSTMSK (REAR_LEFT) | GSTMSK (REAR_RIGHT) |
+      GSTMSK (SIDE_LEFT) | GSTMSK (SIDE_RIGHT);
+
+  format->channels_floor = get_channels (channel_mask & floor);
+  format->channels_top = get_channels (channel_mask & top);
+  format->lfe = !!(channel_mask & GSTMSK (LFE1));
+}
+
+static guint64
+dap_format_to_channel_mask (const dlb_dap_channel_format * format)
+{
+  guint64 mask = DLB_CHANNEL_MASK_2_0;
+
+  if (format->channels_floor == 3)
+    mask |= GSTMSK (FRONT_CENTER);
+  else if (format->channels_floor == 4)
+    mask |= (DLB_CHANNEL_MASK_5_1 & ~GSTMSK (FRONT_CENTER));
+  else if (format->channels_floor == 5)
+    mask |= DLB_CHANNEL_MASK_5_1;
+  else if (format->channels_floor == 6)
+    mask |= (DLB_CHANNEL_MASK_7_1 & ~GSTMSK (FRONT_CENTER));
+  else if (format->channels_floor == 7)
+    mask |= DLB_CHANNEL_MASK_7_1;
+
+  if (format->channels_top == 1)
+    mask |= GSTMSK (TOP_CENTER);
+  else if (format->channels_top == 2)
+    mask |= (GSTMSK (TOP_SIDE_LEFT) | GSTMSK (TOP_SIDE_RIGHT));
+  else if (format->channels_top == 4)
+    mask |= (GSTMSK (TOP_FRONT_LEFT) | GSTMSK (TOP_FRONT_RIGHT) |
+        GSTMSK (TOP_REAR_LEFT) | GSTMSK (TOP_REAR_RIGHT));
+
+  return format->lfe ? mask | GSTMSK (LFE1) : mask & ~GSTMSK (LFE1);
+}
+
+/* only positions DAP proposes as its input can show up here */
+static gulong
+channel_mask_to_oar_speaker_config (guint64 gst_chmask)
+{
+  gulong msk = 0;
+
+  if (gst_chmask & GSTMSK (FRONT_LEFT))
+    msk |= OARMSK (L_R);
+  if (gst_chmask & GSTMSK (FRONT_CENTER))
+    msk |= OARMSK (C);
+  if (gst_chmask & GSTMSK (LFE1))
+    msk |= OARMSK (LFE);
+  if (gst_chmask & GSTMSK (SIDE_LEFT))
+    msk |= OARMSK (LS_RS);
+  if (gst_chmask & GSTMSK (REAR_LEFT))
+    msk |= (msk & OARMSK (LS_RS)) ? OARMSK (LRS_RRS) : OARMSK (LS_RS);
+  if (gst_chmask & GSTMSK (TOP_FRONT_LEFT))
+    msk |= OARMSK (LTF_RTF);
+  if (gst_chmask & GSTMSK (TOP_SIDE_LEFT))
+    msk |= OARMSK (LTM_RTM);
+  if (gst_chmask & GSTMSK (TOP_REAR_LEFT))
+    msk |= OARMSK (LTR_RTR);
+  if (gst_chmask & GSTMSK (TOP_CENTER))
+    msk |= OARMSK (CTM);
+
+  return msk;
+}
+
+/* @reorder maps Dolby order onto the positions of @info, without it the
+ * channels are laid out in Dolby order */
+static gboolean
+block_setup (DlbHomeAudioBlock * block, const guint8 * data,
+    GstAudioInfo * info, gboolean reorder)
+{
+  dlb_buffer_free (block->buf);
+
+  block->buf = dlb_buffer_new_wrapped (data, info, reorder);
+  block->base = data;
+
+  return block->buf != NULL;
+}
+
+static void
+block_clear (DlbHomeAudioBlock * block)
+{
+  dlb_buffer_free (block->buf);
+
+  block->buf = NULL;
+  block->base = NULL;
+}
+
+static dlb_buffer *
+block_at (DlbHomeAudioBlock * block, const guint8 * data)
+{
+  dlb_buffer *buf = block->buf;
+  guint i;
+
+  for (i = 0; i < buf->nchannel; ++i)
+    buf->ppdata[i] = (void *) ((guintptr) buf->ppdata[i] -
+        (guintptr) block->base + (guintptr) data);
+
+  block->base = data;
+  return buf;
+}
+
+/* wrapper maps Dolby order onto GStreamer order of @info, while the decoder
+ * keeps its own order. Points the wrapper at the decoder channels. */
+static void
+block_follow_udc_order (DlbHomeAudioBlock * block, const GstAudioInfo * info,
+    const GstAudioChannelPosition * udcpos)
+{
+  dlb_buffer *buf = block->buf;
+  gint bps = GST_AUDIO_INFO_BPS (info);
+  guint k;
+  gint i, j;
+
+  for (k = 0; k < buf->nchannel; ++k) {
+    i = ((const guint8 *) buf->ppdata[k] - block->base) / bps;
+
+    for (j = 0; j < info->channels; ++j) {
+      if (udcpos[j] == info->position[i]) {
+        buf->ppdata[k] = (void *) (block->base + j * bps);
+        break;
+      }
+    }
+  }
+}
+
+static GstMemory *
+scratch_new (DlbHomeAudio * self, gsize size, GstMapInfo * map)
+{
+  GstMemory *mem;
+
+  mem = gst_allocator_alloc (self->alloc, size, self->alloc_params);
+  if (mem && !gst_memory_map (mem, map, GST_MAP_READWRITE)) {
+    gst_memory_unref (mem);
+    mem = NULL;
+  }
+
+  return mem;
+}
+
+static void
+scratch_free (GstMemory ** mem, GstMapInfo * map)
+{
+  if (!*mem)
+    return;
+
+  gst_memory_unmap (*mem, map);
+  gst_memory_unref (*mem);
+  *mem = NULL;
+}
+
+/* Picks the first layout downstream accepts, processing format does not
+ * depend on the stream so it is fixed for the whole session */
+static void
+select_output_format (DlbHomeAudio * self)
+{
+  GstAudioChannelPosition pos[64];
+  GstCaps *filter, *peercaps;
+  GstStructure *s;
+  guint64 mask = DLB_CHANNEL_MASK_2_0;
+  gint channels;
+  guint i;
+
+  filter = gst_caps_new_empty ();
+  for (i = 0; i < G_N_ELEMENTS (allowed_output_channel_masks); ++i) {
+    guint64 m = allowed_output_channel_masks[i];
+
+    gst_caps_append_structure (filter, gst_structure_new ("audio/x-raw",
+            "format", G_TYPE_STRING, GST_AUDIO_NE (F32),
+            "layout", G_TYPE_STRING, "interleaved",
+            "channels", G_TYPE_INT, get_channels (m),
+            "channel-mask", GST_TYPE_BITMASK, m, NULL));
+  }
+
+  peercaps =
+      gst_pad_peer_query_caps (GST_AUDIO_DECODER_SRC_PAD (self), filter);
+
+  if (peercaps && !gst_caps_is_empty (peercaps)) {
+    s = gst_caps_get_structure (peercaps, 0);
+    gst_structure_get (s, "channel-mask", GST_TYPE_BITMASK, &mask, NULL);
+  }
+
+  channels = get_channels (mask);
+  gst_audio_channel_positions_from_mask (channels, mask, pos);
+  gst_audio_info_set_format (&self->outinfo, GST_AUDIO_FORMAT_F32, 48000,
+      channels, pos);
+  channel_mask_to_dap_format (mask, &self->outfmt);
+
+  GST_DEBUG_OBJECT (self, "output channel-mask 0x%" G_GINT64_MODIFIER "x",
+      mask);
+
+  if (peercaps)
+    gst_caps_unref (peercaps);
+  gst_caps_unref (filter);
+}
+
+static gboolean
+dlb_home_audio_start (GstAudioDecoder * decoder)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (decoder);
+  GstAllocationParams alloc_params;
+  GstAudioInfo audio_info;
+  dlb_udc_init_info init_info;
+  gsize blocksz;
+
+  GST_DEBUG_OBJECT (self, "start");
+
+  select_output_format (self);
+
+  memset (&self->info, 0, sizeof (self->info));
+  self->rate = 0;
+  self->stage_fill = 0;
+  self->latency_samples = 0;
+  self->prefill = 0;
+
+  gst_audio_decoder_get_allocator (decoder, &self->alloc, &alloc_params);
+  self->alloc_params = gst_allocation_params_copy (&alloc_params);
+  self->alloc_params->align = DLB_UDC_OUTBUF_MEMORY_ALIGNMENT - 1;
+
+  /* new instance is configured with all the latest settings */
+  self->applied = dlb_param_mailbox_read (self->params, NULL);
+
+  init_info.outmode = get_udc_output_mode (self->applied->outmode);
+  init_info.dmx_enable = self->applied->dmx_enable;
+
+  self->udc = dlb_udc_new (&init_info);
+  if (!self->udc)
+    goto lib_error;
+
+  self->max_channels = dlb_udc_query_max_output_channels (init_info.outmode);
+  blocksz = dlb_udc_query_max_outbuf_size (init_info.outmode,
+      DLB_BUFFER_FLOAT);
+
+  self->decmem = scratch_new (self, blocksz, &self->decmap);
+  if (!self->decmem)
+    goto buf_error;
+
+  gst_audio_info_init (&audio_info);
+  gst_audio_info_set_format (&audio_info, GST_AUDIO_FORMAT_F32, 48000,
+      self->max_channels, NULL);
+
+  self->decbuf = dlb_buffer_new (&audio_info);
+  if (!self->decbuf)
+    goto buf_error;
+
+  dlb_buffer_map_memory (self->decbuf, self->decmap.data);
+
+  update_decoder_params (self);
+  return TRUE;
+
+buf_error:
+  scratch_free (&self->decmem, &self->decmap);
+  dlb_udc_free (self->udc);
+  self->udc = NULL;
+
+  gst_allocation_params_free (self->alloc_params);
+  self->alloc_params = NULL;
+  if (self->alloc)
+    gst_object_unref (self->alloc);
+  self->alloc = NULL;
+
+lib_error:
+  GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL), ("Failed to open UDC"));
+  return FALSE;
+}
+
+static gboolean
+dlb_home_audio_stop (GstAudioDecoder * decoder)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (decoder);
+
+  GST_DEBUG_OBJECT (self, "stop");
+
+  if (!self->udc)
+    return TRUE;
+
+  close_chain (self);
+
+  dlb_buffer_free (self->decbuf);
+  self->decbuf = NULL;
+  scratch_free (&self->decmem, &self->decmap);
+
+  gst_allocation_params_free (self->alloc_params);
+  self->alloc_params = NULL;
+  if (self->alloc)
+    gst_object_unref (self->alloc);
+  self->alloc = NULL;
+
+  dlb_udc_free (self->udc);
+  self->udc = NULL;
+
+  return TRUE;
+}
+
+static gboolean
+dlb_home_audio_set_format (GstAudioDecoder * decoder, GstCaps * caps)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (decoder);
+  GstStructure *s;
+
+  GST_DEBUG_OBJECT (self, "sink caps: %" GST_PTR_FORMAT, caps);
+
+  s = gst_caps_get_structure (caps, 0);
+  g_return_val_if_fail (s, FALSE);
+  if (!gst_structure_has_name (s, "audio/x-ac3")
+      && !gst_structure_has_name (s, "audio/x-eac3")) {
+    GST_WARNING_OBJECT (self, "Unsupported stream type");
+    g_return_val_if_reached (FALSE);
+  }
+
+  return TRUE;
+}
+
+static void
+dlb_home_audio_flush (GstAudioDecoder * decoder, gboolean hard)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (decoder);
+
+  GST_DEBUG_OBJECT (self, "flush");
+
+  self->stage_fill = 0;
+
+  /* DAP keeps the flushed audio in its delay line */
+  self->prefill = self->latency_samples;
+
+  if (self->oar)
+    dlb_oar_reset (self->oar, self->rate);
+}
+
+static void
+close_chain (DlbHomeAudio * self)
+{
+  if (self->dap)
+    dlb_dap_free (self->dap);
+  if (self->oar)
+    dlb_oar_free (self->oar);
+
+  self->dap = NULL;
+  self->oar = NULL;
+  g_clear_pointer (&self->dap_serialized_config, g_bytes_unref);
+
+  block_clear (&self->decblock);
+  block_clear (&self->renderblock);
+  block_clear (&self->stageblock);
+  block_clear (&self->outblock);
+  scratch_free (&self->workmem, &self->workmap);
+
+  memset (&self->info, 0, sizeof (self->info));
+  self->rate = 0;
+  self->stage_fill = 0;
+}
+
+/* serialized config of json-config for @rate, if the file asks for one and
+ * it produces the output layout picked at start */
+static GBytes *
+select_serialized_config (DlbHomeAudio * self, gint rate)
+{
+  const dlb_dap_json_config *config;
+  dlb_dap_channel_format fmt;
+  GBytes *serialized = NULL;
+  gint channels, virtualizer_enable;
+
+  GST_OBJECT_LOCK (self);
+  config = self->json_config;
+  if (config && config->global.use_serialized_settings) {
+    serialized = dlb_dap_json_config_get_serialized (config, rate,
+        self->applied->virtualizer_enable);
+    self->dap_override_virt = config->global.override_virtualizer_settings;
+  }
+  if (serialized)
+    g_bytes_ref (serialized);
+  GST_OBJECT_UNLOCK (self);
+
+  if (!serialized)
+    return NULL;
+
+  dlb_dap_preprocess_serialized_config (g_bytes_get_data (serialized, NULL),
+      &fmt, &channels, &virtualizer_enable);
+
+  if (channels != GST_AUDIO_INFO_CHANNELS (&self->outinfo)) {
+    GST_ELEMENT_WARNING (self, LIBRARY, SETTINGS, (NULL),
+        ("Serialized config for rate %d outputs %d channels, %d negotiated, "
+            "using properties", rate, channels,
+            GST_AUDIO_INFO_CHANNELS (&self->outinfo)));
+    g_bytes_unref (serialized);
+    return NULL;
+  }
+
+  return serialized;
+}
+
+/* DAP and the scratch memory depend on the sample rate only */
+static gboolean
+open_chain (DlbHomeAudio * self, gint rate)
+{
+  GstAudioChannelPosition pos[64];
+  dlb_dap_init_info init_info;
+  GstCaps *caps;
+  guint64 mask;
+  gint channels;
+  gsize rendersz, stagesz;
+
+  close_chain (self);
+
+  self->dap_serialized_config = select_serialized_config (self, rate);
+
+  init_info.sample_rate = rate;
+  init_info.virtualizer_enable = self->applied->virtualizer_enable;
+  init_info.output_format = self->outfmt;
+  init_info.serialized_config = self->dap_serialized_config ?
+      g_bytes_get_data (self->dap_serialized_config, NULL) : NULL;
+
+  self->dap = dlb_dap_new (&init_info);
+  if (!self->dap)
+    goto dap_error;
+
+  apply_dap_settings (self, DLB_HOME_AUDIO_PARAMS_DAP_GAINS |
+      DLB_HOME_AUDIO_PARAMS_DAP_PROFILE |
+      DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER);
+
+  self->dap_block_samples = dlb_dap_query_block_samples (self->dap);
+
+  /* objects are rendered straight to the layout DAP prefers */
+  dlb_dap_propose_input_format (&self->outfmt,
+      self->applied->virtualizer_enable, &self->renderfmt);
+
+  mask = dap_format_to_channel_mask (&self->renderfmt);
+  channels = get_channels (mask);
+  gst_audio_channel_positions_from_mask (channels, mask, pos);
+  gst_audio_info_set_format (&self->renderinfo, GST_AUDIO_FORMAT_F32, rate,
+      channels, pos);
+
+  memcpy (pos, self->outinfo.position, sizeof (pos));
+  gst_audio_info_set_format (&self->outinfo, GST_AUDIO_FORMAT_F32, rate,
+      self->outinfo.channels, pos);
+
+  rendersz = SCRATCH_ALIGN (DLB_UDC_SAMPLES_PER_BLOCK *
+      GST_AUDIO_INFO_BPF (&self->renderinfo));
+  stagesz = self->dap_block_samples * sizeof (gfloat) *
+      MAX (self->max_channels, channels);
+
+  self->workmem = scratch_new (self, rendersz + stagesz, &self->workmap);
+  if (!self->workmem)
+    goto mem_error;
+
+  self->renderdata = self->workmap.data;
+  self->stagedata = self->workmap.data + rendersz;
+
+  if (!block_setup (&self->renderblock, self->renderdata, &self->renderinfo,
+          TRUE)
+      || !block_setup (&self->outblock, NULL, &self->outinfo,
+          !self->applied->force_order))
+    goto mem_error;
+
+  GST_DEBUG_OBJECT (self, "DAP opened, rate %d, block %d, render %d.%d.%d",
+      rate, self->dap_block_samples, self->renderfmt.channels_floor,
+      self->renderfmt.lfe, self->renderfmt.channels_top);
+
+  caps = gst_audio_info_to_caps (&self->outinfo);
+  if (!gst_audio_decoder_set_output_caps (GST_AUDIO_DECODER (self), caps)) {
+    gst_caps_unref (caps);
+    goto caps_error;
+  }
+
+  gst_caps_unref (caps);
+  self->rate = rate;
+  return TRUE;
+
+dap_error:
+  g_clear_pointer (&self->dap_serialized_config, g_bytes_unref);
+  GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL), ("Failed to open DAP"));
+  return FALSE;
+
+mem_error:
+  close_chain (self);
+  GST_ELEMENT_ERROR (self, RESOURCE, FAILED, (NULL),
+      ("Failed to allocate scratch memory"));
+  return FALSE;
+
+caps_error:
+  close_chain (self);
+  GST_ELEMENT_ERROR (self, CORE, NEGOTIATION, (NULL),
+      ("Audio decoder output format set failed"));
+  return FALSE;
+}
+
+static gboolean
+open_renderer (DlbHomeAudio * self)
+{
+  dlb_oar_init_info init_info;
+  guint64 mask;
+
+  gst_audio_channel_positions_to_mask (self->renderinfo.position,
+      self->renderinfo.channels, FALSE, &mask);
+
+  init_info.sample_rate = self->rate;
+  init_info.limiter_enable = self->applied->limiter_enable;
+  init_info.speaker_mask = channel_mask_to_oar_speaker_config (mask);
+
+  self->oar = dlb_oar_new (&init_info);
+  if (!self->oar) {
+    GST_ELEMENT_ERROR (self, LIBRARY, INIT, (NULL), ("Failed to open OAR"));
+    return FALSE;
+  }
+
+  self->min_render_samples = dlb_oar_query_min_block_samples (self->oar);
+  self->max_render_samples = dlb_oar_query_max_block_samples (self->oar);
+
+  return TRUE;
+}
+
+/* DAP and, for object audio, the renderer delay the output. The delay of a
+ * freshly opened chain is trimmed from the start of the output. */
+static void
+update_latency (DlbHomeAudio * self, gboolean object_audio, gboolean restart)
+{
+  GstClockTime latency;
+  gint samples = 0;
+
+  if (self->applied->discard_latency) {
+    samples = dlb_dap_query_latency (self->dap);
+    if (object_audio)
+      samples += dlb_oar_query_latency (self->oar);
+  }
+
+  if (restart)
+    self->prefill = samples;
+
+  if (samples == self->latency_samples)
+    return;
+
+  GST_DEBUG_OBJECT (self, "latency %d samples", samples);
+
+  self->latency_samples = samples;
+  latency = gst_util_uint64_scale_int (samples, GST_SECOND, self->rate);
+  gst_audio_decoder_set_latency (GST_AUDIO_DECODER (self), latency, latency);
+}
+
+static gboolean
+configure (DlbHomeAudio * self, const dlb_udc_audio_info * info)
+{
+  GstAudioChannelPosition udcpos[64];
+  GstAudioInfo decinfo;
+  guint64 mask;
+
+  GST_DEBUG_OBJECT (self, "stream changed: rate %d, channels %d, "
+      "channel-mask 0x%" G_GINT64_MODIFIER "x, object audio %d", info->rate,
+      info->channels, (guint64) info->channel_mask, info->object_audio);
+
+  if (info->rate != self->rate && !open_chain (self, info->rate))
+    return FALSE;
+
+  if (self->stage_fill) {
+    GST_DEBUG_OBJECT (self, "dropping %" G_GSIZE_FORMAT " staged samples",
+        self->stage_fill);
+    self->stage_fill = 0;
+  }
+
+  gst_audio_info_init (&decinfo);
+
+  if (info->object_audio) {
+    if (!self->oar) {
+      if (!open_renderer (self))
+        return FALSE;
+    } else if (!self->info.object_audio) {
+      dlb_oar_reset (self->oar, self->rate);
+    }
+
+    gst_audio_info_set_format (&decinfo, GST_AUDIO_FORMAT_F32, info->rate,
+        info->channels, NULL);
+    if (!block_setup (&self->decblock, self->decmap.data, &decinfo, TRUE))
+      goto layout_error;
+
+    self->dapinfo = self->renderinfo;
+    self->infmt = self->renderfmt;
+  } else {
+    udc_channel_mask_to_positions (info->channel_mask, info->channels,
+        udcpos);
+    memcpy (decinfo.position, udcpos, sizeof (udcpos[0]) * info->channels);
+    gst_audio_channel_positions_to_valid_order (decinfo.position,
+        info->channels);
+    gst_audio_info_set_format (&decinfo, GST_AUDIO_FORMAT_F32, info->rate,
+        info->channels, decinfo.position);
+
+    if (!block_setup (&self->decblock, self->decmap.data, &decinfo, TRUE))
+      goto layout_error;
+
+    block_follow_udc_order (&self->decblock, &decinfo, udcpos);
+
+    if (info->channels == 1) {
+      self->infmt.channels_floor = 1;
+      self->infmt.channels_top = 0;
+      self->infmt.lfe = 0;
+    } else {
+      gst_audio_channel_positions_to_mask (decinfo.position, info->channels,
+          FALSE, &mask);
+      channel_mask_to_dap_format (mask, &self->infmt);
+    }
+
+    if (self->infmt.channels_floor + self->infmt.channels_top +
+        self->infmt.lfe != info->channels)
+      goto layout_error;
+
+    self->dapinfo = decinfo;
+  }
+
+  if (!block_setup (&self->stageblock, self->stagedata, &self->dapinfo,
+          TRUE))
+    goto layout_error;
+
+  update_latency (self, info->object_audio, !self->info.rate);
+
+  self->info = *info;
+  return TRUE;
+
+layout_error:
+  GST_ELEMENT_ERROR (self, STREAM, FORMAT, (NULL),
+      ("Unsupported channel-mask 0x%" G_GINT64_MODIFIER "x",
+          (guint64) info->channel_mask));
+  return FALSE;
+}
+
+static void
+render_range (DlbHomeAudio * self, gint from, gint to)
+{
+  gsize inbpf = self->info.channels * sizeof (gfloat);
+  gsize outbpf = GST_AUDIO_INFO_BPF (&self->renderinfo);
+  dlb_buffer *in, *out;
+  gint n;
+
+  for (; from < to; from += n) {
+    n = MIN (to - from, self->max_render_samples);
+
+    in = block_at (&self->decblock, self->decmap.data + from * inbpf);
+    out = block_at (&self->renderblock, self->renderdata + from * outbpf);
+
+    dlb_oar_process (self->oar, in, out, n);
+  }
+}
+
+/* renders decoded objects to the DAP input layout, blocks are split where
+ * metadata takes effect as the renderer applies payloads per block */
+static void
+render (DlbHomeAudio * self, const dlb_evo_payload * md, gint samples)
+{
+  dlb_oar_payload payload;
+  gint min = MAX (self->min_render_samples, 1);
+  gint pos = 0;
+
+  if (md->id == DLB_EVODEC_METADATA_ID_OAMD) {
+    pos = md->offset / min * min;
+    pos = pos < samples ? pos : 0;
+
+    render_range (self, 0, pos);
+
+    payload.sample_offset = md->offset - pos;
+    payload.size = md->size;
+    payload.data = md->data;
+    dlb_oar_push_oamd_payload (self->oar, &payload, 1);
+  }
+
+  render_range (self, pos, samples);
+}
+
+/* feeds DAP in its own block size. Full blocks are processed in place,
+ * only remainders are staged. Output goes straight to @out. */
+static gboolean
+post_process (DlbHomeAudio * self, DlbHomeAudioBlock * src,
+    const guint8 * data, gsize samples, guint8 * out, gsize * written)
+{
+  gsize blocksz = self->dap_block_samples;
+  gsize bpf = GST_AUDIO_INFO_BPF (&self->dapinfo);
+  gsize outbpf = GST_AUDIO_INFO_BPF (&self->outinfo);
+  dlb_buffer *in;
+  gsize n;
+
+  while (samples) {
+    if (!self->stage_fill && samples >= blocksz) {
+      in = block_at (src, data);
+      data += blocksz * bpf;
+      samples -= blocksz;
+    } else {
+      n = MIN (blocksz - self->stage_fill, samples);
+      memcpy (self->stagedata + self->stage_fill * bpf, data, n * bpf);
+      self->stage_fill += n;
+      data += n * bpf;
+      samples -= n;
+
+      if (self->stage_fill < blocksz)
+        break;
+
+      in = block_at (&self->stageblock, self->stagedata);
+      self->stage_fill = 0;
+    }
+
+    if (dlb_dap_process (self->dap, &self->infmt, in,
+            block_at (&self->outblock, out + *written * outbpf)))
+      return FALSE;
+
+    *written += blocksz;
+  }
+
+  return TRUE;
+}
+
+/* drops what is left of the initial latency from the front of @outbuf */
+static void
+trim_output (DlbHomeAudio * self, GstBuffer * outbuf, gsize written)
+{
+  gsize bpf = GST_AUDIO_INFO_BPF (&self->outinfo);
+  gsize trim = MIN ((gsize) self->prefill, written);
+
+  self->prefill -= trim;
+  gst_buffer_resize (outbuf, trim * bpf, (written - trim) * bpf);
+}
+
+/* pushes zeros through the chain until the staged remainder and the delayed
+ * tail come out, so the output is as long as the decoded stream */
+static GstFlowReturn
+drain (DlbHomeAudio * self)
+{
+  GstAudioDecoder *decoder = GST_AUDIO_DECODER (self);
+  GstMapInfo outmap;
+  GstBuffer *outbuf;
+  DlbHomeAudioBlock *src;
+  const guint8 *data;
+  gsize blocksz, want, feed, written = 0, n;
+
+  if (!self->dap || !self->info.rate)
+    return GST_FLOW_OK;
+
+  want = self->stage_fill + self->latency_samples;
+  if (!want)
+    return GST_FLOW_OK;
+
+  GST_DEBUG_OBJECT (self, "draining %" G_GSIZE_FORMAT " staged and %d "
+      "latency samples", self->stage_fill, self->latency_samples);
+
+  blocksz = self->dap_block_samples;
+  feed = (want + blocksz - 1) / blocksz * blocksz - self->stage_fill;
+
+  outbuf = gst_audio_decoder_allocate_output_buffer (decoder,
+      (feed + self->stage_fill) * GST_AUDIO_INFO_BPF (&self->outinfo));
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  memset (self->decmap.data, 0,
+      DLB_UDC_SAMPLES_PER_BLOCK * self->info.channels * sizeof (gfloat));
+
+  for (; feed; feed -= n) {
+    n = MIN (feed, DLB_UDC_SAMPLES_PER_BLOCK);
+
+    if (self->info.object_audio) {
+      render_range (self, 0, n);
+      src = &self->renderblock;
+      data = self->renderdata;
+    } else {
+      src = &self->decblock;
+      data = self->decmap.data;
+    }
+
+    if (!post_process (self, src, data, n, outmap.data, &written))
+      goto process_error;
+  }
+
+  gst_buffer_unmap (outbuf, &outmap);
+  trim_output (self, outbuf, MIN (written, want));
+
+  /* delay line holds zeros now, they lead the output of further input */
+  self->stage_fill = 0;
+  self->prefill = self->latency_samples;
+
+  if (!gst_buffer_get_size (outbuf)) {
+    gst_buffer_unref (outbuf);
+    return GST_FLOW_OK;
+  }
+
+  return gst_audio_decoder_finish_frame (decoder, outbuf, 1);
+
+process_error:
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unref (outbuf);
+
+  GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL), ("DAP processing failed"));
+  return GST_FLOW_ERROR;
+}
+
+static GstFlowReturn
+dlb_home_audio_handle_frame (GstAudioDecoder * decoder, GstBuffer * inbuf)
+{
+  DlbHomeAudio *self = DLB_HOME_AUDIO (decoder);
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstMapInfo inmap, outmap = GST_MAP_INFO_INIT;
+  GstBuffer *outbuf = NULL;
+
+  dlb_udc_audio_info info;
+  DlbHomeAudioBlock *src;
+  const guint8 *data;
+  gsize blocksz = 0, written = 0, capacity;
+  gint status, samples;
+  guint i;
+
+  if (G_UNLIKELY (!inbuf))
+    return drain (self);
+
+  if (G_UNLIKELY (!update_params (self)))
+    return GST_FLOW_ERROR;
+
+  GST_LOG_OBJECT (self, "handling input buffer %" GST_PTR_FORMAT, inbuf);
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+
+  status = dlb_udc_push_timeslice (self->udc, (gchar *) inmap.data,
+      inmap.size);
+  if (status)
+    goto push_error;
+
+  for (i = 0; i < DLB_UDC_MAX_BLOCKS_PER_FRAME; ++i) {
+    dlb_evo_payload md = {.data = self->metadata_buffer, };
+
+    status = dlb_udc_process_block (self->udc, self->decbuf, &blocksz, &md,
+        &info);
+    if (G_UNLIKELY (status))
+      goto decode_error;
+
+    if (G_UNLIKELY (!blocksz))
+      break;
+
+    if (G_UNLIKELY (memcmp (&info, &self->info, sizeof (info)))
+        && !configure (self, &info))
+      goto config_error;
+
+    /* whole frame lands in one buffer, sized for everything DAP may emit */
+    if (!outbuf) {
+      capacity = (self->stage_fill + MAX_FRAME_SAMPLES) /
+          self->dap_block_samples * self->dap_block_samples;
+      outbuf = gst_audio_decoder_allocate_output_buffer (decoder,
+          MAX (capacity, 1) * GST_AUDIO_INFO_BPF (&self->outinfo));
+      gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+    }
+
+    samples = blocksz / (info.channels * sizeof (gfloat));
+
+    if (info.object_audio) {
+      render (self, &md, samples);
+      src = &self->renderblock;
+      data = self->renderdata;
+    } else {
+      src = &self->decblock;
+      data = self->decmap.data;
+    }
+
+    if (!post_process (self, src, data, samples, outmap.data, &written))
+      goto process_error;
+  }
+
+  gst_buffer_unmap (inbuf, &inmap);
+
+  if (outbuf) {
+    gst_buffer_unmap (outbuf, &outmap);
+    trim_output (self, outbuf, written);
+
+    if (!gst_buffer_get_size (outbuf))
+      gst_buffer_replace (&outbuf, NULL);
+  }
+
+  GST_LOG_OBJECT (self, "finish frame, %" G_GSIZE_FORMAT " samples", written);
+  return gst_audio_decoder_finish_frame (decoder, outbuf, 1);
+
+push_error:
+  gst_buffer_unmap (inbuf, &inmap);
+
+  GST_AUDIO_DECODER_ERROR (self, 1, STREAM, DECODE, (NULL),
+      ("push timeslice error: %d", status), ret);
+  return ret;
+
+decode_error:
+  gst_buffer_unmap (inbuf, &inmap);
+  if (outbuf) {
+    gst_buffer_unmap (outbuf, &outmap);
+    gst_buffer_unref (outbuf);
+  }
+
+  GST_AUDIO_DECODER_ERROR (self, 1, STREAM, DECODE, (NULL),
+      ("process block error: %d", status), ret);
+  return ret;
+
+process_error:
+  gst_buffer_unmap (inbuf, &inmap);
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unref (outbuf);
+
+  GST_ELEMENT_ERROR (self, STREAM, FAILED, (NULL), ("DAP processing failed"));
+  return GST_FLOW_ERROR;
+
+config_error:
+  gst_buffer_unmap (inbuf, &inmap);
+  if (outbuf) {
+    gst_buffer_unmap (outbuf, &outmap);
+    gst_buffer_unref (outbuf);
+  }
+
+  return GST_FLOW_NOT_NEGOTIATED;
+}
+
+static void
+apply_dap_settings (DlbHomeAudio * self, guint groups)
+{
+  const DlbHomeAudioParams *params = self->applied;
+
+  if (groups & DLB_HOME_AUDIO_PARAMS_DAP_PROFILE)
+    dlb_dap_set_profile_settings (self->dap, &params->profile);
+
+  if (groups & DLB_HOME_AUDIO_PARAMS_DAP_GAINS)
+    dlb_dap_set_gain_settings (self->dap, &params->gains);
+
+  /* serialized config carries its own virtualizer tuning */
+  if ((groups & DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER)
+      && (!self->dap_serialized_config || self->dap_override_virt))
+    dlb_dap_set_virtualizer_settings (self->dap, &params->virt);
+}
+
+/* parsed in the caller thread, the property is only mutable in READY */
+static void
+load_json_config (DlbHomeAudio * self, const gchar * filename)
+{
+  dlb_dap_json_config *config = NULL;
+  DlbHomeAudioParams *params;
+  GError *error = NULL;
+  guint groups = 0;
+
+  if (filename && !(config = dlb_dap_json_config_load (filename, &error))) {
+    GST_ELEMENT_WARNING (self, LIBRARY, SETTINGS, ("%s: %d", error->message,
+            error->code), ("JSON parsing failed"));
+    g_error_free (error);
+  }
+
+  GST_OBJECT_LOCK (self);
+  g_free (self->json_config_path);
+  self->json_config_path = g_strdup (filename);
+  dlb_dap_json_config_free (self->json_config);
+  self->json_config = config;
+  GST_OBJECT_UNLOCK (self);
+
+  if (!config)
+    return;
+
+  /* sections present in the file override earlier property values */
+  params = dlb_param_mailbox_lock (self->params);
+
+  if (config->sections & DLB_DAP_JSON_SECTION_GLOBAL) {
+    params->virtualizer_enable = config->global.virtualizer_enable;
+    groups |= DLB_HOME_AUDIO_PARAMS_DAP_STATIC;
+  }
+  if (config->sections & DLB_DAP_JSON_SECTION_VIRTUALIZER) {
+    params->virt = config->virt;
+    groups |= DLB_HOME_AUDIO_PARAMS_DAP_VIRTUALIZER;
+  }
+  if (config->sections & DLB_DAP_JSON_SECTION_GAINS) {
+    params->gains = config->gains;
+    groups |= DLB_HOME_AUDIO_PARAMS_DAP_GAINS;
+  }
+  if (config->sections & DLB_DAP_JSON_SECTION_PROFILE) {
+    params->profile = config->profile;
+    groups |= DLB_HOME_AUDIO_PARAMS_DAP_PROFILE;
+  }
+
+  dlb_param_mailbox_unlock (self->params, groups);
+}
+
+static gboolean
+update_decoder_params (DlbHomeAudio * self)
+{
+  const DlbHomeAudioParams *params = self->applied;
+  dlb_udc_drc_settings drc;
+
+  if (DLB_AUDIO_DECODER_DRC_MODE_DISABLE == params->drc_mode) {
+    drc.cut = 0;
+    drc.boost = 0;
+  } else {
+    drc.cut = params->drc.cut;
+    drc.boost = params->drc.boost;
+  }
+
+  GST_DEBUG_OBJECT (self, "Dynamic settings: drc_boost %.2f, drc_cut %.2f",
+      drc.boost, drc.cut);
+
+  if (dlb_udc_drc_settings_set (self->udc, &drc)) {
+    GST_WARNING_OBJECT (self, "UDC DRC settings failed.");
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/* picks up settings published since last frame, never blocks */
+static gboolean
+update_params (DlbHomeAudio * self)
+{
+  GstAudioDecoder *decoder = GST_AUDIO_DECODER (self);
+  guint groups;
+
+  self->applied = dlb_param_mailbox_read (self->params, &groups);
+
+  if (G_LIKELY (!groups))
+    return TRUE;
+
+  /* restart applies all the other settings as well */
+  if (groups & DLB_HOME_AUDIO_PARAMS_DECODER_STATIC) {
+    GST_DEBUG_OBJECT (self, "restart");
+    return dlb_home_audio_stop (decoder) && dlb_home_audio_start (decoder);
+  }
+
+  /* renderer and DAP are reopened with the next decoded block */
+  if (groups & (DLB_HOME_AUDIO_PARAMS_RENDERER |
+          DLB_HOME_AUDIO_PARAMS_DAP_STATIC))
+    close_chain (self);
+
+  if (groups & DLB_HOME_AUDIO_PARAMS_DECODER_DYNAMIC)
+    update_decoder_params (self);
+
+  if (self->dap)
+    apply_dap_settings (self, groups);
+
+  return TRUE;
+}
+
+static GstStateChangeReturn
+dlb_home_audio_change_state (GstElement * element, GstStateChange transition)
+{
+  gint failed = 0;
+
+  /* vendor libraries are bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY) {
+#ifdef DLB_UDC_OPEN_DYNLIB
+    failed |= dlb_udc_try_open_dynlib ();
+#endif
+#ifdef DLB_OAR_OPEN_DYNLIB
+    failed |= dlb_oar_try_open_dynlib ();
+#endif
+#ifdef DLB_DAP_OPEN_DYNLIB
+    failed |= dlb_dap_try_open_dynlib ();
+#endif
+  }
+
+  if (failed) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load UDC, OAR or DAP library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+
+  return GST_ELEMENT_CLASS (dlb_home_audio_parent_class)->change_state
+      (element, transition);
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  GST_DEBUG_CATEGORY_INIT (dlb_home_audio_debug_category, "dlbhomeaudio", 0,
+      "debug category for fused home audio processor element");
+
+  if (!gst_element_register (plugin, "dlbhomeaudio", GST_RANK_NONE,
+          DLB_TYPE_HOME_AUDIO))
+    return FALSE;
+
+  return TRUE;
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    dlbhomeaudio,
+    "Dolby Home Audio fused decoder, renderer and post-processor",
+    plugin_init, VERSION, LICENSE, PACKAGE, ORIGIN)
@@ -0,0 +1,151 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _DLB_HOME_AUDIO_H_
+#define _DLB_HOME_AUDIO_H_
+
+#include "dlbutils.h"
+#include "dlbaudiodecoder.h"
+#include "dlbparammailbox.h"
+#include "dlbdapjson.h"
+
+#include "dlb_udc.h"
+#include "dlb_oar.h"
+#include "dlb_dap.h"
+
+G_BEGIN_DECLS
+#define DLB_TYPE_HOME_AUDIO   (dlb_home_audio_get_type())
+#define DLB_HOME_AUDIO(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),DLB_TYPE_HOME_AUDIO,DlbHomeAudio))
+#define DLB_HOME_AUDIO_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),DLB_TYPE_HOME_AUDIO,DlbHomeAudioClass))
+#define DLB_IS_HOME_AUDIO(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),DLB_TYPE_HOME_AUDIO))
+#define DLB_IS_HOME_AUDIO_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),DLB_TYPE_HOME_AUDIO))
+typedef struct _DlbHomeAudio DlbHomeAudio;
+typedef struct _DlbHomeAudioClass DlbHomeAudioClass;
+typedef struct _DlbHomeAudioParams DlbHomeAudioParams;
+typedef struct _DlbHomeAudioBlock DlbHomeAudioBlock;
+
+/* settings exchanged through the parameter mailbox */
+struct _DlbHomeAudioParams
+{
+  /* decoder */
+  DlbAudioDecoderOutMode outmode;
+  gboolean dmx_enable;
+  gint drc_mode;
+  dlb_udc_drc_settings drc;
+
+  /* renderer */
+  gboolean limiter_enable;
+
+  /* post-processing */
+  gboolean virtualizer_enable;
+  dlb_dap_virtualizer_settings virt;
+  dlb_dap_gain_settings gains;
+  dlb_dap_profile_settings profile;
+
+  /* output */
+  gboolean discard_latency;
+  gboolean force_order;
+};
+
+/* interleaved block wrapper, moved onto the data without rebuilding its
+ * channel map */
+struct _DlbHomeAudioBlock
+{
+  dlb_buffer *buf;
+  const guint8 *base;
+};
+
+struct _DlbHomeAudio
+{
+  GstAudioDecoder base_home_audio;
+
+  dlb_udc *udc;
+  dlb_oar *oar;
+  dlb_dap *dap;
+
+  /* stream layout the chain is configured for */
+  dlb_udc_audio_info info;
+  gint rate;
+
+  /* decoder output, aligned as the UDC requires */
+  GstMemory *decmem;
+  GstMapInfo decmap;
+  dlb_buffer *decbuf;
+  gint max_channels;
+
+  /* rendered block and DAP input stage, share one allocation */
+  GstMemory *workmem;
+  GstMapInfo workmap;
+  guint8 *renderdata;
+  guint8 *stagedata;
+  gsize stage_fill;
+
+  DlbHomeAudioBlock decblock;
+  DlbHomeAudioBlock renderblock;
+  DlbHomeAudioBlock stageblock;
+  DlbHomeAudioBlock outblock;
+
+  /* format of the samples entering DAP */
+  GstAudioInfo dapinfo;
+  dlb_dap_channel_format infmt;
+
+  /* renderer target, proposed by DAP for its output format */
+  GstAudioInfo renderinfo;
+  dlb_dap_channel_format renderfmt;
+  gint min_render_samples;
+  gint max_render_samples;
+
+  /* output format, picked from downstream caps at start */
+  GstAudioInfo outinfo;
+  dlb_dap_channel_format outfmt;
+  gint dap_block_samples;
+
+  /* delay of DAP and the renderer, zero unless discard-latency is set. The
+   * first prefill samples of the output are dropped, drain pushes the tail */
+  gint latency_samples;
+  gint prefill;
+
+  GstAllocator *alloc;
+  GstAllocationParams *alloc_params;
+  guint8 *metadata_buffer;
+
+  /* published by property setters, picked up at frame boundary */
+  DlbParamMailbox *params;
+  /* snapshot the chain is configured with */
+  const DlbHomeAudioParams *applied;
+
+  /* parsed json-config, protected by object lock */
+  gchar *json_config_path;
+  dlb_dap_json_config *json_config;
+
+  /* serialized config the running DAP was opened with */
+  GBytes *dap_serialized_config;
+  gboolean dap_override_virt;
+};
+
+struct _DlbHomeAudioClass
+{
+  GstAudioDecoderClass base_home_audio_class;
+};
+
+GType dlb_home_audio_get_type (void);
+
+G_END_DECLS
+#endif
@@ -33,7 +33,7 @@
 GST_DEBUG_CATEGORY_STATIC (dlb_oar_debug_category);
 #define GST_CAT_DEFAULT dlb_oar_debug_category
 
-#define ALLOWED_SRC_CAPS                                                \
+#define RENDERED_CAPS                                                   \
   "audio/x-raw, "                                                       \
   "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",       \
                       "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, "   \
@@ -41,14 +41,47 @@ GST_DEBUG_CATEGORY_STATIC (dlb_oar_debug_category);
   "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
   "layout = (string) interleaved"
 
-
-#define ALLOWED_SINK_CAPS                                               \
+#define OBJECT_CAPS                                                     \
   "audio/x-raw(" DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META "), "          \
   "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",       \
                       "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, "   \
   "channels = (int) [ 1, 32 ], "                                        \
   "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
-  "layout = (string) interleaved"                                       \
+  "layout = (string) interleaved"
+
+/* channel based audio bypasses the renderer unchanged */
+#define CHANNEL_CAPS                                                    \
+  "audio/x-raw, "                                                       \
+  "format = (string) {"GST_AUDIO_NE (F32)", "GST_AUDIO_NE (F64)",       \
+                      "GST_AUDIO_NE (S16)", "GST_AUDIO_NE (S32)" }, "   \
+  "channels = (int) [ 1, 35 ], "                                        \
+  "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
+  "layout = (string) interleaved"
+
+/* native format variants, exchanged with other Dolby elements */
+#define RENDERED_LFRACT_CAPS                                            \
+  DLB_AUDIO_LFRACT_CAPS_NAME ", "                                       \
+  "channels = (int) [ 2, 35 ], "                                        \
+  "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
+  "layout = (string) interleaved"
+
+#define OBJECT_LFRACT_CAPS                                              \
+  DLB_AUDIO_LFRACT_CAPS_NAME                                            \
+  "(" DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META "), "                     \
+  "channels = (int) [ 1, 32 ], "                                        \
+  "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
+  "layout = (string) interleaved"
+
+#define CHANNEL_LFRACT_CAPS                                             \
+  DLB_AUDIO_LFRACT_CAPS_NAME ", "                                       \
+  "channels = (int) [ 1, 35 ], "                                        \
+  "rate = (int) { 48000, 32000, 44100, 88200, 96000 }, "                \
+  "layout = (string) interleaved"
+
+#define ALLOWED_SRC_CAPS CHANNEL_CAPS "; " CHANNEL_LFRACT_CAPS
+#define ALLOWED_SINK_CAPS                                               \
+  OBJECT_CAPS "; " CHANNEL_CAPS "; "                                    \
+  OBJECT_LFRACT_CAPS "; " CHANNEL_LFRACT_CAPS
 
 /**
  * OARMSK:
@@ -58,11 +91,15 @@ GST_DEBUG_CATEGORY_STATIC (dlb_oar_debug_category);
 #define OARMSK(ch) (DLB_OAR_SPEAKER_CONFIG_MASK (ch))
 #define GSTMSK(ch) (GST_AUDIO_CHANNEL_POSITION_MASK (ch))
 
+/* negotiation results kept, both pads of a few streams */
+#define DLB_OAR_CAPS_CACHE_SIZE 16
+
 /* prototypes */
 static void dlb_oar_set_property (GObject * object,
     guint property_id, const GValue * value, GParamSpec * pspec);
 static void dlb_oar_get_property (GObject * object,
     guint property_id, GValue * value, GParamSpec * pspec);
+static void dlb_oar_finalize (GObject * object);
 static GstCaps *dlb_oar_transform_caps (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static gboolean dlb_oar_set_caps (GstBaseTransform * trans,
@@ -72,6 +109,8 @@ static gboolean dlb_oar_query (GstBaseTransform * trans,
 static gboolean dlb_oar_transform_size (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, gsize size, GstCaps * othercaps,
     gsize * othersize);
+static GstStateChangeReturn dlb_oar_change_state (GstElement * element,
+    GstStateChange transition);
 static gboolean dlb_oar_start (GstBaseTransform * trans);
 static gboolean dlb_oar_stop (GstBaseTransform * trans);
 static gboolean dlb_oar_sink_event (GstBaseTransform * trans, GstEvent * event);
@@ -94,8 +133,14 @@ enum
   PROP_0,
   PROP_LIMITER_ENABLE,
   PROP_DISCARD_LATENCY,
+  PROP_SILENCE_THRESHOLD,
+  PROP_IDLE_TIMEOUT,
+  PROP_STATS,
 };
 
+#define DEFAULT_SILENCE_THRESHOLD 0.0
+#define DEFAULT_IDLE_TIMEOUT GST_CLOCK_TIME_NONE
+
 /* pad templates */
 static GstStaticPadTemplate dlb_oar_src_template =
 GST_STATIC_PAD_TEMPLATE ("src",
@@ -138,12 +183,15 @@ dlb_oar_class_init (DlbOarClass * klass)
 
   gobject_class->set_property = GST_DEBUG_FUNCPTR (dlb_oar_set_property);
   gobject_class->get_property = GST_DEBUG_FUNCPTR (dlb_oar_get_property);
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (dlb_oar_finalize);
   base_transform_class->transform_caps =
       GST_DEBUG_FUNCPTR (dlb_oar_transform_caps);
   base_transform_class->set_caps = GST_DEBUG_FUNCPTR (dlb_oar_set_caps);
   base_transform_class->query = GST_DEBUG_FUNCPTR (dlb_oar_query);
   base_transform_class->transform_size =
       GST_DEBUG_FUNCPTR (dlb_oar_transform_size);
+  GST_ELEMENT_CLASS (klass)->change_state =
+      GST_DEBUG_FUNCPTR (dlb_oar_change_state);
   base_transform_class->start = GST_DEBUG_FUNCPTR (dlb_oar_start);
   base_transform_class->stop = GST_DEBUG_FUNCPTR (dlb_oar_stop);
   base_transform_class->sink_event = GST_DEBUG_FUNCPTR (dlb_oar_sink_event);
@@ -163,6 +211,26 @@ dlb_oar_class_init (DlbOarClass * klass)
           "Discard latency",
           "Discard initial latency zeros from the output", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_SILENCE_THRESHOLD,
+      g_param_spec_double ("silence-threshold", "Silence threshold",
+          "Peak input amplitude, relative to full scale, treated as silence "
+          "by the idle bypass, (0) - digital silence only",
+          0.0, 1.0, DEFAULT_SILENCE_THRESHOLD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_IDLE_TIMEOUT,
+      g_param_spec_uint64 ("idle-timeout", "Idle timeout",
+          "Duration of silent or GAP input without object metadata in "
+          "nanoseconds after which rendering is bypassed and GAP buffers "
+          "are produced, never for native format input, (-1) - disable bypass",
+          0, G_MAXUINT64, DEFAULT_IDLE_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  g_object_class_install_property (gobject_class, PROP_STATS,
+      g_param_spec_boxed ("stats", "Statistics",
+          "Processed blocks and library call statistics", GST_TYPE_STRUCTURE,
+          G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -170,19 +238,41 @@ dlb_oar_init (DlbOar * oar)
 {
   oar->oar_instance = NULL;
   oar->oamd_payloads = NULL;
+  oar->oamd_offsets = NULL;
   oar->adapter = NULL;
   oar->max_payloads = 0;
   oar->max_block_size = 0;
   oar->min_block_size = 0;
+  oar->blocks = 0;
   oar->latency = 0;
   oar->prefill = 0;
   oar->latency_samples = 0;
   oar->latency_time = GST_CLOCK_TIME_NONE;
   oar->discard_latency = FALSE;
 
+  oar->silence_threshold = DEFAULT_SILENCE_THRESHOLD;
+  oar->idle_timeout = DEFAULT_IDLE_TIMEOUT;
+  oar->audible_end = 0;
+  oar->oamd_end = 0;
+  oar->silent_samples = 0;
+  oar->idle = FALSE;
+  oar->bypass = FALSE;
+
   oar->oar_config.speaker_mask = 0;
   oar->oar_config.sample_rate = 0;
   oar->oar_config.limiter_enable = 1;
+
+  oar->caps_cache = dlb_caps_cache_new (DLB_OAR_CAPS_CACHE_SIZE);
+}
+
+static void
+dlb_oar_finalize (GObject * object)
+{
+  DlbOar *oar = DLB_OAR (object);
+
+  dlb_caps_cache_free (oar->caps_cache);
+
+  G_OBJECT_CLASS (dlb_oar_parent_class)->finalize (object);
 }
 
 void
@@ -203,6 +293,12 @@ dlb_oar_set_property (GObject * object, guint property_id,
     case PROP_DISCARD_LATENCY:
       oar->discard_latency = g_value_get_boolean (value);
       break;
+    case PROP_SILENCE_THRESHOLD:
+      oar->silence_threshold = g_value_get_double (value);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      oar->idle_timeout = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -221,6 +317,7 @@ dlb_oar_get_property (GObject * object, guint property_id,
     GValue * value, GParamSpec * pspec)
 {
   DlbOar *oar = DLB_OAR (object);
+  GstStructure *stats;
 
   GST_DEBUG_OBJECT (oar, "get_property");
   GST_OBJECT_LOCK (oar);
@@ -232,6 +329,20 @@ dlb_oar_get_property (GObject * object, guint property_id,
     case PROP_DISCARD_LATENCY:
       g_value_set_boolean (value, oar->discard_latency);
       break;
+    case PROP_SILENCE_THRESHOLD:
+      g_value_set_double (value, oar->silence_threshold);
+      break;
+    case PROP_IDLE_TIMEOUT:
+      g_value_set_uint64 (value, oar->idle_timeout);
+      break;
+    case PROP_STATS:
+      stats = gst_structure_new ("dlboar-stats",
+          "blocks", G_TYPE_UINT64, oar->blocks, NULL);
+#ifdef DLB_OAR_OPEN_DYNLIB
+      dlb_shim_stats_append (stats, dlb_oar_query_stats);
+#endif
+      g_value_take_boxed (value, stats);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -252,6 +363,15 @@ get_channel_mask_from_caps (GstCaps * caps)
   return mask;
 }
 
+static gboolean
+caps_have_object_meta (GstCaps * caps)
+{
+  GstCapsFeatures *features = gst_caps_get_features (caps, 0);
+
+  return features && gst_caps_features_contains (features,
+      DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META);
+}
+
 static gboolean
 oar_is_opened (DlbOar * oar)
 {
@@ -313,29 +433,58 @@ dlb_oar_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
     GstCaps * caps, GstCaps * filter)
 {
   DlbOar *oar = DLB_OAR (trans);
-  GstCaps *othercaps;
-  GstStructure *base, *s;
-
-  /* Simply return pad template for given direction */
-  if (direction == GST_PAD_SRC) {
-    /* transform caps going upstream */
-    othercaps = gst_static_pad_template_get_caps (&dlb_oar_sink_template);
-  } else {
-    /* transform caps going downstream */
-    othercaps = gst_static_pad_template_get_caps (&dlb_oar_src_template);
-  }
+  GstCaps *othercaps, *rendered, *lfract;
+  GstCapsFeatures *features;
+  GstStructure *s;
+  const GValue *format, *rate;
+  guint i, cookie;
 
-  othercaps = gst_caps_make_writable (othercaps);
+  /* caps depend on the templates only */
+  othercaps = dlb_caps_cache_lookup (oar->caps_cache, direction, caps, filter,
+      &cookie);
+  if (othercaps)
+    return othercaps;
 
-  if (!gst_caps_is_empty (caps) && (s = gst_caps_get_structure (caps, 0))) {
-    const GValue *format, *rate;
-    base = gst_caps_get_structure (othercaps, 0);
+  othercaps = gst_caps_new_empty ();
+
+  /* object audio is rendered to any speaker layout, channel based audio
+   * passes through with its own layout. The renderer converts from and to
+   * the native format, which is preferred */
+  for (i = 0; i < gst_caps_get_size (caps); ++i) {
+    s = gst_caps_get_structure (caps, i);
+    features = gst_caps_get_features (caps, i);
+
+    if (direction == GST_PAD_SRC) {
+      rendered = gst_caps_from_string (OBJECT_CAPS);
+      lfract = gst_caps_from_string (OBJECT_LFRACT_CAPS);
+    } else if (features && gst_caps_features_contains (features,
+            DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META)) {
+      rendered = gst_caps_from_string (RENDERED_CAPS);
+      lfract = gst_caps_from_string (RENDERED_LFRACT_CAPS);
+    } else {
+      othercaps = gst_caps_merge_structure_full (othercaps,
+          gst_structure_copy (s),
+          features ? gst_caps_features_copy (features) : NULL);
+      continue;
+    }
 
     if ((format = gst_structure_get_value (s, "format")))
-      gst_structure_set_value (base, "format", format);
+      gst_caps_set_value (rendered, "format", format);
+
+    if ((rate = gst_structure_get_value (s, "rate"))) {
+      gst_caps_set_value (rendered, "rate", rate);
+      gst_caps_set_value (lfract, "rate", rate);
+    }
+
+    /* native format needs its sample size */
+    if (dlb_audio_lfract_container () != GST_AUDIO_FORMAT_UNKNOWN)
+      othercaps = gst_caps_merge (othercaps, lfract);
+    else
+      gst_caps_unref (lfract);
+    othercaps = gst_caps_merge (othercaps, rendered);
 
-    if ((rate = gst_structure_get_value (s, "rate")))
-      gst_structure_set_value (base, "rate", rate);
+    if (direction == GST_PAD_SRC)
+      othercaps = gst_caps_merge_structure (othercaps, gst_structure_copy (s));
   }
 
   GST_DEBUG_OBJECT (oar,
@@ -349,10 +498,58 @@ dlb_oar_transform_caps (GstBaseTransform * trans, GstPadDirection direction,
     gst_caps_unref (othercaps);
     GST_DEBUG_OBJECT (oar, "Intersection %" GST_PTR_FORMAT, intersect);
 
-    return intersect;
-  } else {
-    return othercaps;
+    othercaps = intersect;
   }
+
+  dlb_caps_cache_insert (oar->caps_cache, direction, caps, filter, othercaps,
+      cookie);
+  return othercaps;
+}
+
+static void
+dlb_oar_clear_blocks (DlbOar * oar)
+{
+  dlb_buffer_free (oar->inblock);
+  dlb_buffer_free (oar->outblock);
+
+  oar->inblock = NULL;
+  oar->outblock = NULL;
+  oar->inbase = NULL;
+  oar->outbase = NULL;
+}
+
+/* wrappers carry the channel reorder map, so they are built once per caps
+ * and only moved onto each block's data */
+static gboolean
+dlb_oar_setup_blocks (DlbOar * oar)
+{
+  dlb_oar_clear_blocks (oar);
+
+  oar->inblock = dlb_buffer_new_wrapped (NULL, &oar->ininfo, TRUE);
+  oar->outblock = dlb_buffer_new_wrapped (NULL, &oar->outinfo, TRUE);
+
+  if (!oar->inblock || !oar->outblock)
+    return FALSE;
+
+  if (oar->in_lfract)
+    oar->inblock->data_type = DLB_BUFFER_LFRACT;
+  if (oar->out_lfract)
+    oar->outblock->data_type = DLB_BUFFER_LFRACT;
+
+  return TRUE;
+}
+
+static void
+dlb_oar_rebase_block (dlb_buffer * buf, const guint8 ** base,
+    const guint8 * data)
+{
+  gint i;
+
+  for (i = 0; i < buf->nchannel; ++i)
+    buf->ppdata[i] = (void *) ((guintptr) buf->ppdata[i] - (guintptr) * base +
+        (guintptr) data);
+
+  *base = data;
 }
 
 static gboolean
@@ -361,7 +558,7 @@ dlb_oar_set_caps (GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
   DlbOar *oar = DLB_OAR (trans);
   GstAudioInfo in, out;
 
-  gboolean ret;
+  gboolean ret, in_lfract, out_lfract;
   gint rate, channels;
   gsize latency;
   guint64 channel_mask, oar_mask;
@@ -373,11 +570,36 @@ dlb_oar_set_caps (GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
   gst_audio_info_init (&in);
   gst_audio_info_init (&out);
 
-  if (!gst_audio_info_from_caps (&in, incaps))
+  if (!dlb_audio_info_from_caps (&in, incaps, &in_lfract))
     goto incaps_error;
-  if (!gst_audio_info_from_caps (&out, outcaps))
+  if (!dlb_audio_info_from_caps (&out, outcaps, &out_lfract))
     goto outcaps_error;
 
+  if (!caps_have_object_meta (incaps)) {
+    /* drain the renderer tail in the old format before bypassing, the
+     * instance stays open for object audio coming back */
+    if (!oar->bypass && oar_is_opened (oar)) {
+      dlb_oar_push_drain (oar);
+      g_array_set_size (oar->oamd_offsets, 0);
+    }
+
+    GST_INFO_OBJECT (oar, "channel based input, bypassing renderer");
+
+    oar->bypass = TRUE;
+    oar->ininfo = in;
+    oar->outinfo = out;
+    oar->in_lfract = in_lfract;
+    oar->out_lfract = out_lfract;
+    gst_base_transform_set_passthrough (trans, TRUE);
+    return TRUE;
+  }
+
+  if (oar->bypass && oar_is_opened (oar))
+    dlb_oar_reset (oar->oar_instance, oar->oar_config.sample_rate);
+
+  oar->bypass = FALSE;
+  gst_base_transform_set_passthrough (trans, FALSE);
+
   rate = GST_AUDIO_INFO_RATE (&in);
   channels = GST_AUDIO_INFO_CHANNELS (&out);
   channel_mask = get_channel_mask_from_caps (outcaps);
@@ -430,6 +652,11 @@ dlb_oar_set_caps (GstBaseTransform * trans, GstCaps * incaps, GstCaps * outcaps)
 
   oar->ininfo = in;
   oar->outinfo = out;
+  oar->in_lfract = in_lfract;
+  oar->out_lfract = out_lfract;
+
+  if (!dlb_oar_setup_blocks (oar))
+    goto blocks_error;
 
   return TRUE;
 
@@ -445,6 +672,10 @@ outcaps_error:
 open_error:
   oar_close (oar);
   return FALSE;
+
+blocks_error:
+  GST_ERROR_OBJECT (trans, "unsupported channel configuration");
+  return FALSE;
 }
 
 static gboolean
@@ -539,6 +770,7 @@ dlb_oar_stop (GstBaseTransform * trans)
   GST_DEBUG_OBJECT (oar, "stop");
 
   oar_close (oar);
+  dlb_oar_clear_blocks (oar);
 
   oar->max_payloads = 0;
   oar->max_block_size = 0;
@@ -548,6 +780,12 @@ dlb_oar_stop (GstBaseTransform * trans)
   oar->latency_samples = 0;
   oar->latency_time = GST_CLOCK_TIME_NONE;
 
+  oar->audible_end = 0;
+  oar->oamd_end = 0;
+  oar->silent_samples = 0;
+  oar->idle = FALSE;
+  oar->bypass = FALSE;
+
   oar->oar_config.speaker_mask = 0;
   oar->oar_config.sample_rate = 0;
 
@@ -565,8 +803,10 @@ dlb_oar_sink_event (GstBaseTransform * trans, GstEvent * event)
   switch (GST_EVENT_TYPE (event)) {
     case GST_EVENT_FLUSH_STOP:
     case GST_EVENT_EOS:
-      if (oar_is_opened (oar))
+      if (oar_is_opened (oar) && !oar->bypass) {
         dlb_oar_push_drain (oar);
+        g_array_set_size (oar->oamd_offsets, 0);
+      }
       break;
     default:
       break;
@@ -642,13 +882,115 @@ transform_data_block (DlbOar * oar, dlb_buffer * inbuf, dlb_buffer * outbuf,
   dlb_oar_process (oar->oar_instance, inbuf, outbuf, samples);
 }
 
+/* tells whether the block at the head of the adapter can bypass the
+ * renderer. It is left alone only after it rendered silence for idle-timeout
+ * plus its latency, so its internal state has decayed. Blocks carrying
+ * object metadata are always rendered. */
+static gboolean
+dlb_oar_idle_check (DlbOar * oar, const guint8 * data, gsize samples)
+{
+  guint64 decay;
+
+  /* samples of the native format are opaque, silence is not recognized */
+  if (!GST_CLOCK_TIME_IS_VALID (oar->idle_timeout) || oar->in_lfract)
+    return FALSE;
+
+  /* data appended by GAP buffers is known to be silent */
+  if (oar->oamd_end || (oar->audible_end && !dlb_audio_is_silent (data,
+              samples, &oar->ininfo, oar->silence_threshold))) {
+    if (G_UNLIKELY (oar->idle))
+      GST_DEBUG_OBJECT (oar, "Input is audible, leaving idle state");
+
+    oar->idle = FALSE;
+    oar->silent_samples = 0;
+    return FALSE;
+  }
+
+  if (oar->idle)
+    return TRUE;
+
+  decay = gst_util_uint64_scale_int (oar->idle_timeout,
+      GST_AUDIO_INFO_RATE (&oar->ininfo), GST_SECOND);
+  decay += dlb_oar_query_latency (oar->oar_instance);
+
+  if (oar->silent_samples < decay) {
+    oar->silent_samples += samples;
+    return FALSE;
+  }
+
+  GST_DEBUG_OBJECT (oar, "Input is silent, entering idle state");
+  oar->idle = TRUE;
+  return TRUE;
+}
+
+static gint
+compare_offsets (gconstpointer a, gconstpointer b)
+{
+  gsize x = *(const gsize *) a, y = *(const gsize *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+/* records where payloads of the buffer about to be pushed take effect */
+static void
+dlb_oar_queue_oamd_offsets (DlbOar * oar, gint num_payloads)
+{
+  gsize base = gst_adapter_available (oar->adapter);
+  gsize pos;
+  gint i;
+
+  for (i = 0; i < num_payloads; ++i) {
+    pos = base + MAX (oar->oamd_payloads[i].sample_offset, 0) *
+        oar->ininfo.bpf;
+
+    if (pos)
+      g_array_append_val (oar->oamd_offsets, pos);
+  }
+
+  g_array_sort (oar->oamd_offsets, compare_offsets);
+}
+
+static void
+dlb_oar_flush_oamd_offsets (DlbOar * oar, gsize size)
+{
+  guint i, n = 0;
+
+  for (i = 0; i < oar->oamd_offsets->len; ++i) {
+    gsize *pos = &g_array_index (oar->oamd_offsets, gsize, i);
+
+    if (*pos <= size)
+      n++;
+    else
+      *pos -= size;
+  }
+
+  g_array_remove_range (oar->oamd_offsets, 0, n);
+}
+
+/* prefers the largest block allowed, but ends it right where the next
+ * payload takes effect, so metadata updates land on block boundaries */
 static gsize
 get_next_block_size (DlbOar * oar)
 {
   gsize size = MIN (oar->max_block_size, gst_adapter_available (oar->adapter));
+  guint i;
 
   size /= oar->min_block_size;
   size *= oar->min_block_size;
+
+  for (i = 0; i < oar->oamd_offsets->len; ++i) {
+    gsize pos = g_array_index (oar->oamd_offsets, gsize, i);
+
+    /* cannot be split off without going below minimal block size */
+    if (pos < oar->min_block_size)
+      continue;
+
+    if (pos < size)
+      size = pos / oar->min_block_size * oar->min_block_size;
+
+    break;
+  }
+
   return size;
 }
 
@@ -769,17 +1111,17 @@ dlb_oar_transform (GstBaseTransform * trans, GstBuffer * inbuf,
     GstBuffer * outbuf)
 {
   DlbOar *oar = DLB_OAR (trans);
-  GstMapInfo outbuf_map, inbuf_map;
+  GstMapInfo outbuf_map;
 
   gsize insize, outsize = 0;
   gint samples = 0, num_payloads = 0;
+  gint blocks = 0, bypassed = 0;
   gint inbpf = GST_AUDIO_INFO_BPF (&oar->ininfo);
   gint outbpf = GST_AUDIO_INFO_BPF (&oar->outinfo);
 
   GstClockTime timestamp;
   guint64 offset;
 
-  dlb_buffer *in, *out;
   const guint8 *outdata;
 
   GST_LOG_OBJECT (oar, "transform");
@@ -790,12 +1132,22 @@ dlb_oar_transform (GstBaseTransform * trans, GstBuffer * inbuf,
 
   num_payloads = gst_buffer_get_oamd (oar, inbuf);
   dlb_oar_push_oamd_payload (oar->oar_instance, oar->oamd_payloads, num_payloads);
+  dlb_oar_queue_oamd_offsets (oar, num_payloads);
 
   gst_adapter_push (oar->adapter, inbuf);
 
+  if (!GST_BUFFER_FLAG_IS_SET (inbuf, GST_BUFFER_FLAG_GAP))
+    oar->audible_end = gst_adapter_available (oar->adapter);
+
+  if (num_payloads)
+    oar->oamd_end = gst_adapter_available (oar->adapter);
+
   insize = get_next_block_size (oar);
 
-  if (G_UNLIKELY (insize < oar->min_block_size || insize <= oar->prefill))
+  /* all complete blocks get processed, whatever their boundaries are */
+  if (G_UNLIKELY (insize < oar->min_block_size ||
+          gst_adapter_available (oar->adapter) / oar->min_block_size *
+          oar->min_block_size <= oar->prefill))
     goto no_output;
 
   dlb_oar_get_input_timing (oar, &timestamp, &offset);
@@ -805,21 +1157,31 @@ dlb_oar_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   outdata = outbuf_map.data;
 
   while (insize >= oar->min_block_size) {
-    GstBuffer *inbuf = gst_adapter_take_buffer (oar->adapter, insize);
-    gst_buffer_map (inbuf, &inbuf_map, GST_MAP_READ);
-
-    in = dlb_buffer_new_wrapped (inbuf_map.data, &oar->ininfo, TRUE);
-    out = dlb_buffer_new_wrapped (outdata + outsize, &oar->outinfo, TRUE);
+    /* points into the upstream buffer when the block does not straddle
+     * buffers, otherwise into the adapter's reusable staging copy */
+    const guint8 *indata = gst_adapter_map (oar->adapter, insize);
 
     samples = insize / inbpf;
 
-    transform_data_block (oar, in, out, samples);
+    if (dlb_oar_idle_check (oar, indata, samples)) {
+      memset ((guint8 *) outdata + outsize, 0, samples * outbpf);
+      bypassed++;
+    } else {
+      dlb_oar_rebase_block (oar->inblock, &oar->inbase, indata);
+      dlb_oar_rebase_block (oar->outblock, &oar->outbase, outdata + outsize);
+
+      transform_data_block (oar, oar->inblock, oar->outblock, samples);
+    }
 
-    dlb_buffer_free (in);
-    dlb_buffer_free (out);
-    gst_buffer_unmap (inbuf, &inbuf_map);
-    gst_buffer_unref (inbuf);
+    gst_adapter_unmap (oar->adapter);
+    gst_adapter_flush (oar->adapter, insize);
+    dlb_oar_flush_oamd_offsets (oar, insize);
 
+    oar->audible_end -= MIN (oar->audible_end, insize);
+    oar->oamd_end -= MIN (oar->oamd_end, insize);
+
+    blocks++;
+    oar->blocks++;
     outsize += samples * outbpf;
     insize = get_next_block_size (oar);
   }
@@ -827,6 +1189,11 @@ dlb_oar_transform (GstBaseTransform * trans, GstBuffer * inbuf,
   gst_buffer_resize (outbuf, 0, outsize);
   gst_buffer_unmap (outbuf, &outbuf_map);
 
+  if (bypassed == blocks)
+    GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_GAP);
+  else
+    GST_BUFFER_FLAG_UNSET (outbuf, GST_BUFFER_FLAG_GAP);
+
   if (G_UNLIKELY (oar->prefill)) {
     outsize -= oar->latency;
     GST_DEBUG_OBJECT (oar, "Trimming latency from the output");
@@ -867,6 +1234,9 @@ oar_open (DlbOar * oar)
   oar->max_payloads = dlb_oar_query_max_payloads (oar->oar_instance);
   oar->oamd_payloads = g_new0 (dlb_oar_payload, oar->max_payloads);
 
+  oar->oamd_offsets =
+      g_array_sized_new (FALSE, FALSE, sizeof (gsize), oar->max_payloads);
+
   /* Initialize input buffer adapter */
   oar->adapter = gst_adapter_new ();
   return TRUE;
@@ -885,11 +1255,14 @@ oar_close (DlbOar * oar)
     dlb_oar_free (oar->oar_instance);
   if (oar->oamd_payloads)
     g_free (oar->oamd_payloads);
+  if (oar->oamd_offsets)
+    g_array_unref (oar->oamd_offsets);
   if (oar->adapter)
     g_object_unref (oar->adapter);
 
   oar->oar_instance = NULL;
   oar->oamd_payloads = NULL;
+  oar->oamd_offsets = NULL;
   oar->adapter = NULL;
 }
 
@@ -902,14 +1275,26 @@ oar_restart (DlbOar * oar)
   return oar_open (oar);
 }
 
+static GstStateChangeReturn
+dlb_oar_change_state (GstElement * element, GstStateChange transition)
+{
+#ifdef DLB_OAR_OPEN_DYNLIB
+  /* vendor library is bound by the first instance leaving NULL */
+  if (transition == GST_STATE_CHANGE_NULL_TO_READY
+      && dlb_oar_try_open_dynlib ()) {
+    GST_ELEMENT_ERROR (element, LIBRARY, INIT, (NULL),
+        ("Failed to load OAR library"));
+    return GST_STATE_CHANGE_FAILURE;
+  }
+#endif
+
+  return GST_ELEMENT_CLASS (dlb_oar_parent_class)->change_state (element,
+      transition);
+}
+
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  #ifdef DLB_OAR_OPEN_DYNLIB
-  if (dlb_oar_try_open_dynlib ())
-    return FALSE;
-  #endif
-
   if (!gst_element_register (plugin, "dlboar", GST_RANK_PRIMARY, DLB_TYPE_OAR))
     return FALSE;
 
@@ -23,6 +23,7 @@
 
 #include <gst/base/gstbasetransform.h>
 
+#include "dlbcapscache.h"
 #include "dlb_oar.h"
 
 G_BEGIN_DECLS
@@ -53,14 +54,41 @@ struct _DlbOar
   dlb_oar_payload *oamd_payloads;
   gint max_payloads;
 
+  /* pending payload positions in bytes from the adapter head, ascending */
+  GArray *oamd_offsets;
+
   /* Input buffer adapter */
   GstAdapter *adapter;
   gsize max_block_size;
   gsize min_block_size;
+  guint64 blocks;
+
+  /* block wrappers reused across blocks, rebased onto the data */
+  dlb_buffer *inblock;
+  dlb_buffer *outblock;
+  const guint8 *inbase;
+  const guint8 *outbase;
 
   /* Input/Output audio info */
   GstAudioInfo ininfo;
   GstAudioInfo outinfo;
+  /* samples in the library native format */
+  gboolean in_lfract;
+  gboolean out_lfract;
+
+  /* silence bypass */
+  gdouble silence_threshold;
+  GstClockTime idle_timeout;
+  gsize audible_end;
+  gsize oamd_end;
+  guint64 silent_samples;
+  gboolean idle;
+
+  /* channel based input passes through */
+  gboolean bypass;
+
+  /* transform_caps results */
+  DlbCapsCache *caps_cache;
 };
 
 struct _DlbOarClass
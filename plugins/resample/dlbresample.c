@@ -0,0 +1,689 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include <gst/gst.h>
+#include <gst/audio/audio.h>
+#include <gst/base/gstbasetransform.h>
+
+#include "dlbresample.h"
+
+GST_DEBUG_CATEGORY_STATIC (dlb_resample_debug_category);
+#define GST_CAT_DEFAULT dlb_resample_debug_category
+
+/* Kaiser windowed sinc, ~70 dB stopband, passband up to 90% of the input
+ * Nyquist frequency */
+#define DLB_RESAMPLE_TAPS 96
+#define DLB_RESAMPLE_ROLLOFF 0.9
+#define DLB_RESAMPLE_KAISER_BETA 7.0
+
+#define DLB_RESAMPLE_MAX_CHANNELS 32
+
+#define ALLOWED_SRC_CAPS                                                \
+  "audio/x-raw, "                                                       \
+  "format = (string) "GST_AUDIO_NE (F32)", "                            \
+  "channels = (int) [ 1, 32 ], "                                        \
+  "rate = (int) 48000, "                                                \
+  "layout = (string) interleaved"
+
+#define ALLOWED_SINK_CAPS                                               \
+  "audio/x-raw, "                                                       \
+  "format = (string) "GST_AUDIO_NE (F32)", "                            \
+  "channels = (int) [ 1, 32 ], "                                        \
+  "rate = (int) { 48000, 32000, 44100 }, "                              \
+  "layout = (string) interleaved"
+
+/* prototypes */
+static GstCaps *dlb_resample_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter);
+static gboolean dlb_resample_set_caps (GstBaseTransform * trans,
+    GstCaps * incaps, GstCaps * outcaps);
+static gboolean dlb_resample_query (GstBaseTransform * trans,
+    GstPadDirection direction, GstQuery * query);
+static gboolean dlb_resample_transform_size (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, gsize size, GstCaps * othercaps,
+    gsize * othersize);
+static gboolean dlb_resample_start (GstBaseTransform * trans);
+static gboolean dlb_resample_stop (GstBaseTransform * trans);
+static gboolean dlb_resample_sink_event (GstBaseTransform * trans,
+    GstEvent * event);
+static GstFlowReturn dlb_resample_transform (GstBaseTransform * trans,
+    GstBuffer * inbuf, GstBuffer * outbuf);
+static void dlb_resample_finalize (GObject * object);
+
+/* pad templates */
+static GstStaticPadTemplate dlb_resample_src_template =
+GST_STATIC_PAD_TEMPLATE ("src",
+    GST_PAD_SRC,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (ALLOWED_SRC_CAPS)
+    );
+
+static GstStaticPadTemplate dlb_resample_sink_template =
+GST_STATIC_PAD_TEMPLATE ("sink",
+    GST_PAD_SINK,
+    GST_PAD_ALWAYS,
+    GST_STATIC_CAPS (ALLOWED_SINK_CAPS)
+    );
+
+/* class initialization */
+
+G_DEFINE_TYPE_WITH_CODE (DlbResample, dlb_resample, GST_TYPE_BASE_TRANSFORM,
+    GST_DEBUG_CATEGORY_INIT (dlb_resample_debug_category, "dlbresample", 0,
+        "debug category for resample element"));
+
+static void
+dlb_resample_class_init (DlbResampleClass * klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+  GstBaseTransformClass *base_transform_class =
+      GST_BASE_TRANSFORM_CLASS (klass);
+
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_resample_src_template);
+  gst_element_class_add_static_pad_template (GST_ELEMENT_CLASS (klass),
+      &dlb_resample_sink_template);
+
+  gst_element_class_set_static_metadata (GST_ELEMENT_CLASS (klass),
+      "Dolby rate converter", "Filter/Converter/Audio",
+      "Converts 32 kHz and 44.1 kHz audio to the 48 kHz rendering rate",
+      "Dolby Support <support@dolby.com>");
+
+  gobject_class->finalize = GST_DEBUG_FUNCPTR (dlb_resample_finalize);
+  base_transform_class->transform_caps =
+      GST_DEBUG_FUNCPTR (dlb_resample_transform_caps);
+  base_transform_class->set_caps = GST_DEBUG_FUNCPTR (dlb_resample_set_caps);
+  base_transform_class->query = GST_DEBUG_FUNCPTR (dlb_resample_query);
+  base_transform_class->transform_size =
+      GST_DEBUG_FUNCPTR (dlb_resample_transform_size);
+  base_transform_class->start = GST_DEBUG_FUNCPTR (dlb_resample_start);
+  base_transform_class->stop = GST_DEBUG_FUNCPTR (dlb_resample_stop);
+  base_transform_class->sink_event =
+      GST_DEBUG_FUNCPTR (dlb_resample_sink_event);
+  base_transform_class->transform = GST_DEBUG_FUNCPTR (dlb_resample_transform);
+}
+
+static void
+dlb_resample_init (DlbResample * resample)
+{
+  gst_audio_info_init (&resample->ininfo);
+  gst_audio_info_init (&resample->outinfo);
+
+  resample->up = 1;
+  resample->down = 1;
+  resample->taps = DLB_RESAMPLE_TAPS;
+  resample->table = NULL;
+  resample->staging = NULL;
+  resample->staging_frames = 0;
+  resample->pos = 0;
+  resample->base_ts = GST_CLOCK_TIME_NONE;
+  resample->base_offset = 0;
+  resample->out_samples = 0;
+}
+
+static void
+dlb_resample_finalize (GObject * object)
+{
+  DlbResample *resample = DLB_RESAMPLE (object);
+
+  g_free (resample->table);
+  g_free (resample->staging);
+
+  G_OBJECT_CLASS (dlb_resample_parent_class)->finalize (object);
+}
+
+/* filter design */
+static gdouble
+bessel_i0 (gdouble x)
+{
+  gdouble sum = 1.0, term = 1.0;
+  gint k;
+
+  for (k = 1; k < 64 && term > 1e-12 * sum; ++k) {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+
+  return sum;
+}
+
+/* designs the prototype lowpass at up times the input rate and splits it
+ * into up phases. Coefficients of each phase are stored in reverse, so they
+ * run along the input in memory order, and normalized for unity DC gain. */
+static void
+dlb_resample_design (gfloat * table, gint up, gint down, gint taps)
+{
+  gint len = taps * up;
+  gdouble fc = DLB_RESAMPLE_ROLLOFF * 0.5 / MAX (up, down);
+  gdouble center = (len - 1) / 2.0;
+  gdouble norm = bessel_i0 (DLB_RESAMPLE_KAISER_BETA);
+  gdouble *h = g_new (gdouble, len);
+  gint t, p, k;
+
+  for (t = 0; t < len; ++t) {
+    gdouble x = t - center;
+    gdouble r = 2.0 * t / (len - 1) - 1.0;
+    gdouble sinc = x == 0.0 ? 2.0 * fc : sin (2.0 * G_PI * fc * x) / (G_PI * x);
+
+    h[t] = sinc * bessel_i0 (DLB_RESAMPLE_KAISER_BETA * sqrt (1.0 - r * r)) /
+        norm;
+  }
+
+  for (p = 0; p < up; ++p) {
+    gdouble sum = 0.0;
+
+    for (k = 0; k < taps; ++k)
+      sum += h[k * up + p];
+
+    for (k = 0; k < taps; ++k)
+      table[p * taps + k] = h[(taps - 1 - k) * up + p] / sum;
+  }
+
+  g_free (h);
+}
+
+/* FIR kernels, x points to the oldest of taps interleaved frames. Loops are
+ * laid out for the compiler to vectorize: independent accumulators for mono,
+ * two frames per step for stereo and along channels otherwise. */
+static inline void
+fir_mono (gfloat * out, const gfloat * x, const gfloat * h, gint taps)
+{
+  gfloat acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  gint k, i;
+
+  for (k = 0; k < taps; k += 4) {
+    for (i = 0; i < 4; ++i)
+      acc[i] += h[k + i] * x[k + i];
+  }
+
+  out[0] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+static inline void
+fir_stereo (gfloat * out, const gfloat * x, const gfloat * h, gint taps)
+{
+  gfloat acc[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+  gint k;
+
+  for (k = 0; k < taps; k += 2) {
+    acc[0] += h[k] * x[2 * k];
+    acc[1] += h[k] * x[2 * k + 1];
+    acc[2] += h[k + 1] * x[2 * k + 2];
+    acc[3] += h[k + 1] * x[2 * k + 3];
+  }
+
+  out[0] = acc[0] + acc[2];
+  out[1] = acc[1] + acc[3];
+}
+
+static inline void
+fir_interleaved (gfloat * out, const gfloat * x, const gfloat * h, gint taps,
+    gint channels)
+{
+  gfloat acc[DLB_RESAMPLE_MAX_CHANNELS] = { 0.0f };
+  gint k, c;
+
+  for (k = 0; k < taps; ++k) {
+    const gfloat coef = h[k];
+    const gfloat *frame = x + k * channels;
+
+    for (c = 0; c < channels; ++c)
+      acc[c] += coef * frame[c];
+  }
+
+  memcpy (out, acc, channels * sizeof (gfloat));
+}
+
+static gsize
+dlb_resample_process (DlbResample * resample, const gfloat * in, gsize frames,
+    gfloat * out)
+{
+  gint channels = GST_AUDIO_INFO_CHANNELS (&resample->ininfo);
+  gint taps = resample->taps;
+  gsize history = taps - 1;
+  gsize produced = 0;
+
+  if (resample->staging_frames < history + frames) {
+    resample->staging = g_realloc (resample->staging,
+        (history + frames) * channels * sizeof (gfloat));
+    resample->staging_frames = history + frames;
+  }
+
+  memcpy (resample->staging + history * channels, in,
+      frames * channels * sizeof (gfloat));
+
+  while (resample->pos / resample->up < frames) {
+    gsize base = resample->pos / resample->up;
+    const gfloat *x = resample->staging + base * channels;
+    const gfloat *h = resample->table + (resample->pos % resample->up) * taps;
+    gfloat *y = out + produced * channels;
+
+    switch (channels) {
+      case 1:
+        fir_mono (y, x, h, taps);
+        break;
+      case 2:
+        fir_stereo (y, x, h, taps);
+        break;
+      default:
+        fir_interleaved (y, x, h, taps, channels);
+        break;
+    }
+
+    produced++;
+    resample->pos += resample->down;
+  }
+
+  resample->pos -= (guint64) frames * resample->up;
+
+  memmove (resample->staging, resample->staging + frames * channels,
+      history * channels * sizeof (gfloat));
+
+  return produced;
+}
+
+static void
+dlb_resample_reset (DlbResample * resample)
+{
+  if (resample->staging)
+    memset (resample->staging, 0, resample->staging_frames *
+        GST_AUDIO_INFO_BPF (&resample->ininfo));
+
+  resample->pos = 0;
+  resample->base_ts = GST_CLOCK_TIME_NONE;
+  resample->base_offset = 0;
+  resample->out_samples = 0;
+}
+
+/* group delay of the filter in input samples, rounded up */
+static gint
+dlb_resample_latency_samples (DlbResample * resample)
+{
+  return resample->taps / 2;
+}
+
+static GstClockTime
+dlb_resample_latency_time (DlbResample * resample)
+{
+  return gst_util_uint64_scale_round (resample->taps * resample->up - 1,
+      GST_SECOND, 2 * resample->up * GST_AUDIO_INFO_RATE (&resample->ininfo));
+}
+
+static GstCaps *
+dlb_resample_transform_caps (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, GstCaps * filter)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  GstCaps *othercaps, *tmpl;
+  guint i;
+
+  if (direction == GST_PAD_SRC) {
+    /* transform caps going upstream */
+    tmpl = gst_static_pad_template_get_caps (&dlb_resample_sink_template);
+  } else {
+    /* transform caps going downstream */
+    tmpl = gst_static_pad_template_get_caps (&dlb_resample_src_template);
+  }
+
+  /* everything but rate passes through */
+  othercaps = gst_caps_copy (caps);
+  for (i = 0; i < gst_caps_get_size (othercaps); ++i)
+    gst_structure_remove_field (gst_caps_get_structure (othercaps, i), "rate");
+
+  othercaps = gst_caps_intersect_full (othercaps, tmpl,
+      GST_CAPS_INTERSECT_FIRST);
+  gst_caps_unref (tmpl);
+
+  GST_DEBUG_OBJECT (resample,
+      "transformed %" GST_PTR_FORMAT " into %" GST_PTR_FORMAT, caps, othercaps);
+
+  if (filter) {
+    GstCaps *intersect;
+
+    GST_DEBUG_OBJECT (resample, "Using filter caps %" GST_PTR_FORMAT, filter);
+    intersect = gst_caps_intersect (othercaps, filter);
+    gst_caps_unref (othercaps);
+    GST_DEBUG_OBJECT (resample, "Intersection %" GST_PTR_FORMAT, intersect);
+
+    return intersect;
+  } else {
+    return othercaps;
+  }
+}
+
+static gint
+gcd (gint a, gint b)
+{
+  while (b) {
+    gint t = a % b;
+    a = b;
+    b = t;
+  }
+
+  return a;
+}
+
+static gboolean
+dlb_resample_set_caps (GstBaseTransform * trans, GstCaps * incaps,
+    GstCaps * outcaps)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  GstAudioInfo in, out;
+  gint div;
+
+  GST_DEBUG_OBJECT (resample, "incaps %" GST_PTR_FORMAT ", outcaps %"
+      GST_PTR_FORMAT, incaps, outcaps);
+
+  if (!gst_audio_info_from_caps (&in, incaps))
+    goto incaps_error;
+  if (!gst_audio_info_from_caps (&out, outcaps))
+    goto outcaps_error;
+
+  div = gcd (in.rate, out.rate);
+
+  resample->ininfo = in;
+  resample->outinfo = out;
+  resample->up = out.rate / div;
+  resample->down = in.rate / div;
+
+  g_free (resample->table);
+  g_free (resample->staging);
+  resample->table = NULL;
+  resample->staging = NULL;
+  resample->staging_frames = 0;
+
+  gst_base_transform_set_passthrough (trans, in.rate == out.rate);
+
+  if (in.rate != out.rate) {
+    resample->table = g_new (gfloat, resample->up * resample->taps);
+    dlb_resample_design (resample->table, resample->up, resample->down,
+        resample->taps);
+
+    resample->staging_frames = resample->taps - 1;
+    resample->staging = g_new0 (gfloat, resample->staging_frames * in.channels);
+  }
+
+  GST_INFO_OBJECT (resample, "converting %d Hz to %d Hz, %d phases of %d taps",
+      in.rate, out.rate, resample->up, resample->taps);
+
+  dlb_resample_reset (resample);
+  return TRUE;
+
+  /* ERROR */
+incaps_error:
+  GST_ERROR_OBJECT (trans, "invalid incaps");
+  return FALSE;
+
+outcaps_error:
+  GST_ERROR_OBJECT (trans, "invalid outcaps");
+  return FALSE;
+}
+
+static gboolean
+dlb_resample_query (GstBaseTransform * trans, GstPadDirection direction,
+    GstQuery * query)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+
+  switch (GST_QUERY_TYPE (query)) {
+    case GST_QUERY_LATENCY:{
+      if ((gst_pad_peer_query (GST_BASE_TRANSFORM_SINK_PAD (trans), query))) {
+        GstClockTime min, max, latency;
+        gboolean live;
+
+        if (!GST_AUDIO_INFO_RATE (&resample->ininfo))
+          return FALSE;
+
+        latency = dlb_resample_latency_time (resample);
+
+        if (gst_base_transform_is_passthrough (trans))
+          latency = 0;
+
+        gst_query_parse_latency (query, &live, &min, &max);
+
+        GST_DEBUG_OBJECT (resample, "Peer latency: min %"
+            GST_TIME_FORMAT " max %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (min), GST_TIME_ARGS (max));
+
+        /* add our own latency */
+        GST_DEBUG_OBJECT (resample, "Our latency: %" GST_TIME_FORMAT,
+            GST_TIME_ARGS (latency));
+        min += latency;
+        if (GST_CLOCK_TIME_IS_VALID (max))
+          max += latency;
+
+        gst_query_set_latency (query, live, min, max);
+      }
+
+      return TRUE;
+    }
+    default:{
+      return GST_BASE_TRANSFORM_CLASS (dlb_resample_parent_class)->query
+          (trans, direction, query);
+    }
+  }
+}
+
+static gboolean
+dlb_resample_transform_size (GstBaseTransform * trans,
+    GstPadDirection direction, GstCaps * caps, gsize size, GstCaps * othercaps,
+    gsize * othersize)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  gint inbpf = GST_AUDIO_INFO_BPF (&resample->ininfo);
+  gint outbpf = GST_AUDIO_INFO_BPF (&resample->outinfo);
+
+  if (!inbpf || !outbpf)
+    return FALSE;
+
+  if (GST_PAD_SRC == direction) {
+    *othersize = gst_util_uint64_scale_int_ceil (size / outbpf,
+        resample->down, resample->up) * inbpf;
+  } else {
+    /* one more frame for the fractional position carried over */
+    *othersize = (gst_util_uint64_scale_int_ceil (size / inbpf,
+            resample->up, resample->down) + 1) * outbpf;
+  }
+
+  GST_LOG_OBJECT (resample, "transform_size: %" G_GSIZE_FORMAT, *othersize);
+
+  return TRUE;
+}
+
+/* states */
+static gboolean
+dlb_resample_start (GstBaseTransform * trans)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  GST_DEBUG_OBJECT (resample, "start");
+
+  dlb_resample_reset (resample);
+  return TRUE;
+}
+
+static gboolean
+dlb_resample_stop (GstBaseTransform * trans)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  GST_DEBUG_OBJECT (resample, "stop");
+
+  g_free (resample->table);
+  g_free (resample->staging);
+  resample->table = NULL;
+  resample->staging = NULL;
+  resample->staging_frames = 0;
+
+  gst_audio_info_init (&resample->ininfo);
+  gst_audio_info_init (&resample->outinfo);
+
+  return TRUE;
+}
+
+static void
+dlb_resample_set_output_timing (DlbResample * resample, GstBuffer * outbuf,
+    gsize samples)
+{
+  gint rate = GST_AUDIO_INFO_RATE (&resample->outinfo);
+  guint64 offset = resample->base_offset + resample->out_samples;
+
+  if (GST_CLOCK_TIME_IS_VALID (resample->base_ts)) {
+    GST_BUFFER_PTS (outbuf) = resample->base_ts +
+        gst_util_uint64_scale_int (resample->out_samples, GST_SECOND, rate);
+    GST_BUFFER_DURATION (outbuf) = resample->base_ts +
+        gst_util_uint64_scale_int (resample->out_samples + samples,
+        GST_SECOND, rate) - GST_BUFFER_PTS (outbuf);
+  } else {
+    GST_BUFFER_PTS (outbuf) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DURATION (outbuf) =
+        gst_util_uint64_scale_int (samples, GST_SECOND, rate);
+  }
+
+  GST_BUFFER_OFFSET (outbuf) = offset;
+  GST_BUFFER_OFFSET_END (outbuf) = offset + samples;
+
+  resample->out_samples += samples;
+}
+
+/* pushes the filter tail out, so no input is lost at the end of stream */
+static GstFlowReturn
+dlb_resample_push_drain (DlbResample * resample)
+{
+  GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (resample);
+  gint channels = GST_AUDIO_INFO_CHANNELS (&resample->ininfo);
+  gsize frames = dlb_resample_latency_samples (resample) + 1;
+  gsize outframes;
+  GstBuffer *outbuf;
+  GstMapInfo outmap;
+  gfloat *zeros;
+  GstFlowReturn ret;
+
+  zeros = g_new0 (gfloat, frames * channels);
+  outbuf = gst_buffer_new_allocate (NULL, (gst_util_uint64_scale_int_ceil
+          (frames, resample->up, resample->down) + 1) *
+      GST_AUDIO_INFO_BPF (&resample->outinfo), NULL);
+
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+  outframes = dlb_resample_process (resample, zeros, frames,
+      (gfloat *) outmap.data);
+  gst_buffer_unmap (outbuf, &outmap);
+  g_free (zeros);
+
+  gst_buffer_set_size (outbuf, outframes *
+      GST_AUDIO_INFO_BPF (&resample->outinfo));
+  dlb_resample_set_output_timing (resample, outbuf, outframes);
+
+  GST_DEBUG_OBJECT (resample, "Draining %" G_GSIZE_FORMAT " samples",
+      outframes);
+
+  ret = gst_pad_push (GST_BASE_TRANSFORM_SRC_PAD (trans), outbuf);
+  if (ret != GST_FLOW_OK)
+    GST_WARNING_OBJECT (resample, "Pushing failed: %s",
+        gst_flow_get_name (ret));
+
+  return ret;
+}
+
+/* sink pad event handlers */
+static gboolean
+dlb_resample_sink_event (GstBaseTransform * trans, GstEvent * event)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+
+  GST_DEBUG_OBJECT (resample, "sink_event");
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      if (resample->table && GST_CLOCK_TIME_IS_VALID (resample->base_ts) &&
+          !gst_base_transform_is_passthrough (trans))
+        dlb_resample_push_drain (resample);
+      break;
+    case GST_EVENT_FLUSH_STOP:
+      dlb_resample_reset (resample);
+      break;
+    default:
+      break;
+  }
+
+  return GST_BASE_TRANSFORM_CLASS (dlb_resample_parent_class)->sink_event
+      (trans, event);
+}
+
+/* transform */
+static GstFlowReturn
+dlb_resample_transform (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer * outbuf)
+{
+  DlbResample *resample = DLB_RESAMPLE (trans);
+  GstMapInfo inmap, outmap;
+  gsize frames, outframes;
+
+  if (GST_BUFFER_IS_DISCONT (inbuf)
+      || !GST_CLOCK_TIME_IS_VALID (resample->base_ts)) {
+    GST_DEBUG_OBJECT (resample, "Discontinuity, restarting filter");
+
+    dlb_resample_reset (resample);
+    resample->base_ts = GST_BUFFER_PTS (inbuf);
+
+    if (GST_BUFFER_OFFSET_IS_VALID (inbuf))
+      resample->base_offset = gst_util_uint64_scale_int (GST_BUFFER_OFFSET
+          (inbuf), resample->up, resample->down);
+  }
+
+  gst_buffer_map (inbuf, &inmap, GST_MAP_READ);
+  gst_buffer_map (outbuf, &outmap, GST_MAP_WRITE);
+
+  frames = inmap.size / GST_AUDIO_INFO_BPF (&resample->ininfo);
+  outframes = dlb_resample_process (resample, (const gfloat *) inmap.data,
+      frames, (gfloat *) outmap.data);
+
+  gst_buffer_unmap (outbuf, &outmap);
+  gst_buffer_unmap (inbuf, &inmap);
+
+  gst_buffer_set_size (outbuf, outframes *
+      GST_AUDIO_INFO_BPF (&resample->outinfo));
+  dlb_resample_set_output_timing (resample, outbuf, outframes);
+
+  GST_LOG_OBJECT (resample, "inbuf %" GST_PTR_FORMAT ", outbuf %"
+      GST_PTR_FORMAT, inbuf, outbuf);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean
+plugin_init (GstPlugin * plugin)
+{
+  if (!gst_element_register (plugin, "dlbresample", GST_RANK_NONE,
+          DLB_TYPE_RESAMPLE))
+    return FALSE;
+
+  return TRUE;
+}
+
+GST_PLUGIN_DEFINE (GST_VERSION_MAJOR,
+    GST_VERSION_MINOR,
+    dlbresample,
+    "Rate converter for Dolby rendering", plugin_init, VERSION, LICENSE,
+    PACKAGE, ORIGIN)
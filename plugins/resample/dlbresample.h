@@ -0,0 +1,73 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _DLB_RESAMPLE_H
+#define _DLB_RESAMPLE_H
+
+#include <gst/base/gstbasetransform.h>
+#include <gst/audio/audio.h>
+
+G_BEGIN_DECLS
+#define DLB_TYPE_RESAMPLE   (dlb_resample_get_type())
+#define DLB_RESAMPLE(obj)   (G_TYPE_CHECK_INSTANCE_CAST((obj),DLB_TYPE_RESAMPLE,DlbResample))
+#define DLB_RESAMPLE_CLASS(klass)   (G_TYPE_CHECK_CLASS_CAST((klass),DLB_TYPE_RESAMPLE,DlbResampleClass))
+#define DLB_IS_RESAMPLE(obj)   (G_TYPE_CHECK_INSTANCE_TYPE((obj),DLB_TYPE_RESAMPLE))
+#define DLB_IS_RESAMPLE_CLASS(obj)   (G_TYPE_CHECK_CLASS_TYPE((klass),DLB_TYPE_RESAMPLE))
+typedef struct _DlbResample DlbResample;
+typedef struct _DlbResampleClass DlbResampleClass;
+
+struct _DlbResample
+{
+  GstBaseTransform base_resample;
+
+  /* Input/Output audio info */
+  GstAudioInfo ininfo;
+  GstAudioInfo outinfo;
+
+  /* conversion ratio up / down, reduced */
+  gint up;
+  gint down;
+
+  /* polyphase filter, up phases of taps coefficients each */
+  gint taps;
+  gfloat *table;
+
+  /* taps - 1 frames of history followed by the current input */
+  gfloat *staging;
+  gsize staging_frames;
+
+  /* next output position in 1 / up input frames */
+  guint64 pos;
+
+  /* output timing */
+  GstClockTime base_ts;
+  guint64 base_offset;
+  guint64 out_samples;
+};
+
+struct _DlbResampleClass
+{
+  GstBaseTransformClass base_resample_class;
+};
+
+GType dlb_resample_get_type (void);
+
+G_END_DECLS
+#endif
@@ -45,6 +45,12 @@ ac3_type_find (GstTypeFind * tf, gpointer unused)
   gboolean eac;
   const guint8 *data;
 
+#ifdef DLB_AUDIO_PARSER_OPEN_DYNLIB
+  /* bound on first use, registry scans don't load the library */
+  if (dlb_audio_parser_try_open_dynlib ())
+    return;
+#endif
+
   parser = dlb_audio_parser_new (DLB_AUDIO_PARSER_TYPE_AC3);
   frmsize = dlb_audio_parser_query_min_frame_size (parser);
   data = gst_type_find_peek (tf, 0, frmsize);
@@ -78,11 +84,6 @@ ac3_type_find (GstTypeFind * tf, gpointer unused)
 static gboolean
 plugin_init (GstPlugin * plugin)
 {
-  #ifdef DLB_AUDIO_PARSER_OPEN_DYNLIB
-  if (dlb_audio_parser_try_open_dynlib())
-    return FALSE;
-  #endif
-
   GST_DEBUG_CATEGORY_INIT (dlb_type_find_debug, "dlbtypefindfunctions", 0,
       "Dolby specific type find functions");
 
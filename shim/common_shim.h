@@ -28,6 +28,7 @@
 
 #if defined(HAVE_DLADDR)
  #include <dlfcn.h>
+ #include <pthread.h>
 #elif defined(HAVE_WINAPI)
  #include <Windows.h>
 #else
@@ -36,6 +37,11 @@
 
 
 #include <assert.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 static inline void *
 get_proc_address (void *lib, const char *name)
@@ -50,11 +56,13 @@ get_proc_address (void *lib, const char *name)
 #endif
 }
 
+/* the loader keeps one handle per process, elements of all plugins linking
+ * the same shim share it */
 static inline void *
 open_dynamic_lib (const char *name)
 {
 #if defined(HAVE_DLADDR)
-  void *lib = dlopen (name, RTLD_NOW | RTLD_LOCAL);
+  void *lib = dlopen (name, RTLD_LAZY | RTLD_LOCAL);
 #elif defined(HAVE_WINAPI)
   void *lib = LoadLibrary(name);
 #endif
@@ -65,4 +73,362 @@ open_dynamic_lib (const char *name)
   return lib;
 }
 
+static inline void
+close_dynamic_lib (void *lib)
+{
+#if defined(HAVE_DLADDR)
+  dlclose (lib);
+#elif defined(HAVE_WINAPI)
+  FreeLibrary ((HMODULE) lib);
+#endif
+}
+
+/* run once per process, whichever thread gets there first */
+#if defined(HAVE_DLADDR)
+typedef pthread_once_t shim_once;
+#define SHIM_ONCE_INIT PTHREAD_ONCE_INIT
+
+static inline void
+shim_call_once (shim_once * once, void (*func) (void))
+{
+  pthread_once (once, func);
+}
+#elif defined(HAVE_WINAPI)
+typedef INIT_ONCE shim_once;
+#define SHIM_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+static BOOL CALLBACK
+shim_once_callback (PINIT_ONCE once, PVOID param, PVOID *context)
+{
+  ((void (*) (void)) param) ();
+  return TRUE;
+}
+
+static inline void
+shim_call_once (shim_once * once, void (*func) (void))
+{
+  InitOnceExecuteOnce (once, shim_once_callback, (PVOID) func, NULL);
+}
+#endif
+
+typedef struct shim_symbol_s
+{
+  const char *name;
+  size_t offset;
+} shim_symbol;
+
+/* dispatch table entry named after the library function it points to */
+#define SHIM_SYMBOL(table, prefix, field) \
+  { prefix #field, offsetof (table, field) }
+
+/**
+ * bind_dynamic_lib:
+ * @name: library to open
+ * @symbols: symbols to resolve
+ * @count: number of @symbols
+ * @table: dispatch table filled with the resolved symbols
+ * @size: size of @table
+ *
+ * Resolves all symbols or none, @table is left zeroed when the library
+ * can't be opened or misses any of them.
+ *
+ * returns: 0 on success
+ */
+static inline int
+bind_dynamic_lib (const char *name, const shim_symbol * symbols, size_t count,
+    void *table, size_t size)
+{
+  void *lib = open_dynamic_lib (name);
+  size_t i;
+
+  if (!lib)
+    return 1;
+
+  for (i = 0; i < count; ++i) {
+    void *sym = get_proc_address (lib, symbols[i].name);
+
+    if (!sym) {
+      memset (table, 0, size);
+      close_dynamic_lib (lib);
+      return 1;
+    }
+
+    memcpy ((char *) table + symbols[i].offset, &sym, sizeof (sym));
+  }
+
+  return 0;
+}
+
+/* Call statistics, enabled by setting SHIM_STATS_ENV to anything but "0".
+ * Every thread counts into a block of its own, blocks are pushed on a
+ * lock-free list and handed over to new threads when their owner exits, so
+ * counts outlive the threads that made them. Readers sum up all blocks. */
+#define SHIM_STATS_ENV "DLB_SHIM_STATS"
+
+/* bucket i counts calls of [2^i, 2^(i+1)) ns, the last one anything longer */
+#define SHIM_STATS_BUCKETS 32
+
+#if defined(HAVE_DLADDR)
+typedef pthread_key_t shim_tls;
+#elif defined(HAVE_WINAPI)
+typedef DWORD shim_tls;
+#endif
+
+typedef unsigned long long shim_stamp;
+
+typedef struct shim_counter_s
+{
+  unsigned long long calls;
+  unsigned long long total_ns;
+  unsigned long long buckets[SHIM_STATS_BUCKETS];
+} shim_counter;
+
+typedef struct shim_stats_block_s
+{
+  struct shim_stats_block_s *next;
+  int in_use;
+  shim_counter counters[];
+} shim_stats_block;
+
+typedef struct shim_stats_s
+{
+  const shim_symbol *symbols;
+  size_t count;
+  size_t slots;
+  int enabled;
+  shim_tls key;
+  shim_stats_block *blocks;
+} shim_stats;
+
+/* dispatch tables hold function pointers only, the field offset gives the
+ * counter slot */
+#define SHIM_SLOT(table, field) \
+  (offsetof (table, field) / sizeof (void (*) (void)))
+
+/* times @call when statistics are enabled */
+#define SHIM_TIMED(stats, slot, call) \
+  do { \
+    shim_stamp _start = shim_stats_begin (stats); \
+    call; \
+    shim_stats_end (stats, slot, _start); \
+  } while (0)
+
+static inline shim_stamp
+shim_clock_ns (void)
+{
+#if defined(HAVE_DLADDR)
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (shim_stamp) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#elif defined(HAVE_WINAPI)
+  LARGE_INTEGER count, freq;
+
+  QueryPerformanceCounter (&count);
+  QueryPerformanceFrequency (&freq);
+  return (shim_stamp) (count.QuadPart / freq.QuadPart) * 1000000000ULL +
+      (shim_stamp) (count.QuadPart % freq.QuadPart) * 1000000000ULL /
+      freq.QuadPart;
+#endif
+}
+
+/* thread exit, the block is left for the next thread to claim */
+#if defined(HAVE_DLADDR)
+static void
+shim_stats_release (void *block)
+#elif defined(HAVE_WINAPI)
+static VOID WINAPI
+shim_stats_release (PVOID block)
+#endif
+{
+  if (block)
+    __atomic_store_n (&((shim_stats_block *) block)->in_use, 0,
+        __ATOMIC_RELEASE);
+}
+
+/**
+ * shim_stats_init:
+ * @stats: statistics of a bound library
+ * @symbols: symbols of the dispatch table
+ * @count: number of @symbols
+ * @size: size of the dispatch table
+ *
+ * Enables @stats if requested through SHIM_STATS_ENV.
+ *
+ * returns: non-zero if statistics are enabled
+ */
+static inline int
+shim_stats_init (shim_stats * stats, const shim_symbol * symbols,
+    size_t count, size_t size)
+{
+  const char *env = getenv (SHIM_STATS_ENV);
+
+  if (!env || !strcmp (env, "0"))
+    return 0;
+
+#if defined(HAVE_DLADDR)
+  if (pthread_key_create (&stats->key, shim_stats_release))
+    return 0;
+#elif defined(HAVE_WINAPI)
+  stats->key = FlsAlloc (shim_stats_release);
+  if (stats->key == FLS_OUT_OF_INDEXES)
+    return 0;
+#endif
+
+  stats->symbols = symbols;
+  stats->count = count;
+  stats->slots = size / sizeof (void (*) (void));
+  stats->enabled = 1;
+  return 1;
+}
+
+static inline shim_counter *
+shim_stats_counters (shim_stats * stats)
+{
+  shim_stats_block *block, *head;
+
+#if defined(HAVE_DLADDR)
+  block = pthread_getspecific (stats->key);
+#elif defined(HAVE_WINAPI)
+  block = FlsGetValue (stats->key);
+#endif
+  if (block)
+    return block->counters;
+
+  for (block = __atomic_load_n (&stats->blocks, __ATOMIC_ACQUIRE); block;
+      block = block->next) {
+    int unused = 0;
+
+    if (__atomic_compare_exchange_n (&block->in_use, &unused, 1, 0,
+            __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+      goto claimed;
+  }
+
+  block = calloc (1, sizeof (*block) + stats->slots * sizeof (shim_counter));
+  if (!block)
+    return NULL;
+
+  block->in_use = 1;
+  head = __atomic_load_n (&stats->blocks, __ATOMIC_RELAXED);
+  do {
+    block->next = head;
+  } while (!__atomic_compare_exchange_n (&stats->blocks, &head, block, 1,
+          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+claimed:
+#if defined(HAVE_DLADDR)
+  pthread_setspecific (stats->key, block);
+#elif defined(HAVE_WINAPI)
+  FlsSetValue (stats->key, block);
+#endif
+  return block->counters;
+}
+
+static inline shim_stamp
+shim_stats_begin (const shim_stats * stats)
+{
+  return stats->enabled ? shim_clock_ns () : 0;
+}
+
+/* counters are only written by their owner, relaxed stores keep readers
+ * from seeing torn values */
+static inline void
+shim_stats_end (shim_stats * stats, size_t slot, shim_stamp start)
+{
+  shim_counter *counter;
+  shim_stamp ns;
+  int bucket = 0;
+
+  if (!stats->enabled)
+    return;
+
+  ns = shim_clock_ns () - start;
+  counter = shim_stats_counters (stats);
+  if (!counter)
+    return;
+
+  counter += slot;
+  while (bucket < SHIM_STATS_BUCKETS - 1 && ns >> (bucket + 1))
+    ++bucket;
+
+  __atomic_store_n (&counter->calls, counter->calls + 1, __ATOMIC_RELAXED);
+  __atomic_store_n (&counter->total_ns, counter->total_ns + ns,
+      __ATOMIC_RELAXED);
+  __atomic_store_n (&counter->buckets[bucket], counter->buckets[bucket] + 1,
+      __ATOMIC_RELAXED);
+}
+
+/**
+ * shim_stats_read:
+ * @stats: library statistics
+ * @index: symbol index
+ * @name: (out): symbol name
+ * @calls: (out): number of calls
+ * @total_ns: (out): time spent in the calls
+ * @buckets: (out caller-allocates): latency histogram
+ * @nbuckets: size of @buckets, calls past the last bucket are counted in it
+ *
+ * Sums up the counters of all threads.
+ *
+ * returns: 0 on success, non-zero if @index is out of range or statistics
+ *     are disabled
+ */
+static inline int
+shim_stats_read (shim_stats * stats, int index, const char **name,
+    unsigned long long *calls, unsigned long long *total_ns,
+    unsigned long long *buckets, int nbuckets)
+{
+  const shim_stats_block *block;
+  size_t slot;
+  int i;
+
+  if (!stats->enabled || index < 0 || (size_t) index >= stats->count
+      || nbuckets < 1)
+    return 1;
+
+  slot = stats->symbols[index].offset / sizeof (void (*) (void));
+  *name = stats->symbols[index].name;
+  *calls = 0;
+  *total_ns = 0;
+  memset (buckets, 0, nbuckets * sizeof (*buckets));
+
+  for (block = __atomic_load_n (&stats->blocks, __ATOMIC_ACQUIRE); block;
+      block = block->next) {
+    const shim_counter *counter = &block->counters[slot];
+
+    *calls += __atomic_load_n (&counter->calls, __ATOMIC_RELAXED);
+    *total_ns += __atomic_load_n (&counter->total_ns, __ATOMIC_RELAXED);
+
+    for (i = 0; i < SHIM_STATS_BUCKETS; ++i)
+      buckets[i < nbuckets ? i : nbuckets - 1] +=
+          __atomic_load_n (&counter->buckets[i], __ATOMIC_RELAXED);
+  }
+
+  return 0;
+}
+
+/* prints functions called at least once with their non-empty buckets */
+static inline void
+shim_stats_dump (shim_stats * stats)
+{
+  unsigned long long calls, total_ns, buckets[SHIM_STATS_BUCKETS];
+  const char *name;
+  int index, i;
+
+  for (index = 0; !shim_stats_read (stats, index, &name, &calls, &total_ns,
+          buckets, SHIM_STATS_BUCKETS); ++index) {
+    if (!calls)
+      continue;
+
+    fprintf (stderr, "%s: %llu calls, %llu ns total, %llu ns mean\n", name,
+        calls, total_ns, total_ns / calls);
+
+    for (i = 0; i < SHIM_STATS_BUCKETS; ++i) {
+      if (buckets[i])
+        fprintf (stderr, "  >= %llu ns: %llu\n", i ? 1ULL << i : 0ULL,
+            buckets[i]);
+    }
+  }
+}
+
 #endif // __COMMON_SHIM_H_
@@ -38,45 +38,97 @@ typedef struct dlb_audio_parser_dispatch_table_s
 
 static dlb_audio_parser_dispatch_table dispatch_table;
 
-int dlb_audio_parser_try_open_dynlib (void)
+static shim_once bind_once = SHIM_ONCE_INIT;
+static int bind_result = 1;
+
+static shim_stats stats;
+
+#define PARSER_SYMBOL(field) \
+  SHIM_SYMBOL (dlb_audio_parser_dispatch_table, "dlb_audio_parser_", field)
+
+static const shim_symbol symbols[] = {
+  PARSER_SYMBOL (new),
+  PARSER_SYMBOL (free),
+  PARSER_SYMBOL (query_max_inbuff_size),
+  PARSER_SYMBOL (query_min_frame_size),
+  PARSER_SYMBOL (parse),
+};
+
+#define PARSER_TIMED(field, call) \
+  SHIM_TIMED (&stats, SHIM_SLOT (dlb_audio_parser_dispatch_table, field), \
+      call)
+
+static void
+dump_stats (void)
+{
+  shim_stats_dump (&stats);
+}
+
+static void
+bind_dispatch_table (void)
+{
+  bind_result = bind_dynamic_lib (DLB_AUDIO_PARSER_LIBNAME, symbols,
+      sizeof (symbols) / sizeof (symbols[0]), &dispatch_table,
+      sizeof (dispatch_table));
+
+  if (!bind_result && shim_stats_init (&stats, symbols,
+          sizeof (symbols) / sizeof (symbols[0]), sizeof (dispatch_table)))
+    atexit (dump_stats);
+}
+
+/* library is bound by the first caller, others get the cached result */
+int
+dlb_audio_parser_try_open_dynlib (void)
+{
+  shim_call_once (&bind_once, bind_dispatch_table);
+  return bind_result;
+}
+
+int
+dlb_audio_parser_query_stats (int index, const char **name,
+    unsigned long long *calls, unsigned long long *total_ns,
+    unsigned long long *buckets, int nbuckets)
 {
-  void *libap = open_dynamic_lib (DLB_AUDIO_PARSER_LIBNAME);
-  if (!libap)
-    return 1;
-
-  dispatch_table.new = get_proc_address (libap, "dlb_audio_parser_new");
-  dispatch_table.free = get_proc_address (libap, "dlb_audio_parser_free");
-  dispatch_table.query_max_inbuff_size =
-      get_proc_address (libap, "dlb_audio_parser_query_max_inbuff_size");
-  dispatch_table.query_min_frame_size =
-      get_proc_address (libap, "dlb_audio_parser_query_min_frame_size");
-  dispatch_table.parse = get_proc_address (libap, "dlb_audio_parser_parse");
-
-  return 0;
+  return shim_stats_read (&stats, index, name, calls, total_ns, buckets,
+      nbuckets);
 }
 
 dlb_audio_parser *
 dlb_audio_parser_new (dlb_audio_parser_type type)
 {
-  return dispatch_table.new (type);
+  dlb_audio_parser *ret;
+
+  if (dlb_audio_parser_try_open_dynlib ())
+    return NULL;
+
+  PARSER_TIMED (new, ret = dispatch_table.new (type));
+  return ret;
 }
 
 void
 dlb_audio_parser_free (dlb_audio_parser * parser)
 {
-  dispatch_table.free (parser);
+  PARSER_TIMED (free, dispatch_table.free (parser));
 }
 
 size_t
 dlb_audio_parser_query_max_inbuff_size (const dlb_audio_parser * const parser)
 {
-  return dispatch_table.query_max_inbuff_size (parser);
+  size_t ret;
+
+  PARSER_TIMED (query_max_inbuff_size,
+      ret = dispatch_table.query_max_inbuff_size (parser));
+  return ret;
 }
 
 size_t
 dlb_audio_parser_query_min_frame_size (const dlb_audio_parser * const parser)
 {
-  return dispatch_table.query_min_frame_size (parser);
+  size_t ret;
+
+  PARSER_TIMED (query_min_frame_size,
+      ret = dispatch_table.query_min_frame_size (parser));
+  return ret;
 }
 
 dlb_audio_parser_status
@@ -84,5 +136,9 @@ dlb_audio_parser_parse (dlb_audio_parser * parser,
     const uint8_t * const input, size_t insize, dlb_audio_parser_info * info,
     size_t *skipbytes)
 {
-  return dispatch_table.parse (parser, input, insize, info, skipbytes);
+  dlb_audio_parser_status ret;
+
+  PARSER_TIMED (parse,
+      ret = dispatch_table.parse (parser, input, insize, info, skipbytes));
+  return ret;
 }
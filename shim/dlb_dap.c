@@ -51,50 +51,83 @@ typedef struct dlb_dap_dispatch_table_s
 
 static dlb_dap_dispatch_table dispatch_table;
 
-int dlb_dap_try_open_dynlib (void)
-{
-  void *libdap = open_dynamic_lib (DLB_DAP_LIBNAME);
-
-  if (!libdap)
-    return 1;
-
-  dispatch_table.new = get_proc_address (libdap, "dlb_dap_new");
-  dispatch_table.free = get_proc_address (libdap, "dlb_dap_free");
-  dispatch_table.preprocess_serialized_config =
-      get_proc_address (libdap, "dlb_dap_preprocess_serialized_config");
-  dispatch_table.propose_input_format =
-      get_proc_address (libdap, "dlb_dap_propose_input_format");
-  dispatch_table.process = get_proc_address (libdap, "dlb_dap_process");
-  dispatch_table.query_latency =
-      get_proc_address (libdap, "dlb_dap_query_latency");
-  dispatch_table.query_block_samples =
-      get_proc_address (libdap, "dlb_dap_query_block_samples");
-  dispatch_table.virtualizer_settings_init =
-      get_proc_address (libdap, "dlb_dap_virtualizer_settings_init");
-  dispatch_table.set_virtualizer_settings =
-      get_proc_address (libdap, "dlb_dap_set_virtualizer_settings");
-  dispatch_table.profile_settings_init =
-      get_proc_address (libdap, "dlb_dap_profile_settings_init");
-  dispatch_table.set_profile_settings =
-      get_proc_address (libdap, "dlb_dap_set_profile_settings");
-  dispatch_table.gain_settings_init =
-      get_proc_address (libdap, "dlb_dap_gain_settings_init");
-  dispatch_table.set_gain_settings =
-      get_proc_address (libdap, "dlb_dap_set_gain_settings");
-
-  return 0;
+static shim_once bind_once = SHIM_ONCE_INIT;
+static int bind_result = 1;
+
+static shim_stats stats;
+
+#define DAP_SYMBOL(field) \
+  SHIM_SYMBOL (dlb_dap_dispatch_table, "dlb_dap_", field)
+
+static const shim_symbol symbols[] = {
+  DAP_SYMBOL (new),
+  DAP_SYMBOL (free),
+  DAP_SYMBOL (preprocess_serialized_config),
+  DAP_SYMBOL (propose_input_format),
+  DAP_SYMBOL (process),
+  DAP_SYMBOL (query_latency),
+  DAP_SYMBOL (query_block_samples),
+  DAP_SYMBOL (virtualizer_settings_init),
+  DAP_SYMBOL (set_virtualizer_settings),
+  DAP_SYMBOL (profile_settings_init),
+  DAP_SYMBOL (set_profile_settings),
+  DAP_SYMBOL (gain_settings_init),
+  DAP_SYMBOL (set_gain_settings),
+};
+
+#define DAP_TIMED(field, call) \
+  SHIM_TIMED (&stats, SHIM_SLOT (dlb_dap_dispatch_table, field), call)
+
+static void
+dump_stats (void)
+{
+  shim_stats_dump (&stats);
+}
+
+static void
+bind_dispatch_table (void)
+{
+  bind_result = bind_dynamic_lib (DLB_DAP_LIBNAME, symbols,
+      sizeof (symbols) / sizeof (symbols[0]), &dispatch_table,
+      sizeof (dispatch_table));
+
+  if (!bind_result && shim_stats_init (&stats, symbols,
+          sizeof (symbols) / sizeof (symbols[0]), sizeof (dispatch_table)))
+    atexit (dump_stats);
+}
+
+/* library is bound by the first caller, others get the cached result */
+int
+dlb_dap_try_open_dynlib (void)
+{
+  shim_call_once (&bind_once, bind_dispatch_table);
+  return bind_result;
+}
+
+int
+dlb_dap_query_stats (int index, const char **name, unsigned long long *calls,
+    unsigned long long *total_ns, unsigned long long *buckets, int nbuckets)
+{
+  return shim_stats_read (&stats, index, name, calls, total_ns, buckets,
+      nbuckets);
 }
 
 dlb_dap *
 dlb_dap_new (const dlb_dap_init_info * info)
 {
-  return dispatch_table.new (info);
+  dlb_dap *ret;
+
+  if (dlb_dap_try_open_dynlib ())
+    return NULL;
+
+  DAP_TIMED (new, ret = dispatch_table.new (info));
+  return ret;
 }
 
 void
 dlb_dap_free (dlb_dap * self)
 {
-  dispatch_table.free (self);
+  DAP_TIMED (free, dispatch_table.free (self));
 }
 
 void
@@ -102,72 +135,105 @@ dlb_dap_preprocess_serialized_config (const uint8_t * serialized_config,
     dlb_dap_channel_format * intermediate_format, int *output_channels,
     int *virtualizer_enable)
 {
-  dispatch_table.preprocess_serialized_config (serialized_config,
-      intermediate_format, output_channels, virtualizer_enable);
+  if (dlb_dap_try_open_dynlib ())
+    return;
+
+  DAP_TIMED (preprocess_serialized_config,
+      dispatch_table.preprocess_serialized_config (serialized_config,
+          intermediate_format, output_channels, virtualizer_enable));
 }
 
 void
 dlb_dap_propose_input_format (const dlb_dap_channel_format * output_format,
     int virtulizer_enable, dlb_dap_channel_format * input_format)
 {
-  dispatch_table.propose_input_format (output_format, virtulizer_enable,
-      input_format);
+  if (dlb_dap_try_open_dynlib ())
+    return;
+
+  DAP_TIMED (propose_input_format,
+      dispatch_table.propose_input_format (output_format, virtulizer_enable,
+          input_format));
 }
 
 int
 dlb_dap_process (dlb_dap * self, const dlb_dap_channel_format * input_format,
     const dlb_buffer * inbuf, dlb_buffer * outbuf)
 {
-  return dispatch_table.process (self, input_format, inbuf, outbuf);
+  int ret;
+
+  DAP_TIMED (process,
+      ret = dispatch_table.process (self, input_format, inbuf, outbuf));
+  return ret;
 }
 
 int
 dlb_dap_query_latency (dlb_dap * self)
 {
-  return dispatch_table.query_latency (self);
+  int ret;
+
+  DAP_TIMED (query_latency, ret = dispatch_table.query_latency (self));
+  return ret;
 }
 
 int
 dlb_dap_query_block_samples (dlb_dap * self)
 {
-  return dispatch_table.query_block_samples (self);
+  int ret;
+
+  DAP_TIMED (query_block_samples,
+      ret = dispatch_table.query_block_samples (self));
+  return ret;
 }
 
 void
 dlb_dap_virtualizer_settings_init (dlb_dap_virtualizer_settings * settings)
 {
-  dispatch_table.virtualizer_settings_init (settings);
+  if (dlb_dap_try_open_dynlib ())
+    return;
+
+  DAP_TIMED (virtualizer_settings_init,
+      dispatch_table.virtualizer_settings_init (settings));
 }
 
 void
 dlb_dap_set_virtualizer_settings (dlb_dap * self,
     const dlb_dap_virtualizer_settings * settings)
 {
-  dispatch_table.set_virtualizer_settings (self, settings);
+  DAP_TIMED (set_virtualizer_settings,
+      dispatch_table.set_virtualizer_settings (self, settings));
 }
 
 void
 dlb_dap_profile_settings_init (dlb_dap_profile_settings * settings)
 {
-  dispatch_table.profile_settings_init (settings);
+  if (dlb_dap_try_open_dynlib ())
+    return;
+
+  DAP_TIMED (profile_settings_init,
+      dispatch_table.profile_settings_init (settings));
 }
 
 void
 dlb_dap_set_profile_settings (dlb_dap * self,
     const dlb_dap_profile_settings * settings)
 {
-  dispatch_table.set_profile_settings (self, settings);
+  DAP_TIMED (set_profile_settings,
+      dispatch_table.set_profile_settings (self, settings));
 }
 
 void
 dlb_dap_gain_settings_init (dlb_dap_gain_settings * settings)
 {
-  dispatch_table.gain_settings_init (settings);
+  if (dlb_dap_try_open_dynlib ())
+    return;
+
+  DAP_TIMED (gain_settings_init, dispatch_table.gain_settings_init (settings));
 }
 
 void
 dlb_dap_set_gain_settings (dlb_dap * self,
     const dlb_dap_gain_settings * settings)
 {
-  dispatch_table.set_gain_settings (self, settings);
+  DAP_TIMED (set_gain_settings,
+      dispatch_table.set_gain_settings (self, settings));
 }
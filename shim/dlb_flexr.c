@@ -81,72 +81,104 @@ typedef struct dlb_flexr_dispatch_table_s
 
 static dlb_flexr_dispatch_table dispatch_table;
 
+static shim_once bind_once = SHIM_ONCE_INIT;
+static int bind_result = 1;
+
+static shim_stats stats;
+
+#define FLEXR_SYMBOL(field) \
+  SHIM_SYMBOL (dlb_flexr_dispatch_table, "dlb_flexr_", field)
+
+static const shim_symbol symbols[] = {
+  FLEXR_SYMBOL (new),
+  FLEXR_SYMBOL (free),
+  FLEXR_SYMBOL (add_stream),
+  FLEXR_SYMBOL (rm_stream),
+  FLEXR_SYMBOL (push_stream),
+  FLEXR_SYMBOL (generate_output),
+  FLEXR_SYMBOL (reset),
+  FLEXR_SYMBOL (query_num_outputs),
+  FLEXR_SYMBOL (query_outblk_samples),
+  FLEXR_SYMBOL (query_latency),
+  FLEXR_SYMBOL (query_ext_gain_steps),
+  FLEXR_SYMBOL (stream_info_init),
+  FLEXR_SYMBOL (query_pushed_samples),
+  FLEXR_SYMBOL (finished),
+  FLEXR_SYMBOL (set_render_config),
+  FLEXR_SYMBOL (set_external_user_gain),
+  FLEXR_SYMBOL (set_external_user_gain_by_step),
+  FLEXR_SYMBOL (set_internal_user_gain),
+  FLEXR_SYMBOL (set_content_norm_gain),
+};
+
+#define FLEXR_TIMED(field, call) \
+  SHIM_TIMED (&stats, SHIM_SLOT (dlb_flexr_dispatch_table, field), call)
+
+static void
+dump_stats (void)
+{
+  shim_stats_dump (&stats);
+}
+
+static void
+bind_dispatch_table (void)
+{
+  bind_result = bind_dynamic_lib (DLB_FLEXR_LIBNAME, symbols,
+      sizeof (symbols) / sizeof (symbols[0]), &dispatch_table,
+      sizeof (dispatch_table));
+
+  if (!bind_result && shim_stats_init (&stats, symbols,
+          sizeof (symbols) / sizeof (symbols[0]), sizeof (dispatch_table)))
+    atexit (dump_stats);
+}
+
+/* library is bound by the first caller, others get the cached result */
 int
 dlb_flexr_try_open_dynlib (void)
 {
-  void *libflexr = open_dynamic_lib (DLB_FLEXR_LIBNAME);
-  if (!libflexr)
-    return 1;
-
-  dispatch_table.new = get_proc_address (libflexr, "dlb_flexr_new");
-  dispatch_table.free = get_proc_address (libflexr, "dlb_flexr_free");
-  dispatch_table.add_stream =
-      get_proc_address (libflexr, "dlb_flexr_add_stream");
-  dispatch_table.rm_stream = get_proc_address (libflexr, "dlb_flexr_rm_stream");
-  dispatch_table.push_stream =
-      get_proc_address (libflexr, "dlb_flexr_push_stream");
-  dispatch_table.generate_output =
-      get_proc_address (libflexr, "dlb_flexr_generate_output");
-  dispatch_table.reset = get_proc_address (libflexr, "dlb_flexr_reset");
-  dispatch_table.query_num_outputs =
-      get_proc_address (libflexr, "dlb_flexr_query_num_outputs");
-  dispatch_table.query_outblk_samples =
-      get_proc_address (libflexr, "dlb_flexr_query_outblk_samples");
-  dispatch_table.query_latency =
-      get_proc_address (libflexr, "dlb_flexr_query_latency");
-  dispatch_table.query_ext_gain_steps =
-      get_proc_address (libflexr, "dlb_flexr_query_ext_gain_steps");
-  dispatch_table.stream_info_init =
-      get_proc_address (libflexr, "dlb_flexr_stream_info_init");
-  dispatch_table.query_pushed_samples =
-      get_proc_address (libflexr, "dlb_flexr_query_pushed_samples");
-  dispatch_table.finished = get_proc_address (libflexr, "dlb_flexr_finished");
-  dispatch_table.set_render_config =
-      get_proc_address (libflexr, "dlb_flexr_set_render_config");
-  dispatch_table.set_external_user_gain =
-      get_proc_address (libflexr, "dlb_flexr_set_external_user_gain");
-  dispatch_table.set_external_user_gain_by_step =
-      get_proc_address (libflexr, "dlb_flexr_set_external_user_gain_by_step");
-  dispatch_table.set_internal_user_gain =
-      get_proc_address (libflexr, "dlb_flexr_set_internal_user_gain");
-  dispatch_table.set_content_norm_gain =
-      get_proc_address (libflexr, "dlb_flexr_set_content_norm_gain");
-
-  return 0;
+  shim_call_once (&bind_once, bind_dispatch_table);
+  return bind_result;
+}
+
+int
+dlb_flexr_query_stats (int index, const char **name, unsigned long long *calls,
+    unsigned long long *total_ns, unsigned long long *buckets, int nbuckets)
+{
+  return shim_stats_read (&stats, index, name, calls, total_ns, buckets,
+      nbuckets);
 }
 
 dlb_flexr *
 dlb_flexr_new (const dlb_flexr_init_info * info)
 {
-  return dispatch_table.new (info);
+  dlb_flexr *ret;
+
+  if (dlb_flexr_try_open_dynlib ())
+    return NULL;
+
+  FLEXR_TIMED (new, ret = dispatch_table.new (info));
+  return ret;
 }
 
 void
 dlb_flexr_free (dlb_flexr * self)
 {
-  dispatch_table.free (self);
+  FLEXR_TIMED (free, dispatch_table.free (self));
 }
 
 dlb_flexr_stream_handle
 dlb_flexr_add_stream (dlb_flexr * self, const dlb_flexr_stream_info * info)
 {
-  return dispatch_table.add_stream (self, info);
+  dlb_flexr_stream_handle ret;
+
+  FLEXR_TIMED (add_stream, ret = dispatch_table.add_stream (self, info));
+  return ret;
 }
 
 void
 dlb_flexr_rm_stream (dlb_flexr * self, dlb_flexr_stream_handle stream)
 {
-  dispatch_table.rm_stream (self, stream);
+  FLEXR_TIMED (rm_stream, dispatch_table.rm_stream (self, stream));
 }
 
 int
@@ -154,63 +186,98 @@ dlb_flexr_push_stream (dlb_flexr * self,
     dlb_flexr_stream_handle stream,
     dlb_flexr_object_metadata * md, dlb_buffer * inbuf, int samples)
 {
-  return dispatch_table.push_stream (self, stream, md, inbuf, samples);
+  int ret;
+
+  FLEXR_TIMED (push_stream,
+      ret = dispatch_table.push_stream (self, stream, md, inbuf, samples));
+  return ret;
 }
 
 int
 dlb_flexr_generate_output (dlb_flexr * self, dlb_buffer * outbuf, int *samples)
 {
-  return dispatch_table.generate_output (self, outbuf, samples);
+  int ret;
+
+  FLEXR_TIMED (generate_output,
+      ret = dispatch_table.generate_output (self, outbuf, samples));
+  return ret;
 }
 
 void
 dlb_flexr_reset (dlb_flexr * self)
 {
-  dispatch_table.reset (self);
+  FLEXR_TIMED (reset, dispatch_table.reset (self));
 }
 
 int
 dlb_flexr_query_num_outputs (const dlb_flexr * self)
 {
-  return dispatch_table.query_num_outputs (self);
+  int ret;
+
+  FLEXR_TIMED (query_num_outputs,
+      ret = dispatch_table.query_num_outputs (self));
+  return ret;
 }
 
 int
 dlb_flexr_query_outblk_samples (const dlb_flexr * self)
 {
-  return dispatch_table.query_outblk_samples (self);
+  int ret;
+
+  FLEXR_TIMED (query_outblk_samples,
+      ret = dispatch_table.query_outblk_samples (self));
+  return ret;
 }
 
 int
 dlb_flexr_query_latency (const dlb_flexr * self)
 {
-  return dispatch_table.query_latency (self);
+  int ret;
+
+  FLEXR_TIMED (query_latency, ret = dispatch_table.query_latency (self));
+  return ret;
 }
 
-int dlb_flexr_query_ext_gain_steps (const dlb_flexr *self)
+int
+dlb_flexr_query_ext_gain_steps (const dlb_flexr * self)
 {
-  return dispatch_table.query_ext_gain_steps (self);
+  int ret;
+
+  FLEXR_TIMED (query_ext_gain_steps,
+      ret = dispatch_table.query_ext_gain_steps (self));
+  return ret;
 }
 
 void
 dlb_flexr_stream_info_init (dlb_flexr_stream_info * info,
     const uint8_t * serialized_config, size_t serialized_config_size)
 {
-  dispatch_table.stream_info_init (info, serialized_config,
-      serialized_config_size);
+  if (dlb_flexr_try_open_dynlib ())
+    return;
+
+  FLEXR_TIMED (stream_info_init,
+      dispatch_table.stream_info_init (info, serialized_config,
+          serialized_config_size));
 }
 
 int
 dlb_flexr_query_pushed_samples (const dlb_flexr * self,
     dlb_flexr_stream_handle stream)
 {
-  return dispatch_table.query_pushed_samples (self, stream);
+  int ret;
+
+  FLEXR_TIMED (query_pushed_samples,
+      ret = dispatch_table.query_pushed_samples (self, stream));
+  return ret;
 }
 
 int
 dlb_flexr_finished (const dlb_flexr * self, dlb_flexr_stream_handle stream)
 {
-  return dispatch_table.finished (self, stream);
+  int ret;
+
+  FLEXR_TIMED (finished, ret = dispatch_table.finished (self, stream));
+  return ret;
 }
 
 void
@@ -220,32 +287,38 @@ dlb_flexr_set_render_config (dlb_flexr * self,
     size_t serialized_config_size, dlb_flexr_interp_mode interp,
     int xfade_blocks)
 {
-  dispatch_table.set_render_config (self, stream, serialized_config,
-      serialized_config_size, interp, xfade_blocks);
+  FLEXR_TIMED (set_render_config,
+      dispatch_table.set_render_config (self, stream, serialized_config,
+          serialized_config_size, interp, xfade_blocks));
 }
 
-void dlb_flexr_set_external_user_gain_by_step(dlb_flexr *self, int step)
+void
+dlb_flexr_set_external_user_gain_by_step (dlb_flexr * self, int step)
 {
-  dispatch_table.set_external_user_gain_by_step (self, step);
+  FLEXR_TIMED (set_external_user_gain_by_step,
+      dispatch_table.set_external_user_gain_by_step (self, step));
 }
 
 void
 dlb_flexr_set_external_user_gain (dlb_flexr * self, float gain)
 {
-  dispatch_table.set_external_user_gain (self, gain);
+  FLEXR_TIMED (set_external_user_gain,
+      dispatch_table.set_external_user_gain (self, gain));
 }
 
 void
 dlb_flexr_set_internal_user_gain (dlb_flexr * self,
     dlb_flexr_stream_handle stream, float gain)
 {
-  dispatch_table.set_internal_user_gain (self, stream, gain);
+  FLEXR_TIMED (set_internal_user_gain,
+      dispatch_table.set_internal_user_gain (self, stream, gain));
 }
 
 void
 dlb_flexr_set_content_norm_gain (dlb_flexr * self,
     dlb_flexr_stream_handle stream, float gain)
 {
-  dispatch_table.set_content_norm_gain (self, stream, gain);
+  FLEXR_TIMED (set_content_norm_gain,
+      dispatch_table.set_content_norm_gain (self, stream, gain));
 
 }
@@ -43,83 +43,137 @@ typedef struct dlb_oar_dispatch_table_s
 
 static dlb_oar_dispatch_table dispatch_table;
 
+static shim_once bind_once = SHIM_ONCE_INIT;
+static int bind_result = 1;
+
+static shim_stats stats;
+
+#define OAR_SYMBOL(field) \
+  SHIM_SYMBOL (dlb_oar_dispatch_table, "dlb_oar_", field)
+
+static const shim_symbol symbols[] = {
+  OAR_SYMBOL (new),
+  OAR_SYMBOL (free),
+  OAR_SYMBOL (push_oamd_payload),
+  OAR_SYMBOL (process),
+  OAR_SYMBOL (reset),
+  OAR_SYMBOL (query_latency),
+  OAR_SYMBOL (query_min_block_samples),
+  OAR_SYMBOL (query_max_block_samples),
+  OAR_SYMBOL (query_max_payloads),
+};
+
+#define OAR_TIMED(field, call) \
+  SHIM_TIMED (&stats, SHIM_SLOT (dlb_oar_dispatch_table, field), call)
+
+static void
+dump_stats (void)
+{
+  shim_stats_dump (&stats);
+}
+
+static void
+bind_dispatch_table (void)
+{
+  bind_result = bind_dynamic_lib (DLB_OAR_LIBNAME, symbols,
+      sizeof (symbols) / sizeof (symbols[0]), &dispatch_table,
+      sizeof (dispatch_table));
+
+  if (!bind_result && shim_stats_init (&stats, symbols,
+          sizeof (symbols) / sizeof (symbols[0]), sizeof (dispatch_table)))
+    atexit (dump_stats);
+}
+
+/* library is bound by the first caller, others get the cached result */
 int
 dlb_oar_try_open_dynlib (void)
 {
-  void *liboar = open_dynamic_lib (DLB_OAR_LIBNAME);
-  if (!liboar)
-    return 1;
-
-  dispatch_table.new = get_proc_address (liboar, "dlb_oar_new");
-  dispatch_table.free = get_proc_address (liboar, "dlb_oar_free");
-  dispatch_table.push_oamd_payload =
-      get_proc_address (liboar, "dlb_oar_push_oamd_payload");
-  dispatch_table.process = get_proc_address (liboar, "dlb_oar_process");
-  dispatch_table.reset = get_proc_address (liboar, "dlb_oar_reset");
-  dispatch_table.query_latency =
-      get_proc_address (liboar, "dlb_oar_query_latency");
-  dispatch_table.query_min_block_samples =
-      get_proc_address (liboar, "dlb_oar_query_min_block_samples");
-  dispatch_table.query_max_block_samples =
-      get_proc_address (liboar, "dlb_oar_query_max_block_samples");
-  dispatch_table.query_max_payloads =
-      get_proc_address (liboar, "dlb_oar_query_max_payloads");
-
-  return 0;
+  shim_call_once (&bind_once, bind_dispatch_table);
+  return bind_result;
+}
+
+int
+dlb_oar_query_stats (int index, const char **name, unsigned long long *calls,
+    unsigned long long *total_ns, unsigned long long *buckets, int nbuckets)
+{
+  return shim_stats_read (&stats, index, name, calls, total_ns, buckets,
+      nbuckets);
 }
 
 dlb_oar *
 dlb_oar_new (const dlb_oar_init_info * info)
 {
-  return dispatch_table.new (info);
+  dlb_oar *ret;
+
+  if (dlb_oar_try_open_dynlib ())
+    return NULL;
+
+  OAR_TIMED (new, ret = dispatch_table.new (info));
+  return ret;
 }
 
 void
 dlb_oar_free (dlb_oar * self)
 {
-  dispatch_table.free (self);
+  OAR_TIMED (free, dispatch_table.free (self));
 }
 
 void
 dlb_oar_push_oamd_payload (dlb_oar *self, const dlb_oar_payload *payload,
     int payload_num)
 {
-  dispatch_table.push_oamd_payload (self, payload, payload_num);
+  OAR_TIMED (push_oamd_payload,
+      dispatch_table.push_oamd_payload (self, payload, payload_num));
 }
 
 void
 dlb_oar_process (dlb_oar * self, const dlb_buffer * inbuf, dlb_buffer * outbuf,
     int samples)
 {
-  dispatch_table.process (self, inbuf, outbuf, samples);
+  OAR_TIMED (process, dispatch_table.process (self, inbuf, outbuf, samples));
 }
 
 void
 dlb_oar_reset (dlb_oar * self, int sample_rate)
 {
-  dispatch_table.reset (self, sample_rate);
+  OAR_TIMED (reset, dispatch_table.reset (self, sample_rate));
 }
 
 int
 dlb_oar_query_latency (dlb_oar * self)
 {
-  return dispatch_table.query_latency (self);
+  int ret;
+
+  OAR_TIMED (query_latency, ret = dispatch_table.query_latency (self));
+  return ret;
 }
 
 int
 dlb_oar_query_min_block_samples (dlb_oar * self)
 {
-  return dispatch_table.query_min_block_samples (self);
+  int ret;
+
+  OAR_TIMED (query_min_block_samples,
+      ret = dispatch_table.query_min_block_samples (self));
+  return ret;
 }
 
 int
 dlb_oar_query_max_block_samples (dlb_oar * self)
 {
-  return dispatch_table.query_max_block_samples (self);
+  int ret;
+
+  OAR_TIMED (query_max_block_samples,
+      ret = dispatch_table.query_max_block_samples (self));
+  return ret;
 }
 
 int
 dlb_oar_query_max_payloads (dlb_oar * self)
 {
-  return dispatch_table.query_max_payloads (self);
+  int ret;
+
+  OAR_TIMED (query_max_payloads,
+      ret = dispatch_table.query_max_payloads (self));
+  return ret;
 }
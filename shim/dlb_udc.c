@@ -41,86 +41,154 @@ typedef struct dlb_udc_dispatch_table_s
 
 static dlb_udc_dispatch_table dispatch_table;
 
+static shim_once bind_once = SHIM_ONCE_INIT;
+static int bind_result = 1;
+
+static shim_stats stats;
+
+#define UDC_SYMBOL(field) \
+  SHIM_SYMBOL (dlb_udc_dispatch_table, "dlb_udc_", field)
+
+static const shim_symbol symbols[] = {
+  UDC_SYMBOL (new),
+  UDC_SYMBOL (free),
+  UDC_SYMBOL (drc_settings_init),
+  UDC_SYMBOL (drc_settings_set),
+  UDC_SYMBOL (query_max_outbuf_size),
+  UDC_SYMBOL (query_max_output_channels),
+  UDC_SYMBOL (push_timeslice),
+  UDC_SYMBOL (process_block),
+  UDC_SYMBOL (query_latency),
+};
+
+#define UDC_TIMED(field, call) \
+  SHIM_TIMED (&stats, SHIM_SLOT (dlb_udc_dispatch_table, field), call)
+
+static void
+dump_stats (void)
+{
+  shim_stats_dump (&stats);
+}
+
+static void
+bind_dispatch_table (void)
+{
+  bind_result = bind_dynamic_lib (DLB_UDC_LIBNAME, symbols,
+      sizeof (symbols) / sizeof (symbols[0]), &dispatch_table,
+      sizeof (dispatch_table));
+
+  if (!bind_result && shim_stats_init (&stats, symbols,
+          sizeof (symbols) / sizeof (symbols[0]), sizeof (dispatch_table)))
+    atexit (dump_stats);
+}
+
+/* library is bound by the first caller, others get the cached result */
 int
 dlb_udc_try_open_dynlib (void)
 {
-  void *libudc = open_dynamic_lib (DLB_UDC_LIBNAME);
-  if (!libudc)
-    return 1;
-
-  dispatch_table.new = get_proc_address (libudc, "dlb_udc_new");
-  dispatch_table.free = get_proc_address (libudc, "dlb_udc_free");
-  dispatch_table.drc_settings_init =
-      get_proc_address (libudc, "dlb_udc_drc_settings_init");
-  dispatch_table.drc_settings_set =
-      get_proc_address (libudc, "dlb_udc_drc_settings_set");
-  dispatch_table.query_max_outbuf_size =
-      get_proc_address (libudc, "dlb_udc_query_max_outbuf_size");
-  dispatch_table.query_max_output_channels =
-      get_proc_address (libudc, "dlb_udc_query_max_output_channels");
-  dispatch_table.push_timeslice =
-      get_proc_address (libudc, "dlb_udc_push_timeslice");
-  dispatch_table.process_block =
-      get_proc_address (libudc, "dlb_udc_process_block");
-  dispatch_table.query_latency =
-      get_proc_address (libudc, "dlb_udc_query_latency");
-
-  return 0;
+  shim_call_once (&bind_once, bind_dispatch_table);
+  return bind_result;
+}
+
+int
+dlb_udc_query_stats (int index, const char **name, unsigned long long *calls,
+    unsigned long long *total_ns, unsigned long long *buckets, int nbuckets)
+{
+  return shim_stats_read (&stats, index, name, calls, total_ns, buckets,
+      nbuckets);
 }
 
 dlb_udc *
 dlb_udc_new (const dlb_udc_init_info * info)
 {
-  return dispatch_table.new (info);
+  dlb_udc *ret;
+
+  if (dlb_udc_try_open_dynlib ())
+    return NULL;
+
+  UDC_TIMED (new, ret = dispatch_table.new (info));
+  return ret;
 }
 
 void
 dlb_udc_free (dlb_udc * self)
 {
-  dispatch_table.free (self);
+  UDC_TIMED (free, dispatch_table.free (self));
 }
 
 void
 dlb_udc_drc_settings_init (dlb_udc_drc_settings * drc)
 {
-  dispatch_table.drc_settings_init (drc);
+  if (dlb_udc_try_open_dynlib ())
+    return;
+
+  UDC_TIMED (drc_settings_init, dispatch_table.drc_settings_init (drc));
 }
 
 int
 dlb_udc_drc_settings_set (dlb_udc * self, const dlb_udc_drc_settings * drc)
 {
-  return dispatch_table.drc_settings_set (self, drc);
+  int ret;
+
+  UDC_TIMED (drc_settings_set,
+      ret = dispatch_table.drc_settings_set (self, drc));
+  return ret;
 }
 
 int
 dlb_udc_query_latency_samples (dlb_udc * self)
 {
-  return dispatch_table.query_latency (self);
+  int ret;
+
+  UDC_TIMED (query_latency, ret = dispatch_table.query_latency (self));
+  return ret;
 }
 
 
 size_t
 dlb_udc_query_max_outbuf_size (dlb_udc_output_mode mode, int data_type)
 {
-  return dispatch_table.query_max_outbuf_size (mode, data_type);
+  size_t ret;
+
+  if (dlb_udc_try_open_dynlib ())
+    return 0;
+
+  UDC_TIMED (query_max_outbuf_size,
+      ret = dispatch_table.query_max_outbuf_size (mode, data_type));
+  return ret;
 }
 
 int
 dlb_udc_query_max_output_channels (dlb_udc_output_mode mode)
 {
-  return dispatch_table.query_max_output_channels (mode);
+  int ret;
+
+  if (dlb_udc_try_open_dynlib ())
+    return 0;
+
+  UDC_TIMED (query_max_output_channels,
+      ret = dispatch_table.query_max_output_channels (mode));
+  return ret;
 }
 
 int
 dlb_udc_push_timeslice (dlb_udc * self, const char *indata, size_t indatasz)
 {
-  return dispatch_table.push_timeslice (self, indata, indatasz);
+  int ret;
+
+  UDC_TIMED (push_timeslice,
+      ret = dispatch_table.push_timeslice (self, indata, indatasz));
+  return ret;
 }
 
 int
 dlb_udc_process_block (dlb_udc * self, dlb_buffer * outbuf, size_t *framesz,
     dlb_evo_payload * metadata, dlb_udc_audio_info * audio_info)
 {
-  return dispatch_table.process_block (self, outbuf, framesz, metadata,
-      audio_info);
+  int ret;
+
+  UDC_TIMED (process_block,
+      ret = dispatch_table.process_block (self, outbuf, framesz, metadata,
+          audio_info));
+  return ret;
 }
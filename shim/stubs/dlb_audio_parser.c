@@ -0,0 +1,177 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/* AC-3 and E-AC-3 frame parser, dependent E-AC-3 substreams are returned
+ * together with the independent substream they follow */
+
+#include "dlb_audio_parser.h"
+#include "dlb_stub.h"
+
+/* two full size substreams and the header of the next frame */
+#define MAX_INBUFF_SIZE (2 * 4096 + DLB_STUB_AC3_HEADER_SIZE)
+
+typedef struct dlb_audio_parser_stub_s
+{
+  dlb_audio_parser parent;
+  size_t min_frame_size;
+} dlb_audio_parser_stub;
+
+#define STUB(parser) \
+  MEMBER_TO_STRUCT_PTR (dlb_audio_parser_stub, parent, parser)
+
+static size_t
+ac3_query_max_inbuff_size (const dlb_audio_parser * const parser)
+{
+  (void) parser;
+  return MAX_INBUFF_SIZE;
+}
+
+static size_t
+ac3_query_min_frame_size (const dlb_audio_parser * const parser)
+{
+  return STUB (parser)->min_frame_size;
+}
+
+static dlb_audio_parser_status
+ac3_need_more (dlb_audio_parser_stub * self, size_t size)
+{
+  self->min_frame_size = size;
+  return DLB_AUDIO_PARSER_STATUS_NEED_MORE_DATA;
+}
+
+static dlb_audio_parser_status
+ac3_parse (dlb_audio_parser * parser, const uint8_t * const input,
+    size_t insize, dlb_audio_parser_info * info, size_t * skipbytes)
+{
+  dlb_audio_parser_stub *self = STUB (parser);
+  dlb_stub_ac3_header hdr, dep;
+  size_t offset, frame;
+  int ret;
+
+  *skipbytes = 0;
+
+  if (!dlb_stub_ac3_find_sync (input, insize, &offset)) {
+    *skipbytes = offset;
+    return DLB_AUDIO_PARSER_STATUS_NO_SYNCWORD;
+  }
+
+  if (offset) {
+    *skipbytes = offset;
+    return DLB_AUDIO_PARSER_STATUS_OUT_OF_SYNC;
+  }
+
+  ret = dlb_stub_ac3_parse_header (input, insize, &hdr);
+  if (ret == DLB_STUB_AC3_NEED_MORE_DATA)
+    return ac3_need_more (self, DLB_STUB_AC3_HEADER_SIZE);
+
+  /* false sync or a dependent substream without its independent one */
+  if (ret == DLB_STUB_AC3_INVALID) {
+    *skipbytes = 1;
+    return DLB_AUDIO_PARSER_STATUS_OUT_OF_SYNC;
+  }
+
+  if (hdr.eac3 && hdr.strmtyp == 1) {
+    *skipbytes = hdr.framesize;
+    return DLB_AUDIO_PARSER_STATUS_OUT_OF_SYNC;
+  }
+
+  frame = hdr.framesize;
+
+  while (hdr.eac3) {
+    if (insize < frame + DLB_STUB_AC3_HEADER_SIZE) {
+      if (dlb_audio_parser_draining_get (parser))
+        break;
+
+      return ac3_need_more (self, frame + DLB_STUB_AC3_HEADER_SIZE);
+    }
+
+    if (dlb_stub_ac3_parse_header (input + frame, insize - frame, &dep)
+        || !dep.eac3 || dep.strmtyp != 1)
+      break;
+
+    frame += dep.framesize;
+  }
+
+  if (insize < frame)
+    return ac3_need_more (self, frame);
+
+  info->data_type = hdr.eac3 ? DATA_TYPE_EAC3 : DATA_TYPE_AC3;
+  info->channels = hdr.channels;
+  info->sample_rate = (dlb_audio_parser_sample_rate) hdr.rate;
+  info->framesize = frame;
+  info->samples = hdr.blocks * 256;
+  info->object_audio = 0;
+
+  self->min_frame_size = DLB_STUB_AC3_HEADER_SIZE;
+  return DLB_AUDIO_PARSER_STATUS_OK;
+}
+
+static void
+ac3_release (dlb_audio_parser * parser)
+{
+  free (STUB (parser));
+}
+
+dlb_audio_parser *
+dlb_audio_parser_new (dlb_audio_parser_type type)
+{
+  dlb_audio_parser_stub *self;
+
+  if (type != DLB_AUDIO_PARSER_TYPE_AC3)
+    return NULL;
+
+  self = calloc (1, sizeof (*self));
+  if (!self)
+    return NULL;
+
+  self->parent.ops.query_max_inbuff_size = ac3_query_max_inbuff_size;
+  self->parent.ops.query_min_frame_size = ac3_query_min_frame_size;
+  self->parent.ops.parse = ac3_parse;
+  self->parent.ops.release = ac3_release;
+  self->min_frame_size = DLB_STUB_AC3_HEADER_SIZE;
+
+  return AUDIO_PARSER (self);
+}
+
+void
+dlb_audio_parser_free (dlb_audio_parser * parser)
+{
+  if (parser)
+    parser->ops.release (parser);
+}
+
+size_t
+dlb_audio_parser_query_max_inbuff_size (const dlb_audio_parser * const parser)
+{
+  return parser->ops.query_max_inbuff_size (parser);
+}
+
+size_t
+dlb_audio_parser_query_min_frame_size (const dlb_audio_parser * const parser)
+{
+  return parser->ops.query_min_frame_size (parser);
+}
+
+dlb_audio_parser_status
+dlb_audio_parser_parse (dlb_audio_parser * parser, const uint8_t * const input,
+    size_t insize, dlb_audio_parser_info * info, size_t * skipbytes)
+{
+  return parser->ops.parse (parser, input, insize, info, skipbytes);
+}
@@ -0,0 +1,190 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/* Post-processing stand-in, folds the input onto the output channels and
+ * applies the pre, post and system gains. Serialized configurations are
+ * opaque to it and always select a stereo output. */
+
+#include <math.h>
+#include <string.h>
+
+#include "dlb_dap.h"
+#include "dlb_stub.h"
+
+#define BLOCK_SAMPLES 256
+#define MAX_CHANNELS 64
+
+struct dlb_dap_s
+{
+  dlb_dap_init_info info;
+  dlb_dap_gain_settings gains;
+  float gain;
+  int cost;
+};
+
+static const dlb_dap_channel_format serialized_output = { 2, 0, 0 };
+
+/* immersive input gives the virtualizer the most to work with */
+static const dlb_dap_channel_format virtualizer_input = { 7, 4, 1 };
+
+static float
+total_gain (const dlb_dap_gain_settings * gains)
+{
+  /* settings are in 1/16 dB steps */
+  int steps = gains->pregain + gains->postgain + gains->system_gain;
+
+  return powf (10.0f, steps / (16.0f * 20.0f));
+}
+
+dlb_dap *
+dlb_dap_new (const dlb_dap_init_info * info)
+{
+  dlb_dap *self = calloc (1, sizeof (*self));
+
+  if (!self)
+    return NULL;
+
+  self->info = *info;
+  if (info->serialized_config)
+    self->info.output_format = serialized_output;
+
+  self->cost = dlb_stub_cost ();
+  dlb_dap_gain_settings_init (&self->gains);
+  self->gain = total_gain (&self->gains);
+
+  return self;
+}
+
+void
+dlb_dap_free (dlb_dap * self)
+{
+  free (self);
+}
+
+void
+dlb_dap_preprocess_serialized_config (const uint8_t * serialized_config,
+    dlb_dap_channel_format * intermediate_format, int *output_channels,
+    int *virtualizer_enable)
+{
+  (void) serialized_config;
+  (void) virtualizer_enable;
+
+  *intermediate_format = serialized_output;
+  *output_channels = serialized_output.channels_floor +
+      serialized_output.channels_top + serialized_output.lfe;
+}
+
+void
+dlb_dap_propose_input_format (const dlb_dap_channel_format * output_format,
+    int virtulizer_enable, dlb_dap_channel_format * input_format)
+{
+  *input_format = virtulizer_enable ? virtualizer_input : *output_format;
+}
+
+int
+dlb_dap_process (dlb_dap * self, const dlb_dap_channel_format * input_format,
+    const dlb_buffer * inbuf, dlb_buffer * outbuf)
+{
+  unsigned in, out, inputs = inbuf->nchannel, outputs = outbuf->nchannel;
+  int i;
+
+  (void) input_format;
+
+  if (!outputs || inputs > MAX_CHANNELS || outputs > MAX_CHANNELS)
+    return -1;
+
+  for (i = 0; i < BLOCK_SAMPLES; ++i) {
+    float mix[MAX_CHANNELS] = { 0 };
+
+    for (in = 0; in < inputs; ++in)
+      mix[dlb_stub_fold (in, outputs)] += dlb_stub_read (inbuf, in, i);
+
+    for (out = 0; out < outputs; ++out) {
+      float x = dlb_stub_burn (mix[out] * self->gain, self->cost);
+
+      dlb_stub_write (outbuf, out, i, x);
+    }
+  }
+
+  return 0;
+}
+
+int
+dlb_dap_query_latency (dlb_dap * self)
+{
+  (void) self;
+  return 0;
+}
+
+int
+dlb_dap_query_block_samples (dlb_dap * self)
+{
+  (void) self;
+  return BLOCK_SAMPLES;
+}
+
+void
+dlb_dap_virtualizer_settings_init (dlb_dap_virtualizer_settings * settings)
+{
+  settings->front_speaker_angle = 10;
+  settings->surround_speaker_angle = 20;
+  settings->rear_surround_speaker_angle = 30;
+  settings->height_speaker_angle = 0;
+  settings->rear_height_speaker_angle = 0;
+  settings->height_filter_enable = 0;
+}
+
+void
+dlb_dap_set_virtualizer_settings (dlb_dap * self,
+    const dlb_dap_virtualizer_settings * settings)
+{
+  (void) self;
+  (void) settings;
+}
+
+void
+dlb_dap_profile_settings_init (dlb_dap_profile_settings * settings)
+{
+  memset (settings, 0, sizeof (*settings));
+}
+
+void
+dlb_dap_set_profile_settings (dlb_dap * self,
+    const dlb_dap_profile_settings * settings)
+{
+  (void) self;
+  (void) settings;
+}
+
+void
+dlb_dap_gain_settings_init (dlb_dap_gain_settings * settings)
+{
+  settings->pregain = 0;
+  settings->postgain = 0;
+  settings->system_gain = 0;
+}
+
+void
+dlb_dap_set_gain_settings (dlb_dap * self,
+    const dlb_dap_gain_settings * settings)
+{
+  self->gains = *settings;
+  self->gain = total_gain (settings);
+}
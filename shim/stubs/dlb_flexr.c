@@ -0,0 +1,341 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/* Mixer stand-in, every stream is folded onto the outputs, scaled by its
+ * gains and summed. Device and render configurations are opaque to it, the
+ * output channel count is read from DLB_STUB_FLEXR_OUTPUTS, stereo when
+ * unset. */
+
+#include <string.h>
+
+#include "dlb_flexr.h"
+#include "dlb_stub.h"
+
+#define OUTPUTS_ENV "DLB_STUB_FLEXR_OUTPUTS"
+#define MAX_OUTPUTS 32
+#define MAX_STREAMS 16
+#define OUTBLK_SAMPLES 256
+#define MAX_INPUT_BLK_SAMPLES 4096
+#define EXT_GAIN_STEPS 16
+
+typedef struct stub_stream_s
+{
+  int active;
+  int removed;
+  float internal_gain;
+  float norm_gain;
+
+  /* input folded onto the outputs, waiting for generate_output */
+  float *fifo;
+  int capacity;
+  int pushed;
+} stub_stream;
+
+struct dlb_flexr_s
+{
+  int rate;
+  int outputs;
+  float ext_gain;
+  int cost;
+
+  stub_stream streams[MAX_STREAMS];
+};
+
+dlb_flexr *
+dlb_flexr_new (const dlb_flexr_init_info * info)
+{
+  const char *env = getenv (OUTPUTS_ENV);
+  int outputs = env ? atoi (env) : 2;
+  dlb_flexr *self;
+
+  if (!info->serialized_config || outputs < 1 || outputs > MAX_OUTPUTS)
+    return NULL;
+
+  self = calloc (1, sizeof (*self));
+  if (!self)
+    return NULL;
+
+  self->rate = info->rate;
+  self->outputs = outputs;
+  self->ext_gain = 1.0f;
+  self->cost = dlb_stub_cost ();
+
+  return self;
+}
+
+void
+dlb_flexr_free (dlb_flexr * self)
+{
+  int i;
+
+  if (!self)
+    return;
+
+  for (i = 0; i < MAX_STREAMS; ++i)
+    free (self->streams[i].fifo);
+
+  free (self);
+}
+
+/* handles are slot indices plus one, zero is invalid */
+static stub_stream *
+get_stream (const dlb_flexr * self, dlb_flexr_stream_handle stream)
+{
+  if (stream == DLB_FLEXR_STREAM_HANDLE_INVALID || stream > MAX_STREAMS)
+    return NULL;
+
+  return (stub_stream *) & self->streams[stream - 1];
+}
+
+dlb_flexr_stream_handle
+dlb_flexr_add_stream (dlb_flexr * self, const dlb_flexr_stream_info * info)
+{
+  stub_stream *s;
+  int i;
+
+  for (i = 0; i < MAX_STREAMS; ++i) {
+    s = &self->streams[i];
+    if (s->active)
+      continue;
+
+    s->capacity = info->max_input_blk_samples + OUTBLK_SAMPLES;
+    s->fifo = calloc ((size_t) s->capacity * self->outputs, sizeof (float));
+    if (!s->fifo)
+      return DLB_FLEXR_STREAM_HANDLE_INVALID;
+
+    s->active = 1;
+    s->removed = 0;
+    s->internal_gain = 1.0f;
+    s->norm_gain = 1.0f;
+    s->pushed = 0;
+
+    return i + 1;
+  }
+
+  return DLB_FLEXR_STREAM_HANDLE_INVALID;
+}
+
+void
+dlb_flexr_rm_stream (dlb_flexr * self, dlb_flexr_stream_handle stream)
+{
+  stub_stream *s = get_stream (self, stream);
+
+  if (!s)
+    return;
+
+  free (s->fifo);
+  memset (s, 0, sizeof (*s));
+}
+
+int
+dlb_flexr_push_stream (dlb_flexr * self, dlb_flexr_stream_handle stream,
+    dlb_flexr_object_metadata * md, dlb_buffer * inbuf, int samples)
+{
+  stub_stream *s = get_stream (self, stream);
+  unsigned ch;
+  int i;
+
+  (void) md;
+
+  if (!s || !s->active || s->pushed + samples > s->capacity)
+    return -1;
+
+  for (i = 0; i < samples; ++i) {
+    float *frame = s->fifo + (size_t) (s->pushed + i) * self->outputs;
+
+    for (ch = 0; ch < inbuf->nchannel; ++ch)
+      frame[dlb_stub_fold (ch, self->outputs)] += dlb_stub_read (inbuf, ch, i);
+  }
+
+  s->pushed += samples;
+  return 0;
+}
+
+int
+dlb_flexr_generate_output (dlb_flexr * self, dlb_buffer * outbuf, int *samples)
+{
+  float mix[MAX_OUTPUTS];
+  int i, n, ch, outputs = self->outputs;
+
+  if ((int) outbuf->nchannel < outputs)
+    return -1;
+
+  for (i = 0; i < OUTBLK_SAMPLES; ++i) {
+    memset (mix, 0, sizeof (mix));
+
+    for (n = 0; n < MAX_STREAMS; ++n) {
+      stub_stream *s = &self->streams[n];
+      const float *frame = s->fifo + (size_t) i * outputs;
+      float gain = s->internal_gain * s->norm_gain * self->ext_gain;
+
+      /* streams short of a full block are padded with silence */
+      if (!s->active || i >= s->pushed)
+        continue;
+
+      for (ch = 0; ch < outputs; ++ch)
+        mix[ch] += frame[ch] * gain;
+    }
+
+    for (ch = 0; ch < outputs; ++ch)
+      dlb_stub_write (outbuf, ch, i, dlb_stub_burn (mix[ch], self->cost));
+  }
+
+  for (n = 0; n < MAX_STREAMS; ++n) {
+    stub_stream *s = &self->streams[n];
+    int used = s->pushed < OUTBLK_SAMPLES ? s->pushed : OUTBLK_SAMPLES;
+
+    if (!s->active)
+      continue;
+
+    memmove (s->fifo, s->fifo + (size_t) used * outputs,
+        (size_t) (s->pushed - used) * outputs * sizeof (float));
+    memset (s->fifo + (size_t) (s->pushed - used) * outputs, 0,
+        (size_t) used * outputs * sizeof (float));
+    s->pushed -= used;
+  }
+
+  *samples = OUTBLK_SAMPLES;
+  return 0;
+}
+
+void
+dlb_flexr_reset (dlb_flexr * self)
+{
+  int n;
+
+  for (n = 0; n < MAX_STREAMS; ++n) {
+    stub_stream *s = &self->streams[n];
+
+    if (!s->active)
+      continue;
+
+    memset (s->fifo, 0,
+        (size_t) s->capacity * self->outputs * sizeof (float));
+    s->pushed = 0;
+  }
+}
+
+void
+dlb_flexr_set_external_user_gain (dlb_flexr * self, float gain)
+{
+  self->ext_gain = gain;
+}
+
+void
+dlb_flexr_set_external_user_gain_by_step (dlb_flexr * self, int step)
+{
+  if (step < 0)
+    step = 0;
+  else if (step > EXT_GAIN_STEPS)
+    step = EXT_GAIN_STEPS;
+
+  self->ext_gain = (float) step / EXT_GAIN_STEPS;
+}
+
+int
+dlb_flexr_query_num_outputs (const dlb_flexr * self)
+{
+  return self->outputs;
+}
+
+int
+dlb_flexr_query_latency (const dlb_flexr * self)
+{
+  (void) self;
+  return 0;
+}
+
+int
+dlb_flexr_query_outblk_samples (const dlb_flexr * self)
+{
+  (void) self;
+  return OUTBLK_SAMPLES;
+}
+
+int
+dlb_flexr_query_ext_gain_steps (const dlb_flexr * self)
+{
+  (void) self;
+  return EXT_GAIN_STEPS;
+}
+
+int
+dlb_flexr_query_pushed_samples (const dlb_flexr * self,
+    dlb_flexr_stream_handle stream)
+{
+  stub_stream *s = get_stream (self, stream);
+
+  return s ? s->pushed : 0;
+}
+
+/* a stream is finished once everything pushed was rendered */
+int
+dlb_flexr_finished (const dlb_flexr * self, dlb_flexr_stream_handle stream)
+{
+  stub_stream *s = get_stream (self, stream);
+
+  return !s || !s->active || s->pushed == 0;
+}
+
+void
+dlb_flexr_set_render_config (dlb_flexr * self, dlb_flexr_stream_handle stream,
+    const uint8_t * serialized_config, size_t serialized_config_size,
+    dlb_flexr_interp_mode interp, int xfade_blocks)
+{
+  (void) self;
+  (void) stream;
+  (void) serialized_config;
+  (void) serialized_config_size;
+  (void) interp;
+  (void) xfade_blocks;
+}
+
+void
+dlb_flexr_stream_info_init (dlb_flexr_stream_info * info,
+    const uint8_t * serialized_config, size_t serialized_config_size)
+{
+  memset (info, 0, sizeof (*info));
+
+  info->format = DLB_FLEXR_INPUT_FORMAT_2_0;
+  info->interp = DLB_FLEXR_INTERP_OFFLINE;
+  info->max_input_blk_samples = MAX_INPUT_BLK_SAMPLES;
+  info->serialized_config = serialized_config;
+  info->serialized_config_size = serialized_config_size;
+}
+
+void
+dlb_flexr_set_internal_user_gain (dlb_flexr * self,
+    dlb_flexr_stream_handle stream, float gain)
+{
+  stub_stream *s = get_stream (self, stream);
+
+  if (s)
+    s->internal_gain = gain;
+}
+
+void
+dlb_flexr_set_content_norm_gain (dlb_flexr * self,
+    dlb_flexr_stream_handle stream, float gain)
+{
+  stub_stream *s = get_stream (self, stream);
+
+  if (s)
+    s->norm_gain = gain;
+}
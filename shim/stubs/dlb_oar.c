@@ -0,0 +1,176 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/* Renderer stand-in, objects are panned to the output channel picked by
+ * the x position of the synthetic OAMD written by the decoder stub. Without
+ * metadata inputs fold onto the outputs in order. */
+
+#include "dlb_oar.h"
+#include "dlb_stub.h"
+
+#define MIN_BLOCK_SAMPLES 32
+#define MAX_BLOCK_SAMPLES 1536
+#define MAX_PAYLOADS 8
+#define MAX_CHANNELS 64
+
+struct dlb_oar_s
+{
+  dlb_oar_init_info info;
+  int cost;
+
+  /* object positions and gains from the latest payload */
+  int objects;
+  unsigned char x[DLB_STUB_OAMD_MAX_OBJECTS];
+  float gain[DLB_STUB_OAMD_MAX_OBJECTS];
+};
+
+dlb_oar *
+dlb_oar_new (const dlb_oar_init_info * info)
+{
+  dlb_oar *self;
+
+  if (!info->speaker_mask)
+    return NULL;
+
+  self = calloc (1, sizeof (*self));
+  if (!self)
+    return NULL;
+
+  self->info = *info;
+  self->cost = dlb_stub_cost ();
+  return self;
+}
+
+void
+dlb_oar_free (dlb_oar * self)
+{
+  free (self);
+}
+
+static void
+parse_oamd (dlb_oar * self, const dlb_oar_payload * payload)
+{
+  const uint8_t *md = payload->data;
+  int i, objects;
+
+  if (payload->size < DLB_STUB_OAMD_HEADER_SIZE
+      || md[0] != DLB_STUB_OAMD_MAGIC_0 || md[1] != DLB_STUB_OAMD_MAGIC_1
+      || md[2] != DLB_STUB_OAMD_VERSION)
+    return;
+
+  objects = md[3] < DLB_STUB_OAMD_MAX_OBJECTS ? md[3] :
+      DLB_STUB_OAMD_MAX_OBJECTS;
+  if (payload->size < DLB_STUB_OAMD_HEADER_SIZE +
+      (size_t) objects * DLB_STUB_OAMD_OBJECT_SIZE)
+    return;
+
+  for (i = 0; i < objects; ++i) {
+    const uint8_t *obj =
+        md + DLB_STUB_OAMD_HEADER_SIZE + i * DLB_STUB_OAMD_OBJECT_SIZE;
+
+    self->x[i] = obj[0];
+    self->gain[i] = obj[3] / 255.0f;
+  }
+
+  self->objects = objects;
+}
+
+/* payloads apply from the start of the next block, offsets are ignored */
+void
+dlb_oar_push_oamd_payload (dlb_oar * self, const dlb_oar_payload * payload,
+    int payload_num)
+{
+  int i;
+
+  for (i = 0; i < payload_num; ++i)
+    parse_oamd (self, &payload[i]);
+}
+
+void
+dlb_oar_process (dlb_oar * self, const dlb_buffer * inbuf, dlb_buffer * outbuf,
+    int samples)
+{
+  unsigned target[MAX_CHANNELS];
+  float gain[MAX_CHANNELS];
+  unsigned in, out, objects = inbuf->nchannel, outputs = outbuf->nchannel;
+  int i;
+
+  if (!outputs || objects > MAX_CHANNELS || outputs > MAX_CHANNELS)
+    return;
+
+  for (in = 0; in < objects; ++in) {
+    if ((int) in < self->objects) {
+      target[in] = self->x[in] * outputs / 256;
+      gain[in] = self->gain[in];
+    } else {
+      target[in] = dlb_stub_fold (in, outputs);
+      gain[in] = 1.0f;
+    }
+  }
+
+  for (i = 0; i < samples; ++i) {
+    float mix[MAX_CHANNELS] = { 0 };
+
+    for (in = 0; in < objects; ++in)
+      mix[target[in]] += dlb_stub_read (inbuf, in, i) * gain[in];
+
+    for (out = 0; out < outputs; ++out) {
+      float x = dlb_stub_burn (mix[out], self->cost);
+
+      /* write clamps, which is all the limiter does */
+      dlb_stub_write (outbuf, out, i, x);
+    }
+  }
+}
+
+void
+dlb_oar_reset (dlb_oar * self, int sample_rate)
+{
+  self->info.sample_rate = sample_rate;
+  self->objects = 0;
+}
+
+int
+dlb_oar_query_latency (dlb_oar * self)
+{
+  (void) self;
+  return 0;
+}
+
+int
+dlb_oar_query_min_block_samples (dlb_oar * self)
+{
+  (void) self;
+  return MIN_BLOCK_SAMPLES;
+}
+
+int
+dlb_oar_query_max_block_samples (dlb_oar * self)
+{
+  (void) self;
+  return MAX_BLOCK_SAMPLES;
+}
+
+int
+dlb_oar_query_max_payloads (dlb_oar * self)
+{
+  (void) self;
+  return MAX_PAYLOADS;
+}
@@ -0,0 +1,267 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/*
+ * Helpers shared by the reference stand-ins of the Dolby libraries. The
+ * stubs implement the interfaces the shims bind to with simple,
+ * deterministic processing, they don't reproduce any Dolby algorithm.
+ */
+
+#ifndef __DLB_STUB_H_
+#define __DLB_STUB_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "dlb_buffer.h"
+
+/* extra multiply-adds per processed sample, read from DLB_STUB_COST */
+#define DLB_STUB_COST_ENV "DLB_STUB_COST"
+
+/* synthetic object audio metadata, stands in for OAMD payloads:
+ * magic, version, object count, then x, y, z and gain of every object, one
+ * octet each */
+#define DLB_STUB_OAMD_MAGIC_0 'S'
+#define DLB_STUB_OAMD_MAGIC_1 'O'
+#define DLB_STUB_OAMD_VERSION 1
+#define DLB_STUB_OAMD_HEADER_SIZE 4
+#define DLB_STUB_OAMD_OBJECT_SIZE 4
+#define DLB_STUB_OAMD_MAX_OBJECTS 16
+
+static inline int
+dlb_stub_cost (void)
+{
+  const char *env = getenv (DLB_STUB_COST_ENV);
+  int cost = env ? atoi (env) : 0;
+
+  return cost > 0 ? cost : 0;
+}
+
+/* burns a fixed amount of work per sample, the result is folded into the
+ * signal scaled to nothing so the compiler can't drop the loop */
+static inline float
+dlb_stub_burn (float x, int cost)
+{
+  volatile float acc = x;
+  int i;
+
+  for (i = 0; i < cost; ++i)
+    acc = acc * 0.999f + 0.001f;
+
+  return x + (acc - acc);
+}
+
+static inline size_t
+dlb_stub_sample_size (int data_type)
+{
+  switch (data_type) {
+    case DLB_BUFFER_SHORT_16:
+      return 2;
+    case DLB_BUFFER_DOUBLE:
+      return 8;
+    case DLB_BUFFER_OCTET_UNPACKED:
+    case DLB_BUFFER_OCTET_PACKED:
+      return 1;
+    default:
+      /* LFRACT uses a float container */
+      return 4;
+  }
+}
+
+static inline float
+dlb_stub_read (const dlb_buffer * buf, unsigned ch, size_t i)
+{
+  const void *p = buf->ppdata[ch];
+  size_t pos = i * buf->nstride;
+
+  switch (buf->data_type) {
+    case DLB_BUFFER_SHORT_16:
+      return ((const int16_t *) p)[pos] / 32768.0f;
+    case DLB_BUFFER_INT_LEFT:
+    case DLB_BUFFER_LONG_32:
+      return (float) (((const int32_t *) p)[pos] / 2147483648.0);
+    case DLB_BUFFER_DOUBLE:
+      return (float) ((const double *) p)[pos];
+    default:
+      return ((const float *) p)[pos];
+  }
+}
+
+static inline void
+dlb_stub_write (dlb_buffer * buf, unsigned ch, size_t i, float x)
+{
+  void *p = buf->ppdata[ch];
+  size_t pos = i * buf->nstride;
+
+  if (x > 1.0f)
+    x = 1.0f;
+  else if (x < -1.0f)
+    x = -1.0f;
+
+  switch (buf->data_type) {
+    case DLB_BUFFER_SHORT_16:
+      ((int16_t *) p)[pos] = (int16_t) (x < 1.0f ? x * 32768.0f : 32767.0f);
+      break;
+    case DLB_BUFFER_INT_LEFT:
+    case DLB_BUFFER_LONG_32:
+      ((int32_t *) p)[pos] =
+          (int32_t) (x < 1.0f ? x * 2147483648.0 : 2147483647.0);
+      break;
+    case DLB_BUFFER_DOUBLE:
+      ((double *) p)[pos] = x;
+      break;
+    default:
+      ((float *) p)[pos] = x;
+      break;
+  }
+}
+
+/* output channel an input channel folds into when the layouts differ */
+static inline unsigned
+dlb_stub_fold (unsigned ch, unsigned out_channels)
+{
+  return ch % out_channels;
+}
+
+/* AC-3 and E-AC-3 sync frame header, ETSI TS 102 366 */
+typedef struct dlb_stub_ac3_header_s
+{
+  int eac3;
+  int strmtyp;
+  int rate;
+  int blocks;
+  int acmod;
+  int lfeon;
+  int channels;
+  size_t framesize;
+} dlb_stub_ac3_header;
+
+#define DLB_STUB_AC3_HEADER_SIZE 8
+
+enum
+{
+  DLB_STUB_AC3_OK = 0,
+  DLB_STUB_AC3_NEED_MORE_DATA = 1,
+  DLB_STUB_AC3_INVALID = -1,
+};
+
+static inline int
+dlb_stub_ac3_find_sync (const uint8_t * data, size_t size, size_t * offset)
+{
+  size_t i;
+
+  for (i = 0; i + 1 < size; ++i) {
+    if (data[i] == 0x0b && data[i + 1] == 0x77) {
+      *offset = i;
+      return 1;
+    }
+  }
+
+  *offset = size ? size - 1 : 0;
+  return 0;
+}
+
+static inline int
+dlb_stub_ac3_parse_header (const uint8_t * data, size_t size,
+    dlb_stub_ac3_header * hdr)
+{
+  /* frame size in 16 bit words per frmsizecod and fscod 48, 44.1, 32 kHz */
+  static const uint16_t ac3_frame_words[38][3] = {
+    {64, 69, 96}, {64, 70, 96}, {80, 87, 120}, {80, 88, 120},
+    {96, 104, 144}, {96, 105, 144}, {112, 121, 168}, {112, 122, 168},
+    {128, 139, 192}, {128, 140, 192}, {160, 174, 240}, {160, 175, 240},
+    {192, 208, 288}, {192, 209, 288}, {224, 243, 336}, {224, 244, 336},
+    {256, 278, 384}, {256, 279, 384}, {320, 348, 480}, {320, 349, 480},
+    {384, 417, 576}, {384, 418, 576}, {448, 487, 672}, {448, 488, 672},
+    {512, 557, 768}, {512, 558, 768}, {640, 696, 960}, {640, 697, 960},
+    {768, 835, 1152}, {768, 836, 1152}, {896, 975, 1344}, {896, 976, 1344},
+    {1024, 1114, 1536}, {1024, 1115, 1536}, {1152, 1253, 1728},
+    {1152, 1254, 1728}, {1280, 1393, 1920}, {1280, 1394, 1920},
+  };
+  static const int rates[3] = { 48000, 44100, 32000 };
+  static const int acmod_channels[8] = { 2, 1, 2, 3, 3, 4, 4, 5 };
+  static const int eac3_blocks[4] = { 1, 2, 3, 6 };
+
+  int bsid, fscod;
+
+  if (size < DLB_STUB_AC3_HEADER_SIZE)
+    return DLB_STUB_AC3_NEED_MORE_DATA;
+
+  if (data[0] != 0x0b || data[1] != 0x77)
+    return DLB_STUB_AC3_INVALID;
+
+  bsid = data[5] >> 3;
+
+  if (bsid <= 10) {
+    int frmsizecod = data[4] & 0x3f;
+    int bit = 3;
+
+    fscod = data[4] >> 6;
+    if (fscod == 3 || frmsizecod >= 38)
+      return DLB_STUB_AC3_INVALID;
+
+    hdr->eac3 = 0;
+    hdr->strmtyp = 0;
+    hdr->rate = rates[fscod];
+    hdr->blocks = 6;
+    hdr->framesize = ac3_frame_words[frmsizecod][fscod] * 2;
+    hdr->acmod = data[6] >> 5;
+
+    /* optional mix levels and surround mode precede lfeon */
+    if ((hdr->acmod & 1) && hdr->acmod != 1)
+      bit += 2;
+    if (hdr->acmod & 4)
+      bit += 2;
+    if (hdr->acmod == 2)
+      bit += 2;
+
+    hdr->lfeon = (((data[6] << 8) | data[7]) >> (15 - bit)) & 1;
+  } else if (bsid <= 16) {
+    fscod = data[4] >> 6;
+
+    hdr->eac3 = 1;
+    hdr->strmtyp = data[2] >> 6;
+    hdr->framesize = ((((data[2] & 0x07) << 8) | data[3]) + 1) * 2;
+
+    if (fscod == 3) {
+      int fscod2 = (data[4] >> 4) & 3;
+
+      if (fscod2 == 3)
+        return DLB_STUB_AC3_INVALID;
+
+      hdr->rate = rates[fscod2] / 2;
+      hdr->blocks = 6;
+    } else {
+      hdr->rate = rates[fscod];
+      hdr->blocks = eac3_blocks[(data[4] >> 4) & 3];
+    }
+
+    hdr->acmod = (data[4] >> 1) & 7;
+    hdr->lfeon = data[4] & 1;
+  } else {
+    return DLB_STUB_AC3_INVALID;
+  }
+
+  hdr->channels = acmod_channels[hdr->acmod] + hdr->lfeon;
+  return DLB_STUB_AC3_OK;
+}
+
+#endif // __DLB_STUB_H_
@@ -0,0 +1,287 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+/* Decoder stand-in, every frame decodes to a tone per channel. The tone
+ * depends on the frame header only, so output is reproducible. E-AC-3 in
+ * raw output mode is treated as object audio and carries a synthetic OAMD
+ * payload on the first block of each frame. */
+
+#include "dlb_udc.h"
+#include "dlb_stub.h"
+
+#define CH(ch) DLB_UDC_CHANNEL_MASK (ch)
+
+#define MASK_2_0 (CH (LEFT) | CH (RIGHT))
+#define MASK_3_0 (MASK_2_0 | CH (CENTER))
+#define MASK_4_0 (MASK_2_0 | CH (SIDE_LEFT) | CH (SIDE_RIGHT))
+#define MASK_5_0 (MASK_4_0 | CH (CENTER))
+#define MASK_6_0 (MASK_4_0 | CH (BACK_LEFT) | CH (BACK_RIGHT))
+#define MASK_7_0 (MASK_6_0 | CH (CENTER))
+
+#define OBJECTS DLB_UDC_MAX_RAW_OUTPUT_CHANNELS
+
+/* exported under this name, wrapped as dlb_udc_query_latency_samples */
+int dlb_udc_query_latency (dlb_udc * self);
+
+struct dlb_udc_s
+{
+  dlb_udc_init_info info;
+  dlb_udc_drc_settings drc;
+  int cost;
+
+  /* frame being decoded */
+  dlb_stub_ac3_header hdr;
+  int block;
+  unsigned long frames;
+  uint64_t phase;
+};
+
+static const uint64_t acmod_masks[8] = {
+  MASK_2_0, CH (CENTER), MASK_2_0, MASK_3_0,
+  MASK_2_0 | CH (BACK_CENTER), MASK_3_0 | CH (BACK_CENTER), MASK_4_0, MASK_5_0,
+};
+
+static uint64_t
+outmode_mask (dlb_udc_output_mode mode)
+{
+  switch (mode) {
+    case DLB_UDC_OUTPUT_MODE_2_0:
+      return MASK_2_0;
+    case DLB_UDC_OUTPUT_MODE_2_1:
+      return MASK_2_0 | CH (LFE);
+    case DLB_UDC_OUTPUT_MODE_3_0:
+      return MASK_3_0;
+    case DLB_UDC_OUTPUT_MODE_3_1:
+      return MASK_3_0 | CH (LFE);
+    case DLB_UDC_OUTPUT_MODE_4_0:
+      return MASK_4_0;
+    case DLB_UDC_OUTPUT_MODE_4_1:
+      return MASK_4_0 | CH (LFE);
+    case DLB_UDC_OUTPUT_MODE_5_0:
+      return MASK_5_0;
+    case DLB_UDC_OUTPUT_MODE_5_1:
+      return MASK_5_0 | CH (LFE);
+    case DLB_UDC_OUTPUT_MODE_6_0:
+      return MASK_6_0;
+    case DLB_UDC_OUTPUT_MODE_6_1:
+      return MASK_6_0 | CH (LFE);
+    case DLB_UDC_OUTPUT_MODE_7_0:
+      return MASK_7_0;
+    case DLB_UDC_OUTPUT_MODE_7_1:
+    default:
+      return MASK_7_0 | CH (LFE);
+  }
+}
+
+static int
+mask_channels (uint64_t mask)
+{
+  int n = 0;
+
+  for (; mask; mask &= mask - 1)
+    ++n;
+
+  return n;
+}
+
+dlb_udc *
+dlb_udc_new (const dlb_udc_init_info * info)
+{
+  dlb_udc *self = calloc (1, sizeof (*self));
+
+  if (!self)
+    return NULL;
+
+  self->info = *info;
+  self->cost = dlb_stub_cost ();
+  dlb_udc_drc_settings_init (&self->drc);
+
+  return self;
+}
+
+void
+dlb_udc_free (dlb_udc * self)
+{
+  free (self);
+}
+
+void
+dlb_udc_drc_settings_init (dlb_udc_drc_settings * drc)
+{
+  drc->boost = 1.0;
+  drc->cut = 1.0;
+}
+
+int
+dlb_udc_drc_settings_set (dlb_udc * self, const dlb_udc_drc_settings * drc)
+{
+  if (drc->boost < 0.0 || drc->boost > 1.0 || drc->cut < 0.0
+      || drc->cut > 1.0)
+    return DLB_UDC_EGENERIC;
+
+  self->drc = *drc;
+  return DLB_UDC_OK;
+}
+
+int
+dlb_udc_query_latency (dlb_udc * self)
+{
+  (void) self;
+  return 0;
+}
+
+int
+dlb_udc_query_max_output_channels (dlb_udc_output_mode mode)
+{
+  switch (mode) {
+    case DLB_UDC_OUTPUT_MODE_RAW:
+      return DLB_UDC_MAX_RAW_OUTPUT_CHANNELS;
+    case DLB_UDC_OUTPUT_MODE_CORE:
+      return 6;
+    default:
+      return mask_channels (outmode_mask (mode));
+  }
+}
+
+size_t
+dlb_udc_query_max_outbuf_size (dlb_udc_output_mode mode, int data_type)
+{
+  return dlb_udc_query_max_output_channels (mode) *
+      DLB_UDC_SAMPLES_PER_BLOCK * dlb_stub_sample_size (data_type);
+}
+
+int
+dlb_udc_push_timeslice (dlb_udc * self, const char *indata, size_t indatasz)
+{
+  dlb_stub_ac3_header hdr;
+
+  if (dlb_stub_ac3_parse_header ((const uint8_t *) indata, indatasz, &hdr)
+      || indatasz < hdr.framesize)
+    return DLB_UDC_ENOTFRAMED;
+
+  self->hdr = hdr;
+  self->block = 0;
+  self->frames++;
+  return DLB_UDC_OK;
+}
+
+static size_t
+write_oamd (dlb_udc * self, dlb_evo_payload * metadata)
+{
+  uint8_t *md = metadata->data;
+  int i;
+
+  md[0] = DLB_STUB_OAMD_MAGIC_0;
+  md[1] = DLB_STUB_OAMD_MAGIC_1;
+  md[2] = DLB_STUB_OAMD_VERSION;
+  md[3] = OBJECTS;
+
+  /* objects circle the room, one step per frame */
+  for (i = 0; i < OBJECTS; ++i) {
+    uint8_t *obj = md + DLB_STUB_OAMD_HEADER_SIZE +
+        i * DLB_STUB_OAMD_OBJECT_SIZE;
+
+    obj[0] = (uint8_t) (self->frames * 4 + i * 16);
+    obj[1] = (uint8_t) (i * 16);
+    obj[2] = (uint8_t) (i >= OBJECTS / 2 ? 255 : 0);
+    obj[3] = 255;
+  }
+
+  return DLB_STUB_OAMD_HEADER_SIZE + OBJECTS * DLB_STUB_OAMD_OBJECT_SIZE;
+}
+
+int
+dlb_udc_process_block (dlb_udc * self, dlb_buffer * outbuf, size_t * blocksz,
+    dlb_evo_payload * metadata, dlb_udc_audio_info * audio_info)
+{
+  dlb_buffer block = *outbuf;
+  uint64_t native = acmod_masks[self->hdr.acmod];
+  uint64_t mask;
+  int object_audio, channels, ch, out = 0;
+  float gain;
+  size_t i;
+
+  metadata->id = DLB_UDC_METADATA_ID_INVALID;
+  metadata->size = 0;
+  metadata->offset = 0;
+
+  if (self->block >= self->hdr.blocks) {
+    *blocksz = 0;
+    return DLB_UDC_OK;
+  }
+
+  if (self->hdr.lfeon)
+    native |= CH (LFE);
+
+  object_audio = self->hdr.eac3
+      && self->info.outmode == DLB_UDC_OUTPUT_MODE_RAW;
+
+  if (self->info.outmode == DLB_UDC_OUTPUT_MODE_RAW
+      || self->info.outmode == DLB_UDC_OUTPUT_MODE_CORE)
+    mask = native;
+  else
+    mask = outmode_mask (self->info.outmode);
+
+  channels = object_audio ? OBJECTS : mask_channels (mask);
+  if (channels > (int) outbuf->nchannel)
+    return DLB_UDC_EGENERIC;
+
+  /* interleaved output is packed to the decoded channels */
+  if (block.nstride > 1)
+    block.nstride = channels;
+
+  /* heavy compression keeps the tone well below full scale */
+  gain = (float) (0.5 - 0.25 * self->drc.cut);
+
+  for (ch = 0; ch < DLB_UDC_MAX_RAW_OUTPUT_CHANNELS && out < channels; ++ch) {
+    /* channels missing from the stream stay silent */
+    float level = object_audio || (native & (1ULL << ch)) ? gain : 0.0f;
+    uint64_t period = 32 + 8 * out;
+
+    if (!object_audio && !(mask & (1ULL << ch)))
+      continue;
+
+    for (i = 0; i < DLB_UDC_SAMPLES_PER_BLOCK; ++i) {
+      uint64_t pos = (self->phase + i) % period;
+      float x = level * (2.0f * pos / period - 1.0f);
+
+      dlb_stub_write (&block, out, i, dlb_stub_burn (x, self->cost));
+    }
+
+    ++out;
+  }
+
+  if (object_audio && self->block == 0) {
+    metadata->id = DLB_EVODEC_METADATA_ID_OAMD;
+    metadata->size = write_oamd (self, metadata);
+  }
+
+  audio_info->channel_mask = object_audio ? 0 : mask;
+  audio_info->channels = channels;
+  audio_info->rate = self->hdr.rate;
+  audio_info->object_audio = object_audio;
+
+  *blocksz = DLB_UDC_SAMPLES_PER_BLOCK * channels *
+      dlb_stub_sample_size (outbuf->data_type);
+
+  self->phase += DLB_UDC_SAMPLES_PER_BLOCK;
+  self->block++;
+  return DLB_UDC_OK;
+}
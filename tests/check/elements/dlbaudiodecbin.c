@@ -0,0 +1,314 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <gst/check/gstcheck.h>
+
+static GstElement *pipeline;
+static gint buffers;
+
+static GstPadProbeReturn
+on_output_buffer (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  g_atomic_int_inc (&buffers);
+  return GST_PAD_PROBE_OK;
+}
+
+static void
+dlb_audio_dec_bin_test_setup (void)
+{
+  gchar *filename = g_build_filename (GST_TEST_FILES_PATH, "51_1kHz_ddp.ec3",
+      NULL);
+  gchar *desc = g_strdup_printf ("filesrc location=%s ! dlbaudiodecbin "
+      "name=decbin ! fakesink name=sink", filename);
+  GstElement *sink;
+  GstPad *pad;
+
+  pipeline = gst_parse_launch (desc, NULL);
+  fail_unless (pipeline != NULL);
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, on_output_buffer, NULL,
+      NULL);
+  gst_object_unref (pad);
+  gst_object_unref (sink);
+
+  buffers = 0;
+
+  g_free (desc);
+  g_free (filename);
+}
+
+static void
+dlb_audio_dec_bin_test_teardown (void)
+{
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  pipeline = NULL;
+}
+
+static GstElement *
+get_decbin (void)
+{
+  return gst_bin_get_by_name (GST_BIN (pipeline), "decbin");
+}
+
+/* name of the element the decbin sink pad feeds */
+static gchar *
+get_sink_target_name (GstElement * decbin)
+{
+  GstPad *sinkpad = gst_element_get_static_pad (decbin, "sink");
+  GstPad *target = gst_ghost_pad_get_target (GST_GHOST_PAD (sinkpad));
+  gchar *name;
+
+  fail_unless (target != NULL);
+  name = gst_object_get_name (GST_OBJECT_PARENT (target));
+
+  gst_object_unref (target);
+  gst_object_unref (sinkpad);
+  return name;
+}
+
+static void
+run_to_eos (void)
+{
+  GstBus *bus = gst_element_get_bus (pipeline);
+  GstMessage *msg;
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_PLAYING) !=
+      GST_STATE_CHANGE_FAILURE);
+
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  fail_unless_equals_int (GST_MESSAGE_TYPE (msg), GST_MESSAGE_EOS);
+
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+}
+
+/* sets input-caps and checks whether the first buffer goes to the parser
+ * once the bin reaches @state */
+static void
+check_input_caps (const gchar * caps_str, GstState state, gboolean built)
+{
+  GstElement *decbin = get_decbin ();
+  GstCaps *caps = gst_caps_from_string (caps_str);
+  gchar *name;
+
+  g_object_set (decbin, "input-caps", caps, NULL);
+  gst_caps_unref (caps);
+
+  fail_if (gst_element_set_state (pipeline, state) ==
+      GST_STATE_CHANGE_FAILURE);
+  fail_unless (gst_element_get_state (pipeline, NULL, NULL,
+          GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE);
+
+  name = get_sink_target_name (decbin);
+  fail_unless_equals_int (g_strcmp0 (name, "parser0") == 0, built);
+  g_free (name);
+
+  run_to_eos ();
+  fail_unless (g_atomic_int_get (&buffers) > 0);
+
+  gst_object_unref (decbin);
+}
+
+GST_START_TEST (test_dlb_audio_dec_bin_input_caps)
+{
+  /* chain is built at READY, the first buffer goes to the parser */
+  check_input_caps ("audio/x-eac3", GST_STATE_READY, TRUE);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_audio_dec_bin_input_caps_alias)
+{
+  check_input_caps ("audio/eac3", GST_STATE_READY, TRUE);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_audio_dec_bin_input_caps_unknown)
+{
+  /* not a type the bin decodes, the stream is detected instead */
+  check_input_caps ("audio/mpeg", GST_STATE_READY, FALSE);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_audio_dec_bin_input_caps_in_ready)
+{
+  GstElement *decbin = get_decbin ();
+
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_READY) ==
+      GST_STATE_CHANGE_SUCCESS);
+  gst_object_unref (decbin);
+
+  /* set in READY, applied when going to PAUSED */
+  check_input_caps ("audio/x-eac3", GST_STATE_PAUSED, TRUE);
+}
+
+GST_END_TEST
+
+static gboolean
+has_child (GstElement * decbin, const gchar * name)
+{
+  GstElement *child = gst_bin_get_by_name (GST_BIN (decbin), name);
+
+  if (child)
+    gst_object_unref (child);
+
+  return child != NULL;
+}
+
+GST_START_TEST (test_dlb_audio_dec_bin_threading_single)
+{
+  GstElement *decbin = get_decbin ();
+
+  g_object_set (decbin, "threading", 0, NULL);
+  run_to_eos ();
+
+  fail_unless (g_atomic_int_get (&buffers) > 0);
+  fail_if (has_child (decbin, "decqueue"));
+  fail_if (has_child (decbin, "renderqueue"));
+
+  gst_object_unref (decbin);
+}
+
+GST_END_TEST
+
+#ifdef __linux__
+typedef struct
+{
+  cpu_set_t initial;
+  gint entered;
+  gint restored;
+} StageThreadCheck;
+
+/* runs in the stage thread after the decbin handled the message */
+static GstBusSyncReply
+on_stage_status (GstBus * bus, GstMessage * msg, gpointer user_data)
+{
+  StageThreadCheck *check = user_data;
+  GstStreamStatusType type;
+  GstElement *owner;
+  cpu_set_t set;
+
+  if (GST_MESSAGE_TYPE (msg) != GST_MESSAGE_STREAM_STATUS)
+    return GST_BUS_PASS;
+
+  gst_message_parse_stream_status (msg, &type, &owner);
+  if (g_strcmp0 (GST_ELEMENT_NAME (owner), "decqueue"))
+    return GST_BUS_PASS;
+
+  fail_if (sched_getaffinity (0, sizeof (set), &set));
+
+  if (type == GST_STREAM_STATUS_TYPE_ENTER && CPU_COUNT (&set) == 1 &&
+      CPU_ISSET (0, &set))
+    g_atomic_int_inc (&check->entered);
+  else if (type == GST_STREAM_STATUS_TYPE_LEAVE &&
+      CPU_EQUAL (&set, &check->initial))
+    g_atomic_int_inc (&check->restored);
+
+  return GST_BUS_PASS;
+}
+#endif
+
+GST_START_TEST (test_dlb_audio_dec_bin_threading_pipelined)
+{
+  GstElement *decbin = get_decbin ();
+#ifdef __linux__
+  StageThreadCheck check = { {{0}}, 0, 0 };
+  GstBus *bus = gst_element_get_bus (pipeline);
+
+  fail_if (sched_getaffinity (0, sizeof (check.initial), &check.initial));
+  gst_bus_set_sync_handler (bus, on_stage_status, &check, NULL);
+
+  g_object_set (decbin, "decoder-affinity", G_GUINT64_CONSTANT (0x1), NULL);
+#endif
+
+  g_object_set (decbin, "threading", 1, NULL);
+  run_to_eos ();
+
+  fail_unless (g_atomic_int_get (&buffers) > 0);
+  fail_unless (has_child (decbin, "decqueue"));
+  fail_unless (has_child (decbin, "renderqueue"));
+
+  /* pooled stage threads are given back as they were */
+  fail_unless (gst_element_set_state (pipeline, GST_STATE_NULL) ==
+      GST_STATE_CHANGE_SUCCESS);
+
+#ifdef __linux__
+  if (CPU_ISSET (0, &check.initial)) {
+    fail_unless (g_atomic_int_get (&check.entered) > 0);
+    fail_unless_equals_int (g_atomic_int_get (&check.restored),
+        g_atomic_int_get (&check.entered));
+  }
+
+  gst_bus_set_sync_handler (bus, NULL, NULL, NULL);
+  gst_object_unref (bus);
+#endif
+
+  /* back to a single thread on the next start */
+  g_object_set (decbin, "threading", 0, NULL);
+  buffers = 0;
+  run_to_eos ();
+
+  fail_unless (g_atomic_int_get (&buffers) > 0);
+  fail_if (has_child (decbin, "decqueue"));
+
+  gst_object_unref (decbin);
+}
+
+GST_END_TEST
+
+static Suite *
+dlbaudiodecbin_suite (void)
+{
+  Suite *s = suite_create ("dlbaudiodecbin");
+  TCase *tc_general = tcase_create ("general");
+
+  /* set setup and teardown functions for each test in the test case */
+  tcase_add_checked_fixture (tc_general, dlb_audio_dec_bin_test_setup,
+      dlb_audio_dec_bin_test_teardown);
+
+  /* add tests to the test case */
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_input_caps);
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_input_caps_alias);
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_input_caps_unknown);
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_input_caps_in_ready);
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_threading_single);
+  tcase_add_test (tc_general, test_dlb_audio_dec_bin_threading_pipelined);
+
+  /* add test case to the suite */
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dlbaudiodecbin)
@@ -0,0 +1,212 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+static GstHarness *harness;
+
+#define HARNESS_CAPS                                            \
+  "audio/x-raw, "                                               \
+  "format = (string) " GST_AUDIO_NE (F32) ", "                  \
+  "channels = (int) %d, "                                       \
+  "channel-mask = (bitmask) 0x%" G_GINT64_MODIFIER "x, "        \
+  "rate = (int) 48000, "                                        \
+  "layout = (string) interleaved"                               \
+
+static void
+dlb_ch_mix_test_setup (void)
+{
+  harness = gst_harness_new ("dlbchmix");
+}
+
+static void
+dlb_ch_mix_test_teardown (void)
+{
+  if (harness) {
+    gst_harness_teardown (harness);
+    harness = NULL;
+  }
+}
+
+static void
+set_matrix (const gfloat * matrix, gint rows, gint cols)
+{
+  GValue value = G_VALUE_INIT, row = G_VALUE_INIT, gain = G_VALUE_INIT;
+  gint i, j;
+
+  g_value_init (&value, GST_TYPE_ARRAY);
+  g_value_init (&row, GST_TYPE_ARRAY);
+  g_value_init (&gain, G_TYPE_FLOAT);
+
+  for (i = 0; i < rows; ++i) {
+    for (j = 0; j < cols; ++j) {
+      g_value_set_float (&gain, matrix[i * cols + j]);
+      gst_value_array_append_value (&row, &gain);
+    }
+
+    gst_value_array_append_value (&value, &row);
+    g_value_reset (&row);
+  }
+
+  g_object_set_property (G_OBJECT (harness->element), "mix-matrix", &value);
+
+  g_value_unset (&gain);
+  g_value_unset (&row);
+  g_value_unset (&value);
+}
+
+static void
+set_src_caps (gint channels, guint64 mask)
+{
+  gchar *caps_str = g_strdup_printf (HARNESS_CAPS, channels, mask);
+
+  gst_harness_set_src_caps_str (harness, caps_str);
+  g_free (caps_str);
+}
+
+static GstBuffer *
+create_ramp_buffer (gint channels, gint samples)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gfloat *data;
+  gint i;
+
+  buf = gst_harness_create_buffer (harness, samples * channels * 4);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = (gfloat *) map.data;
+  for (i = 0; i < samples * channels; ++i)
+    data[i] = (i % channels + 1) * 0.1f;
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale_int (samples, GST_SECOND, 48000);
+
+  return buf;
+}
+
+static void
+check_output_info (GstAudioInfo * info)
+{
+  GstCaps *caps = gst_pad_get_current_caps (harness->sinkpad);
+
+  fail_unless (caps != NULL);
+  fail_unless (gst_audio_info_from_caps (info, caps));
+  gst_caps_unref (caps);
+}
+
+GST_START_TEST (test_dlb_ch_mix_upmix_mask)
+{
+  /* stereo to 5.1, center and LFE from both inputs */
+  const gfloat matrix[6 * 2] = {
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+    0.5f, 0.5f,
+    0.5f, 0.5f,
+    1.0f, 0.0f,
+    0.0f, 1.0f,
+  };
+  const gfloat expected[6] = { 0.1f, 0.2f, 0.15f, 0.15f, 0.1f, 0.2f };
+  GstAudioInfo info;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  gfloat *data;
+  gint i;
+
+  set_matrix (matrix, 6, 2);
+  set_src_caps (2, 0x3);
+
+  outbuf = gst_harness_push_and_pull (harness, create_ramp_buffer (2, 256));
+
+  /* more than two channels must be positioned to be parsed downstream */
+  check_output_info (&info);
+  fail_unless_equals_int (GST_AUDIO_INFO_CHANNELS (&info), 6);
+  fail_unless (!GST_AUDIO_INFO_IS_UNPOSITIONED (&info));
+
+  fail_unless_equals_uint64 (gst_buffer_get_size (outbuf), 256 * 6 * 4);
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  data = (gfloat *) map.data;
+  for (i = 0; i < 256 * 6; ++i)
+    fail_unless (ABS (data[i] - expected[i % 6]) < 1e-6f);
+  gst_buffer_unmap (outbuf, &map);
+
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_ch_mix_permute_keeps_mask)
+{
+  /* 5.1 with front left and right swapped */
+  const gfloat matrix[6 * 6] = {
+    0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+    0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f,
+  };
+  GstAudioInfo info;
+  GstCaps *caps;
+  guint64 mask;
+
+  set_matrix (matrix, 6, 6);
+  set_src_caps (6, 0x60f);
+
+  gst_buffer_unref (gst_harness_push_and_pull (harness,
+          create_ramp_buffer (6, 256)));
+
+  /* positions of the input are kept */
+  check_output_info (&info);
+  fail_unless_equals_int (GST_AUDIO_INFO_CHANNELS (&info), 6);
+
+  caps = gst_pad_get_current_caps (harness->sinkpad);
+  fail_unless (gst_structure_get (gst_caps_get_structure (caps, 0),
+          "channel-mask", GST_TYPE_BITMASK, &mask, NULL));
+  fail_unless_equals_uint64 (mask, 0x60f);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST
+
+static Suite *
+dlbchmix_suite (void)
+{
+  Suite *s = suite_create ("dlbchmix");
+  TCase *tc_general = tcase_create ("general");
+
+  /* set setup and teardown functions for each test in the test case */
+  tcase_add_checked_fixture (tc_general, dlb_ch_mix_test_setup,
+      dlb_ch_mix_test_teardown);
+
+  /* add tests to the test case */
+  tcase_add_test (tc_general, test_dlb_ch_mix_upmix_mask);
+  tcase_add_test (tc_general, test_dlb_ch_mix_permute_keeps_mask);
+
+  /* add test case to the suite */
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dlbchmix)
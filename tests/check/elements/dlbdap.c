@@ -20,6 +20,8 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
+#include <gst/controller/gstinterpolationcontrolsource.h>
+#include <gst/controller/gstdirectcontrolbinding.h>
 
 static GstHarness *harness;
 
@@ -401,8 +403,12 @@ GST_START_TEST (test_dap_serialized_settings)
 
   gint channels;
   guint64 channel_mask;
+  gboolean virtualizer_enable;
 
+  /* file is parsed in background, reading a property waits for it */
   gst_harness_set (harness, "dlbdap", "json-config", json_filename, NULL);
+  gst_harness_get (harness, "dlbdap", "virtualizer-enable",
+      &virtualizer_enable, NULL);
   gst_harness_set_src_caps_str (harness, src_pad_caps_str);
 
   srcpad = gst_element_get_static_pad (harness->element, "src");
@@ -449,7 +455,9 @@ GST_START_TEST (test_dap_message_post)
 
   g_object_set (dap, "json-config", json_filename, NULL);
 
-  message = gst_bus_pop_filtered (bus, GST_MESSAGE_ELEMENT);
+  /* posted from the loader thread */
+  message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_ELEMENT);
   fail_unless (message != NULL);
   fail_unless (GST_MESSAGE_SRC (message) == GST_OBJECT (dap));
   fail_unless (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ELEMENT);
@@ -697,6 +705,348 @@ GST_START_TEST (test_dlb_dap_drain_adapter_only)
 }
 GST_END_TEST
 
+GST_START_TEST (test_dlb_dap_crossfade_switch)
+{
+  gint samples = 1024, i;
+  guint switches = 0;
+  gboolean switching = TRUE;
+  GstBuffer *inbuf, *outbuf = NULL;
+  GstStructure *stats = NULL;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  gst_harness_set (harness, "dlbdap", "crossfade-blocks", 2,
+      "virtualizer-enable", FALSE, NULL);
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 0, 0, samples, 48000);
+  gst_buffer_unref (gst_harness_push_and_pull (harness, inbuf));
+
+  gst_harness_set (harness, "dlbdap", "virtualizer-enable", TRUE, NULL);
+
+  /* new instance is created asynchronously, keep streaming until the
+   * crossfade completes */
+  for (i = 1; i < 100 && (switching || !switches); ++i) {
+    inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+    init_buffer (inbuf, i * 1024 * GST_SECOND / 48000, i * samples,
+        samples, 48000);
+    outbuf = gst_harness_push_and_pull (harness, inbuf);
+
+    /* crossfade does not change the output size */
+    fail_unless_equals_int (gst_buffer_get_size (outbuf), samples * 2 * 4);
+    gst_buffer_unref (outbuf);
+
+    gst_harness_get (harness, "dlbdap", "stats", &stats, NULL);
+    fail_unless (gst_structure_get_uint (stats, "switches", &switches));
+    fail_unless (gst_structure_get_boolean (stats, "switching", &switching));
+    gst_structure_free (stats);
+
+    g_usleep (1000);
+  }
+
+  fail_unless_equals_int (switches, 1);
+  fail_if (switching);
+
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_dap_switch_without_crossfade)
+{
+  gint samples = 1024;
+  guint switches = 0;
+  gboolean switching = TRUE;
+  GstBuffer *inbuf, *outbuf;
+  GstStructure *stats = NULL;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  gst_harness_set (harness, "dlbdap", "crossfade-blocks", 0,
+      "virtualizer-enable", FALSE, NULL);
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 0, 0, samples, 48000);
+  gst_buffer_unref (gst_harness_push_and_pull (harness, inbuf));
+
+  gst_harness_set (harness, "dlbdap", "virtualizer-enable", TRUE, NULL);
+
+  /* instance is replaced at the next block boundary */
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 1024 * GST_SECOND / 48000, samples, samples, 48000);
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), samples * 2 * 4);
+  gst_buffer_unref (outbuf);
+
+  gst_harness_get (harness, "dlbdap", "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint (stats, "switches", &switches));
+  fail_unless (gst_structure_get_boolean (stats, "switching", &switching));
+  gst_structure_free (stats);
+
+  fail_unless_equals_int (switches, 1);
+  fail_if (switching);
+
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+/* zone instance is built in background and attached at buffer boundary,
+ * returns main output of the buffer the zone was attached at */
+static GstBuffer *
+push_until_zone_attached (GstHarness * zone, gint samples, gint channels,
+    guint64 * offset)
+{
+  GstBuffer *inbuf, *outbuf = NULL;
+
+  while (!gst_pad_has_current_caps (zone->sinkpad)) {
+    if (outbuf)
+      gst_buffer_unref (outbuf);
+
+    inbuf = gst_harness_create_buffer (harness, samples * channels * 4);
+    init_buffer (inbuf, gst_util_uint64_scale_int (*offset, GST_SECOND,
+            48000), *offset, samples, 48000);
+    outbuf = gst_harness_push_and_pull (harness, inbuf);
+    *offset += samples;
+  }
+
+  return outbuf;
+}
+
+GST_START_TEST (test_dlb_dap_zone_output)
+{
+  gint samples = 1024;
+  guint64 offset = 0;
+  GstHarness *zone;
+  GstBuffer *outbuf, *zonebuf;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+  gchar *zone_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  zone = gst_harness_new_with_element (harness->element, NULL, "src_%u");
+  gst_harness_set_sink_caps_str (zone, zone_pad_caps_str);
+
+  gst_harness_set (harness, "dlbdap", "discard-latency", TRUE, NULL);
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  outbuf = push_until_zone_attached (zone, samples, 6, &offset);
+  zonebuf = gst_harness_pull (zone);
+
+  /* zone trims its own latency and stays aligned with the main output */
+  fail_unless_equals_int (gst_buffer_get_size (zonebuf),
+      (samples - 512) * 2 * 4);
+  fail_unless_equals_clocktime (GST_BUFFER_PTS (zonebuf),
+      GST_BUFFER_PTS (outbuf) + gst_util_uint64_scale_int (
+          gst_buffer_get_size (outbuf) / (6 * 4) - (samples - 512),
+          GST_SECOND, 48000));
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (zonebuf),
+      GST_BUFFER_OFFSET_END (outbuf));
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (zonebuf);
+
+  /* drained on eos to the same amount of samples */
+  gst_harness_push_event (harness, gst_event_new_eos ());
+  outbuf = gst_harness_pull (harness);
+  zonebuf = gst_harness_pull (zone);
+
+  fail_unless_equals_int (gst_buffer_get_size (outbuf) / (6 * 4),
+      gst_buffer_get_size (zonebuf) / (2 * 4));
+
+  gst_buffer_unref (outbuf);
+  gst_buffer_unref (zonebuf);
+  gst_harness_teardown (zone);
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+  g_free (zone_pad_caps_str);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_dap_zone_latency_across_buffers)
+{
+  gint samples = 256, i;
+  guint64 offset = 1024;
+  GstHarness *zone;
+  GstBuffer *inbuf, *outbuf, *zonebuf;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  gst_harness_set (harness, "dlbdap", "discard-latency", TRUE, NULL);
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, 1024 * 2 * 4);
+  init_buffer (inbuf, 0, 0, 1024, 48000);
+  gst_buffer_unref (gst_harness_push_and_pull (harness, inbuf));
+
+  /* zone joins while playing, its latency is longer than one buffer, the
+   * buffer it is attached at is consumed by latency */
+  zone = gst_harness_new_with_element (harness->element, NULL, "src_%u");
+  gst_harness_set_sink_caps_str (zone, src_pad_caps_str);
+
+  gst_buffer_unref (push_until_zone_attached (zone, samples, 2, &offset));
+  fail_unless (gst_harness_try_pull (zone) == NULL);
+
+  for (i = 0; i < 2; ++i) {
+    inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+    init_buffer (inbuf, gst_util_uint64_scale_int (offset, GST_SECOND, 48000),
+        offset, samples, 48000);
+    outbuf = gst_harness_push_and_pull (harness, inbuf);
+    offset += samples;
+
+    if (i < 1) {
+      /* consumed by latency entirely */
+      fail_unless (gst_harness_try_pull (zone) == NULL);
+      gst_buffer_unref (outbuf);
+      continue;
+    }
+
+    zonebuf = gst_harness_pull (zone);
+    fail_unless_equals_int (gst_buffer_get_size (zonebuf), samples * 2 * 4);
+    fail_unless_equals_clocktime (GST_BUFFER_PTS (zonebuf),
+        GST_BUFFER_PTS (outbuf));
+
+    gst_buffer_unref (zonebuf);
+    gst_buffer_unref (outbuf);
+  }
+
+  gst_harness_teardown (zone);
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_dap_controller_sync)
+{
+  gint samples = 1024, pregain = 0;
+  GstControlSource *cs;
+  GstBuffer *inbuf;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  cs = gst_interpolation_control_source_new ();
+  g_object_set (cs, "mode", GST_INTERPOLATION_MODE_LINEAR, NULL);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (cs),
+      0, -960);
+  gst_timed_value_control_source_set (GST_TIMED_VALUE_CONTROL_SOURCE (cs),
+      GST_SECOND, 0);
+
+  gst_object_add_control_binding (GST_OBJECT (harness->element),
+      gst_direct_control_binding_new_absolute (GST_OBJECT (harness->element),
+          "pregain", cs));
+
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 0, 0, samples, 48000);
+  gst_buffer_unref (gst_harness_push_and_pull (harness, inbuf));
+
+  /* last block starts at 768 samples, value interpolated there is
+   * -960 + 960 * 768 / 48000, off by at most one step of rounding */
+  gst_harness_get (harness, "dlbdap", "pregain", &pregain, NULL);
+  fail_unless (ABS (pregain - (-960 + 960 * 768 / 48000)) <= 1,
+      "pregain %d not interpolated", pregain);
+
+  gst_object_unref (cs);
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_dap_idle_bypass)
+{
+  gint samples = 1024;
+  guint64 bypassed = 0, decay, idle_timeout = 0;
+  guint block = 0, latency = 0;
+  gboolean idle = FALSE;
+  GstBuffer *inbuf, *outbuf;
+  GstStructure *stats = NULL;
+  GstMapInfo map;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_PAD_CAPS, "F32LE", 2, 0x3, 48000);
+
+  gst_harness_set (harness, "dlbdap", "idle-timeout", idle_timeout, NULL);
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  /* instance has to process its latency worth of silence first */
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 0, 0, samples, 48000);
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  fail_if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP));
+  gst_buffer_unref (outbuf);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 1024 * GST_SECOND / 48000, samples, samples, 48000);
+  GST_BUFFER_FLAG_SET (inbuf, GST_BUFFER_FLAG_GAP);
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  fail_unless (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP));
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), samples * 2 * 4);
+  gst_buffer_unref (outbuf);
+
+  gst_harness_get (harness, "dlbdap", "stats", &stats, NULL);
+  fail_unless (gst_structure_get_boolean (stats, "idle", &idle));
+  fail_unless (gst_structure_get_uint64 (stats, "bypassed-blocks",
+          &bypassed));
+  fail_unless (gst_structure_get_uint (stats, "block-samples", &block));
+  fail_unless (gst_structure_get_uint (stats, "latency-samples", &latency));
+  gst_structure_free (stats);
+  fail_unless (idle);
+  fail_unless (block > 0);
+
+  /* blocks of silence processed until idle-timeout plus latency is reached
+   * are not bypassed, all the others pushed so far are */
+  decay = gst_util_uint64_scale_int (idle_timeout, 48000, GST_SECOND);
+  decay += latency;
+  fail_unless_equals_uint64 (bypassed,
+      2 * samples / block - (decay + block - 1) / block);
+
+  /* first audible block wakes processing up */
+  inbuf = gst_harness_create_buffer (harness, samples * 2 * 4);
+  init_buffer (inbuf, 2048 * GST_SECOND / 48000, 2 * samples, samples, 48000);
+  gst_buffer_map (inbuf, &map, GST_MAP_WRITE);
+  ((gfloat *) map.data)[0] = 0.5f;
+  gst_buffer_unmap (inbuf, &map);
+
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  fail_if (GST_BUFFER_FLAG_IS_SET (outbuf, GST_BUFFER_FLAG_GAP));
+  gst_buffer_unref (outbuf);
+
+  gst_harness_get (harness, "dlbdap", "stats", &stats, NULL);
+  fail_unless (gst_structure_get_boolean (stats, "idle", &idle));
+  gst_structure_free (stats);
+  fail_if (idle);
+
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
 static Suite *
 dlbdap_suite (void)
 {
@@ -719,6 +1069,12 @@ dlbdap_suite (void)
   tcase_add_test (tc_general, test_dlb_dap_drain_on_flush_event);
   tcase_add_test (tc_general, test_dlb_dap_drain_on_eos_event);
   tcase_add_test (tc_general, test_dlb_dap_drain_adapter_only);
+  tcase_add_test (tc_general, test_dlb_dap_crossfade_switch);
+  tcase_add_test (tc_general, test_dlb_dap_switch_without_crossfade);
+  tcase_add_test (tc_general, test_dlb_dap_zone_output);
+  tcase_add_test (tc_general, test_dlb_dap_zone_latency_across_buffers);
+  tcase_add_test (tc_general, test_dlb_dap_controller_sync);
+  tcase_add_test (tc_general, test_dlb_dap_idle_bypass);
 
   /* add test case to the suite */
   suite_add_tcase (s, tc_general);
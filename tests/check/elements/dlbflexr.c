@@ -20,6 +20,7 @@
 
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstconsistencychecker.h>
+#include <gst/check/gstharness.h>
 
 static GMainLoop *main_loop;
 
@@ -139,6 +140,321 @@ GST_START_TEST (test_dlb_flexr_data_consistency)
   g_free (stream_conf);
 }
 
+GST_END_TEST typedef struct
+{
+  GstElement *pipe;
+  GstElement *flexr;
+  GstElement *src;
+  GstPad *flexrpad;
+  gchar *stream_conf;
+  gint outbufs;
+  gint added_at;
+  gint released_at;
+} PadChangeData;
+
+static gboolean
+release_source (gpointer user_data)
+{
+  PadChangeData *data = user_data;
+  GstPad *srcpad = gst_element_get_static_pad (data->src, "src");
+
+  gst_element_set_state (data->src, GST_STATE_NULL);
+  gst_pad_unlink (srcpad, data->flexrpad);
+  gst_object_unref (srcpad);
+
+  gst_element_release_request_pad (data->flexr, data->flexrpad);
+  g_clear_object (&data->flexrpad);
+  gst_bin_remove (GST_BIN (data->pipe), data->src);
+
+  data->released_at = g_atomic_int_get (&data->outbufs);
+  return G_SOURCE_REMOVE;
+}
+
+static GstPadProbeReturn
+on_source_eos (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  if (GST_EVENT_TYPE (GST_PAD_PROBE_INFO_EVENT (info)) != GST_EVENT_EOS)
+    return GST_PAD_PROBE_OK;
+
+  /* EOS of a released pad must not end the mix */
+  g_idle_add (release_source, user_data);
+  return GST_PAD_PROBE_DROP;
+}
+
+static gboolean
+add_source (gpointer user_data)
+{
+  PadChangeData *data = user_data;
+  GstPad *srcpad;
+
+  data->src = gst_element_factory_make ("audiotestsrc", "src2");
+  g_object_set (data->src, "num-buffers", 10, "samplesperbuffer", 256, NULL);
+  gst_bin_add (GST_BIN (data->pipe), data->src);
+
+  fail_unless (gst_element_link (data->src, data->flexr));
+  srcpad = gst_element_get_static_pad (data->src, "src");
+  data->flexrpad = gst_pad_get_peer (srcpad);
+  gst_object_unref (srcpad);
+
+  g_object_set (data->flexrpad, "stream-config", data->stream_conf, NULL);
+  gst_pad_add_probe (data->flexrpad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      on_source_eos, data, NULL);
+
+  fail_unless (gst_element_sync_state_with_parent (data->src));
+
+  data->added_at = g_atomic_int_get (&data->outbufs);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  PadChangeData *data = user_data;
+
+  if (g_atomic_int_add (&data->outbufs, 1) == 10)
+    g_idle_add (add_source, data);
+}
+
+GST_START_TEST (test_dlb_flexr_pad_add_remove_playing)
+{
+  GstElement *src, *sink;
+  GstPad *srcpad;
+  GstBus *bus;
+  GstStreamConsistency *chk;
+  GstStateChangeReturn state_ret;
+  PadChangeData data = { NULL };
+
+  gchar *device_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.dconf", NULL);
+  data.stream_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.conf", NULL);
+
+  data.pipe = gst_pipeline_new ("pipeline");
+  bus = gst_element_get_bus (data.pipe);
+  gst_bus_add_signal_watch_full (bus, G_PRIORITY_HIGH);
+
+  src = gst_element_factory_make ("audiotestsrc", "src1");
+  g_object_set (src, "num-buffers", 60, "samplesperbuffer", 256, NULL);
+
+  data.flexr = gst_element_factory_make ("dlbflexr", "dlbflexr");
+  g_object_set (data.flexr, "device-config", device_conf, NULL);
+
+  sink = gst_element_factory_make ("fakesink", "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", (GCallback) on_handoff, &data);
+
+  gst_bin_add_many (GST_BIN (data.pipe), src, data.flexr, sink, NULL);
+  fail_unless (gst_element_link_many (src, data.flexr, sink, NULL));
+
+  srcpad = gst_element_get_static_pad (src, "src");
+  data.flexrpad = gst_pad_get_peer (srcpad);
+  g_object_set (data.flexrpad, "stream-config", data.stream_conf, NULL);
+  g_clear_object (&data.flexrpad);
+  gst_object_unref (srcpad);
+
+  /* output timestamps stay contiguous while streams come and go */
+  srcpad = gst_element_get_static_pad (data.flexr, "src");
+  chk = gst_consistency_checker_new (srcpad);
+  gst_object_unref (srcpad);
+
+  g_signal_connect (bus, "message::eos", (GCallback) on_msg, data.pipe);
+
+  state_ret = gst_element_set_state (data.pipe, GST_STATE_PLAYING);
+  fail_unless (state_ret != GST_STATE_CHANGE_FAILURE);
+
+  g_main_loop_run (main_loop);
+
+  state_ret = gst_element_set_state (data.pipe, GST_STATE_NULL);
+  fail_unless (state_ret != GST_STATE_CHANGE_FAILURE);
+
+  fail_unless (data.added_at > 0);
+  fail_unless (data.released_at > data.added_at);
+  fail_unless_equals_int (GST_ELEMENT_CAST (data.flexr)->numsinkpads, 1);
+
+  gst_consistency_checker_free (chk);
+  gst_bus_remove_signal_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (data.pipe);
+  g_free (device_conf);
+  g_free (data.stream_conf);
+}
+
+GST_END_TEST typedef struct
+{
+  guint64 frames;
+  GstClockTime next_pts;
+  gboolean contiguous;
+} DriftCount;
+
+static GstPadProbeReturn
+on_compensated_buffer (GstPad * pad, GstPadProbeInfo * info,
+    gpointer user_data)
+{
+  GstBuffer *buf = GST_PAD_PROBE_INFO_BUFFER (info);
+  DriftCount *count = user_data;
+
+  if (GST_CLOCK_TIME_IS_VALID (count->next_pts)
+      && GST_BUFFER_PTS (buf) != count->next_pts)
+    count->contiguous = FALSE;
+
+  count->next_pts = GST_BUFFER_PTS (buf) + GST_BUFFER_DURATION (buf);
+  count->frames += gst_buffer_get_size (buf) / (2 * sizeof (gfloat));
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_dlb_flexr_drift_compensation)
+{
+  GstHarness *h;
+  GstElement *flexr;
+  GstPad *flexrpad;
+  GstBuffer *buf;
+  DriftCount count = { 0, GST_CLOCK_TIME_NONE, TRUE };
+  GstClockTime duration;
+  gint i;
+
+  const gint frames = 1024;
+  const gint buffers = 200;
+
+  gchar *device_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.dconf", NULL);
+  gchar *stream_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.conf", NULL);
+
+  flexr = gst_element_factory_make ("dlbflexr", NULL);
+  g_object_set (flexr, "device-config", device_conf, NULL);
+
+  h = gst_harness_new_with_element (flexr, "sink_%u", "src");
+  gst_object_unref (flexr);
+
+  flexrpad = gst_pad_get_peer (h->srcpad);
+  g_object_set (flexrpad, "stream-config", stream_conf,
+      "drift-compensation", TRUE, NULL);
+  gst_pad_add_probe (flexrpad, GST_PAD_PROBE_TYPE_BUFFER,
+      on_compensated_buffer, &count, NULL);
+
+  /* clock is picked up when going to PLAYING */
+  gst_harness_use_testclock (h);
+  gst_element_set_state (h->element, GST_STATE_PAUSED);
+  gst_harness_play (h);
+
+  gst_harness_set_upstream_latency (h, 20 * GST_MSECOND);
+  gst_harness_set_src_caps_str (h, "audio/x-raw, format=(string)F32LE, "
+      "channels=(int)2, channel-mask=(bitmask)0x3, rate=(int)48000, "
+      "layout=(string)interleaved");
+
+  /* source clock runs 5% slower than the pipeline clock */
+  duration = gst_util_uint64_scale_int (frames, GST_SECOND, 48000);
+  for (i = 0; i < buffers; ++i) {
+    gst_harness_set_time (h, i * duration * 105 / 100);
+
+    buf = gst_harness_create_buffer (h, frames * 2 * sizeof (gfloat));
+    gst_buffer_memset (buf, 0, 0, frames * 2 * sizeof (gfloat));
+    GST_BUFFER_PTS (buf) = i * duration;
+    GST_BUFFER_DURATION (buf) = duration;
+    if (i == 0)
+      GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+
+    fail_unless_equals_int (gst_harness_push (h, buf), GST_FLOW_OK);
+  }
+
+  /* missing samples are made up for, without gaps in the timeline */
+  fail_unless (count.contiguous);
+  fail_unless (count.frames > (guint64) frames * buffers);
+
+  gst_object_unref (flexrpad);
+  gst_harness_teardown (h);
+  g_free (device_conf);
+  g_free (stream_conf);
+}
+
+GST_END_TEST typedef struct
+{
+  GstElement *flexr;
+  gint outbufs;
+  gsize size;
+  GstClockTime next_pts;
+  gboolean continuous;
+} SwitchData;
+
+static void
+on_switch_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  SwitchData *data = user_data;
+
+  if (GST_CLOCK_TIME_IS_VALID (data->next_pts)
+      && (GST_BUFFER_PTS (buf) != data->next_pts
+          || gst_buffer_get_size (buf) != data->size))
+    data->continuous = FALSE;
+
+  data->next_pts = GST_BUFFER_PTS (buf) + GST_BUFFER_DURATION (buf);
+  data->size = gst_buffer_get_size (buf);
+
+  /* new instance is built and crossfaded to while playing */
+  if (++data->outbufs == 20)
+    g_object_set (data->flexr, "active-channels-enable", TRUE,
+        "active-channels-mask", G_GUINT64_CONSTANT (0x1), NULL);
+}
+
+GST_START_TEST (test_dlb_flexr_switch_active_channels)
+{
+  GstElement *pipe, *src, *sink;
+  GstPad *srcpad, *flexrpad;
+  GstBus *bus;
+  GstStateChangeReturn state_ret;
+  SwitchData data = { NULL, 0, 0, GST_CLOCK_TIME_NONE, TRUE };
+
+  gchar *device_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.dconf", NULL);
+  gchar *stream_conf = g_build_filename (GST_FGEN_FILES_PATH,
+      "stereo.conf", NULL);
+
+  pipe = gst_pipeline_new ("pipeline");
+  bus = gst_element_get_bus (pipe);
+  gst_bus_add_signal_watch_full (bus, G_PRIORITY_HIGH);
+
+  src = gst_element_factory_make ("audiotestsrc", "src");
+  g_object_set (src, "num-buffers", 100, "samplesperbuffer", 256, NULL);
+
+  data.flexr = gst_element_factory_make ("dlbflexr", "dlbflexr");
+  g_object_set (data.flexr, "device-config", device_conf, NULL);
+
+  sink = gst_element_factory_make ("fakesink", "sink");
+  g_object_set (sink, "signal-handoffs", TRUE, NULL);
+  g_signal_connect (sink, "handoff", (GCallback) on_switch_handoff, &data);
+
+  gst_bin_add_many (GST_BIN (pipe), src, data.flexr, sink, NULL);
+  fail_unless (gst_element_link_many (src, data.flexr, sink, NULL));
+
+  srcpad = gst_element_get_static_pad (src, "src");
+  flexrpad = gst_pad_get_peer (srcpad);
+  g_object_set (flexrpad, "stream-config", stream_conf, NULL);
+  gst_object_unref (flexrpad);
+  gst_object_unref (srcpad);
+
+  g_signal_connect (bus, "message::eos", (GCallback) on_msg, pipe);
+
+  state_ret = gst_element_set_state (pipe, GST_STATE_PLAYING);
+  fail_unless (state_ret != GST_STATE_CHANGE_FAILURE);
+
+  g_main_loop_run (main_loop);
+
+  state_ret = gst_element_set_state (pipe, GST_STATE_NULL);
+  fail_unless (state_ret != GST_STATE_CHANGE_FAILURE);
+
+  /* no gaps, overlaps or short buffers around the switch */
+  fail_unless (data.outbufs > 20);
+  fail_unless (data.continuous);
+
+  gst_bus_remove_signal_watch (bus);
+  gst_object_unref (bus);
+  gst_object_unref (pipe);
+  g_free (device_conf);
+  g_free (stream_conf);
+}
+
 GST_END_TEST static Suite *
 dlbflexr_suite (void)
 {
@@ -155,6 +471,9 @@ dlbflexr_suite (void)
     TCase *tc_general = tcase_create ("general");
 
     tcase_add_test (tc_general, test_dlb_flexr_data_consistency);
+    tcase_add_test (tc_general, test_dlb_flexr_pad_add_remove_playing);
+    tcase_add_test (tc_general, test_dlb_flexr_drift_compensation);
+    tcase_add_test (tc_general, test_dlb_flexr_switch_active_channels);
     tcase_add_checked_fixture (tc_general, test_setup, test_teardown);
 
     /* add test case to the suite */
@@ -0,0 +1,297 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+#include <gst/audio/audio.h>
+
+#include "dlbaudiodecoder.h"
+#include "dlbutils.h"
+
+#define FRAME_COUNT 10
+#define AC3_FRAME_SAMPLES 1536
+
+#define HARNESS_SINK_CAPS                                       \
+  "audio/x-raw, "                                               \
+  "format = (string) " GST_AUDIO_NE (F32) ", "                  \
+  "channels = (int) %d, "                                       \
+  "channel-mask = (bitmask) 0x%" G_GINT64_MODIFIER "x, "        \
+  "layout = (string) interleaved"
+
+/* element is started by the harness, so it is restarted to pick the output
+ * layout from the sink caps */
+static GstHarness *
+setup_harness (GstElement * element, const gchar * file, gint channels,
+    guint64 mask)
+{
+  GstHarness *h = gst_harness_new_with_element (element, "sink", "src");
+  GstHarness *hs = gst_harness_new_parse ("filesrc ! dlbac3parse");
+  gchar *filename = g_build_filename (GST_TEST_FILES_PATH, file, NULL);
+  gchar *caps = g_strdup_printf (HARNESS_SINK_CAPS, channels, mask);
+
+  gst_element_set_state (h->element, GST_STATE_READY);
+  gst_harness_set_sink_caps_str (h, caps);
+  gst_harness_play (h);
+
+  gst_harness_add_src_harness (h, hs, TRUE);
+  gst_harness_set (hs, "filesrc", "location", filename, NULL);
+
+  g_free (caps);
+  g_free (filename);
+  return h;
+}
+
+/* returns number of samples received, checks each buffer against caps */
+static gsize
+pull_samples (GstHarness * h, gint channels)
+{
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstAudioInfo info;
+  gsize samples = 0;
+
+  caps = gst_pad_get_current_caps (h->sinkpad);
+  fail_unless (caps);
+  fail_unless (gst_audio_info_from_caps (&info, caps));
+  fail_unless_equals_int (GST_AUDIO_INFO_CHANNELS (&info), channels);
+  fail_unless_equals_int (GST_AUDIO_INFO_RATE (&info), 48000);
+  gst_caps_unref (caps);
+
+  while ((buf = gst_harness_try_pull (h))) {
+    fail_unless_equals_int (gst_buffer_get_size (buf) %
+        GST_AUDIO_INFO_BPF (&info), 0);
+    samples += gst_buffer_get_size (buf) / GST_AUDIO_INFO_BPF (&info);
+    gst_buffer_unref (buf);
+  }
+
+  return samples;
+}
+
+GST_START_TEST (test_dlb_home_audio_channel_based)
+{
+  GstElement *element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  GstHarness *h;
+  GstFlowReturn ret;
+
+  h = setup_harness (element, "51_1kHz_dd.ac3", 6, DLB_CHANNEL_MASK_5_1);
+  gst_object_unref (element);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless (pull_samples (h, 6) > 0);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dlb_home_audio_object_based)
+{
+  GstElement *element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  GstHarness *h;
+  GstFlowReturn ret;
+
+  /* E-AC-3 in raw output mode goes through the renderer */
+  g_object_set (element, "out-mode", DLB_AUDIO_DECODER_OUT_MODE_RAW, NULL);
+  h = setup_harness (element, "51_1kHz_ddp.ec3", 12, DLB_CHANNEL_MASK_7_1_4);
+  gst_object_unref (element);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless (pull_samples (h, 12) > 0);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dlb_home_audio_runtime_params)
+{
+  GstElement *element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  GstHarness *h;
+  GstFlowReturn ret;
+  gsize before, after;
+  gint pregain, angle;
+  gboolean virtualizer_enable;
+
+  h = setup_harness (element, "51_1kHz_ddp.ec3", 6, DLB_CHANNEL_MASK_5_1);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT / 2);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  before = pull_samples (h, 6);
+  fail_unless (before > 0);
+
+  /* gains, profile and virtualizer tuning are applied in place,
+   * virtualizer-enable reopens DAP, drc-cut goes to the running decoder */
+  g_object_set (element, "pregain", 160, "dialog-enhancer-enable", TRUE,
+      "dialog-enhancer-amount", 8, "ieq-enable", TRUE,
+      "virtualizer-front-speaker-angle", 10, "virtualizer-enable", TRUE,
+      "drc-cut", 0.5, NULL);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT / 2);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  after = pull_samples (h, 6);
+  fail_unless (after > 0);
+
+  g_object_get (element, "pregain", &pregain,
+      "virtualizer-front-speaker-angle", &angle,
+      "virtualizer-enable", &virtualizer_enable, NULL);
+  fail_unless_equals_int (pregain, 160);
+  fail_unless_equals_int (angle, 10);
+  fail_unless (virtualizer_enable);
+
+  gst_object_unref (element);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dlb_home_audio_json_config)
+{
+  GstElement *element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  gchar *json_filename = g_build_filename (GST_TEST_FILES_PATH,
+      "default.json", NULL);
+  gint angle, bass_enhancer_boost, pregain, volmax_boost;
+  gboolean virtualizer_enable, ieq_enable;
+  GstHarness *h;
+  GstFlowReturn ret;
+
+  g_object_set (element, "pregain", 0, "json-config", json_filename, NULL);
+  g_object_get (element, "virtualizer-enable", &virtualizer_enable,
+      "virtualizer-front-speaker-angle", &angle,
+      "bass-enhancer-boost", &bass_enhancer_boost,
+      "ieq-enable", &ieq_enable, "pregain", &pregain,
+      "volmax-boost", &volmax_boost, NULL);
+
+  fail_unless (virtualizer_enable);
+  fail_unless_equals_int (angle, 5);
+  fail_unless_equals_int (bass_enhancer_boost, 100);
+  fail_unless (ieq_enable);
+  fail_unless_equals_int (pregain, 30);
+  fail_unless_equals_int (volmax_boost, 200);
+
+  /* properties set later override the file */
+  g_object_set (element, "pregain", 10, NULL);
+  g_object_get (element, "pregain", &pregain, NULL);
+  fail_unless_equals_int (pregain, 10);
+
+  h = setup_harness (element, "51_1kHz_dd.ac3", 6, DLB_CHANNEL_MASK_5_1);
+  gst_object_unref (element);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless (pull_samples (h, 6) > 0);
+
+  g_free (json_filename);
+  gst_harness_teardown (h);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dlb_home_audio_serialized_config)
+{
+  gchar *json_filename = g_build_filename (GST_TEST_FILES_PATH,
+      "default-serialized-config.json", NULL);
+  GstElement *element;
+  GstHarness *h;
+  GstFlowReturn ret;
+
+  /* serialized config matching the negotiated layout opens DAP */
+  element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  g_object_set (element, "json-config", json_filename, NULL);
+  h = setup_harness (element, "51_1kHz_dd.ac3", 2, DLB_CHANNEL_MASK_2_0);
+  gst_object_unref (element);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless (pull_samples (h, 2) > 0);
+  gst_harness_teardown (h);
+
+  /* other layouts fall back to the property settings */
+  element = gst_element_factory_make ("dlbhomeaudio", NULL);
+  g_object_set (element, "json-config", json_filename, NULL);
+  h = setup_harness (element, "51_1kHz_dd.ac3", 6, DLB_CHANNEL_MASK_5_1);
+  gst_object_unref (element);
+
+  ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+  fail_unless_equals_int (ret, GST_FLOW_OK);
+  gst_harness_push_event (h, gst_event_new_eos ());
+
+  fail_unless (pull_samples (h, 6) > 0);
+  gst_harness_teardown (h);
+
+  g_free (json_filename);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_dlb_home_audio_drain)
+{
+  GstElement *element;
+  GstHarness *h;
+  GstFlowReturn ret;
+  gboolean discard;
+
+  /* staged remainder and, with discard-latency, the delayed tail are pushed
+   * at EOS, so output is as long as the decoded stream */
+  for (discard = FALSE; discard <= TRUE; ++discard) {
+    element = gst_element_factory_make ("dlbhomeaudio", NULL);
+    g_object_set (element, "discard-latency", discard, NULL);
+    h = setup_harness (element, "51_1kHz_dd.ac3", 6, DLB_CHANNEL_MASK_5_1);
+    gst_object_unref (element);
+
+    ret = gst_harness_src_crank_and_push_many (h, 0, FRAME_COUNT);
+    fail_unless_equals_int (ret, GST_FLOW_OK);
+    gst_harness_push_event (h, gst_event_new_eos ());
+
+    fail_unless_equals_int (pull_samples (h, 6),
+        FRAME_COUNT * AC3_FRAME_SAMPLES);
+    gst_harness_teardown (h);
+  }
+}
+
+GST_END_TEST;
+
+static Suite *
+dlbhomeaudio_suite (void)
+{
+  Suite *s = suite_create ("dlbhomeaudio");
+  TCase *tc_general = tcase_create ("general");
+
+  tcase_add_test (tc_general, test_dlb_home_audio_channel_based);
+  tcase_add_test (tc_general, test_dlb_home_audio_object_based);
+  tcase_add_test (tc_general, test_dlb_home_audio_runtime_params);
+  tcase_add_test (tc_general, test_dlb_home_audio_json_config);
+  tcase_add_test (tc_general, test_dlb_home_audio_serialized_config);
+  tcase_add_test (tc_general, test_dlb_home_audio_drain);
+
+  suite_add_tcase (s, tc_general);
+  return s;
+}
+
+GST_CHECK_MAIN (dlbhomeaudio)
@@ -289,6 +289,216 @@ GST_START_TEST (test_dlb_oar_drain_adapter_only)
   g_free (src_pad_caps_str);
 }
 GST_END_TEST
+
+GST_START_TEST (test_dlb_oar_channel_based_bypass)
+{
+  gint samples = 16;
+  GstBuffer *inbuf, *outbuf = NULL;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_SINK_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_SRC_PAD_CAPS, "F32LE", 16, 48000, 32);
+
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, sink_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 6 * 4);
+  init_buffer_ts (inbuf, 0, 0, samples, 48000);
+
+  /* channel based input leaves untouched */
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  fail_unless (outbuf == inbuf);
+  gst_buffer_unref (outbuf);
+
+  /* object based input is rendered again by the same element */
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  inbuf = gst_harness_create_buffer (harness, samples * 16 * 4);
+  init_buffer_ts (inbuf, gst_util_uint64_scale_int (samples, GST_SECOND,
+          48000), samples, samples, 48000);
+
+  gst_harness_push (harness, inbuf);
+  gst_harness_push_event (harness, gst_event_new_eos ());
+  outbuf = gst_harness_pull (harness);
+
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), 16 * 6 * 4);
+
+  gst_buffer_unref (outbuf);
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_oar_lfract_input)
+{
+  gint samples = 32;
+  GstBuffer *inbuf, *outbuf;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_SINK_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+
+  /* native format from the decoder is rendered to PCM */
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness,
+      "audio/x-dlb-lfract(" DLB_CAPS_FEATURE_META_OBJECT_AUDIO_META "), "
+      "channels = (int) 16, channel-mask = (bitmask) 0x0, "
+      "rate = (int) 48000, layout = (string) interleaved");
+
+  inbuf = gst_harness_create_buffer (harness, samples * 16 * 4);
+  init_buffer_ts (inbuf, 0, 0, samples, 48000);
+
+  gst_harness_push (harness, inbuf);
+  gst_harness_push_event (harness, gst_event_new_eos ());
+  outbuf = gst_harness_pull (harness);
+
+  fail_unless_equals_int (gst_buffer_get_size (outbuf), samples * 6 * 4);
+
+  gst_buffer_unref (outbuf);
+  g_free (sink_pad_caps_str);
+}
+GST_END_TEST
+
+/* empty payload in the layout understood by the reference renderer */
+static const guint8 oamd_payload[] = { 'S', 'O', 1, 0 };
+
+static guint64
+get_processed_blocks (void)
+{
+  GstStructure *stats;
+  guint64 blocks = 0;
+
+  gst_harness_get (harness, "dlboar", "stats", &stats, NULL);
+  fail_unless (gst_structure_get_uint64 (stats, "blocks", &blocks));
+  gst_structure_free (stats);
+
+  return blocks;
+}
+
+/* pushes 100 samples with a payload taking effect at offset, offset < 0
+ * pushes no payload, returns the number of blocks processed */
+static guint64
+push_with_payload (gint offset, guint64 ts)
+{
+  gint samples = 100, channels = 16;
+  guint64 blocks = get_processed_blocks ();
+  GstBuffer *inbuf, *outbuf;
+
+  inbuf = gst_harness_create_buffer (harness, samples * channels * 4);
+  gst_buffer_memset (inbuf, 0, 0, samples * channels * 4);
+  init_buffer_ts (inbuf, gst_util_uint64_scale_int (ts, GST_SECOND, 48000),
+      ts, samples, 48000);
+
+  if (offset >= 0)
+    dlb_audio_object_meta_add (inbuf, oamd_payload, sizeof (oamd_payload),
+        offset, channels * 4);
+
+  outbuf = gst_harness_push_and_pull (harness, inbuf);
+  gst_buffer_unref (outbuf);
+
+  return get_processed_blocks () - blocks;
+}
+
+GST_START_TEST (test_dlb_oar_blocks_follow_oamd_offsets)
+{
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_SINK_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_SRC_PAD_CAPS, "F32LE", 16, 48000, 32);
+
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  /* 96 of 100 samples fit a single block, 4 stay in the adapter */
+  fail_unless_equals_uint64 (push_with_payload (-1, 0), 1);
+
+  /* block ends where the payload takes effect, 4 + 60 gives blocks of 64
+   * and 32, 8 stay */
+  fail_unless_equals_uint64 (push_with_payload (60, 100), 2);
+
+  /* not aligned to minimal block size, the block ends at the aligned
+   * position below, 8 + 46 gives blocks of 32 and 64, 12 stay */
+  fail_unless_equals_uint64 (push_with_payload (46, 200), 2);
+
+  /* 12 + 10 is within the first minimal block, cannot be split off */
+  fail_unless_equals_uint64 (push_with_payload (10, 300), 1);
+
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+GST_END_TEST
+
+static GstBuffer *
+render_chunks (const gint * chunks, gint n)
+{
+  gint i, j, pos = 0, channels = 16;
+  GstBuffer *inbuf, *outbuf, *res = gst_buffer_new ();
+  GstMapInfo map;
+
+  gchar *sink_pad_caps_str = g_strdup_printf (
+      HARNESS_SINK_PAD_CAPS, "F32LE", 6, 0x3f, 48000);
+  gchar *src_pad_caps_str = g_strdup_printf (
+      HARNESS_SRC_PAD_CAPS, "F32LE", 16, 48000, 32);
+
+  harness = gst_harness_new ("dlboar");
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  for (i = 0; i < n; ++i) {
+    inbuf = gst_harness_create_buffer (harness, chunks[i] * channels * 4);
+    init_buffer_ts (inbuf, gst_util_uint64_scale_int (pos, GST_SECOND,
+            48000), pos, chunks[i], 48000);
+
+    gst_buffer_map (inbuf, &map, GST_MAP_WRITE);
+    for (j = 0; j < chunks[i] * channels; ++j)
+      ((gfloat *) map.data)[j] = (gfloat) (pos * channels + j) / 65536;
+    gst_buffer_unmap (inbuf, &map);
+
+    pos += chunks[i];
+    gst_harness_push (harness, inbuf);
+
+    while ((outbuf = gst_harness_try_pull (harness)))
+      res = gst_buffer_append (res, outbuf);
+  }
+
+  gst_harness_teardown (harness);
+  harness = NULL;
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+  return res;
+}
+
+GST_START_TEST (test_dlb_oar_rebase_straddling_blocks)
+{
+  const gint aligned[] = { 32, 32, 32 };
+  const gint straddling[] = { 40, 24, 20, 12 };
+  GstBuffer *ref, *out;
+  GstMapInfo refmap, outmap;
+
+  /* teardown of the fixture harness, each run needs a fresh element */
+  gst_harness_teardown (harness);
+  harness = NULL;
+
+  /* the same 96 samples rendered in 32 sample blocks, either each block is
+   * a buffer of its own or blocks straddle buffers and the wrappers are
+   * rebased onto the adapter's staging copy */
+  ref = render_chunks (aligned, G_N_ELEMENTS (aligned));
+  out = render_chunks (straddling, G_N_ELEMENTS (straddling));
+
+  fail_unless_equals_int (gst_buffer_get_size (ref), 96 * 6 * 4);
+  fail_unless_equals_int (gst_buffer_get_size (out), 96 * 6 * 4);
+
+  gst_buffer_map (ref, &refmap, GST_MAP_READ);
+  gst_buffer_map (out, &outmap, GST_MAP_READ);
+  fail_unless (memcmp (refmap.data, outmap.data, refmap.size) == 0);
+  gst_buffer_unmap (ref, &refmap);
+  gst_buffer_unmap (out, &outmap);
+
+  gst_buffer_unref (ref);
+  gst_buffer_unref (out);
+}
+GST_END_TEST
+
 static Suite *
 dlboar_suite (void)
 {
@@ -305,6 +515,10 @@ dlboar_suite (void)
   tcase_add_test (tc_general, test_dlb_oar_drain_on_flush_event);
   tcase_add_test (tc_general, test_dlb_oar_drain_on_eos_event);
   tcase_add_test (tc_general, test_dlb_oar_drain_adapter_only);
+  tcase_add_test (tc_general, test_dlb_oar_channel_based_bypass);
+  tcase_add_test (tc_general, test_dlb_oar_lfract_input);
+  tcase_add_test (tc_general, test_dlb_oar_blocks_follow_oamd_offsets);
+  tcase_add_test (tc_general, test_dlb_oar_rebase_straddling_blocks);
 
   /* add test case to the suite */
   suite_add_tcase (s, tc_general);
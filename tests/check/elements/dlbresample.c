@@ -0,0 +1,193 @@
+/*******************************************************************************
+
+ * Dolby Home Audio GStreamer Plugins
+ * Copyright (C) 2022, Dolby Laboratories
+
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ ******************************************************************************/
+
+#include <math.h>
+
+#include <gst/check/gstcheck.h>
+#include <gst/check/gstharness.h>
+
+static GstHarness *harness;
+
+#define HARNESS_CAPS                                            \
+  "audio/x-raw, "                                               \
+  "format = (string) " GST_AUDIO_NE (F32) ", "                  \
+  "channels = (int) %d, "                                       \
+  "rate = (int) %d, "                                           \
+  "layout = (string) interleaved"                               \
+
+static void
+dlb_resample_test_setup (void)
+{
+  harness = gst_harness_new ("dlbresample");
+}
+
+static void
+dlb_resample_test_teardown (void)
+{
+  if (harness) {
+    gst_harness_teardown (harness);
+    harness = NULL;
+  }
+}
+
+static void
+set_harness_caps (gint channels, gint inrate)
+{
+  gchar *src_pad_caps_str = g_strdup_printf (HARNESS_CAPS, channels, inrate);
+  gchar *sink_pad_caps_str = g_strdup_printf (HARNESS_CAPS, channels, 48000);
+
+  gst_harness_set_sink_caps_str (harness, sink_pad_caps_str);
+  gst_harness_set_src_caps_str (harness, src_pad_caps_str);
+
+  g_free (sink_pad_caps_str);
+  g_free (src_pad_caps_str);
+}
+
+static GstBuffer *
+create_dc_buffer (gint channels, gint samples, gint rate, gfloat value)
+{
+  GstBuffer *buf;
+  GstMapInfo map;
+  gfloat *data;
+  gint i;
+
+  buf = gst_harness_create_buffer (harness, samples * channels * 4);
+  gst_buffer_map (buf, &map, GST_MAP_WRITE);
+  data = (gfloat *) map.data;
+  for (i = 0; i < samples * channels; ++i)
+    data[i] = value;
+  gst_buffer_unmap (buf, &map);
+
+  GST_BUFFER_PTS (buf) = 0;
+  GST_BUFFER_OFFSET (buf) = 0;
+  GST_BUFFER_DURATION (buf) =
+      gst_util_uint64_scale_int (samples, GST_SECOND, rate);
+
+  return buf;
+}
+
+GST_START_TEST (test_dlb_resample_32k_output_size)
+{
+  gint channels = 2, samples = 1000;
+  GstBuffer *outbuf;
+
+  set_harness_caps (channels, 32000);
+
+  outbuf = gst_harness_push_and_pull (harness,
+      create_dc_buffer (channels, samples, 32000, 0.0f));
+
+  /* 3 / 2 ratio */
+  fail_unless_equals_uint64 (gst_buffer_get_size (outbuf),
+      1500 * channels * 4);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET (outbuf), 0);
+  fail_unless_equals_uint64 (GST_BUFFER_OFFSET_END (outbuf), 1500);
+  fail_unless_equals_clocktime (GST_BUFFER_PTS (outbuf), 0);
+  fail_unless_equals_clocktime (GST_BUFFER_DURATION (outbuf),
+      gst_util_uint64_scale_int (1500, GST_SECOND, 48000));
+
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_resample_44k_output_size)
+{
+  gint channels = 6, samples = 1000;
+  GstBuffer *outbuf;
+
+  set_harness_caps (channels, 44100);
+
+  outbuf = gst_harness_push_and_pull (harness,
+      create_dc_buffer (channels, samples, 44100, 0.0f));
+
+  /* 160 / 147 ratio, 1000 * 160 / 147 rounded up */
+  fail_unless_equals_uint64 (gst_buffer_get_size (outbuf),
+      1089 * channels * 4);
+
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_resample_dc_gain)
+{
+  gint channels = 1, samples = 1000;
+  GstBuffer *outbuf;
+  GstMapInfo map;
+  gfloat *data;
+  gint i, frames;
+
+  set_harness_caps (channels, 32000);
+
+  outbuf = gst_harness_push_and_pull (harness,
+      create_dc_buffer (channels, samples, 32000, 0.5f));
+
+  gst_buffer_map (outbuf, &map, GST_MAP_READ);
+  data = (gfloat *) map.data;
+  frames = map.size / (channels * 4);
+
+  /* skip the filter delay, the rest is settled */
+  for (i = 200; i < frames; ++i)
+    fail_unless (fabsf (data[i] - 0.5f) < 1e-3f);
+
+  gst_buffer_unmap (outbuf, &map);
+  gst_buffer_unref (outbuf);
+}
+
+GST_END_TEST
+
+GST_START_TEST (test_dlb_resample_latency)
+{
+  GstClockTime latency;
+
+  set_harness_caps (2, 44100);
+  gst_buffer_unref (gst_harness_push_and_pull (harness,
+          create_dc_buffer (2, 1000, 44100, 0.0f)));
+
+  latency = gst_harness_query_latency (harness);
+  fail_unless (latency > 0);
+  fail_unless (latency < 5 * GST_MSECOND);
+}
+
+GST_END_TEST
+
+static Suite *
+dlbresample_suite (void)
+{
+  Suite *s = suite_create ("dlbresample");
+  TCase *tc_general = tcase_create ("general");
+
+  /* set setup and teardown functions for each test in the test case */
+  tcase_add_checked_fixture (tc_general, dlb_resample_test_setup,
+      dlb_resample_test_teardown);
+
+  /* add tests to the test case */
+  tcase_add_test (tc_general, test_dlb_resample_32k_output_size);
+  tcase_add_test (tc_general, test_dlb_resample_44k_output_size);
+  tcase_add_test (tc_general, test_dlb_resample_dc_gain);
+  tcase_add_test (tc_general, test_dlb_resample_latency);
+
+  /* add test case to the suite */
+  suite_add_tcase (s, tc_general);
+
+  return s;
+}
+
+GST_CHECK_MAIN (dlbresample)
@@ -18,11 +18,18 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  ******************************************************************************/
 
+#include <string.h>
+
 #include <gst/check/gstcheck.h>
 #include <gst/check/gstharness.h>
 #include <gst/gst.h>
+#include <glib/gstdio.h>
 
 #include "dlbutils.h"
+#include "dlbconfigloader.h"
+#include "dlbparammailbox.h"
+#include "dlbchannelmix.h"
+#include "dlbcapscache.h"
 
 GST_START_TEST (test_dlb_utils_buffer_data_type)
 {
@@ -123,6 +130,428 @@ GST_START_TEST (test_dlb_utils_buffer_reordering)
 }
 
 GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_audio_is_silent)
+{
+  GstAudioInfo info;
+  gfloat fdata[4] = { 0.0f, -0.0f, 0.0f, 0.0f };
+  gint16 sdata[4] = { 0, 0, 0, 0 };
+
+  gst_audio_info_init (&info);
+  gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_F32, 48000, 2, NULL);
+
+  fail_unless (dlb_audio_is_silent ((guint8 *) fdata, 2, &info, 0.0));
+
+  fdata[3] = -0.001f;
+  fail_if (dlb_audio_is_silent ((guint8 *) fdata, 2, &info, 0.0));
+  fail_unless (dlb_audio_is_silent ((guint8 *) fdata, 2, &info, 0.01));
+  fail_unless (dlb_audio_is_silent ((guint8 *) fdata, 1, &info, 0.0));
+
+  gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_S16, 48000, 2, NULL);
+
+  fail_unless (dlb_audio_is_silent ((guint8 *) sdata, 2, &info, 0.0));
+
+  sdata[1] = -300;
+  fail_if (dlb_audio_is_silent ((guint8 *) sdata, 2, &info, 0.0));
+  fail_unless (dlb_audio_is_silent ((guint8 *) sdata, 2, &info, 0.01));
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_positions_to_dlb_order)
+{
+  GstAudioChannelPosition dlb_pos[64];
+  GstAudioChannelPosition pos[8] = {
+    GST_AUDIO_CHANNEL_POSITION_FRONT_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_FRONT_RIGHT,
+    GST_AUDIO_CHANNEL_POSITION_FRONT_CENTER,
+    GST_AUDIO_CHANNEL_POSITION_LFE1,
+    GST_AUDIO_CHANNEL_POSITION_REAR_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT,
+    GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT,
+  };
+  GstAudioChannelPosition expected[8] = {
+    GST_AUDIO_CHANNEL_POSITION_FRONT_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_FRONT_RIGHT,
+    GST_AUDIO_CHANNEL_POSITION_FRONT_CENTER,
+    GST_AUDIO_CHANNEL_POSITION_LFE1,
+    GST_AUDIO_CHANNEL_POSITION_SIDE_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_SIDE_RIGHT,
+    GST_AUDIO_CHANNEL_POSITION_REAR_LEFT,
+    GST_AUDIO_CHANNEL_POSITION_REAR_RIGHT,
+  };
+  gint i;
+
+  fail_unless (dlb_audio_channel_positions_to_dlb_order (pos, 8, dlb_pos));
+  for (i = 0; i < 8; ++i)
+    fail_unless_equals_int (dlb_pos[i], expected[i]);
+
+  for (i = 0; i < 8; ++i)
+    pos[i] = GST_AUDIO_CHANNEL_POSITION_NONE;
+
+  fail_unless (dlb_audio_channel_positions_to_dlb_order (pos, 8, dlb_pos));
+  for (i = 0; i < 8; ++i)
+    fail_unless_equals_int (dlb_pos[i], GST_AUDIO_CHANNEL_POSITION_NONE);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_audio_crossfade)
+{
+  GstAudioInfo info;
+  gfloat out[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+  gfloat in[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+  gfloat *ramp = dlb_audio_crossfade_ramp_new (2);
+
+  gst_audio_info_init (&info);
+  gst_audio_info_set_format (&info, GST_AUDIO_FORMAT_F32, 48000, 2, NULL);
+
+  /* fade out over 2 samples, the rest is taken from the new signal */
+  dlb_audio_crossfade ((guint8 *) out, (const guint8 *) in, 4, &info, ramp,
+      0, 2);
+
+  fail_unless_equals_float (out[0], 1.0f);
+  fail_unless_equals_float (out[1], 1.0f);
+  fail_unless (ABS (out[2] - G_SQRT2 / 2) < 1e-6);
+  fail_unless (ABS (out[3] - G_SQRT2 / 2) < 1e-6);
+  fail_unless (ABS (out[4]) < 1e-6);
+  fail_unless (ABS (out[7]) < 1e-6);
+
+  g_free (ramp);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_channel_mix)
+{
+  const gfloat swap[] = { 0, 1, 1, 0 };
+  const gfloat copy[] = { 1, 0, 0, 1, 0, 0, 1, 0 };
+  const gfloat upmix[] = { 0.5f, 0.5f };
+  const gfloat mix[] = { 1, 0.5f, 0, 1 };
+  gfloat f32[6] = { 1, 2, 3, 4, 5, 6 };
+  gfloat out[12];
+  gint16 s16[2] = { 30000, -100 };
+  gint16 s16out[4];
+  DlbChannelMix *m;
+
+  /* permutation in place */
+  m = dlb_channel_mix_new (swap, 2, 2);
+  fail_unless_equals_int (dlb_channel_mix_get_kind (m),
+      DLB_CHANNEL_MIX_PERMUTATION);
+  dlb_channel_mix_process (m, (guint8 *) f32, (guint8 *) f32, 3,
+      GST_AUDIO_FORMAT_F32);
+  fail_unless_equals_float (f32[0], 2);
+  fail_unless_equals_float (f32[1], 1);
+  fail_unless_equals_float (f32[5], 5);
+  dlb_channel_mix_free (m);
+
+  /* duplication with a silent output */
+  m = dlb_channel_mix_new (copy, 2, 4);
+  fail_unless_equals_int (dlb_channel_mix_get_kind (m),
+      DLB_CHANNEL_MIX_DUPLICATION);
+  dlb_channel_mix_process (m, (guint8 *) f32, (guint8 *) out, 3,
+      GST_AUDIO_FORMAT_F32);
+  fail_unless_equals_float (out[0], 2);
+  fail_unless_equals_float (out[1], 1);
+  fail_unless_equals_float (out[2], 0);
+  fail_unless_equals_float (out[3], 2);
+  fail_unless_equals_float (out[11], 6);
+  dlb_channel_mix_free (m);
+
+  /* scaled mono upmix, integer output is rounded */
+  m = dlb_channel_mix_new (upmix, 1, 2);
+  fail_unless_equals_int (dlb_channel_mix_get_kind (m),
+      DLB_CHANNEL_MIX_SPARSE);
+  dlb_channel_mix_process (m, (guint8 *) s16, (guint8 *) s16out, 2,
+      GST_AUDIO_FORMAT_S16);
+  fail_unless_equals_int (s16out[0], 15000);
+  fail_unless_equals_int (s16out[1], 15000);
+  fail_unless_equals_int (s16out[2], -50);
+  dlb_channel_mix_free (m);
+
+  /* weighted sum */
+  m = dlb_channel_mix_new (mix, 2, 2);
+  fail_unless_equals_int (dlb_channel_mix_get_kind (m),
+      DLB_CHANNEL_MIX_SPARSE);
+  dlb_channel_mix_process (m, (guint8 *) f32, (guint8 *) f32, 3,
+      GST_AUDIO_FORMAT_F32);
+  fail_unless_equals_float (f32[0], 2.5f);
+  fail_unless_equals_float (f32[1], 1);
+  dlb_channel_mix_free (m);
+}
+GST_END_TEST
+
+static gpointer
+read_config (const gchar * filename, gpointer user_data, GError ** error)
+{
+  gchar *contents = NULL;
+
+  g_file_get_contents (filename, &contents, NULL, error);
+  return contents;
+}
+
+GST_START_TEST (test_dlb_utils_config_loader)
+{
+  DlbConfigLoader *loader;
+  gchar *filename, *config;
+  gint fd;
+
+  fd = g_file_open_tmp ("dlbconfigloader-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  g_close (fd, NULL);
+
+  loader = dlb_config_loader_new (read_config, g_free, NULL, NULL);
+  fail_unless (dlb_config_loader_take (loader) == NULL);
+
+  fail_unless (g_file_set_contents (filename, "first", -1, NULL));
+  dlb_config_loader_set_filename (loader, filename);
+  dlb_config_loader_wait (loader);
+
+  config = dlb_config_loader_take (loader);
+  fail_unless_equals_string (config, "first");
+  fail_unless (dlb_config_loader_take (loader) == NULL);
+  g_free (config);
+
+  /* setting the same file again forces reload */
+  fail_unless (g_file_set_contents (filename, "second", -1, NULL));
+  dlb_config_loader_set_filename (loader, filename);
+  dlb_config_loader_wait (loader);
+
+  config = dlb_config_loader_take (loader);
+  fail_unless_equals_string (config, "second");
+  g_free (config);
+
+  /* unconsumed config is released together with the loader */
+  dlb_config_loader_set_filename (loader, filename);
+  dlb_config_loader_wait (loader);
+  dlb_config_loader_free (loader);
+
+  g_unlink (filename);
+  g_free (filename);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_param_mailbox)
+{
+  DlbParamMailbox *mailbox;
+  const gint *params;
+  gint initial[2] = { 1, 2 };
+  gint *shadow;
+  guint groups;
+
+  mailbox = dlb_param_mailbox_new (sizeof (initial), initial);
+
+  params = dlb_param_mailbox_read (mailbox, &groups);
+  fail_unless_equals_int (groups, 0);
+  fail_unless_equals_int (params[0], 1);
+  fail_unless_equals_int (params[1], 2);
+
+  /* nothing is published for an empty transaction */
+  shadow = dlb_param_mailbox_lock (mailbox);
+  shadow[0] = 10;
+  dlb_param_mailbox_unlock (mailbox, 0);
+
+  params = dlb_param_mailbox_read (mailbox, &groups);
+  fail_unless_equals_int (groups, 0);
+  fail_unless_equals_int (params[0], 1);
+
+  /* only the latest snapshot is seen, groups are accumulated */
+  shadow = dlb_param_mailbox_lock (mailbox);
+  shadow[1] = 20;
+  dlb_param_mailbox_unlock (mailbox, 1 << 1);
+
+  shadow = dlb_param_mailbox_lock (mailbox);
+  fail_unless_equals_int (shadow[1], 20);
+  shadow[1] = 30;
+  dlb_param_mailbox_unlock (mailbox, 1 << 0);
+
+  params = dlb_param_mailbox_read (mailbox, &groups);
+  fail_unless_equals_int (groups, (1 << 0) | (1 << 1));
+  fail_unless_equals_int (params[0], 10);
+  fail_unless_equals_int (params[1], 30);
+
+  params = dlb_param_mailbox_read (mailbox, &groups);
+  fail_unless_equals_int (groups, 0);
+  fail_unless_equals_int (params[1], 30);
+
+  dlb_param_mailbox_free (mailbox);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_lfract_caps)
+{
+  GstCaps *raw, *lfract, *back;
+  GstStructure *s;
+  GstAudioInfo info;
+  GstAudioFormat container = dlb_audio_lfract_container ();
+  gboolean is_lfract;
+  guint8 data[64];
+  dlb_buffer *buf;
+
+  raw = gst_caps_from_string ("audio/x-raw(meta:DlbObjectAudioMeta), "
+      "format = (string) S16LE, channels = (int) 2, rate = (int) 48000, "
+      "layout = (string) interleaved; audio/x-ac3");
+
+  /* native format is refused while its sample size is not known */
+  if (container == GST_AUDIO_FORMAT_UNKNOWN) {
+    lfract = dlb_audio_caps_to_lfract (raw);
+    fail_unless (gst_caps_is_empty (lfract));
+    gst_caps_unref (lfract);
+
+    lfract = gst_caps_from_string (DLB_AUDIO_LFRACT_CAPS_NAME
+        ", channels = (int) 2, rate = (int) 48000, "
+        "layout = (string) interleaved");
+    fail_if (dlb_audio_info_from_caps (&info, lfract, &is_lfract));
+    gst_caps_unref (lfract);
+    gst_caps_unref (raw);
+    return;
+  }
+
+  /* only audio/x-raw structures are converted, features are kept */
+  lfract = dlb_audio_caps_to_lfract (raw);
+  fail_unless_equals_int (gst_caps_get_size (lfract), 1);
+  s = gst_caps_get_structure (lfract, 0);
+  fail_unless (gst_structure_has_name (s, DLB_AUDIO_LFRACT_CAPS_NAME));
+  fail_unless (!gst_structure_has_field (s, "format"));
+  fail_unless (gst_caps_features_contains (gst_caps_get_features (lfract, 0),
+          "meta:DlbObjectAudioMeta"));
+
+  /* parsed as the container format */
+  fail_unless (dlb_audio_info_from_caps (&info, lfract, &is_lfract));
+  fail_unless (is_lfract);
+  fail_unless_equals_int (GST_AUDIO_INFO_FORMAT (&info), container);
+  fail_unless_equals_int (GST_AUDIO_INFO_CHANNELS (&info), 2);
+
+  back = dlb_audio_caps_from_lfract (lfract);
+  s = gst_caps_get_structure (back, 0);
+  fail_unless (gst_structure_has_name (s, "audio/x-raw"));
+  fail_unless_equals_string (gst_structure_get_string (s, "format"),
+      gst_audio_format_to_string (container));
+
+  fail_unless (dlb_audio_info_from_caps (&info, raw, &is_lfract));
+  fail_unless (!is_lfract);
+  fail_unless_equals_int (GST_AUDIO_INFO_FORMAT (&info), GST_AUDIO_FORMAT_S16);
+
+  /* native samples are mapped with the container size */
+  buf = dlb_buffer_new (&info);
+  buf->data_type = DLB_BUFFER_LFRACT;
+  dlb_buffer_map_memory (buf, data);
+  fail_unless (buf->ppdata[1] == data +
+      GST_AUDIO_FORMAT_INFO_WIDTH (gst_audio_format_get_info (container)) / 8);
+  dlb_buffer_free (buf);
+
+  gst_caps_unref (raw);
+  gst_caps_unref (lfract);
+  gst_caps_unref (back);
+}
+GST_END_TEST
+
+GST_START_TEST (test_dlb_utils_caps_cache)
+{
+  DlbCapsCache *cache = dlb_caps_cache_new (2);
+  GstCaps *a, *a2, *b, *c, *result, *cached;
+  guint cookie, stale;
+
+  a = gst_caps_from_string ("audio/x-raw, channels = (int) 2");
+  a2 = gst_caps_from_string ("audio/x-raw, channels = (int) 2");
+  b = gst_caps_from_string ("audio/x-raw, channels = (int) 6");
+  c = gst_caps_from_string ("audio/x-raw, channels = (int) 8");
+  result = gst_caps_from_string ("audio/x-raw, channels = (int) [ 2, 8 ]");
+
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SINK, a, NULL,
+          &cookie) == NULL);
+  dlb_caps_cache_insert (cache, GST_PAD_SINK, a, NULL, result, cookie);
+
+  /* keyed by equal caps, direction and filter */
+  cached = dlb_caps_cache_lookup (cache, GST_PAD_SINK, a2, NULL, NULL);
+  fail_unless (cached == result);
+  gst_caps_unref (cached);
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SRC, a, NULL,
+          NULL) == NULL);
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SINK, a, b,
+          NULL) == NULL);
+
+  /* oldest result is evicted */
+  dlb_caps_cache_lookup (cache, GST_PAD_SINK, b, NULL, &cookie);
+  dlb_caps_cache_insert (cache, GST_PAD_SINK, b, NULL, result, cookie);
+  dlb_caps_cache_lookup (cache, GST_PAD_SINK, c, NULL, &cookie);
+  dlb_caps_cache_insert (cache, GST_PAD_SINK, c, NULL, result, cookie);
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SINK, a, NULL,
+          NULL) == NULL);
+
+  /* results computed before invalidation are not stored */
+  dlb_caps_cache_lookup (cache, GST_PAD_SINK, a, NULL, &stale);
+  dlb_caps_cache_invalidate (cache);
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SINK, b, NULL,
+          NULL) == NULL);
+  dlb_caps_cache_insert (cache, GST_PAD_SINK, a, NULL, result, stale);
+  fail_unless (dlb_caps_cache_lookup (cache, GST_PAD_SINK, a, NULL,
+          NULL) == NULL);
+
+  dlb_caps_cache_free (cache);
+  gst_caps_unref (a);
+  gst_caps_unref (a2);
+  gst_caps_unref (b);
+  gst_caps_unref (c);
+  gst_caps_unref (result);
+}
+GST_END_TEST
+
+static gint
+fake_shim_stats_query (gint index, const gchar ** name,
+    unsigned long long *calls, unsigned long long *total_ns,
+    unsigned long long *buckets, gint nbuckets)
+{
+  static const gchar *names[] = { "dlb_fake_process", "dlb_fake_reset" };
+
+  if ((guint) index >= G_N_ELEMENTS (names))
+    return 1;
+
+  *name = names[index];
+  memset (buckets, 0, nbuckets * sizeof (*buckets));
+
+  /* reset was never called */
+  *calls = index ? 0 : 3;
+  *total_ns = index ? 0 : 2100;
+  if (!index) {
+    buckets[9] = 2;
+    buckets[10] = 1;
+  }
+
+  return 0;
+}
+
+GST_START_TEST (test_dlb_utils_shim_stats)
+{
+  GstStructure *stats = gst_structure_new_empty ("stats");
+  const GstStructure *call;
+  const GValue *histogram;
+  guint64 calls, total_ns;
+
+  dlb_shim_stats_append (stats, fake_shim_stats_query);
+
+  fail_unless_equals_int (gst_structure_n_fields (stats), 1);
+  fail_if (gst_structure_has_field (stats, "dlb_fake_reset"));
+
+  call = gst_value_get_structure (gst_structure_get_value (stats,
+          "dlb_fake_process"));
+  fail_unless (gst_structure_get_uint64 (call, "calls", &calls));
+  fail_unless (gst_structure_get_uint64 (call, "total-ns", &total_ns));
+  fail_unless_equals_uint64 (calls, 3);
+  fail_unless_equals_uint64 (total_ns, 2100);
+
+  /* trimmed after the last non-empty bucket */
+  histogram = gst_structure_get_value (call, "histogram");
+  fail_unless_equals_int (gst_value_array_get_size (histogram), 11);
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (histogram, 0)), 0);
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (histogram, 9)), 2);
+  fail_unless_equals_uint64 (g_value_get_uint64 (gst_value_array_get_value
+          (histogram, 10)), 1);
+
+  gst_structure_free (stats);
+}
+GST_END_TEST
+
 static Suite *
 dlbutils_suite (void)
 {
@@ -132,6 +561,15 @@ dlbutils_suite (void)
   /* add tests to the test case */
   tcase_add_test (tc_general, test_dlb_utils_buffer_data_type);
   tcase_add_test (tc_general, test_dlb_utils_buffer_reordering);
+  tcase_add_test (tc_general, test_dlb_utils_audio_is_silent);
+  tcase_add_test (tc_general, test_dlb_utils_positions_to_dlb_order);
+  tcase_add_test (tc_general, test_dlb_utils_audio_crossfade);
+  tcase_add_test (tc_general, test_dlb_utils_channel_mix);
+  tcase_add_test (tc_general, test_dlb_utils_config_loader);
+  tcase_add_test (tc_general, test_dlb_utils_param_mailbox);
+  tcase_add_test (tc_general, test_dlb_utils_lfract_caps);
+  tcase_add_test (tc_general, test_dlb_utils_caps_cache);
+  tcase_add_test (tc_general, test_dlb_utils_shim_stats);
 
   /* add test case to the suite */
   suite_add_tcase (s, tc_general);
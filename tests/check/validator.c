@@ -1,19 +1,41 @@
 #include <stdlib.h>
 #include <gst/gst.h>
 
+/* plugins register without their vendor library, which is only loaded once
+ * an element goes to READY */
+static gboolean element_usable(const char *name) {
+    GstElement *element = gst_element_factory_make(name, NULL);
+    gboolean usable;
+
+    if (!element)
+      return FALSE;
+
+    usable = gst_element_set_state(element, GST_STATE_READY) !=
+        GST_STATE_CHANGE_FAILURE;
+
+    gst_element_set_state(element, GST_STATE_NULL);
+    gst_object_unref(element);
+    return usable;
+}
+
 int main(int argc, char *argv[]) {
     if (argc == 3) {
-      GstPlugin *plugin;
+      GstElementFactory *factory;
+      gboolean usable = FALSE;
       gst_init(NULL, NULL);
 
-      if ((plugin = gst_registry_find_plugin (gst_registry_get (), argv[2]))) {
-        gst_object_unref (plugin);
-        gst_deinit ();
+      /* several elements may live in one plugin, look up the element */
+      if ((factory = gst_element_factory_find (argv[2]))) {
+        gst_object_unref (factory);
+        usable = element_usable(argv[2]);
+      }
+
+      gst_deinit ();
+
+      if (usable)
         goto run_test;
-      } else {
-        gst_deinit ();
+      else
         goto skip_test;
-      }
     }
 
 run_test: